@@ -0,0 +1,324 @@
+// alloc_bench — verifies that the message path does not allocate once warm.
+// A loopback WebSocket server thread sends synthetic bookTicker frames; a
+// session thread acquires a slab slot, reads each frame into it and hands it
+// to OnMessage (latency histogram and push → publish), the per-message body
+// SyncSession and AsyncSession share; the merger orders them into a file sink
+// and records the merged latency, and the logger drains the latency queue,
+// both writing to /dev/null. Global operator new and (on glibc)
+// malloc/calloc/realloc/aligned allocation are counted on every thread except
+// the server while the session reads messages [WARMUP, WARMUP + MESSAGES).
+//
+//   alloc_bench [MESSAGES] [WARMUP]
+//
+// Prints allocations and bytes per message plus the distinct call stacks
+// that allocated, and exits 1 when steady-state allocations are non-zero.
+#include <utility>
+#include "core/message.hpp"
+#include "logging/latency_event.hpp"
+#include "logging/latency_histogram.hpp"
+#include "logging/logger.hpp"
+#include "merge/stream_merger.hpp"
+#include "sessions/on_message.hpp"
+#include "sink/sink_factory.hpp"
+#include "util/latency.hpp"
+#include <atomic>
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/websocket.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <execinfo.h>
+#include <new>
+#include <string>
+#include <thread>
+
+namespace {
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace websocket = beast::websocket;
+using tcp = net::ip::tcp;
+
+// ---- allocation hook -------------------------------------------------------
+
+constexpr int kFrames = 14;
+constexpr int kSkipFrames = 2; // Record + the hook
+constexpr std::size_t kMaxSites = 64;
+
+struct Site {
+  std::uint64_t hash = 0;
+  std::uint64_t count = 0;
+  std::uint64_t bytes = 0;
+  int depth = 0;
+  void *frames[kFrames] = {};
+};
+
+std::atomic<bool> g_counting{false};
+std::atomic<std::uint64_t> g_allocs{0};
+std::atomic<std::uint64_t> g_bytes{0};
+std::atomic_flag g_sites_lock = ATOMIC_FLAG_INIT;
+Site g_sites[kMaxSites];
+std::size_t g_site_count = 0;
+std::uint64_t g_sites_lost = 0; // stacks beyond kMaxSites
+thread_local bool t_in_hook = false;
+thread_local bool t_ignore = false; // the synthetic server's own thread
+
+// Counts one allocation and files its call stack; allocation-free itself
+// (backtrace is warmed up in main before counting starts)
+void Record(std::size_t n) {
+  if (!g_counting.load(std::memory_order_relaxed) || t_in_hook || t_ignore) {
+    return;
+  }
+  t_in_hook = true;
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  g_bytes.fetch_add(n, std::memory_order_relaxed);
+  void *frames[kFrames];
+  const int depth = ::backtrace(frames, kFrames);
+  std::uint64_t h = 1469598103934665603ull;
+  for (int i = kSkipFrames; i < depth; ++i) {
+    h = (h ^ reinterpret_cast<std::uintptr_t>(frames[i])) * 1099511628211ull;
+  }
+  while (g_sites_lock.test_and_set(std::memory_order_acquire)) {
+  }
+  std::size_t i = 0;
+  while (i < g_site_count && g_sites[i].hash != h) {
+    ++i;
+  }
+  if (i == g_site_count && g_site_count < kMaxSites) {
+    Site &s = g_sites[g_site_count++];
+    s.hash = h;
+    s.depth = depth;
+    std::memcpy(s.frames, frames, sizeof(void *) * depth);
+  }
+  if (i < g_site_count) {
+    ++g_sites[i].count;
+    g_sites[i].bytes += n;
+  } else {
+    ++g_sites_lost;
+  }
+  g_sites_lock.clear(std::memory_order_release);
+  t_in_hook = false;
+}
+
+} // namespace
+
+#ifdef __GLIBC__
+// Every allocation, whether through operator new (libstdc++ forwards to
+// malloc) or a direct malloc call, ends up here
+extern "C" {
+void *__libc_malloc(std::size_t);
+void *__libc_calloc(std::size_t, std::size_t);
+void *__libc_realloc(void *, std::size_t);
+void *__libc_memalign(std::size_t, std::size_t);
+
+void *malloc(std::size_t n) {
+  Record(n);
+  return __libc_malloc(n);
+}
+void *calloc(std::size_t k, std::size_t n) {
+  Record(k * n);
+  return __libc_calloc(k, n);
+}
+void *realloc(void *p, std::size_t n) {
+  Record(n);
+  return __libc_realloc(p, n);
+}
+void *aligned_alloc(std::size_t a, std::size_t n) {
+  Record(n);
+  return __libc_memalign(a, n);
+}
+void *memalign(std::size_t a, std::size_t n) {
+  Record(n);
+  return __libc_memalign(a, n);
+}
+int posix_memalign(void **out, std::size_t a, std::size_t n) {
+  Record(n);
+  void *p = __libc_memalign(a, n);
+  if (p == nullptr) {
+    return ENOMEM;
+  }
+  *out = p;
+  return 0;
+}
+}
+#else
+// Elsewhere only operator new is counted
+void *operator new(std::size_t n) {
+  Record(n);
+  if (void *p = std::malloc(n == 0 ? 1 : n)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+void *operator new[](std::size_t n) { return ::operator new(n); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+#endif
+
+namespace {
+
+// ---- pipeline --------------------------------------------------------------
+
+// Sends `total` bookTicker frames with increasing `u` to the first client
+void Serve(tcp::acceptor &acceptor, std::uint64_t total) {
+  t_ignore = true;
+  net::io_context ioc;
+  tcp::socket sock(ioc);
+  acceptor.accept(sock);
+  websocket::stream<tcp::socket> ws(std::move(sock));
+  ws.accept();
+  ws.text(true);
+  char frame[256];
+  for (std::uint64_t u = 1; u <= total; ++u) {
+    const std::int64_t ms = lat::EpochNanosUtc() / 1'000'000;
+    const int n = std::snprintf(
+        frame, sizeof(frame),
+        R"({"e":"bookTicker","u":%llu,"s":"BTCUSDT","b":"110799.90",)"
+        R"("B":"5.213","a":"110800.00","A":"1.744","T":%lld,"E":%lld})",
+        static_cast<unsigned long long>(u), static_cast<long long>(ms),
+        static_cast<long long>(ms));
+    ws.write(net::buffer(frame, static_cast<std::size_t>(n)));
+  }
+  // No close handshake: the client stops reading after the last frame
+}
+
+void PrintSites() {
+  for (std::size_t i = 0; i < g_site_count; ++i) {
+    const Site &s = g_sites[i];
+    std::printf("site %zu: allocations=%llu bytes=%llu\n", i + 1,
+                static_cast<unsigned long long>(s.count),
+                static_cast<unsigned long long>(s.bytes));
+    char **names = ::backtrace_symbols(s.frames + kSkipFrames,
+                                       s.depth - kSkipFrames);
+    for (int f = 0; names != nullptr && f < s.depth - kSkipFrames; ++f) {
+      // "binary(mangled+0x1f) [0x...]" → demangled function name
+      std::string line = names[f];
+      const std::size_t l = line.find('(');
+      const std::size_t p = line.find('+', l);
+      if (l != std::string::npos && p != std::string::npos && p > l + 1) {
+        int st = 0;
+        char *d = abi::__cxa_demangle(line.substr(l + 1, p - l - 1).c_str(),
+                                      nullptr, nullptr, &st);
+        if (st == 0 && d != nullptr) {
+          line = std::string(d).substr(0, 160);
+        }
+        std::free(d);
+      }
+      std::printf("    %s\n", line.c_str());
+    }
+    std::free(names);
+  }
+  if (g_sites_lost != 0) {
+    std::printf("(%llu allocations from further call stacks)\n",
+                static_cast<unsigned long long>(g_sites_lost));
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const std::uint64_t messages =
+      argc > 1 ? std::stoull(argv[1]) : std::uint64_t{200'000};
+  const std::uint64_t warmup =
+      argc > 2 ? std::stoull(argv[2]) : std::uint64_t{50'000};
+  {
+    void *f[4];
+    (void)::backtrace(f, 4); // loads the unwinder before counting
+  }
+
+  auto q = RawOrderQueue::Create({}, QueueOverflow::block);
+  if (!q) {
+    std::fprintf(stderr, "queue: %s\n", q.error().message().c_str());
+    return 1;
+  }
+  std::vector<std::shared_ptr<RawOrderQueue>> queues{*q};
+  RawOrderQueue &ring = **q;
+  auto latency = std::make_shared<logging::LatencyQueue>();
+  auto histogram = std::make_shared<logging::LatencyHistogram>();
+
+  FileLogger logger;
+  (void)logger.AddSession(latency, "/dev/null");
+  StreamMerger merger{queues};
+  merger.SetLatencyHistogram(std::make_shared<logging::LatencyHistogram>());
+  sink::SinkSpec spec;
+  spec.kind = "file";
+  spec.target = "/dev/null";
+  auto fileSink = sink::MakeSink(spec);
+  if (!fileSink) {
+    std::fprintf(stderr, "sink: %s\n", fileSink.error().message().c_str());
+    return 1;
+  }
+  merger.AddSink(std::move(*fileSink), spec.cfg);
+  logger.Start();
+  merger.Start();
+
+  net::io_context ioc;
+  tcp::acceptor acceptor(ioc, {net::ip::make_address("127.0.0.1"), 0});
+  const std::uint64_t total = warmup + messages;
+  std::jthread server([&] { Serve(acceptor, total); });
+
+  // The session: SyncSession::ReadLoop without TLS, timeouts and reconnects
+  tcp::socket sock(ioc);
+  sock.connect(acceptor.local_endpoint());
+  websocket::stream<tcp::socket> ws(std::move(sock));
+  ws.read_message_max(ring.MaxMessage());
+  ws.handshake("127.0.0.1", "/");
+  RawOrderUpdate slot;
+  bool pooled = false;
+  const auto t0 = std::chrono::steady_clock::now();
+  auto t1 = t0;
+  for (std::uint64_t i = 0; i < total; ++i) {
+    if (i == warmup) {
+      g_counting.store(true, std::memory_order_relaxed);
+      t1 = std::chrono::steady_clock::now();
+    }
+    if (!pooled) {
+      while (!ring.acquire(slot)) {
+        std::this_thread::yield();
+      }
+      pooled = true;
+    }
+    slot.buf.clear();
+    beast::error_code ec;
+    const std::size_t n = ws.read(slot.buf, ec);
+    if (ec) {
+      std::fprintf(stderr, "read: %s\n", ec.message().c_str());
+      return 1;
+    }
+    OnMessage(ring, slot, n, pooled, *histogram, latency.get(), nullptr);
+  }
+  const auto t2 = std::chrono::steady_clock::now();
+  // Let the merger's hold-back window and the sink/logger threads catch up
+  // with the measured messages before counting stops
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  g_counting.store(false, std::memory_order_relaxed);
+  server.join();
+  merger.Join();
+  logger.Join();
+
+  const std::uint64_t allocs = g_allocs.load();
+  const std::uint64_t bytes = g_bytes.load();
+  const auto &st = ring.GetStats();
+  std::printf("messages=%llu warmup=%llu written=%llu read_ns/msg=%.0f\n",
+              static_cast<unsigned long long>(messages),
+              static_cast<unsigned long long>(warmup),
+              static_cast<unsigned long long>(
+                  merger.Sinks()[0]->GetStats().written.load()),
+              std::chrono::duration<double, std::nano>(t2 - t1).count() /
+                  static_cast<double>(messages));
+  std::printf("allocations=%llu bytes=%llu per_message=%.4f "
+              "(published=%llu latency_dropped=%llu)\n",
+              static_cast<unsigned long long>(allocs),
+              static_cast<unsigned long long>(bytes),
+              static_cast<double>(allocs) / static_cast<double>(messages),
+              static_cast<unsigned long long>(st.published.load()),
+              static_cast<unsigned long long>(st.latency_dropped.load()));
+  PrintSites();
+  std::printf("%s\n", allocs == 0 ? "PASS" : "FAIL");
+  return allocs == 0 ? 0 : 1;
+}
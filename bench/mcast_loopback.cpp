@@ -0,0 +1,151 @@
+// mcast_loopback — publish → receive → retransmit over the loopback
+// interface. Synthetic bookTicker messages go through a merge::ConsumerHub
+// into an mcast::MulticastPublisher; an mcast::MulticastReceiver on the same
+// host discards every DROP_EVERY-th quote datagram (Config::drop_every) and
+// has to get each one back through the retransmit side channel.
+//
+//   mcast_loopback [MESSAGES] [DROP_EVERY] [GROUP:PORT]
+//
+// Prints publisher and receiver counters and exits 1 unless every message
+// arrived exactly once and every gap was recovered.
+#include <utility>
+#include "merge/stream_consumer.hpp"
+#include "net/multicast.hpp"
+#include "util/latency.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char **argv) {
+  const std::uint64_t messages =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+  const unsigned dropEvery =
+      argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 7;
+  const auto ep =
+      mcast::ParseEndpoint(argc > 3 ? argv[3] : "239.255.42.9:31101",
+                           "127.0.0.1");
+  if (messages == 0 || !ep) {
+    std::fprintf(stderr,
+                 "usage: mcast_loopback [MESSAGES] [DROP_EVERY] "
+                 "[GROUP:PORT]\n");
+    return 1;
+  }
+
+  auto hub = std::make_shared<merge::ConsumerHub>();
+  mcast::MulticastPublisher pub(
+      std::make_unique<merge::StreamConsumer>(hub, "multicast"),
+      mcast::MulticastPublisher::Config{.endpoint = *ep});
+  mcast::MulticastReceiver rx(
+      mcast::MulticastReceiver::Config{.endpoint = *ep,
+                                       .drop_every = dropEvery});
+  if (auto st = pub.Open(); !st) {
+    std::fprintf(stderr, "[mcast_loopback] publisher: %s\n",
+                 st.error().message().c_str());
+    return 1;
+  }
+  // Joined before the first datagram goes out
+  if (auto st = rx.Open(); !st) {
+    std::fprintf(stderr, "[mcast_loopback] receiver: %s\n",
+                 st.error().message().c_str());
+    return 1;
+  }
+  pub.Start();
+
+  std::vector<std::uint32_t> seen(messages + 1, 0);
+  std::uint64_t have = 0;
+  std::uint64_t extra = 0; // trailing messages past MESSAGES
+  auto poll = [&] {
+    return rx.Poll([&](const codec::QuoteRecord &r, std::string_view,
+                       std::uint64_t, bool) {
+      if (r.u >= 1 && r.u <= messages && seen[r.u]++ == 0) {
+        ++have;
+      }
+    });
+  };
+  char payload[160];
+  std::uint64_t published = 0;
+  auto publish = [&](std::uint64_t u) {
+    const int len = std::snprintf(
+        payload, sizeof(payload),
+        "{\"u\":%llu,\"s\":\"BTCUSDT\",\"b\":\"100.10\",\"B\":\"1.50\","
+        "\"a\":\"100.20\",\"A\":\"2.00\"}",
+        static_cast<unsigned long long>(u));
+    hub->Publish(u, 0, lat::EpochNanosUtc(), payload,
+                 static_cast<std::size_t>(len));
+    ++published;
+  };
+
+  const auto start = std::chrono::steady_clock::now();
+  constexpr std::uint64_t kChunk = 512;
+  for (std::uint64_t u = 1; u <= messages;) {
+    for (const std::uint64_t end = std::min(messages, u + kChunk - 1);
+         u <= end; ++u) {
+      publish(u);
+    }
+    // Keep the publisher within the hub ring and the socket buffers drained
+    while (pub.GetStats().records.load() < published) {
+      if (poll() == 0) {
+        std::this_thread::yield();
+      }
+    }
+  }
+  // A dropped last datagram is only noticed when a later one arrives: keep
+  // publishing single messages while the receiver is missing some
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  auto lastProgress = std::chrono::steady_clock::now();
+  std::uint64_t lastHave = have;
+  while (have < messages && std::chrono::steady_clock::now() < deadline) {
+    if (poll() == 0) {
+      std::this_thread::yield();
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (have != lastHave) {
+      lastHave = have;
+      lastProgress = now;
+    } else if (now - lastProgress > std::chrono::milliseconds(50)) {
+      publish(messages + ++extra);
+      lastProgress = now;
+    }
+  }
+  const double secs = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+  pub.Join();
+
+  std::uint64_t duplicates = 0;
+  for (std::uint64_t u = 1; u <= messages; ++u) {
+    duplicates += seen[u] > 1 ? seen[u] - 1 : 0;
+  }
+  const auto &ps = pub.GetStats();
+  const auto &rs = rx.GetStats();
+  std::printf("messages=%llu received=%llu duplicates=%llu trailing=%llu "
+              "seconds=%.3f\n",
+              static_cast<unsigned long long>(messages),
+              static_cast<unsigned long long>(have),
+              static_cast<unsigned long long>(duplicates),
+              static_cast<unsigned long long>(extra), secs);
+  std::printf("publisher datagrams=%llu records=%llu sendmmsg=%llu "
+              "retransmitted=%llu unavailable=%llu\n",
+              static_cast<unsigned long long>(ps.datagrams.load()),
+              static_cast<unsigned long long>(ps.records.load()),
+              static_cast<unsigned long long>(ps.sendmmsg_calls.load()),
+              static_cast<unsigned long long>(ps.retransmitted.load()),
+              static_cast<unsigned long long>(ps.unavailable.load()));
+  std::printf("receiver datagrams=%llu records=%llu gaps=%llu recovered=%llu "
+              "unrecoverable=%llu (dropping every %u)\n",
+              static_cast<unsigned long long>(rs.datagrams),
+              static_cast<unsigned long long>(rs.records),
+              static_cast<unsigned long long>(rs.gaps),
+              static_cast<unsigned long long>(rs.recovered),
+              static_cast<unsigned long long>(rs.unrecoverable), dropEvery);
+  const bool ok = have == messages && duplicates == 0 &&
+                  rs.unrecoverable == 0 && rs.recovered == rs.gaps &&
+                  (dropEvery == 0 || rs.gaps != 0);
+  std::printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
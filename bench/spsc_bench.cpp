@@ -0,0 +1,261 @@
+// spsc_bench — cross-thread throughput of the SPSC queues on the message path
+// against boost::lockfree::spsc_queue. One producer and one consumer thread
+// move N 32-byte items (the size of a RawOrderUpdate) and the bench reports
+// ns per item plus hardware cache misses of both threads (perf_event_open;
+// "n/a" when perf counters are not available).
+//
+//   spsc_bench [ITEMS] [PRODUCER_CPU CONSUMER_CPU]
+//
+// Cases:
+//   boost_spsc   push/pop on boost::lockfree::spsc_queue
+//   spsc         push/pop on lockfree::SpscQueue
+//   spsc_bulk32  push_bulk/pop_bulk of 32 on lockfree::SpscQueue
+//   boost_ring2  the previous Ring: free + ready boost queues per round trip
+//   ring         lockfree::Ring acquire/publish/consume/release
+#include "lockfree/ring.hpp"
+#include "lockfree/spsc_queue.hpp"
+#include <boost/lockfree/spsc_queue.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+constexpr std::size_t kCap = 16384;
+
+struct Item {
+  std::uint64_t seq = 0;
+  std::uint64_t pad[3] = {};
+};
+
+// Cache misses of this thread and the threads it starts after Start()
+// (inherited counters are folded in when those threads exit)
+class MissCounter {
+public:
+  void Start() {
+    perf_event_attr a{};
+    a.type = PERF_TYPE_HARDWARE;
+    a.size = sizeof(a);
+    a.config = PERF_COUNT_HW_CACHE_MISSES;
+    a.disabled = 1;
+    a.inherit = 1;
+    a.exclude_kernel = 1;
+    a.exclude_hv = 1;
+    fd_ = static_cast<int>(::syscall(SYS_perf_event_open, &a, 0, -1, -1, 0));
+    if (fd_ != -1) {
+      ::ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ::ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+  std::optional<std::uint64_t> Stop() {
+    if (fd_ == -1) {
+      return std::nullopt;
+    }
+    ::ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    std::uint64_t v = 0;
+    const bool ok = ::read(fd_, &v, sizeof(v)) == sizeof(v);
+    ::close(fd_);
+    fd_ = -1;
+    return ok ? std::optional(v) : std::nullopt;
+  }
+
+private:
+  int fd_ = -1;
+};
+
+void Pin(int cpu) {
+  if (cpu < 0) {
+    return;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  (void)pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+struct Cpus {
+  int producer = -1;
+  int consumer = -1;
+};
+
+// Runs producer(n) and consumer(n) on two threads; checks the consumer saw
+// every sequence number in order
+template <typename Produce, typename Consume>
+void RunCase(const char *name, std::size_t n, Cpus cpus, Produce produce,
+             Consume consume) {
+  MissCounter misses;
+  misses.Start();
+  const auto t0 = Clock::now();
+  std::uint64_t bad = 0;
+  {
+    std::jthread c([&] {
+      Pin(cpus.consumer);
+      bad = consume(n);
+    });
+    std::jthread p([&] {
+      Pin(cpus.producer);
+      produce(n);
+    });
+  }
+  const double ns =
+      std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+  const auto m = misses.Stop();
+  char missText[32] = "n/a";
+  if (m) {
+    std::snprintf(missText, sizeof(missText), "%.3f",
+                  static_cast<double>(*m) / static_cast<double>(n));
+  }
+  std::printf("%-12s %8.2f ns/item  %12.0f items/s  cache-misses/item=%s%s\n",
+              name, ns / static_cast<double>(n),
+              static_cast<double>(n) * 1e9 / ns, missText,
+              bad != 0 ? "  ORDER ERROR" : "");
+}
+
+void Spin() { std::this_thread::yield(); }
+
+template <typename Q> void QueueCase(const char *name, std::size_t n, Cpus cpus) {
+  auto q = std::make_unique<Q>();
+  RunCase(
+      name, n, cpus,
+      [&](std::size_t total) {
+        for (std::uint64_t i = 0; i < total; ++i) {
+          const Item it{i};
+          while (!q->push(it)) {
+            Spin();
+          }
+        }
+      },
+      [&](std::size_t total) {
+        std::uint64_t bad = 0;
+        Item it;
+        for (std::uint64_t i = 0; i < total; ++i) {
+          while (!q->pop(it)) {
+            Spin();
+          }
+          bad += it.seq != i;
+        }
+        return bad;
+      });
+}
+
+void BulkCase(std::size_t n, Cpus cpus) {
+  constexpr std::size_t kBatch = 32;
+  auto q = std::make_unique<lockfree::SpscQueue<Item, kCap>>();
+  RunCase(
+      "spsc_bulk32", n, cpus,
+      [&](std::size_t total) {
+        Item batch[kBatch];
+        for (std::uint64_t i = 0; i < total;) {
+          const std::size_t want = std::min<std::size_t>(kBatch, total - i);
+          for (std::size_t k = 0; k < want; ++k) {
+            batch[k].seq = i + k;
+          }
+          std::size_t done = 0;
+          while (done < want) {
+            const std::size_t got = q->push_bulk(batch + done, want - done);
+            if (got == 0) {
+              Spin();
+            }
+            done += got;
+          }
+          i += want;
+        }
+      },
+      [&](std::size_t total) {
+        std::uint64_t bad = 0;
+        Item batch[kBatch];
+        for (std::uint64_t i = 0; i < total;) {
+          const std::size_t got = q->pop_bulk(batch, kBatch);
+          if (got == 0) {
+            Spin();
+            continue;
+          }
+          for (std::size_t k = 0; k < got; ++k) {
+            bad += batch[k].seq != i + k;
+          }
+          i += got;
+        }
+        return bad;
+      });
+}
+
+// The Ring as it was before lockfree::Ring recycled slots in place
+class BoostRing2 {
+public:
+  using Queue =
+      boost::lockfree::spsc_queue<Item, boost::lockfree::capacity<kCap>>;
+  BoostRing2() {
+    for (std::size_t i = 0; i < kCap; ++i) {
+      (void)free_.push(Item{});
+    }
+  }
+  bool acquire(Item &out) { return free_.pop(out); }
+  bool publish(Item &&item) { return ready_.push(item); }
+  bool consume(Item &out) { return ready_.pop(out); }
+  bool release(Item &&item) { return free_.push(item); }
+
+private:
+  Queue free_;
+  Queue ready_;
+};
+
+template <typename R> void RingCase(const char *name, std::size_t n, Cpus cpus) {
+  auto r = std::make_unique<R>();
+  RunCase(
+      name, n, cpus,
+      [&](std::size_t total) {
+        Item it;
+        for (std::uint64_t i = 0; i < total; ++i) {
+          while (!r->acquire(it)) {
+            Spin();
+          }
+          it.seq = i;
+          (void)r->publish(std::move(it));
+        }
+      },
+      [&](std::size_t total) {
+        std::uint64_t bad = 0;
+        Item it;
+        for (std::uint64_t i = 0; i < total; ++i) {
+          while (!r->consume(it)) {
+            Spin();
+          }
+          bad += it.seq != i;
+          (void)r->release(std::move(it));
+        }
+        return bad;
+      });
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const std::size_t n =
+      argc > 1 ? std::stoull(argv[1]) : std::size_t{20'000'000};
+  Cpus cpus;
+  if (argc > 3) {
+    cpus = {std::stoi(argv[2]), std::stoi(argv[3])};
+  }
+  std::printf("items=%zu capacity=%zu item=%zu B producer_cpu=%d "
+              "consumer_cpu=%d\n",
+              n, kCap, sizeof(Item), cpus.producer, cpus.consumer);
+  QueueCase<boost::lockfree::spsc_queue<Item, boost::lockfree::capacity<kCap>>>(
+      "boost_spsc", n, cpus);
+  QueueCase<lockfree::SpscQueue<Item, kCap>>("spsc", n, cpus);
+  BulkCase(n, cpus);
+  RingCase<BoostRing2>("boost_ring2", n, cpus);
+  RingCase<lockfree::Ring<Item, kCap>>("ring", n, cpus);
+  return 0;
+}
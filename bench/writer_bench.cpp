@@ -0,0 +1,90 @@
+// writer_bench — sustained-load comparison of the io::IWriter backends.
+// Appends NDJSON-sized lines in batches of 64 [payload, "\n"] pairs (the
+// FileSink pattern) and reports throughput plus the distribution of time the
+// calling thread spends inside one batch write.
+//
+//   writer_bench [DIR] [MESSAGES] [write|mmap|uring|stream|direct ...]
+#include "io/open_writer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void RunOne(const std::string &dir, io::WriterKind kind, std::size_t messages) {
+  const std::string path =
+      dir + "/writer_bench_" + io::WriterKindName(kind) + ".ndjson";
+  const std::string line =
+      R"({"e":"bookTicker","u":8422198374162,"s":"BTCUSDT","b":"110799.90",)"
+      R"("B":"5.213","a":"110800.00","A":"1.744","T":1757107620123,)"
+      R"("E":1757107620124})";
+  static const char newline = '\n';
+  constexpr int kBatch = 64;
+  std::vector<std::int64_t> samples;
+  samples.reserve(messages / kBatch + 1);
+  const auto t0 = Clock::now();
+  {
+    auto w = io::OpenWriter(path, kind);
+    if (!w) {
+      std::printf("%-6s open failed: %s\n", io::WriterKindName(kind),
+                  w.error().message().c_str());
+      return;
+    }
+    struct iovec iov[2 * kBatch];
+    for (std::size_t sent = 0; sent < messages; sent += kBatch) {
+      for (int i = 0; i < kBatch; ++i) {
+        iov[2 * i] = {(void *)line.data(), line.size()};
+        iov[2 * i + 1] = {(void *)&newline, 1};
+      }
+      const auto b0 = Clock::now();
+      (*w)->Writev(iov, 2 * kBatch);
+      samples.push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                               b0)
+              .count());
+    }
+    (*w)->Flush();
+  } // destructor drains in-flight writes and closes
+  const double secs =
+      std::chrono::duration<double>(Clock::now() - t0).count();
+  std::sort(samples.begin(), samples.end());
+  auto pct = [&](double p) {
+    return samples[static_cast<std::size_t>(p * (samples.size() - 1))] /
+           1000.0;
+  };
+  const double mb = static_cast<double>(messages * (line.size() + 1)) / 1e6;
+  std::printf("%-6s %8.1f MB/s %10.0f msg/s  batch us: p50=%.2f p99=%.2f "
+              "p99.9=%.2f max=%.2f\n",
+              io::WriterKindName(kind), mb / secs, messages / secs, pct(0.50),
+              pct(0.99), pct(0.999), samples.back() / 1000.0);
+  ::unlink(path.c_str());
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const std::string dir = argc > 1 ? argv[1] : ".";
+  const std::size_t messages =
+      argc > 2 ? std::stoull(argv[2]) : std::size_t{2'000'000};
+  std::vector<io::WriterKind> kinds;
+  for (int i = 3; i < argc; ++i) {
+    if (auto k = io::ParseWriterKind(argv[i])) {
+      kinds.push_back(*k);
+    }
+  }
+  if (kinds.empty()) {
+    kinds = {io::WriterKind::write, io::WriterKind::mmap,
+             io::WriterKind::uring, io::WriterKind::stream,
+             io::WriterKind::direct};
+  }
+  for (auto k : kinds) {
+    RunOne(dir, k, messages);
+  }
+  return 0;
+}
@@ -0,0 +1,243 @@
+#pragma once
+
+#include "codec/book_ticker.hpp"
+#include "util/branch.hpp"
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+
+// namespace analytics — incremental top-of-book analytics computed on the
+// merged stream. One writer (the StreamMerger thread) updates per-symbol state
+// in O(1) per message; any number of in-process readers take consistent
+// snapshots through a per-symbol seqlock without blocking the writer.
+namespace analytics {
+
+// Published per-symbol view. Prices are in quote units (double) because the
+// consumers are strategy code; the fixed-point inputs stay exact internally.
+struct Snapshot {
+  std::uint64_t u = 0;        // updateId of the last applied quote
+  std::int64_t event_ms = 0;  // exchange event time of the last quote
+  std::uint64_t updates = 0;  // quotes applied so far
+  double bid = 0.0;
+  double ask = 0.0;
+  double mid = 0.0;
+  double spread = 0.0;
+  double microprice = 0.0; // size-weighted mid: (b*A + a*B) / (A + B)
+  double imbalance = 0.0;  // (B - A) / (B + A), in [-1, 1]
+  double ewma_vol = 0.0;   // EWMA std-dev of mid log returns (per update)
+  double vwap = 0.0;       // quote-size weighted mid over the rolling window
+  std::uint32_t vwap_samples = 0; // quotes currently inside the window
+};
+
+struct Config {
+  // Rolling VWAP window over exchange time
+  std::int64_t vwap_window_ms = 1000;
+  // EWMA decay for squared log returns: var = (1 - alpha) * var + alpha * r^2
+  double ewma_alpha = 0.05;
+};
+
+// SymbolState keeps the running aggregates for one symbol. The VWAP window is
+// a fixed ring of samples; when a burst exceeds kWindowSlots inside one
+// window, the oldest samples are evicted early (window shrinks, never grows).
+class SymbolState {
+public:
+  static constexpr std::size_t kWindowSlots = 4096;
+
+  void Apply(const codec::BookTicker &bt, const Config &cfg, Snapshot &out) {
+    const double scale = static_cast<double>(codec::kFixedScale);
+    const double bid = static_cast<double>(bt.bid_px) / scale;
+    const double ask = static_cast<double>(bt.ask_px) / scale;
+    const double bq = static_cast<double>(bt.bid_qty) / scale;
+    const double aq = static_cast<double>(bt.ask_qty) / scale;
+    const double mid = 0.5 * (bid + ask);
+    const double depth = bq + aq;
+
+    // EWMA volatility of mid log returns
+    if (BRANCH_LIKELY(last_mid_ > 0.0 && mid > 0.0)) {
+      const double r = std::log(mid / last_mid_);
+      var_ = (1.0 - cfg.ewma_alpha) * var_ + cfg.ewma_alpha * r * r;
+    }
+    last_mid_ = mid;
+
+    // Rolling time-window VWAP: add the new sample, evict expired ones
+    const std::int64_t t = bt.event_ms != 0 ? bt.event_ms : bt.trade_ms;
+    if (BRANCH_UNLIKELY(count_ == kWindowSlots)) {
+      Evict();
+    }
+    Sample &s = window_[(head_ + count_) % kWindowSlots];
+    s = {t, mid * depth, depth};
+    ++count_;
+    pv_sum_ += s.pv;
+    v_sum_ += s.v;
+    while (count_ > 1 && window_[head_].t_ms <= t - cfg.vwap_window_ms) {
+      Evict();
+    }
+
+    out.u = bt.u;
+    out.event_ms = t;
+    ++out.updates;
+    out.bid = bid;
+    out.ask = ask;
+    out.mid = mid;
+    out.spread = ask - bid;
+    out.microprice = depth > 0.0 ? (bid * aq + ask * bq) / depth : mid;
+    out.imbalance = depth > 0.0 ? (bq - aq) / depth : 0.0;
+    out.ewma_vol = std::sqrt(var_);
+    out.vwap = v_sum_ > 0.0 ? pv_sum_ / v_sum_ : mid;
+    out.vwap_samples = static_cast<std::uint32_t>(count_);
+  }
+
+private:
+  struct Sample {
+    std::int64_t t_ms;
+    double pv; // mid * (bid_qty + ask_qty)
+    double v;  // bid_qty + ask_qty
+  };
+
+  void Evict() {
+    const Sample &old = window_[head_];
+    pv_sum_ -= old.pv;
+    v_sum_ -= old.v;
+    head_ = (head_ + 1) % kWindowSlots;
+    --count_;
+  }
+
+  std::array<Sample, kWindowSlots> window_{};
+  std::size_t head_ = 0;
+  std::size_t count_ = 0;
+  double pv_sum_ = 0.0;
+  double v_sum_ = 0.0;
+  double last_mid_ = 0.0;
+  double var_ = 0.0;
+};
+
+// MarketAnalytics
+// Threading model:
+// - Single writer: OnMessage() is called from the StreamMerger thread for
+//   every emitted (ordered, deduplicated) message
+// - Multiple readers: Read()/Find() from any thread; a per-symbol seqlock
+//   lets readers retry instead of blocking the writer
+// - Fixed symbol table (kMaxSymbols); no allocation after construction
+class MarketAnalytics {
+public:
+  static constexpr std::size_t kMaxSymbols = 64;
+  static constexpr std::size_t kMaxSymbolLen = 23;
+
+  explicit MarketAnalytics(Config cfg = {}) : cfg_(cfg) {}
+
+  MarketAnalytics(const MarketAnalytics &) = delete;
+  MarketAnalytics &operator=(const MarketAnalytics &) = delete;
+
+  // Writer API: parses and applies one bookTicker payload. Returns false for
+  // payloads that are not bookTicker or when the symbol table is full.
+  bool OnMessage(std::string_view payload) {
+    auto bt = codec::ParseBookTicker(payload);
+    if (BRANCH_UNLIKELY(!bt.has_value())) {
+      return false;
+    }
+    return Apply(*bt);
+  }
+
+  bool Apply(const codec::BookTicker &bt) {
+    Entry *e = FindOrAdd(bt.symbol);
+    if (BRANCH_UNLIKELY(e == nullptr)) {
+      return false;
+    }
+    const std::uint64_t seq = e->seq.load(std::memory_order_relaxed);
+    e->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    e->state.Apply(bt, cfg_, e->snap);
+    e->seq.store(seq + 2, std::memory_order_release);
+    return true;
+  }
+
+  // Reader API
+  std::size_t SymbolCount() const {
+    return count_.load(std::memory_order_acquire);
+  }
+
+  std::string_view SymbolName(std::size_t id) const {
+    if (id >= SymbolCount()) {
+      return {};
+    }
+    return {entries_[id].name, entries_[id].name_len};
+  }
+
+  // Copies a consistent snapshot for symbol `id`; returns false if unknown
+  bool Read(std::size_t id, Snapshot &out) const {
+    if (BRANCH_UNLIKELY(id >= SymbolCount())) {
+      return false;
+    }
+    const Entry &e = entries_[id];
+    for (;;) {
+      const std::uint64_t s1 = e.seq.load(std::memory_order_acquire);
+      if (BRANCH_UNLIKELY(s1 & 1u)) {
+        continue;
+      }
+      std::memcpy(&out, &e.snap, sizeof(Snapshot));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (BRANCH_LIKELY(e.seq.load(std::memory_order_relaxed) == s1)) {
+        return true;
+      }
+    }
+  }
+
+  std::optional<Snapshot> Find(std::string_view symbol) const {
+    const std::size_t n = SymbolCount();
+    for (std::size_t i = 0; i < n; ++i) {
+      if (SymbolName(i) == symbol) {
+        Snapshot s;
+        Read(i, s);
+        return s;
+      }
+    }
+    return std::nullopt;
+  }
+
+private:
+  struct alignas(64) Entry {
+    std::atomic<std::uint64_t> seq{0};
+    char name[kMaxSymbolLen + 1]{};
+    std::size_t name_len = 0;
+    Snapshot snap{};
+    SymbolState state;
+  };
+
+  static std::string_view NameOf(const Entry &e) {
+    return {e.name, e.name_len};
+  }
+
+  // Writer-only: linear probe over a handful of symbols beats hashing here
+  Entry *FindOrAdd(std::string_view symbol) {
+    const std::size_t n = count_.load(std::memory_order_relaxed);
+    if (BRANCH_LIKELY(last_ < n && NameOf(entries_[last_]) == symbol)) {
+      return &entries_[last_];
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      if (NameOf(entries_[i]) == symbol) {
+        last_ = i;
+        return &entries_[i];
+      }
+    }
+    if (BRANCH_UNLIKELY(n == kMaxSymbols || symbol.size() > kMaxSymbolLen)) {
+      return nullptr;
+    }
+    Entry &e = entries_[n];
+    std::memcpy(e.name, symbol.data(), symbol.size());
+    e.name_len = symbol.size();
+    count_.store(n + 1, std::memory_order_release);
+    last_ = n;
+    return &e;
+  }
+
+  Config cfg_;
+  std::array<Entry, kMaxSymbols> entries_{};
+  std::atomic<std::size_t> count_{0};
+  std::size_t last_ = 0; // writer-side cache of the last symbol hit
+};
+
+} // namespace analytics
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "codec/binary_record.hpp"
+#include "codec/book_ticker.hpp"
+#include "util/branch.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <string_view>
+#include <system_error>
+
+// namespace capture — on-disk binary capture of the merged stream.
+//
+// Layout (little-endian):
+//   FileHeader (64 bytes) | record | record | ...
+// Every record is one 72-byte codec::QuoteRecord slot; `kind` tells quotes
+// from codec::SymbolRecord definitions. A symbol is always defined before the
+// first quote that uses it, so a file can be decoded front to back with no
+// side tables, and a truncated file is still valid up to its last whole
+// record.
+namespace capture {
+
+inline constexpr char kMagic[8] = {'W', 'H', 'Q', 'C', 'A', 'P', '\0', '\0'};
+inline constexpr std::uint16_t kSchemaVersion = 1;
+inline constexpr std::size_t kRecordSize = sizeof(codec::QuoteRecord);
+
+struct FileHeader {
+  char magic[8];
+  std::uint16_t version;     // kSchemaVersion
+  std::uint16_t record_size; // kRecordSize
+  std::uint32_t flags;       // reserved, 0
+  std::int64_t created_ns;   // wall clock at creation (UTC)
+  std::uint8_t reserved[40];
+};
+static_assert(sizeof(FileHeader) == 64, "FileHeader layout changed");
+
+inline FileHeader MakeHeader(std::int64_t createdNs) {
+  FileHeader h{};
+  std::memcpy(h.magic, kMagic, sizeof(kMagic));
+  h.version = kSchemaVersion;
+  h.record_size = static_cast<std::uint16_t>(kRecordSize);
+  h.created_ns = createdNs;
+  return h;
+}
+
+// True if `data` starts with the capture magic (format sniffing)
+inline bool HasMagic(const void *data, std::size_t len) {
+  return len >= sizeof(kMagic) &&
+         std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+inline std::expected<void, std::error_code>
+ValidateHeader(const FileHeader &h) {
+  if (!HasMagic(&h, sizeof(h))) {
+    return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+  }
+  if (h.version != kSchemaVersion || h.record_size != kRecordSize) {
+    return std::unexpected(std::make_error_code(std::errc::not_supported));
+  }
+  return {};
+}
+
+// RecordEncoder — NDJSON bookTicker payload → records. Keeps the writer-side
+// symbol table and emits a SymbolRecord ahead of the first quote of each new
+// symbol. Payloads that are not bookTickers (or exceed the symbol table) are
+// counted in Skipped() and produce no output.
+class RecordEncoder {
+public:
+  // Upper bound of bytes appended by one Encode call
+  static constexpr std::size_t kMaxBytesPerMessage = 2 * kRecordSize;
+
+  // Appends the records for `payload` at `out`; returns bytes written
+  std::size_t Encode(std::string_view payload, std::uint8_t src,
+                     std::int64_t recvNs, std::byte *out) {
+    auto bt = codec::ParseBookTicker(payload);
+    if (BRANCH_UNLIKELY(!bt.has_value())) {
+      ++skipped_;
+      return 0;
+    }
+    const std::uint16_t before = symbols_.Size();
+    auto id = symbols_.Intern(bt->symbol);
+    if (BRANCH_UNLIKELY(!id.has_value())) {
+      ++skipped_;
+      return 0;
+    }
+    std::size_t n = 0;
+    if (BRANCH_UNLIKELY(symbols_.Size() != before)) {
+      const codec::SymbolRecord def = codec::MakeSymbolRecord(*id, bt->symbol);
+      std::memcpy(out, &def, kRecordSize);
+      n += kRecordSize;
+    }
+    const codec::QuoteRecord r = codec::MakeQuoteRecord(*bt, *id, src, recvNs);
+    std::memcpy(out + n, &r, kRecordSize);
+    return n + kRecordSize;
+  }
+
+  std::uint64_t Skipped() const { return skipped_; }
+
+  // Re-binds a definition already in the file being appended to, so the
+  // symbol keeps its id and is not defined a second time
+  bool Preload(const codec::SymbolRecord &d) {
+    return symbols_.Define(
+        d.symbol_id,
+        std::string_view{d.name,
+                         std::min<std::size_t>(d.name_len, sizeof(d.name))});
+  }
+
+private:
+  codec::SymbolTable symbols_;
+  std::uint64_t skipped_ = 0;
+};
+
+// RecordDecoder — records → (QuoteRecord, symbol) callbacks. Feed whole
+// records in file order; symbol definitions update the table and are not
+// reported. Unknown kinds are skipped (forward compatibility).
+class RecordDecoder {
+public:
+  // Decodes `count` records at `data`, calling fn(const QuoteRecord&,
+  // std::string_view symbol) per quote; returns the number of quotes.
+  template <typename Fn>
+  std::size_t Decode(const std::byte *data, std::size_t count, Fn &&fn) {
+    std::size_t quotes = 0;
+    for (std::size_t i = 0; i < count; ++i, data += kRecordSize) {
+      codec::QuoteRecord r;
+      std::memcpy(&r, data, kRecordSize);
+      if (BRANCH_LIKELY(r.kind == codec::kQuote)) {
+        fn(r, symbols_.Get(r.symbol_id));
+        ++quotes;
+      } else if (r.kind == codec::kSymbolDef) {
+        codec::SymbolRecord d;
+        std::memcpy(&d, data, kRecordSize);
+        symbols_.Define(d.symbol_id,
+                        std::string_view{d.name, std::min<std::size_t>(
+                                                     d.name_len,
+                                                     sizeof(d.name))});
+      }
+    }
+    return quotes;
+  }
+
+  const codec::SymbolTable &Symbols() const { return symbols_; }
+
+private:
+  codec::SymbolTable symbols_;
+};
+
+} // namespace capture
@@ -0,0 +1,407 @@
+#pragma once
+
+#include "capture/capture_format.hpp"
+#include "codec/binary_record.hpp"
+#include "codec/book_ticker.hpp"
+#include "codec/field_scan.hpp"
+#include "compress/seekable_reader.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <fcntl.h>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace capture {
+
+enum class CaptureFormat { ndjson, binary };
+
+// One indexed record: where it starts in the (decompressed) capture and the
+// two keys lookups need. Non-bookTicker lines and symbol definitions are not
+// indexed.
+struct RecordRef {
+  std::uint64_t offset;
+  std::uint64_t u;
+  std::int64_t event_ms; // exchange event time "E"
+};
+static_assert(sizeof(RecordRef) == 24);
+
+// RecordView — a record in place: `bytes` points into the reader's mapping
+// and stays valid for the reader's lifetime.
+struct RecordView {
+  std::string_view bytes;  // NDJSON line (no newline) or the 72-byte record
+  std::uint64_t u = 0;
+  std::int64_t event_ms = 0;
+  std::string_view symbol; // binary captures only; NDJSON: see Decode()
+  bool binary = false;
+
+  // Binary captures: the record itself (records are 8-byte aligned in the
+  // mapping); nullptr for NDJSON
+  const codec::QuoteRecord *Quote() const {
+    return binary ? reinterpret_cast<const codec::QuoteRecord *>(bytes.data())
+                  : nullptr;
+  }
+
+  // All bookTicker fields: ParseBookTicker for NDJSON, a field copy for
+  // binary records
+  std::optional<codec::BookTicker> Decode() const {
+    if (!binary) {
+      return codec::ParseBookTicker(bytes);
+    }
+    const codec::QuoteRecord &r = *Quote();
+    codec::BookTicker bt;
+    bt.u = r.u;
+    bt.symbol = symbol;
+    bt.bid_px = r.bid_px;
+    bt.bid_qty = r.bid_qty;
+    bt.ask_px = r.ask_px;
+    bt.ask_qty = r.ask_qty;
+    bt.event_ms = r.event_ms;
+    bt.trade_ms = r.trade_ms;
+    bt.px_decimals = static_cast<std::uint8_t>(r.decimals & 0x0F);
+    bt.qty_decimals = static_cast<std::uint8_t>(r.decimals >> 4);
+    return bt;
+  }
+};
+
+// CaptureReader — read side of what the file sinks write: NDJSON streams and
+// binary captures, plain or block-compressed (--compress).
+// Threading model:
+// - Open maps the file read-only; a compressed file is decoded frame by frame
+//   into an anonymous mapping by a pool of workers (frames are independent)
+// - BuildIndex splits the bytes into one range per worker at record
+//   boundaries, indexes the ranges concurrently (codec::ScanLines for NDJSON,
+//   fixed stride for binary), then stitches the partial indexes in parallel
+// - After BuildIndex the reader is immutable: At/ForEach/ParallelForEach may
+//   be called from any number of threads and copy nothing
+class CaptureReader {
+public:
+  // `threads` = 0 uses every online CPU
+  static std::expected<CaptureReader, std::error_code>
+  Open(const std::string &path, unsigned threads = 0) {
+    CaptureReader r;
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+      const int e = errno;
+      ::close(fd);
+      return std::unexpected(std::error_code(e, std::generic_category()));
+    }
+    const std::size_t len = static_cast<std::size_t>(st.st_size);
+    if (len != 0) {
+      void *m = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (m == MAP_FAILED) {
+        const int e = errno;
+        ::close(fd);
+        return std::unexpected(std::error_code(e, std::generic_category()));
+      }
+      (void)::madvise(m, len, MADV_SEQUENTIAL);
+      r.map_ = m;
+      r.map_len_ = len;
+      r.data_ = static_cast<const char *>(m);
+      r.size_ = len;
+    }
+    ::close(fd);
+    if (r.size_ >= 4) {
+      std::uint32_t magic = 0;
+      std::memcpy(&magic, r.data_, 4);
+      if (magic == 0xFD2FB528u || magic == 0x184D2204u ||
+          magic == compress::kCheckpointMagic) {
+        if (auto st2 = r.Inflate(path, Workers(threads)); !st2) {
+          return std::unexpected(st2.error());
+        }
+      }
+    }
+    if (HasMagic(r.data_, r.size_)) {
+      FileHeader h;
+      if (r.size_ < sizeof(h)) {
+        return std::unexpected(
+            std::make_error_code(std::errc::invalid_argument));
+      }
+      std::memcpy(&h, r.data_, sizeof(h));
+      if (auto v = ValidateHeader(h); !v) {
+        return std::unexpected(v.error());
+      }
+      r.format_ = CaptureFormat::binary;
+      r.body_ = sizeof(FileHeader);
+    }
+    return r;
+  }
+
+  CaptureReader(CaptureReader &&o) noexcept { *this = std::move(o); }
+  CaptureReader &operator=(CaptureReader &&o) noexcept {
+    std::swap(map_, o.map_);
+    std::swap(map_len_, o.map_len_);
+    std::swap(data_, o.data_);
+    std::swap(size_, o.size_);
+    std::swap(format_, o.format_);
+    std::swap(compressed_, o.compressed_);
+    std::swap(body_, o.body_);
+    index_.swap(o.index_);
+    std::swap(symbols_, o.symbols_);
+    std::swap(skipped_, o.skipped_);
+    return *this;
+  }
+  ~CaptureReader() {
+    if (map_ != nullptr) {
+      ::munmap(map_, map_len_);
+    }
+  }
+
+  CaptureFormat Format() const { return format_; }
+  bool Compressed() const { return compressed_; }
+  // Whole (decompressed) capture, header included
+  std::string_view Data() const { return {data_, size_}; }
+
+  // Offsets of `parts` + 1 record boundaries splitting the records into
+  // `parts` ranges of about equal size (some may be empty)
+  std::vector<std::size_t> Split(unsigned parts) const {
+    parts = std::max(parts, 1u);
+    std::vector<std::size_t> bounds(parts + 1, size_);
+    bounds[0] = std::min(body_, size_);
+    if (format_ == CaptureFormat::binary) {
+      const std::size_t n = (size_ - bounds[0]) / kRecordSize;
+      for (unsigned k = 0; k <= parts; ++k) {
+        bounds[k] = bounds[0] + (n * k / parts) * kRecordSize;
+      }
+      return bounds;
+    }
+    for (unsigned k = 1; k < parts; ++k) {
+      std::size_t at = std::max(bounds[0] + (size_ - bounds[0]) * k / parts,
+                                bounds[k - 1]);
+      const void *nl = at < size_ ? std::memchr(data_ + at, '\n', size_ - at)
+                                  : nullptr;
+      bounds[k] = nl == nullptr
+                      ? size_
+                      : static_cast<std::size_t>(
+                            static_cast<const char *>(nl) - data_) + 1;
+    }
+    return bounds;
+  }
+
+  // Indexes every record on `threads` workers (0 = every online CPU)
+  void BuildIndex(unsigned threads = 0) {
+    const unsigned parts = Workers(threads);
+    const std::vector<std::size_t> bounds = Split(parts);
+    std::vector<std::vector<RecordRef>> local(parts);
+    std::vector<std::vector<codec::SymbolRecord>> defs(parts);
+    std::vector<std::uint64_t> skipped(parts, 0);
+    RunWorkers(parts, [&](unsigned w) {
+      const char *begin = data_ + bounds[w];
+      const char *end = data_ + bounds[w + 1];
+      auto &out = local[w];
+      if (format_ == CaptureFormat::ndjson) {
+        out.reserve(static_cast<std::size_t>(end - begin) / 128);
+        codec::ScanLines(begin, end,
+                         [&](std::string_view line, const codec::LineKeys &k) {
+                           if (BRANCH_UNLIKELY(k.u == 0)) {
+                             ++skipped[w];
+                             return;
+                           }
+                           out.push_back(
+                               {static_cast<std::uint64_t>(line.data() - data_),
+                                k.u, k.event_ms});
+                         });
+        return;
+      }
+      out.reserve(static_cast<std::size_t>(end - begin) / kRecordSize);
+      for (const char *p = begin; p < end; p += kRecordSize) {
+        codec::QuoteRecord r;
+        std::memcpy(&r, p, kRecordSize);
+        if (BRANCH_LIKELY(r.kind == codec::kQuote)) {
+          out.push_back(
+              {static_cast<std::uint64_t>(p - data_), r.u, r.event_ms});
+        } else if (r.kind == codec::kSymbolDef) {
+          codec::SymbolRecord d;
+          std::memcpy(&d, p, kRecordSize);
+          defs[w].push_back(d);
+        } else {
+          ++skipped[w];
+        }
+      }
+    });
+    std::vector<std::size_t> at(parts + 1, 0);
+    for (unsigned w = 0; w < parts; ++w) {
+      at[w + 1] = at[w] + local[w].size();
+      skipped_ += skipped[w];
+      for (const auto &d : defs[w]) {
+        symbols_.Define(d.symbol_id,
+                        std::string_view{d.name, std::min<std::size_t>(
+                                                     d.name_len,
+                                                     sizeof(d.name))});
+      }
+    }
+    index_.resize(at[parts]);
+    RunWorkers(parts, [&](unsigned w) {
+      std::copy(local[w].begin(), local[w].end(), index_.begin() + at[w]);
+      std::vector<RecordRef>().swap(local[w]);
+    });
+  }
+
+  // Indexed records (after BuildIndex)
+  std::size_t Size() const { return index_.size(); }
+  const std::vector<RecordRef> &Index() const { return index_; }
+  // Lines without "u" / unknown record kinds left out of the index
+  std::uint64_t Skipped() const { return skipped_; }
+  // Symbols defined in a binary capture
+  const codec::SymbolTable &Symbols() const { return symbols_; }
+
+  RecordView At(std::size_t i) const {
+    const RecordRef &ref = index_[i];
+    RecordView v;
+    v.u = ref.u;
+    v.event_ms = ref.event_ms;
+    const char *p = data_ + ref.offset;
+    if (format_ == CaptureFormat::binary) {
+      v.binary = true;
+      v.bytes = {p, kRecordSize};
+      v.symbol = symbols_.Get(v.Quote()->symbol_id);
+      return v;
+    }
+    const std::size_t rest = size_ - ref.offset;
+    const void *nl = std::memchr(p, '\n', rest);
+    v.bytes = {p, nl == nullptr ? rest
+                                : static_cast<std::size_t>(
+                                      static_cast<const char *>(nl) - p)};
+    return v;
+  }
+
+  // First record with u >= `u` / event time >= `ms` (the merged stream is
+  // ordered by u, so both are binary searches); Size() if none
+  std::size_t LowerBoundU(std::uint64_t u) const {
+    return static_cast<std::size_t>(
+        std::lower_bound(index_.begin(), index_.end(), u,
+                         [](const RecordRef &r, std::uint64_t v) {
+                           return r.u < v;
+                         }) -
+        index_.begin());
+  }
+  std::size_t LowerBoundTime(std::int64_t ms) const {
+    return static_cast<std::size_t>(
+        std::lower_bound(index_.begin(), index_.end(), ms,
+                         [](const RecordRef &r, std::int64_t v) {
+                           return r.event_ms < v;
+                         }) -
+        index_.begin());
+  }
+
+  // fn(const RecordView&) for every record, in order, on the calling thread
+  template <typename Fn> void ForEach(Fn &&fn) const {
+    for (std::size_t i = 0; i < index_.size(); ++i) {
+      fn(At(i));
+    }
+  }
+
+  // fn(unsigned worker, const RecordView&) on `threads` workers, each given
+  // one contiguous run of records in order; per-worker results are the
+  // caller's to merge
+  template <typename Fn> void ParallelForEach(unsigned threads, Fn &&fn) const {
+    const unsigned parts = Workers(threads);
+    const std::size_t n = index_.size();
+    RunWorkers(parts, [&](unsigned w) {
+      const std::size_t end = n * (w + 1) / parts;
+      for (std::size_t i = n * w / parts; i < end; ++i) {
+        fn(w, At(i));
+      }
+    });
+  }
+
+  static unsigned Workers(unsigned threads) {
+    return threads != 0 ? threads
+                        : std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // Runs fn(0..n-1) on n threads (the caller's included) and joins them
+  template <typename Fn> static void RunWorkers(unsigned n, Fn &&fn) {
+    if (n == 1) {
+      fn(0u);
+      return;
+    }
+    std::vector<std::jthread> pool;
+    pool.reserve(n - 1);
+    for (unsigned w = 1; w < n; ++w) {
+      pool.emplace_back([&fn, w] { fn(w); });
+    }
+    fn(0u);
+  }
+
+private:
+  CaptureReader() = default;
+
+  // Replaces the compressed mapping by its decoded contents
+  std::expected<void, std::error_code> Inflate(const std::string &path,
+                                               unsigned threads) {
+    auto sr = compress::SeekableReader::Open(path);
+    if (!sr) {
+      // Compressed without a seek table (e.g. a gzip/zstd process sink)
+      return std::unexpected(std::make_error_code(std::errc::not_supported));
+    }
+    const std::size_t raw = static_cast<std::size_t>(sr->RawSize());
+    void *m = nullptr;
+    if (raw != 0) {
+      m = ::mmap(nullptr, raw, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (m == MAP_FAILED) {
+        return std::unexpected(
+            std::error_code(errno, std::generic_category()));
+      }
+    }
+    const auto &frames = sr->Frames();
+    const compress::BlockCodec &codec = sr->Decoder();
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool> ok{true};
+    RunWorkers(std::min<unsigned>(threads, std::max<std::size_t>(
+                                               frames.size(), 1)),
+               [&](unsigned) {
+                 for (std::size_t i = next++; i < frames.size(); i = next++) {
+                   const auto &f = frames[i];
+                   if (!codec.Decompress(data_ + f.offset, f.size,
+                                         static_cast<char *>(m) + f.raw_offset,
+                                         f.raw_size)) {
+                     ok = false;
+                   }
+                 }
+               });
+    ::munmap(map_, map_len_);
+    map_ = m;
+    map_len_ = raw;
+    data_ = static_cast<const char *>(m);
+    size_ = raw;
+    compressed_ = true;
+    if (!ok) {
+      return std::unexpected(std::make_error_code(std::errc::illegal_byte_sequence));
+    }
+    if (m != nullptr) {
+      (void)::mprotect(m, raw, PROT_READ);
+    }
+    return {};
+  }
+
+  void *map_ = nullptr;
+  std::size_t map_len_ = 0;
+  const char *data_ = nullptr;
+  std::size_t size_ = 0;
+  CaptureFormat format_ = CaptureFormat::ndjson;
+  bool compressed_ = false;
+  std::size_t body_ = 0; // first record byte (after a binary FileHeader)
+  std::vector<RecordRef> index_;
+  codec::SymbolTable symbols_;
+  std::uint64_t skipped_ = 0;
+};
+
+} // namespace capture
@@ -0,0 +1,343 @@
+#pragma once
+
+#include "capture/capture_reader.hpp"
+#include "capture/npy_column.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+// Columnar export of captures and latency series: a directory with one
+// NpyColumn per field. Timestamps are int64 nanoseconds, prices and sizes
+// stay fixed-point int64 (divide by codec::kFixedScale), and strings are
+// dictionary-encoded: `<name>.npy` holds small integer codes and
+// `<name>.dict.npy` the distinct values ('|S16', code = row).
+namespace capture {
+
+namespace detail {
+
+// Fixed-width dictionary column from `values`
+inline std::expected<void, std::error_code>
+WriteDictionary(const std::filesystem::path &dir, const std::string &name,
+                const std::vector<std::string> &values) {
+  auto col = NpyColumn::Create((dir / (name + ".dict.npy")).string(), "|S16",
+                               16, values.size());
+  if (!col) {
+    return std::unexpected(col.error());
+  }
+  char *out = col->Data<char>();
+  for (const auto &v : values) {
+    std::memset(out, 0, 16);
+    std::memcpy(out, v.data(), std::min<std::size_t>(v.size(), 16));
+    out += 16;
+  }
+  return {};
+}
+
+// Small string → code map for a handful of distinct values
+struct LocalDictionary {
+  std::vector<std::string> values;
+  std::uint16_t last = 0;
+
+  std::uint16_t Code(std::string_view v) {
+    if (BRANCH_LIKELY(last < values.size() && values[last] == v)) {
+      return last;
+    }
+    for (std::size_t i = 0; i < values.size(); ++i) {
+      if (values[i] == v) {
+        return last = static_cast<std::uint16_t>(i);
+      }
+    }
+    values.emplace_back(v);
+    return last = static_cast<std::uint16_t>(values.size() - 1);
+  }
+};
+
+} // namespace detail
+
+// Symbol code of rows that did not decode as a bookTicker
+inline constexpr std::uint16_t kNoSymbol = 0xFFFF;
+
+// Writes every indexed record of `reader` (BuildIndex done) to `dir`:
+//   u (<u8), event_ns, trade_ns, recv_ns (<i8; recv_ns is 0 for NDJSON),
+//   bid_px, bid_qty, ask_px, ask_qty (<i8, fixed-point 1e-8),
+//   symbol (<u2) + symbol.dict, src (|u1, producer connection; 0 for NDJSON)
+// Rows are filled on `threads` workers straight into the column mappings.
+// Returns the row count.
+inline std::expected<std::size_t, std::error_code>
+ExportCaptureColumns(const CaptureReader &reader,
+                     const std::filesystem::path &dir, unsigned threads = 0) {
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  if (ec) {
+    return std::unexpected(ec);
+  }
+  const std::size_t rows = reader.Size();
+  struct Spec {
+    const char *name;
+    const char *descr;
+    std::size_t width;
+  };
+  static constexpr Spec kSpecs[] = {
+      {"u", "<u8", 8},        {"event_ns", "<i8", 8}, {"trade_ns", "<i8", 8},
+      {"recv_ns", "<i8", 8},  {"bid_px", "<i8", 8},   {"bid_qty", "<i8", 8},
+      {"ask_px", "<i8", 8},   {"ask_qty", "<i8", 8},  {"symbol", "<u2", 2},
+      {"src", "|u1", 1}};
+  std::vector<NpyColumn> cols;
+  for (const Spec &s : kSpecs) {
+    auto c = NpyColumn::Create((dir / (std::string(s.name) + ".npy")).string(),
+                               s.descr, s.width, rows);
+    if (!c) {
+      return std::unexpected(c.error());
+    }
+    cols.push_back(std::move(*c));
+  }
+  auto *u = cols[0].Data<std::uint64_t>();
+  auto *eventNs = cols[1].Data<std::int64_t>();
+  auto *tradeNs = cols[2].Data<std::int64_t>();
+  auto *recvNs = cols[3].Data<std::int64_t>();
+  auto *bidPx = cols[4].Data<std::int64_t>();
+  auto *bidQty = cols[5].Data<std::int64_t>();
+  auto *askPx = cols[6].Data<std::int64_t>();
+  auto *askQty = cols[7].Data<std::int64_t>();
+  auto *symbol = cols[8].Data<std::uint16_t>();
+  auto *src = cols[9].Data<std::uint8_t>();
+
+  const bool binary = reader.Format() == CaptureFormat::binary;
+  const unsigned parts = CaptureReader::Workers(threads);
+  std::vector<detail::LocalDictionary> dicts(parts);
+  CaptureReader::RunWorkers(parts, [&](unsigned w) {
+    const std::size_t end = rows * (w + 1) / parts;
+    for (std::size_t i = rows * w / parts; i < end; ++i) {
+      const RecordView v = reader.At(i);
+      u[i] = v.u;
+      auto bt = v.Decode();
+      if (BRANCH_UNLIKELY(!bt.has_value())) {
+        eventNs[i] = v.event_ms * 1'000'000;
+        tradeNs[i] = recvNs[i] = bidPx[i] = bidQty[i] = askPx[i] = askQty[i] =
+            0;
+        symbol[i] = kNoSymbol;
+        src[i] = 0;
+        continue;
+      }
+      eventNs[i] = bt->event_ms * 1'000'000;
+      tradeNs[i] = bt->trade_ms * 1'000'000;
+      bidPx[i] = bt->bid_px;
+      bidQty[i] = bt->bid_qty;
+      askPx[i] = bt->ask_px;
+      askQty[i] = bt->ask_qty;
+      if (binary) {
+        const codec::QuoteRecord *q = v.Quote();
+        recvNs[i] = q->recv_ns;
+        symbol[i] = q->symbol_id;
+        src[i] = q->src;
+      } else {
+        recvNs[i] = 0;
+        symbol[i] = dicts[w].Code(bt->symbol);
+        src[i] = 0;
+      }
+    }
+  });
+
+  // Symbol dictionary: the capture's own ids for binary input; for NDJSON the
+  // workers' local codes are remapped to one table in first-seen order
+  std::vector<std::string> names;
+  if (binary) {
+    for (std::uint16_t id = 0; id < reader.Symbols().Size(); ++id) {
+      names.emplace_back(reader.Symbols().Get(id));
+    }
+  } else {
+    std::vector<std::vector<std::uint16_t>> remap(parts);
+    bool identity = true;
+    for (unsigned w = 0; w < parts; ++w) {
+      for (std::size_t k = 0; k < dicts[w].values.size(); ++k) {
+        const auto it = std::find(names.begin(), names.end(),
+                                  dicts[w].values[k]);
+        const auto code = static_cast<std::uint16_t>(it - names.begin());
+        if (it == names.end()) {
+          names.push_back(dicts[w].values[k]);
+        }
+        remap[w].push_back(code);
+        identity = identity && code == k;
+      }
+    }
+    if (!identity) {
+      CaptureReader::RunWorkers(parts, [&](unsigned w) {
+        const std::size_t end = rows * (w + 1) / parts;
+        for (std::size_t i = rows * w / parts; i < end; ++i) {
+          if (symbol[i] != kNoSymbol) {
+            symbol[i] = remap[w][symbol[i]];
+          }
+        }
+      });
+    }
+  }
+  if (auto st = detail::WriteDictionary(dir, "symbol", names); !st) {
+    return std::unexpected(st.error());
+  }
+  return rows;
+}
+
+// Latency file name as written by the runner (and the Python baseline):
+// `<kind>_[<conn>_]<YYYYMMDD_HHMMSS>.<ext>`, kind = async_conn | sync_conn |
+// python. Unknown names keep their stem as `run` with kind "other".
+struct LatencyFileName {
+  std::string kind = "other";
+  std::string run;
+  int conn = -1;
+};
+
+inline LatencyFileName ParseLatencyFileName(const std::filesystem::path &p) {
+  LatencyFileName n;
+  const std::string stem = p.stem().string();
+  n.run = stem;
+  for (const char *k : {"async_conn_", "sync_conn_", "python_"}) {
+    const std::string_view kind(k);
+    if (!stem.starts_with(kind)) {
+      continue;
+    }
+    std::string rest = stem.substr(kind.size());
+    // [<conn>_]YYYYMMDD_HHMMSS
+    const std::size_t first = rest.find('_');
+    if (first != std::string::npos && rest.size() - first - 1 >= 15 &&
+        first > 0 &&
+        std::all_of(rest.begin(), rest.begin() + static_cast<long>(first),
+                    [](char c) { return c >= '0' && c <= '9'; })) {
+      n.conn = std::stoi(rest.substr(0, first));
+      rest = rest.substr(first + 1);
+    }
+    n.kind = std::string(kind.substr(0, kind.size() - 1));
+    n.run = rest;
+    break;
+  }
+  return n;
+}
+
+namespace detail {
+
+// One latency line ("12", "3.25") → microseconds; false if not a number
+inline bool ParseLatencyUs(std::string_view s, std::int64_t &out) {
+  std::int64_t v = 0;
+  int frac = -1;
+  bool digits = false;
+  for (char c : s) {
+    if (c == '.' && frac < 0) {
+      frac = 0;
+    } else if (c >= '0' && c <= '9') {
+      digits = true;
+      if (frac < 0) {
+        v = v * 10 + (c - '0');
+      } else if (frac < 3) {
+        v = v * 10 + (c - '0');
+        ++frac;
+      }
+    } else if (c != '\r' && c != '-') {
+      return false;
+    }
+  }
+  for (int f = frac < 0 ? 0 : frac; f < 3; ++f) {
+    v *= 10;
+  }
+  out = v;
+  return digits;
+}
+
+} // namespace detail
+
+// Writes latency series (one `.lat` file per connection and run) to `dir`:
+//   lat_us (<i8), seq (<u4, sample index within its file, for warm-up cuts),
+//   conn (<i2, -1 when the name has none), kind (|u1) + kind.dict,
+//   run (<u2) + run.dict (the YYYYMMDD_HHMMSS of the run)
+// Files are parsed concurrently; rows keep the order of `files`. Returns the
+// row count.
+inline std::expected<std::size_t, std::error_code>
+ExportLatencyColumns(const std::vector<std::filesystem::path> &files,
+                     const std::filesystem::path &dir, unsigned threads = 0) {
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  if (ec) {
+    return std::unexpected(ec);
+  }
+  std::vector<std::vector<std::int64_t>> series(files.size());
+  std::atomic<std::size_t> next{0};
+  std::atomic<bool> ok{true};
+  CaptureReader::RunWorkers(
+      std::min<unsigned>(CaptureReader::Workers(threads),
+                         std::max<std::size_t>(files.size(), 1)),
+      [&](unsigned) {
+        for (std::size_t f = next++; f < files.size(); f = next++) {
+          std::ifstream in(files[f], std::ios::binary);
+          if (!in) {
+            ok = false;
+            continue;
+          }
+          const std::string text{std::istreambuf_iterator<char>(in),
+                                 std::istreambuf_iterator<char>()};
+          auto &out = series[f];
+          out.reserve(text.size() / 3);
+          std::size_t pos = 0;
+          while (pos < text.size()) {
+            std::size_t nl = text.find('\n', pos);
+            if (nl == std::string::npos) {
+              nl = text.size();
+            }
+            std::int64_t us = 0;
+            if (detail::ParseLatencyUs({text.data() + pos, nl - pos}, us)) {
+              out.push_back(us);
+            }
+            pos = nl + 1;
+          }
+        }
+      });
+  if (!ok) {
+    return std::unexpected(
+        std::make_error_code(std::errc::no_such_file_or_directory));
+  }
+  std::size_t rows = 0;
+  for (const auto &s : series) {
+    rows += s.size();
+  }
+  auto lat = NpyColumn::Create((dir / "lat_us.npy").string(), "<i8", 8, rows);
+  auto seq = NpyColumn::Create((dir / "seq.npy").string(), "<u4", 4, rows);
+  auto conn = NpyColumn::Create((dir / "conn.npy").string(), "<i2", 2, rows);
+  auto kind = NpyColumn::Create((dir / "kind.npy").string(), "|u1", 1, rows);
+  auto run = NpyColumn::Create((dir / "run.npy").string(), "<u2", 2, rows);
+  for (auto *c : {&lat, &seq, &conn, &kind, &run}) {
+    if (!*c) {
+      return std::unexpected(c->error());
+    }
+  }
+  detail::LocalDictionary kinds;
+  detail::LocalDictionary runs;
+  std::size_t row = 0;
+  for (std::size_t f = 0; f < files.size(); ++f) {
+    const LatencyFileName name = ParseLatencyFileName(files[f]);
+    const auto k = static_cast<std::uint8_t>(kinds.Code(name.kind));
+    const std::uint16_t r = runs.Code(name.run);
+    const auto &s = series[f];
+    std::copy(s.begin(), s.end(), lat->Data<std::int64_t>() + row);
+    for (std::size_t i = 0; i < s.size(); ++i, ++row) {
+      seq->Data<std::uint32_t>()[row] = static_cast<std::uint32_t>(i);
+      conn->Data<std::int16_t>()[row] = static_cast<std::int16_t>(name.conn);
+      kind->Data<std::uint8_t>()[row] = k;
+      run->Data<std::uint16_t>()[row] = r;
+    }
+  }
+  if (auto st = detail::WriteDictionary(dir, "kind", kinds.values); !st) {
+    return std::unexpected(st.error());
+  }
+  if (auto st = detail::WriteDictionary(dir, "run", runs.values); !st) {
+    return std::unexpected(st.error());
+  }
+  return rows;
+}
+
+} // namespace capture
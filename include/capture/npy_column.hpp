@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <expected>
+#include <fcntl.h>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+
+namespace capture {
+
+// NpyColumn — one column of a columnar export: a NumPy .npy (format 1.0)
+// file holding `rows` fixed-width values. The row count is known up front,
+// so the file is sized once and filled through a shared writable mapping;
+// workers fill disjoint row ranges concurrently with no locking. Readers
+// get it back with np.load(path, mmap_mode='r') — no parsing, no copy.
+// `descr` is a NumPy type string: '<i8', '<u8', '<u2', '|u1', '|S16', ...
+class NpyColumn {
+public:
+  static std::expected<NpyColumn, std::error_code>
+  Create(const std::string &path, std::string_view descr, std::size_t width,
+         std::size_t rows) {
+    // Header: magic, version, u16 length, Python dict literal padded with
+    // spaces to a 64-byte boundary and terminated by '\n'
+    char dict[128];
+    const int n = std::snprintf(
+        dict, sizeof(dict),
+        "{'descr': '%.*s', 'fortran_order': False, 'shape': (%zu,), }",
+        static_cast<int>(descr.size()), descr.data(), rows);
+    if (n < 0 || static_cast<std::size_t>(n) + 11 > kHeaderBytes) {
+      return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+    char header[kHeaderBytes];
+    std::memset(header, ' ', sizeof(header));
+    std::memcpy(header, "\x93NUMPY\x01\x00", 8);
+    const std::uint16_t len = kHeaderBytes - 10;
+    std::memcpy(header + 8, &len, 2);
+    std::memcpy(header + 10, dict, static_cast<std::size_t>(n));
+    header[kHeaderBytes - 1] = '\n';
+
+    NpyColumn c;
+    c.fd_ = ::open(path.c_str(), O_CREAT | O_RDWR | O_TRUNC | O_CLOEXEC, 0644);
+    if (c.fd_ == -1) {
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    c.len_ = kHeaderBytes + width * rows;
+    if (::ftruncate(c.fd_, static_cast<off_t>(c.len_)) != 0) {
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    void *m = ::mmap(nullptr, c.len_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     c.fd_, 0);
+    if (m == MAP_FAILED) {
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    c.map_ = static_cast<char *>(m);
+    std::memcpy(c.map_, header, kHeaderBytes);
+    return c;
+  }
+
+  NpyColumn(NpyColumn &&o) noexcept { *this = std::move(o); }
+  NpyColumn &operator=(NpyColumn &&o) noexcept {
+    std::swap(fd_, o.fd_);
+    std::swap(map_, o.map_);
+    std::swap(len_, o.len_);
+    return *this;
+  }
+  ~NpyColumn() {
+    if (map_ != nullptr) {
+      ::munmap(map_, len_);
+    }
+    if (fd_ != -1) {
+      ::close(fd_);
+    }
+  }
+
+  // Row storage (row i at Data<T>()[i])
+  template <typename T> T *Data() {
+    return reinterpret_cast<T *>(map_ + kHeaderBytes);
+  }
+
+private:
+  // Fixed so the values start 64-byte aligned whatever the row count
+  static constexpr std::size_t kHeaderBytes = 128;
+
+  NpyColumn() = default;
+
+  int fd_ = -1;
+  char *map_ = nullptr;
+  std::size_t len_ = 0;
+};
+
+} // namespace capture
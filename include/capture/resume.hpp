@@ -0,0 +1,253 @@
+#pragma once
+
+#include "capture/capture_format.hpp"
+#include "capture/segment_index.hpp"
+#include "codec/binary_record.hpp"
+#include "codec/field_scan.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <expected>
+#include <fcntl.h>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+#include <vector>
+
+// Warm restart of an existing output. FindResumePoint inspects what a
+// previous run left behind, cuts a record torn by the crash and reports where
+// the stream stopped, so the new run appends to the same file (or continues
+// with the next segment) and its merger drops everything up to `last_u`.
+// Only the tail is read for NDJSON; a binary capture is also walked once for
+// its symbol definitions so appended quotes keep the ids already on disk.
+namespace capture {
+
+struct ResumePoint {
+  bool found = false;          // an earlier output exists
+  std::uint64_t last_u = 0;    // last update id on disk (0 = none)
+  std::uint64_t bytes = 0;     // output size after truncation (append offset)
+  std::uint64_t truncated = 0; // torn bytes cut off the end
+  std::uint32_t next_segment = 0; // segmented outputs: sequence to open next
+  std::vector<codec::SymbolRecord> symbols; // binary: definitions on disk
+};
+
+namespace detail {
+
+inline std::error_code Errno() {
+  return std::error_code(errno, std::generic_category());
+}
+
+// Last '\n'-terminated line of an NDJSON file: cuts a torn tail and reads `u`
+// of the line before it. Reads backwards from the end in growing windows, so
+// the cost is one or two pread(2)s whatever the file size.
+inline std::expected<void, std::error_code> ResumeNdjson(int fd,
+                                                         ResumePoint &rp) {
+  std::vector<char> buf;
+  std::size_t window = 64u << 10;
+  const std::uint64_t size = rp.bytes;
+  for (;;) {
+    const std::uint64_t from = size > window ? size - window : 0;
+    buf.resize(static_cast<std::size_t>(size - from));
+    if (::pread(fd, buf.data(), buf.size(), static_cast<off_t>(from)) !=
+        static_cast<ssize_t>(buf.size())) {
+      return std::unexpected(Errno());
+    }
+    const char *b = buf.data();
+    const char *e = b + buf.size();
+    // End of the last whole line
+    const char *nl = e;
+    while (nl > b && nl[-1] != '\n') {
+      --nl;
+    }
+    if (nl == b && from != 0) {
+      window *= 4;
+      continue; // no newline in the window yet
+    }
+    // Start of that line
+    const char *line = nl > b ? nl - 1 : b;
+    while (line > b && line[-1] != '\n') {
+      --line;
+    }
+    if (line == b && from != 0 && nl > b) {
+      window *= 4;
+      continue; // the line starts before the window
+    }
+    rp.truncated = static_cast<std::uint64_t>(e - nl);
+    rp.bytes = from + static_cast<std::uint64_t>(nl - b);
+    codec::ScanLines(line, nl, [&](std::string_view, const codec::LineKeys &k) {
+      if (k.u != 0) {
+        rp.last_u = k.u;
+      }
+    });
+    return {};
+  }
+}
+
+// A zero-filled slot: never a real record (kind kQuote is 0, but every quote
+// has a non-zero `u`)
+inline bool ZeroRecord(const std::byte *r) {
+  std::uint64_t u;
+  std::memcpy(&u, r, sizeof(u));
+  if (u != 0) {
+    return false;
+  }
+  return std::all_of(r, r + kRecordSize,
+                     [](std::byte b) { return b == std::byte{0}; });
+}
+
+// Binary capture: keeps the header and whole records, the last quote's `u`
+// and every symbol definition. A crashed --writer mmap capture ends in the
+// zero-filled tail of its preallocated segment; the first all-zero record
+// is where the data stopped, so the file is cut there
+inline std::expected<void, std::error_code> ResumeBinary(int fd,
+                                                         ResumePoint &rp) {
+  if (rp.bytes < sizeof(FileHeader)) {
+    rp.truncated = rp.bytes; // torn header: start the file over
+    rp.bytes = 0;
+    return {};
+  }
+  FileHeader h;
+  if (::pread(fd, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h))) {
+    return std::unexpected(Errno());
+  }
+  const auto *hb = reinterpret_cast<const std::byte *>(&h);
+  if (std::all_of(hb, hb + sizeof(h),
+                  [](std::byte b) { return b == std::byte{0}; })) {
+    rp.truncated = rp.bytes; // crashed before the header: start over
+    rp.bytes = 0;
+    return {};
+  }
+  if (auto st = ValidateHeader(h); !st) {
+    return std::unexpected(st.error());
+  }
+  std::uint64_t records = (rp.bytes - sizeof(FileHeader)) / kRecordSize;
+  const std::uint64_t mapped = sizeof(FileHeader) + records * kRecordSize;
+  if (records != 0) {
+    void *m = ::mmap(nullptr, mapped, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m == MAP_FAILED) {
+      return std::unexpected(Errno());
+    }
+    (void)::madvise(m, mapped, MADV_SEQUENTIAL);
+    const auto *rec = static_cast<const std::byte *>(m) + sizeof(FileHeader);
+    // Only `kind` is looked at per record; definitions are rare
+    constexpr std::size_t kKindOff = offsetof(codec::QuoteRecord, kind);
+    constexpr std::uint64_t kNone = ~std::uint64_t{0};
+    std::uint64_t lastQuote = kNone;
+    for (std::uint64_t i = 0; i < records; ++i) {
+      const std::byte *r = rec + i * kRecordSize;
+      std::uint32_t kind;
+      std::memcpy(&kind, r + kKindOff, sizeof(kind));
+      if (BRANCH_UNLIKELY(kind == codec::kSymbolDef)) {
+        codec::SymbolRecord d;
+        std::memcpy(&d, r, kRecordSize);
+        rp.symbols.push_back(d);
+      } else if (kind == codec::kQuote) {
+        if (BRANCH_UNLIKELY(ZeroRecord(r))) {
+          records = i; // preallocated tail
+          break;
+        }
+        lastQuote = i;
+      }
+    }
+    if (lastQuote != kNone) {
+      codec::QuoteRecord q;
+      std::memcpy(&q, rec + lastQuote * kRecordSize, kRecordSize);
+      rp.last_u = q.u;
+    }
+    ::munmap(m, mapped);
+  }
+  const std::uint64_t whole = sizeof(FileHeader) + records * kRecordSize;
+  rp.truncated = rp.bytes - whole;
+  rp.bytes = whole;
+  return {};
+}
+
+// Resumes one plain (not compressed) output file in place
+inline std::expected<ResumePoint, std::error_code>
+ResumeFile(const std::string &path, bool binary) {
+  ResumePoint rp;
+  const int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+  if (fd == -1) {
+    if (errno == ENOENT) {
+      return rp; // nothing to resume: a fresh output
+    }
+    return std::unexpected(Errno());
+  }
+  struct stat st{};
+  if (::fstat(fd, &st) != 0) {
+    const auto ec = Errno();
+    ::close(fd);
+    return std::unexpected(ec);
+  }
+  rp.found = true;
+  rp.bytes = static_cast<std::uint64_t>(st.st_size);
+  std::expected<void, std::error_code> r;
+  if (rp.bytes != 0) {
+    r = binary ? ResumeBinary(fd, rp) : ResumeNdjson(fd, rp);
+  }
+  if (r && rp.truncated != 0 &&
+      ::ftruncate(fd, static_cast<off_t>(rp.bytes)) != 0) {
+    r = std::unexpected(Errno());
+  }
+  ::close(fd);
+  if (!r) {
+    return std::unexpected(r.error());
+  }
+  return rp;
+}
+
+// "<stem>.000012.idx" → 12
+inline std::uint32_t SegmentSeq(const std::string &indexPath) {
+  const std::size_t end = indexPath.size() - 4; // ".idx"
+  const std::size_t dot = indexPath.rfind('.', end - 1);
+  return static_cast<std::uint32_t>(
+      std::strtoul(indexPath.c_str() + dot + 1, nullptr, 10));
+}
+
+} // namespace detail
+
+// Where the output at `path` (as the primary output or a file/bin sink would
+// write it) left off. Segmented outputs are never appended to: the last
+// segment keeps its index and the run continues with the next sequence;
+// `last_u` comes from that index, or from the data file itself when it is
+// uncompressed and was written past the index's last update. A single
+// compressed file cannot be resumed (its seek table ends the file).
+inline std::expected<ResumePoint, std::error_code>
+FindResumePoint(const std::string &path, bool binary, bool compressed,
+                bool segmented) {
+  if (!segmented) {
+    if (compressed) {
+      return std::unexpected(std::make_error_code(std::errc::not_supported));
+    }
+    return detail::ResumeFile(path, binary);
+  }
+  const std::vector<SegmentIndex> segs = LoadSegments(SplitExt(path).first);
+  ResumePoint rp;
+  if (segs.empty()) {
+    return rp;
+  }
+  const SegmentIndex &last = segs.back();
+  rp.found = true;
+  rp.next_segment = detail::SegmentSeq(last.index_path) + 1;
+  for (auto it = segs.rbegin(); it != segs.rend() && rp.last_u == 0; ++it) {
+    rp.last_u = it->header.last_u; // an empty last segment: look further back
+  }
+  if ((last.header.flags & kIndexCompressed) == 0 && !last.data_path.empty()) {
+    auto tail = detail::ResumeFile(last.data_path,
+                                   (last.header.flags & kIndexBinary) != 0);
+    if (!tail) {
+      return std::unexpected(tail.error());
+    }
+    rp.last_u = std::max(rp.last_u, tail->last_u);
+    rp.truncated = tail->truncated;
+  }
+  return rp;
+}
+
+} // namespace capture
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <expected>
+#include <fcntl.h>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// Sidecar index of one capture segment (`<stem>.<seq>.idx` next to
+// `<stem>.<seq>.<ext>`): a fixed header with the segment's u/time range,
+// then one IndexEntry per ~stride bytes of output, in stream order. Offsets
+// are logical (uncompressed) byte offsets of a message start, so they apply
+// to compressed segments through compress::SeekableReader as well.
+namespace capture {
+
+inline constexpr char kIndexMagic[8] = {'W', 'H', 'Q', 'I', 'D', 'X', '\0',
+                                        '\0'};
+inline constexpr std::uint16_t kIndexVersion = 1;
+
+enum IndexFlags : std::uint16_t {
+  kIndexBinary = 1,     // segment is a binary capture (capture_format.hpp)
+  kIndexCompressed = 2, // segment is block-compressed (seekable frames)
+  kIndexClosed = 4,     // header totals are final
+};
+
+struct IndexHeader {
+  char magic[8];
+  std::uint16_t version;
+  std::uint16_t flags;  // IndexFlags
+  std::uint32_t stride; // target bytes between entries
+  std::int64_t created_ns;
+  std::uint64_t first_u;
+  std::uint64_t last_u;
+  std::int64_t first_ms; // exchange event time "E"
+  std::int64_t last_ms;
+  std::uint64_t messages;
+  std::uint64_t bytes;
+  std::uint8_t reserved[24];
+};
+static_assert(sizeof(IndexHeader) == 96, "IndexHeader layout changed");
+
+struct IndexEntry {
+  std::uint64_t u;
+  std::int64_t event_ms;
+  std::uint64_t offset;
+};
+static_assert(sizeof(IndexEntry) == 24, "IndexEntry layout changed");
+
+// IndexWriter — appends entries with write(2) in 4 KiB batches; the header
+// is rewritten in place on Flush and Close so a crashed capture still has a
+// usable (if slightly stale) range.
+class IndexWriter {
+public:
+  static std::expected<IndexWriter, std::error_code>
+  Create(const std::string &path, std::uint16_t flags, std::uint32_t stride,
+         std::int64_t createdNs) {
+    IndexWriter w;
+    w.fd_ = ::open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC,
+                   0644);
+    if (w.fd_ == -1) {
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    std::memcpy(w.h_.magic, kIndexMagic, sizeof(kIndexMagic));
+    w.h_.version = kIndexVersion;
+    w.h_.flags = flags;
+    w.h_.stride = stride;
+    w.h_.created_ns = createdNs;
+    w.WriteHeader();
+    (void)::lseek(w.fd_, sizeof(IndexHeader), SEEK_SET); // entries follow
+    return w;
+  }
+
+  IndexWriter() = default;
+  IndexWriter(IndexWriter &&o) noexcept { *this = std::move(o); }
+  IndexWriter &operator=(IndexWriter &&o) noexcept {
+    std::swap(fd_, o.fd_);
+    std::swap(h_, o.h_);
+    pending_.swap(o.pending_);
+    std::swap(entries_, o.entries_);
+    return *this;
+  }
+  ~IndexWriter() { Close(); }
+
+  void Add(std::uint64_t u, std::int64_t eventMs, std::uint64_t offset) {
+    if (entries_++ == 0) {
+      h_.first_u = u;
+      h_.first_ms = eventMs;
+    }
+    pending_.push_back({u, eventMs, offset});
+    if (pending_.size() * sizeof(IndexEntry) >= 4096) {
+      WriteEntries();
+    }
+  }
+
+  // Segment totals, reported by the owner as messages are written
+  void Update(std::uint64_t lastU, std::int64_t lastMs, std::uint64_t messages,
+              std::uint64_t bytes) {
+    h_.last_u = lastU;
+    if (lastMs != 0) {
+      h_.last_ms = lastMs;
+    }
+    h_.messages = messages;
+    h_.bytes = bytes;
+  }
+
+  void Flush() {
+    if (fd_ == -1) {
+      return;
+    }
+    WriteEntries();
+    WriteHeader();
+  }
+
+  void Close() {
+    if (fd_ == -1) {
+      return;
+    }
+    h_.flags |= kIndexClosed;
+    Flush();
+    ::close(fd_);
+    fd_ = -1;
+  }
+
+private:
+  void WriteEntries() {
+    if (!pending_.empty()) {
+      (void)::write(fd_, pending_.data(), pending_.size() * sizeof(IndexEntry));
+      pending_.clear();
+    }
+  }
+  void WriteHeader() { (void)::pwrite(fd_, &h_, sizeof(h_), 0); }
+
+  int fd_ = -1;
+  IndexHeader h_{};
+  std::vector<IndexEntry> pending_;
+  std::uint64_t entries_ = 0;
+};
+
+// SegmentIndex — one loaded .idx file
+struct SegmentIndex {
+  std::string index_path;
+  std::string data_path; // empty if the segment file is missing
+  IndexHeader header{};
+  std::vector<IndexEntry> entries;
+
+  static std::expected<SegmentIndex, std::error_code>
+  Load(const std::string &path) {
+    SegmentIndex s;
+    s.index_path = path;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    const off_t end = ::lseek(fd, 0, SEEK_END);
+    bool ok = end >= static_cast<off_t>(sizeof(IndexHeader)) &&
+              ::pread(fd, &s.header, sizeof(s.header), 0) ==
+                  static_cast<ssize_t>(sizeof(s.header)) &&
+              std::memcmp(s.header.magic, kIndexMagic, 8) == 0 &&
+              s.header.version == kIndexVersion;
+    if (ok) {
+      const std::size_t n =
+          (static_cast<std::size_t>(end) - sizeof(IndexHeader)) /
+          sizeof(IndexEntry);
+      s.entries.resize(n);
+      ok = n == 0 || ::pread(fd, s.entries.data(), n * sizeof(IndexEntry),
+                             sizeof(IndexHeader)) ==
+                         static_cast<ssize_t>(n * sizeof(IndexEntry));
+    }
+    ::close(fd);
+    if (!ok) {
+      return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+    // A segment cut short by a crash: derive the range from the entries
+    if (s.header.last_u == 0 && !s.entries.empty()) {
+      s.header.last_u = s.entries.back().u;
+      s.header.last_ms = s.entries.back().event_ms;
+    }
+    return s;
+  }
+
+  // Last entry at or before `u` (the scan for `u` starts there)
+  std::size_t FindU(std::uint64_t u) const {
+    auto it = std::upper_bound(
+        entries.begin(), entries.end(), u,
+        [](std::uint64_t v, const IndexEntry &e) { return v < e.u; });
+    return it == entries.begin() ? 0
+                                 : static_cast<std::size_t>(
+                                       it - entries.begin() - 1);
+  }
+
+  // Last entry with event time strictly before `ms`
+  std::size_t FindTime(std::int64_t ms) const {
+    auto it = std::lower_bound(
+        entries.begin(), entries.end(), ms,
+        [](const IndexEntry &e, std::int64_t v) { return e.event_ms < v; });
+    return it == entries.begin() ? 0
+                                 : static_cast<std::size_t>(
+                                       it - entries.begin() - 1);
+  }
+};
+
+// Segment file names: `<stem>.<seq>.<ext>` with a zero-padded sequence, so
+// lexical order is capture order
+inline std::string SegmentPath(const std::string &stem, const std::string &ext,
+                               std::uint32_t seq) {
+  char num[16];
+  std::snprintf(num, sizeof(num), "%06u", seq);
+  return stem + "." + num + ext;
+}
+
+// Splits "dir/stream.ndjson" into stem "dir/stream" and ext ".ndjson"
+inline std::pair<std::string, std::string> SplitExt(const std::string &path) {
+  const std::size_t slash = path.rfind('/');
+  const std::size_t dot = path.rfind('.');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+    return {path, ""};
+  }
+  return {path.substr(0, dot), path.substr(dot)};
+}
+
+// Loads every segment index of `stem`, ordered by sequence number
+inline std::vector<SegmentIndex> LoadSegments(const std::string &stem) {
+  namespace fs = std::filesystem;
+  const fs::path p(stem);
+  const fs::path dir = p.has_parent_path() ? p.parent_path() : fs::path(".");
+  const std::string prefix = p.filename().string() + ".";
+  std::vector<std::string> paths;
+  std::error_code ec;
+  for (const auto &de : fs::directory_iterator(dir, ec)) {
+    const std::string name = de.path().filename().string();
+    if (name.size() > prefix.size() + 4 && name.starts_with(prefix) &&
+        name.ends_with(".idx")) {
+      paths.push_back(de.path().string());
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+  std::vector<SegmentIndex> out;
+  for (const auto &ip : paths) {
+    auto s = SegmentIndex::Load(ip);
+    if (!s) {
+      continue;
+    }
+    // Data file: same name with the .idx replaced by any other extension
+    const std::string base = ip.substr(0, ip.size() - 4);
+    if (fs::exists(base, ec)) {
+      s->data_path = base;
+    }
+    for (const auto &de : fs::directory_iterator(dir, ec)) {
+      const std::string cand = de.path().string();
+      if (s->data_path.empty() && cand != ip &&
+          cand.starts_with(base + ".")) {
+        s->data_path = cand;
+        break;
+      }
+    }
+    out.push_back(std::move(*s));
+  }
+  return out;
+}
+
+} // namespace capture
@@ -0,0 +1,320 @@
+#pragma once
+
+#include "io/open_writer.hpp"
+#include "io/writer.hpp"
+#include "util/branch.hpp"
+#include "util/cpu_affinity.hpp"
+#include <atomic>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <fcntl.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Raw wire capture — every WebSocket message exactly as a session received
+// it, before the merger parses, reorders or drops anything. One file per
+// connection (little-endian):
+//   WireFileHeader (64 bytes) | WireRecordHeader (32) payload | ...
+// Records are not padded; `seq` counts every message the session read, so a
+// gap in `seq` marks messages lost to a full tap ring.
+namespace capture {
+
+inline constexpr char kWireMagic[8] = {'W', 'H', 'Q', 'W', 'I', 'R', 'E', '\0'};
+inline constexpr std::uint16_t kWireVersion = 1;
+
+struct WireFileHeader {
+  char magic[8];
+  std::uint16_t version;   // kWireVersion
+  std::uint16_t reserved0;
+  std::uint32_t conn;      // session index
+  std::int64_t created_ns; // wall clock at creation (UTC)
+  std::int64_t mono_ns;    // steady clock at creation (same instant)
+  std::uint8_t reserved[32];
+};
+static_assert(sizeof(WireFileHeader) == 64, "WireFileHeader layout changed");
+
+struct WireRecordHeader {
+  std::uint32_t len;     // payload bytes
+  std::uint32_t conn;    // session index
+  std::uint64_t seq;     // per-connection message number, 0-based
+  std::int64_t recv_ns;  // wall clock right after the read (epoch ns)
+  std::int64_t mono_ns;  // steady clock, same instant (inter-arrival timing)
+};
+static_assert(sizeof(WireRecordHeader) == 32, "WireRecordHeader layout changed");
+
+inline std::int64_t MonoNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// WireTap
+// Threading model:
+// - The session that owns the connection is the single producer: Record()
+//   copies one message into a byte SPSC ring and never blocks or allocates;
+//   when the ring is full the message is counted as dropped instead
+// - The WireRecorder thread is the single consumer and writes the ring
+//   contents to the connection's file as an opaque byte stream
+class WireTap {
+public:
+  WireTap(std::uint32_t conn, std::size_t ringBytes)
+      : conn_(conn), ring_(ringBytes) {}
+
+  // Session thread, right after the read completed
+  void Record(std::int64_t recvNs, const void *data, std::size_t len) {
+    const WireRecordHeader h{static_cast<std::uint32_t>(len), conn_, seq_++,
+                             recvNs, MonoNanos()};
+    if (BRANCH_UNLIKELY(ring_.write_available() < sizeof(h) + len)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    // Room was checked above and only this thread writes, so both pushes
+    // complete. The consumer copies bytes without parsing them, so it may
+    // take the header in one chunk and the payload in the next.
+    ring_.push(reinterpret_cast<const char *>(&h), sizeof(h));
+    ring_.push(static_cast<const char *>(data), len);
+    recorded_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  std::uint32_t Conn() const { return conn_; }
+  std::uint64_t Recorded() const {
+    return recorded_.load(std::memory_order_relaxed);
+  }
+  std::uint64_t Dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+private:
+  friend class WireRecorder;
+  using Ring = boost::lockfree::spsc_queue<char>;
+
+  std::uint32_t conn_;
+  std::uint64_t seq_ = 0; // producer-only
+  Ring ring_;
+  alignas(64) std::atomic<std::uint64_t> recorded_{0};
+  std::atomic<std::uint64_t> dropped_{0};
+};
+
+// WireRecorder
+// Threading model:
+// - One background std::jthread drains every tap round-robin in large
+//   chunks and appends them to the per-connection files through an
+//   io::IWriter; the byte stream is copied as is, records may straddle
+//   chunk boundaries
+// - Taps are added before Start(); Join() drains what the sessions recorded
+//   up to that point and closes the files
+class WireRecorder {
+public:
+  struct Config {
+    std::size_t ring_bytes = 8u << 20; // per connection
+    io::WriterKind writer = io::WriterKind::write;
+    std::shared_ptr<io::SyncService> sync; // durability of the files
+  };
+
+  WireRecorder() = default;
+  explicit WireRecorder(Config cfg) : cfg_(cfg) {}
+  ~WireRecorder() { Join(); }
+
+  // Creates `path` (truncating), writes its header and returns the tap the
+  // session records into
+  std::expected<std::shared_ptr<WireTap>, std::error_code>
+  AddConnection(std::uint32_t conn, const std::string &path) {
+    auto w = io::OpenWriter(path, cfg_.writer, /*append=*/false, std::nullopt,
+                            cfg_.sync.get());
+    if (!w) {
+      return std::unexpected(w.error());
+    }
+    WireFileHeader h{};
+    std::memcpy(h.magic, kWireMagic, sizeof(kWireMagic));
+    h.version = kWireVersion;
+    h.conn = conn;
+    h.created_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+    h.mono_ns = MonoNanos();
+    (*w)->Write(&h, sizeof(h));
+    (*w)->Flush();
+    auto tap = std::make_shared<WireTap>(conn, cfg_.ring_bytes);
+    taps_.push_back(tap);
+    writers_.push_back(std::move(*w));
+    return tap;
+  }
+
+  const std::vector<std::shared_ptr<WireTap>> &Taps() const { return taps_; }
+
+  void Start(std::optional<int> pinCpu = std::nullopt) {
+    if (running_.exchange(true)) {
+      return;
+    }
+    chunk_.resize(kChunkBytes);
+    worker_ = std::jthread([this, pinCpu] {
+#ifdef __linux__
+      if (pinCpu.has_value()) {
+        CpuAffinity::PinThisThreadToCpu("wire_capture", *pinCpu);
+      } else {
+        CpuAffinity::PickAndPin("wire_capture");
+      }
+#endif
+      RunLoop();
+    });
+  }
+
+  // Call after the sessions stopped producing
+  void Join() {
+    running_.store(false, std::memory_order_relaxed);
+    if (worker_.joinable()) {
+      worker_.join();
+    }
+    for (auto &w : writers_) {
+      if (w) {
+        w->Flush();
+      }
+    }
+  }
+
+private:
+  static constexpr std::size_t kChunkBytes = 256u << 10;
+  // Idle wait between empty passes: the files trail the wire by at most
+  // this much, and an idle recorder does not burn a core
+  static constexpr std::chrono::microseconds kIdleSleep{500};
+
+  void RunLoop() {
+    while (running_.load(std::memory_order_relaxed)) {
+      if (DrainAll() == 0) {
+        std::this_thread::sleep_for(kIdleSleep);
+      }
+    }
+    DrainAll();
+  }
+
+  std::size_t DrainAll() {
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < taps_.size(); ++i) {
+      std::size_t n;
+      std::size_t drained = 0;
+      while ((n = taps_[i]->ring_.pop(chunk_.data(), chunk_.size())) != 0) {
+        writers_[i]->Write(chunk_.data(), n);
+        drained += n;
+      }
+      if (drained != 0) {
+        writers_[i]->Flush();
+        total += drained;
+      }
+    }
+    return total;
+  }
+
+  Config cfg_;
+  std::vector<std::shared_ptr<WireTap>> taps_;
+  std::vector<std::unique_ptr<io::IWriter>> writers_;
+  std::vector<char> chunk_;
+  std::jthread worker_;
+  std::atomic<bool> running_{false};
+};
+
+// One record of a wire file; `payload` points into the mapping
+struct WireRecord {
+  WireRecordHeader h;
+  std::string_view payload;
+};
+
+// WireFile — read-only mapping of one wire capture. A file cut short by a
+// crash is valid up to its last whole record.
+class WireFile {
+public:
+  static std::expected<WireFile, std::error_code> Open(const std::string &path) {
+    WireFile f;
+    f.fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (f.fd_ == -1) {
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    struct stat st{};
+    if (::fstat(f.fd_, &st) != 0) {
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    f.len_ = static_cast<std::size_t>(st.st_size);
+    if (f.len_ < sizeof(WireFileHeader)) {
+      return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+    void *m = ::mmap(nullptr, f.len_, PROT_READ, MAP_PRIVATE, f.fd_, 0);
+    if (m == MAP_FAILED) {
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    f.map_ = static_cast<const char *>(m);
+    (void)::madvise(const_cast<char *>(f.map_), f.len_, MADV_SEQUENTIAL);
+    std::memcpy(&f.header_, f.map_, sizeof(f.header_));
+    if (std::memcmp(f.header_.magic, kWireMagic, sizeof(kWireMagic)) != 0) {
+      return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+    if (f.header_.version != kWireVersion) {
+      return std::unexpected(std::make_error_code(std::errc::not_supported));
+    }
+    return f;
+  }
+
+  WireFile(WireFile &&o) noexcept { *this = std::move(o); }
+  WireFile &operator=(WireFile &&o) noexcept {
+    std::swap(fd_, o.fd_);
+    std::swap(map_, o.map_);
+    std::swap(len_, o.len_);
+    std::swap(header_, o.header_);
+    return *this;
+  }
+  ~WireFile() {
+    if (map_ != nullptr) {
+      ::munmap(const_cast<char *>(map_), len_);
+    }
+    if (fd_ != -1) {
+      ::close(fd_);
+    }
+  }
+
+  const WireFileHeader &Header() const { return header_; }
+  std::size_t Bytes() const { return len_; }
+
+  // Reads the record at byte `offset` (start at Begin()); false at the end,
+  // at a truncated tail or at an all-zero header (the preallocated, never
+  // written tail of a live or crashed MmapWriter). Advances `offset` past
+  // the record.
+  bool Next(std::size_t &offset, WireRecord &out) const {
+    if (offset + sizeof(WireRecordHeader) > len_) {
+      return false;
+    }
+    std::memcpy(&out.h, map_ + offset, sizeof(out.h));
+    if (BRANCH_UNLIKELY(out.h.len == 0 && out.h.seq == 0 &&
+                        out.h.recv_ns == 0 && out.h.mono_ns == 0)) {
+      return false;
+    }
+    const std::size_t end = offset + sizeof(WireRecordHeader) + out.h.len;
+    if (end > len_) {
+      return false;
+    }
+    out.payload = {map_ + offset + sizeof(WireRecordHeader), out.h.len};
+    offset = end;
+    return true;
+  }
+  static constexpr std::size_t Begin() { return sizeof(WireFileHeader); }
+
+private:
+  WireFile() = default;
+
+  int fd_ = -1;
+  const char *map_ = nullptr;
+  std::size_t len_ = 0;
+  WireFileHeader header_{};
+};
+
+} // namespace capture
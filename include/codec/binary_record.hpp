@@ -0,0 +1,201 @@
+#pragma once
+
+#include "codec/book_ticker.hpp"
+#include "util/branch.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+
+// namespace codec — compact fixed-size binary form of a bookTicker update.
+// Little-endian, naturally aligned, no padding: the same 72-byte record is
+// used on the wire (multicast datagrams) and in binary captures. Symbols are
+// carried as small ids; the id → name mapping travels separately
+// (SymbolTable) so records stay fixed-size.
+namespace codec {
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "binary records are defined as little-endian");
+
+struct QuoteRecord {
+  std::uint64_t u;
+  std::int64_t event_ms;
+  std::int64_t trade_ms;
+  std::int64_t recv_ns;
+  std::int64_t bid_px; // fixed-point, kFixedScale
+  std::int64_t bid_qty;
+  std::int64_t ask_px;
+  std::int64_t ask_qty;
+  std::uint16_t symbol_id;
+  std::uint8_t src;      // producer connection index
+  std::uint8_t decimals; // low nibble: price decimals, high nibble: qty
+  std::uint32_t kind;    // RecordKind; always kQuote on the wire
+};
+static_assert(sizeof(QuoteRecord) == 72, "QuoteRecord layout changed");
+
+// Discriminates the record types sharing the 72-byte slot of a capture file
+enum RecordKind : std::uint32_t { kQuote = 0, kSymbolDef = 1 };
+
+// SymbolRecord — binds `symbol_id` to a name inside a record stream. Same
+// size as QuoteRecord with `symbol_id` and `kind` at the same offsets, so a
+// reader can dispatch on `kind` before interpreting the rest.
+struct SymbolRecord {
+  char name[16]; // not NUL-terminated when name_len == 16
+  std::uint8_t reserved0[48];
+  std::uint16_t symbol_id;
+  std::uint8_t name_len;
+  std::uint8_t reserved1;
+  std::uint32_t kind; // kSymbolDef
+};
+static_assert(sizeof(SymbolRecord) == sizeof(QuoteRecord),
+              "SymbolRecord must fill a QuoteRecord slot");
+static_assert(offsetof(SymbolRecord, symbol_id) ==
+                  offsetof(QuoteRecord, symbol_id) &&
+              offsetof(SymbolRecord, kind) == offsetof(QuoteRecord, kind));
+
+// SymbolTable — writer-side interning of symbol names to dense ids. Fixed
+// capacity, no allocation; names longer than kMaxSymbolLen are rejected.
+class SymbolTable {
+public:
+  static constexpr std::size_t kMaxSymbols = 256;
+  static constexpr std::size_t kMaxSymbolLen = 15;
+
+  struct Name {
+    char data[kMaxSymbolLen + 1];
+    std::uint8_t len;
+  };
+
+  std::optional<std::uint16_t> Intern(std::string_view symbol) {
+    if (BRANCH_LIKELY(last_ < count_ && Get(last_) == symbol)) {
+      return last_;
+    }
+    for (std::uint16_t i = 0; i < count_; ++i) {
+      if (Get(i) == symbol) {
+        last_ = i;
+        return i;
+      }
+    }
+    return Add(symbol);
+  }
+
+  // Registers `symbol` under a specific id (reader side, from a definition)
+  bool Define(std::uint16_t id, std::string_view symbol) {
+    if (id >= kMaxSymbols || symbol.size() > kMaxSymbolLen) {
+      return false;
+    }
+    std::memcpy(names_[id].data, symbol.data(), symbol.size());
+    names_[id].len = static_cast<std::uint8_t>(symbol.size());
+    if (id >= count_) {
+      count_ = static_cast<std::uint16_t>(id + 1);
+    }
+    return true;
+  }
+
+  std::string_view Get(std::uint16_t id) const {
+    if (id >= count_) {
+      return {};
+    }
+    return {names_[id].data, names_[id].len};
+  }
+
+  std::uint16_t Size() const { return count_; }
+
+private:
+  std::optional<std::uint16_t> Add(std::string_view symbol) {
+    if (BRANCH_UNLIKELY(count_ == kMaxSymbols ||
+                        symbol.size() > kMaxSymbolLen)) {
+      return std::nullopt;
+    }
+    const std::uint16_t id = count_;
+    Define(id, symbol);
+    last_ = id;
+    return id;
+  }
+
+  std::array<Name, kMaxSymbols> names_{};
+  std::uint16_t count_ = 0;
+  std::uint16_t last_ = 0;
+};
+
+inline SymbolRecord MakeSymbolRecord(std::uint16_t id,
+                                     std::string_view symbol) {
+  SymbolRecord r{};
+  const std::size_t n = std::min(symbol.size(), sizeof(r.name));
+  std::memcpy(r.name, symbol.data(), n);
+  r.name_len = static_cast<std::uint8_t>(n);
+  r.symbol_id = id;
+  r.kind = kSymbolDef;
+  return r;
+}
+
+// Builds a record from a decoded bookTicker
+inline QuoteRecord MakeQuoteRecord(const BookTicker &bt, std::uint16_t symbolId,
+                                   std::uint8_t src, std::int64_t recvNs) {
+  QuoteRecord r{};
+  r.u = bt.u;
+  r.event_ms = bt.event_ms;
+  r.trade_ms = bt.trade_ms;
+  r.recv_ns = recvNs;
+  r.bid_px = bt.bid_px;
+  r.bid_qty = bt.bid_qty;
+  r.ask_px = bt.ask_px;
+  r.ask_qty = bt.ask_qty;
+  r.symbol_id = symbolId;
+  r.src = src;
+  r.decimals = static_cast<std::uint8_t>((bt.px_decimals & 0x0F) |
+                                         ((bt.qty_decimals & 0x0F) << 4));
+  return r;
+}
+
+// Upper bound of FormatBookTickerJson output
+inline constexpr std::size_t kMaxJsonLen = 256;
+
+// Renders a record back to Binance's bookTicker JSON (canonical key order,
+// original decimal precision). `out` needs kMaxJsonLen bytes; returns length.
+inline std::size_t FormatBookTickerJson(const QuoteRecord &r,
+                                        std::string_view symbol, char *out) {
+  char *p = out;
+  auto put = [&p](std::string_view s) {
+    std::memcpy(p, s.data(), s.size());
+    p += s.size();
+  };
+  auto putInt = [&p](std::uint64_t v) {
+    char tmp[24];
+    int i = 0;
+    do {
+      tmp[i++] = char('0' + v % 10);
+      v /= 10;
+    } while (v);
+    while (i) {
+      *p++ = tmp[--i];
+    }
+  };
+  const int pxDec = r.decimals & 0x0F;
+  const int qtyDec = r.decimals >> 4;
+  auto putFixed = [&p](std::int64_t v, int dec) {
+    p += FormatFixed(v, p, dec);
+  };
+  put(R"({"e":"bookTicker","u":)");
+  putInt(r.u);
+  put(R"(,"s":")");
+  put(symbol.substr(0, SymbolTable::kMaxSymbolLen));
+  put(R"(","b":")");
+  putFixed(r.bid_px, pxDec);
+  put(R"(","B":")");
+  putFixed(r.bid_qty, qtyDec);
+  put(R"(","a":")");
+  putFixed(r.ask_px, pxDec);
+  put(R"(","A":")");
+  putFixed(r.ask_qty, qtyDec);
+  put(R"(","T":)");
+  putInt(static_cast<std::uint64_t>(r.trade_ms));
+  put(R"(,"E":)");
+  putInt(static_cast<std::uint64_t>(r.event_ms));
+  *p++ = '}';
+  return static_cast<std::size_t>(p - out);
+}
+
+} // namespace codec
@@ -0,0 +1,257 @@
+#pragma once
+
+#include "util/branch.hpp"
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// namespace codec — allocation-free decoding of Binance `bookTicker` payloads.
+// A single left-to-right pass over the JSON object extracts the one-letter
+// fields we care about; prices and sizes are converted to fixed-point integers
+// (1e-8 units) so downstream stages never touch floating-point parsing.
+namespace codec {
+
+// Fixed-point scale for prices and sizes: value = mantissa / kFixedScale
+inline constexpr std::int64_t kFixedScale = 100'000'000;
+inline constexpr int kFixedDigits = 8;
+
+struct BookTicker {
+  std::uint64_t u = 0;       // order book updateId
+  std::string_view symbol;   // view into the payload ("s")
+  std::int64_t bid_px = 0;   // "b", fixed-point
+  std::int64_t bid_qty = 0;  // "B", fixed-point
+  std::int64_t ask_px = 0;   // "a", fixed-point
+  std::int64_t ask_qty = 0;  // "A", fixed-point
+  std::int64_t event_ms = 0; // "E"
+  std::int64_t trade_ms = 0; // "T"
+  std::uint8_t px_decimals = 0;  // fractional digits of "b" as received
+  std::uint8_t qty_decimals = 0; // fractional digits of "B" as received
+};
+
+// Parses a decimal string like "110799.90" into fixed-point 1e-8 units.
+// Extra fractional digits beyond kFixedDigits are truncated. `fracDigits`
+// (optional) receives the number of fractional digits seen. Values whose
+// fixed-point form does not fit an int64 (about 9.2e10) are rejected.
+inline bool ParseFixed(std::string_view s, std::int64_t &out,
+                       int *fracDigits = nullptr) {
+  const char *p = s.data();
+  const char *end = p + s.size();
+  bool neg = false;
+  if (p < end && *p == '-') {
+    neg = true;
+    ++p;
+  }
+  if (BRANCH_UNLIKELY(p == end)) {
+    return false;
+  }
+  constexpr std::uint64_t kMax = INT64_MAX;
+  std::uint64_t v = 0;
+  int frac = -1;
+  for (; p < end; ++p) {
+    const char c = *p;
+    if (c == '.') {
+      if (BRANCH_UNLIKELY(frac >= 0)) {
+        return false;
+      }
+      frac = 0;
+      continue;
+    }
+    if (BRANCH_UNLIKELY(c < '0' || c > '9')) {
+      return false;
+    }
+    if (frac >= kFixedDigits) {
+      continue;
+    }
+    const auto d = static_cast<std::uint64_t>(c - '0');
+    if (BRANCH_UNLIKELY(v > (kMax - d) / 10)) {
+      return false;
+    }
+    v = v * 10 + d;
+    if (frac >= 0) {
+      ++frac;
+    }
+  }
+  for (int f = frac < 0 ? 0 : frac; f < kFixedDigits; ++f) {
+    if (BRANCH_UNLIKELY(v > kMax / 10)) {
+      return false;
+    }
+    v *= 10;
+  }
+  out = neg ? -static_cast<std::int64_t>(v) : static_cast<std::int64_t>(v);
+  if (fracDigits != nullptr) {
+    *fracDigits = frac < 0 ? 0 : frac;
+  }
+  return true;
+}
+
+// Formats a fixed-point value back to decimal, trimming trailing fractional
+// zeros but keeping at least `minFracDigits` digits (so "110799.90" survives a
+// round trip when called with its original precision). Returns the number of
+// bytes written; `out` needs 32 bytes.
+inline std::size_t FormatFixed(std::int64_t v, char *out,
+                               int minFracDigits = 0) {
+  char tmp[32];
+  std::size_t o = 0;
+  std::uint64_t x = v < 0 ? static_cast<std::uint64_t>(-v)
+                          : static_cast<std::uint64_t>(v);
+  if (v < 0) {
+    out[o++] = '-';
+  }
+  std::uint64_t ip = x / kFixedScale;
+  std::uint64_t fp = x % kFixedScale;
+  int i = 0;
+  do {
+    tmp[i++] = char('0' + ip % 10);
+    ip /= 10;
+  } while (ip);
+  while (i) {
+    out[o++] = tmp[--i];
+  }
+  char frac[kFixedDigits];
+  for (int d = kFixedDigits - 1; d >= 0; --d) {
+    frac[d] = char('0' + fp % 10);
+    fp /= 10;
+  }
+  int keep = kFixedDigits;
+  while (keep > minFracDigits && frac[keep - 1] == '0') {
+    --keep;
+  }
+  if (keep > 0) {
+    out[o++] = '.';
+    for (int d = 0; d < keep; ++d) {
+      out[o++] = frac[d];
+    }
+  }
+  return o;
+}
+
+namespace detail {
+
+inline bool ParseUnsigned(std::string_view s, std::uint64_t &out) {
+  if (BRANCH_UNLIKELY(s.empty())) {
+    return false;
+  }
+  std::uint64_t v = 0;
+  for (char c : s) {
+    if (BRANCH_UNLIKELY(c < '0' || c > '9')) {
+      return false;
+    }
+    const auto d = static_cast<std::uint64_t>(c - '0');
+    if (BRANCH_UNLIKELY(v > (UINT64_MAX - d) / 10)) {
+      return false;
+    }
+    v = v * 10 + d;
+  }
+  out = v;
+  return true;
+}
+
+} // namespace detail
+
+// Decodes a flat bookTicker object. Unknown keys are skipped; nested objects
+// are not supported (bookTicker never contains any). Returns nullopt when `u`
+// or any of the four book fields is missing or malformed.
+inline std::optional<BookTicker> ParseBookTicker(std::string_view sv) {
+  BookTicker bt;
+  unsigned seen = 0;
+  const char *p = sv.data();
+  const char *end = p + sv.size();
+  while (p < end) {
+    // Key
+    while (p < end && *p != '"') {
+      ++p;
+    }
+    if (p == end) {
+      break;
+    }
+    const char *key = ++p;
+    while (p < end && *p != '"') {
+      ++p;
+    }
+    if (BRANCH_UNLIKELY(p == end)) {
+      return std::nullopt;
+    }
+    const std::size_t keyLen = static_cast<std::size_t>(p - key);
+    ++p;
+    while (p < end && (*p == ':' || static_cast<unsigned char>(*p) <= ' ')) {
+      ++p;
+    }
+    // Value: either "string" or a bare token up to ',' / '}'
+    std::string_view val;
+    if (p < end && *p == '"') {
+      const char *vb = ++p;
+      while (p < end && *p != '"') {
+        ++p;
+      }
+      val = std::string_view{vb, static_cast<std::size_t>(p - vb)};
+      if (p < end) {
+        ++p;
+      }
+    } else {
+      const char *vb = p;
+      while (p < end && *p != ',' && *p != '}' &&
+             static_cast<unsigned char>(*p) > ' ') {
+        ++p;
+      }
+      val = std::string_view{vb, static_cast<std::size_t>(p - vb)};
+    }
+    if (keyLen != 1) {
+      continue;
+    }
+    bool ok = true;
+    switch (*key) {
+    case 'u':
+      ok = detail::ParseUnsigned(val, bt.u);
+      seen |= 1u;
+      break;
+    case 's':
+      bt.symbol = val;
+      break;
+    case 'b': {
+      int digits = 0;
+      ok = ParseFixed(val, bt.bid_px, &digits);
+      bt.px_decimals = static_cast<std::uint8_t>(digits);
+      seen |= 2u;
+      break;
+    }
+    case 'B': {
+      int digits = 0;
+      ok = ParseFixed(val, bt.bid_qty, &digits);
+      bt.qty_decimals = static_cast<std::uint8_t>(digits);
+      seen |= 4u;
+      break;
+    }
+    case 'a':
+      ok = ParseFixed(val, bt.ask_px);
+      seen |= 8u;
+      break;
+    case 'A':
+      ok = ParseFixed(val, bt.ask_qty);
+      seen |= 16u;
+      break;
+    case 'E': {
+      std::uint64_t v = 0;
+      ok = detail::ParseUnsigned(val, v);
+      bt.event_ms = static_cast<std::int64_t>(v);
+      break;
+    }
+    case 'T': {
+      std::uint64_t v = 0;
+      ok = detail::ParseUnsigned(val, v);
+      bt.trade_ms = static_cast<std::int64_t>(v);
+      break;
+    }
+    default:
+      break;
+    }
+    if (BRANCH_UNLIKELY(!ok)) {
+      return std::nullopt;
+    }
+  }
+  if (BRANCH_UNLIKELY(seen != 31u)) {
+    return std::nullopt;
+  }
+  return bt;
+}
+
+} // namespace codec
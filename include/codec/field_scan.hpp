@@ -0,0 +1,119 @@
+#pragma once
+
+#include "util/branch.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// namespace codec — vectorised line/field scanning for bulk readers of
+// captured NDJSON. One pass classifies every byte of a 64-byte block as
+// newline, quote or other (SSE2 compares + movemask, scalar elsewhere); the
+// caller then only visits the set bits. Line ends come straight from the
+// newline mask, and the `u` / `E` keys are recognised at quote positions as
+// `"u":` / `"E":`, so a record is split and keyed without running the full
+// ParseBookTicker.
+namespace codec {
+
+namespace detail {
+
+// Bit i of `nl` / `quote` is set when p[i] is '\n' / '"'
+inline void ClassifyBlock(const char *p, std::uint64_t &nl,
+                          std::uint64_t &quote) {
+#if defined(__SSE2__)
+  const __m128i vnl = _mm_set1_epi8('\n');
+  const __m128i vq = _mm_set1_epi8('"');
+  nl = 0;
+  quote = 0;
+  for (int i = 0; i < 4; ++i) {
+    const __m128i b =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * i));
+    nl |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(
+              _mm_movemask_epi8(_mm_cmpeq_epi8(b, vnl))))
+          << (16 * i);
+    quote |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(
+                 _mm_movemask_epi8(_mm_cmpeq_epi8(b, vq))))
+             << (16 * i);
+  }
+#else
+  nl = 0;
+  quote = 0;
+  for (int i = 0; i < 64; ++i) {
+    nl |= static_cast<std::uint64_t>(p[i] == '\n') << i;
+    quote |= static_cast<std::uint64_t>(p[i] == '"') << i;
+  }
+#endif
+}
+
+// Digits at [p, end) → value; stops at the first non-digit
+inline std::uint64_t ScanDigits(const char *p, const char *end) {
+  std::uint64_t v = 0;
+  for (; p < end && static_cast<unsigned>(*p - '0') < 10u; ++p) {
+    v = v * 10 + static_cast<std::uint64_t>(*p - '0');
+  }
+  return v;
+}
+
+} // namespace detail
+
+// Keys extracted from one NDJSON line by ScanLines
+struct LineKeys {
+  std::uint64_t u = 0;       // 0 when the line has no "u"
+  std::int64_t event_ms = 0; // 0 when the line has no "E"
+};
+
+// Calls fn(std::string_view line, const LineKeys&) for every '\n'-terminated
+// line in [begin, end) and for a trailing unterminated one. Lines are views
+// into the input (without the newline); empty lines are skipped.
+template <typename Fn>
+void ScanLines(const char *begin, const char *end, Fn &&fn) {
+  const char *line = begin;
+  LineKeys keys;
+  auto onQuote = [&](const char *q) {
+    // `"u":` / `"E":` — a value string can never be followed by ':'
+    if (q + 4 <= end && q[2] == '"' && q[3] == ':') {
+      if (q[1] == 'u') {
+        keys.u = detail::ScanDigits(q + 4, end);
+      } else if (q[1] == 'E') {
+        keys.event_ms = static_cast<std::int64_t>(detail::ScanDigits(q + 4, end));
+      }
+    }
+  };
+  auto onNewline = [&](const char *nl) {
+    if (nl > line) {
+      fn(std::string_view{line, static_cast<std::size_t>(nl - line)}, keys);
+    }
+    line = nl + 1;
+    keys = LineKeys{};
+  };
+  const char *p = begin;
+  for (; end - p >= 64; p += 64) {
+    std::uint64_t nl;
+    std::uint64_t quote;
+    detail::ClassifyBlock(p, nl, quote);
+    std::uint64_t any = nl | quote;
+    while (any != 0) {
+      const int i = __builtin_ctzll(any);
+      any &= any - 1;
+      if ((nl >> i) & 1u) {
+        onNewline(p + i);
+      } else {
+        onQuote(p + i);
+      }
+    }
+  }
+  for (; p < end; ++p) {
+    if (*p == '\n') {
+      onNewline(p);
+    } else if (*p == '"') {
+      onQuote(p);
+    }
+  }
+  if (end > line) {
+    fn(std::string_view{line, static_cast<std::size_t>(end - line)}, keys);
+  }
+}
+
+} // namespace codec
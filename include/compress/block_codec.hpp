@@ -0,0 +1,243 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <dlfcn.h>
+#include <expected>
+#include <optional>
+#include <string_view>
+#include <system_error>
+
+// namespace compress — block compression for captures. The codec libraries
+// (libzstd, liblz4) are bound at runtime with dlopen, so the tree builds
+// without their development headers and a host without them only loses the
+// compressed output modes. Only the stable one-shot frame APIs are used;
+// every block becomes one self-contained frame that `zstd -d` / `lz4 -d`
+// can decode on its own.
+namespace compress {
+
+enum class Codec { zstd, lz4 };
+
+inline std::optional<Codec> ParseCodec(std::string_view s) {
+  if (s == "zstd") {
+    return Codec::zstd;
+  }
+  if (s == "lz4") {
+    return Codec::lz4;
+  }
+  return std::nullopt;
+}
+
+inline const char *CodecName(Codec c) {
+  return c == Codec::zstd ? "zstd" : "lz4";
+}
+
+namespace detail {
+
+// Function tables resolved once per process; the handles are never closed
+struct ZstdApi {
+  std::size_t (*compressBound)(std::size_t);
+  std::size_t (*compress)(void *, std::size_t, const void *, std::size_t, int);
+  std::size_t (*decompress)(void *, std::size_t, const void *, std::size_t);
+  unsigned (*isError)(std::size_t);
+};
+
+struct Lz4Api {
+  std::size_t (*compressFrameBound)(std::size_t, const void *);
+  std::size_t (*compressFrame)(void *, std::size_t, const void *, std::size_t,
+                               const void *);
+  unsigned (*isError)(std::size_t);
+  std::size_t (*createDctx)(void **, unsigned);
+  std::size_t (*freeDctx)(void *);
+  std::size_t (*decompress)(void *, void *, std::size_t *, const void *,
+                            std::size_t *, const void *);
+};
+
+template <typename T> bool Bind(void *lib, const char *name, T &fn) {
+  fn = reinterpret_cast<T>(::dlsym(lib, name));
+  return fn != nullptr;
+}
+
+inline const ZstdApi *LoadZstd() {
+  static const ZstdApi *api = []() -> const ZstdApi * {
+    void *lib = ::dlopen("libzstd.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (lib == nullptr) {
+      return nullptr;
+    }
+    static ZstdApi a{};
+    const bool ok = Bind(lib, "ZSTD_compressBound", a.compressBound) &&
+                    Bind(lib, "ZSTD_compress", a.compress) &&
+                    Bind(lib, "ZSTD_decompress", a.decompress) &&
+                    Bind(lib, "ZSTD_isError", a.isError);
+    return ok ? &a : nullptr;
+  }();
+  return api;
+}
+
+inline const Lz4Api *LoadLz4() {
+  static const Lz4Api *api = []() -> const Lz4Api * {
+    void *lib = ::dlopen("liblz4.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (lib == nullptr) {
+      return nullptr;
+    }
+    static Lz4Api a{};
+    const bool ok =
+        Bind(lib, "LZ4F_compressFrameBound", a.compressFrameBound) &&
+        Bind(lib, "LZ4F_compressFrame", a.compressFrame) &&
+        Bind(lib, "LZ4F_isError", a.isError) &&
+        Bind(lib, "LZ4F_createDecompressionContext", a.createDctx) &&
+        Bind(lib, "LZ4F_freeDecompressionContext", a.freeDctx) &&
+        Bind(lib, "LZ4F_decompress", a.decompress);
+    return ok ? &a : nullptr;
+  }();
+  return api;
+}
+
+} // namespace detail
+
+// BlockCodec — one-shot frame compression/decompression. Cheap to copy;
+// safe to use from several threads at once (no shared mutable state).
+class BlockCodec {
+public:
+  static std::expected<BlockCodec, std::error_code> Load(Codec c,
+                                                         int level = 3) {
+    BlockCodec b;
+    b.codec_ = c;
+    b.level_ = level;
+    if (c == Codec::zstd) {
+      b.zstd_ = detail::LoadZstd();
+    } else {
+      b.lz4_ = detail::LoadLz4();
+    }
+    if (b.zstd_ == nullptr && b.lz4_ == nullptr) {
+      return std::unexpected(std::make_error_code(std::errc::not_supported));
+    }
+    return b;
+  }
+
+  Codec GetCodec() const { return codec_; }
+
+  // Worst-case compressed size of an `n`-byte block
+  std::size_t Bound(std::size_t n) const {
+    return zstd_ != nullptr ? zstd_->compressBound(n)
+                            : lz4_->compressFrameBound(n, nullptr);
+  }
+
+  // Compresses `src` into one frame at `dst`; returns its size, 0 on error
+  std::size_t Compress(const void *src, std::size_t n, void *dst,
+                       std::size_t cap) const {
+    if (zstd_ != nullptr) {
+      const std::size_t r = zstd_->compress(dst, cap, src, n, level_);
+      return zstd_->isError(r) ? 0 : r;
+    }
+    const std::size_t r = lz4_->compressFrame(dst, cap, src, n, nullptr);
+    return lz4_->isError(r) ? 0 : r;
+  }
+
+  // Worst-case size of Store() for an `n`-byte block
+  std::size_t StoredBound(std::size_t n) const {
+    if (zstd_ != nullptr) {
+      return 13 + n + 3 * (n / kZstdRawBlock + 1);
+    }
+    return 7 + n + 4 * (n / kLz4RawBlock + 1) + 4;
+  }
+
+  // Writes `src` uncompressed as one valid frame of the codec (zstd raw
+  // blocks, lz4 uncompressed blocks), for blocks Compress() failed on;
+  // returns its size, 0 if `cap` is too small
+  std::size_t Store(const void *src, std::size_t n, void *dst,
+                    std::size_t cap) const {
+    if (cap < StoredBound(n)) {
+      return 0;
+    }
+    const auto *in = static_cast<const unsigned char *>(src);
+    auto *out = static_cast<unsigned char *>(dst);
+    auto put = [&out](std::uint64_t v, int bytes) {
+      for (int i = 0; i < bytes; ++i, v >>= 8) {
+        *out++ = static_cast<unsigned char>(v);
+      }
+    };
+    if (zstd_ != nullptr) {
+      // Single-segment frame with an 8-byte content size, no checksum
+      put(0xFD2FB528u, 4);
+      put(0xE0, 1);
+      put(n, 8);
+      std::size_t left = n;
+      do {
+        const std::size_t len = left < kZstdRawBlock ? left : kZstdRawBlock;
+        left -= len;
+        put((len << 3) | (left == 0 ? 1u : 0u), 3); // raw block, last bit
+        std::memcpy(out, in, len);
+        out += len;
+        in += len;
+      } while (left != 0);
+    } else {
+      // FLG: version 01, independent blocks; BD: 4 MiB blocks; header
+      // checksum of those two bytes
+      put(0x184D2204u, 4);
+      put(0x60, 1);
+      put(0x70, 1);
+      put(0x73, 1);
+      for (std::size_t left = n; left != 0;) {
+        const std::size_t len = left < kLz4RawBlock ? left : kLz4RawBlock;
+        put(len | 0x80000000u, 4); // high bit: stored uncompressed
+        std::memcpy(out, in, len);
+        out += len;
+        in += len;
+        left -= len;
+      }
+      put(0, 4); // end mark
+    }
+    return static_cast<std::size_t>(out - static_cast<unsigned char *>(dst));
+  }
+
+  // Decodes one frame whose decompressed size (`dsize`) is known
+  bool Decompress(const void *src, std::size_t n, void *dst,
+                  std::size_t dsize) const {
+    if (zstd_ != nullptr) {
+      const std::size_t r = zstd_->decompress(dst, dsize, src, n);
+      return !zstd_->isError(r) && r == dsize;
+    }
+    void *dctx = nullptr;
+    if (lz4_->isError(lz4_->createDctx(&dctx, 100))) {
+      return false;
+    }
+    std::size_t out = dsize;
+    std::size_t in = n;
+    const std::size_t r = lz4_->decompress(dctx, dst, &out, src, &in, nullptr);
+    lz4_->freeDctx(dctx);
+    return !lz4_->isError(r) && out == dsize;
+  }
+
+private:
+  static constexpr std::size_t kZstdRawBlock = 128u << 10;
+  static constexpr std::size_t kLz4RawBlock = 4u << 20;
+
+  Codec codec_ = Codec::zstd;
+  int level_ = 3;
+  const detail::ZstdApi *zstd_ = nullptr;
+  const detail::Lz4Api *lz4_ = nullptr;
+};
+
+// Seek table appended to a compressed capture: the zstd "seekable format"
+// (a skippable frame, so plain `zstd -d` / `lz4 -d` ignore it):
+//   u32 0x184D2A5E | u32 size | {u32 compressed, u32 decompressed} * N |
+//   u32 N | u8 descriptor (0) | u32 0x8F92EAB1
+inline constexpr std::uint32_t kSkippableMagic = 0x184D2A5E;
+inline constexpr std::uint32_t kSeekableMagic = 0x8F92EAB1;
+inline constexpr std::size_t kSeekFooterBytes = 9;
+
+// Checkpoint written before every frame, so a capture whose seek table was
+// never written (crash) can still be indexed by walking the file forward;
+// the seek table lists each checkpoint as a frame of decompressed size 0:
+//   u32 0x184D2A5D | u32 8 | u32 compressed | u32 decompressed
+inline constexpr std::uint32_t kCheckpointMagic = 0x184D2A5D;
+inline constexpr std::size_t kCheckpointBytes = 16;
+
+struct FrameEntry {
+  std::uint32_t compressed;
+  std::uint32_t decompressed;
+};
+
+} // namespace compress
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "compress/block_codec.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <fcntl.h>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+#include <vector>
+
+namespace compress {
+
+// SeekableReader — random access into a capture written by
+// io::CompressingWriter. Reads the seek table from the end of the file,
+// detects the codec from the first frame's magic and decompresses single
+// frames on demand with pread(2); nothing before the requested frame is
+// touched. Without a seek table (the writer crashed) the frames are indexed
+// from the checkpoints in front of each of them.
+class SeekableReader {
+public:
+  struct Frame {
+    std::uint64_t offset;     // compressed offset in the file
+    std::uint64_t raw_offset; // decompressed offset in the stream
+    std::uint32_t size;
+    std::uint32_t raw_size;
+  };
+
+  static std::expected<SeekableReader, std::error_code>
+  Open(const std::string &path) {
+    SeekableReader r;
+    r.fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (r.fd_ == -1) {
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    const off_t end = ::lseek(r.fd_, 0, SEEK_END);
+    const auto bad = std::make_error_code(std::errc::invalid_argument);
+    if (!r.ReadTable(end) && !r.Recover(end)) {
+      return std::unexpected(bad);
+    }
+    std::uint32_t first = 0;
+    if (!r.frames_.empty() &&
+        !r.ReadAt(&first, 4, static_cast<off_t>(r.frames_[0].offset))) {
+      return std::unexpected(bad);
+    }
+    auto codec = BlockCodec::Load(first == 0x184D2204u ? Codec::lz4
+                                                       : Codec::zstd);
+    if (!codec) {
+      return std::unexpected(codec.error());
+    }
+    r.codec_ = *codec;
+    return r;
+  }
+
+  SeekableReader(SeekableReader &&o) noexcept { *this = std::move(o); }
+  SeekableReader &operator=(SeekableReader &&o) noexcept {
+    std::swap(fd_, o.fd_);
+    frames_.swap(o.frames_);
+    raw_size_ = o.raw_size_;
+    recovered_ = o.recovered_;
+    codec_ = o.codec_;
+    return *this;
+  }
+  ~SeekableReader() {
+    if (fd_ != -1) {
+      ::close(fd_);
+    }
+  }
+
+  const std::vector<Frame> &Frames() const { return frames_; }
+  std::uint64_t RawSize() const { return raw_size_; }
+  Codec GetCodec() const { return codec_.GetCodec(); }
+  // Frame decoder, for callers that decode frames from their own buffers
+  const BlockCodec &Decoder() const { return codec_; }
+
+  // Index of the frame holding decompressed offset `rawOff`
+  std::size_t FrameAt(std::uint64_t rawOff) const {
+    auto it = std::upper_bound(
+        frames_.begin(), frames_.end(), rawOff,
+        [](std::uint64_t v, const Frame &f) { return v < f.raw_offset; });
+    return it == frames_.begin() ? 0
+                                 : static_cast<std::size_t>(
+                                       it - frames_.begin() - 1);
+  }
+
+  // Decompresses frame `i` into `out` (resized to its raw size)
+  bool ReadFrame(std::size_t i, std::vector<char> &out) {
+    const Frame &f = frames_.at(i);
+    scratch_.resize(f.size);
+    out.resize(f.raw_size);
+    return ReadAt(scratch_.data(), f.size, static_cast<off_t>(f.offset)) &&
+           codec_.Decompress(scratch_.data(), f.size, out.data(), f.raw_size);
+  }
+
+  // True when the frames come from checkpoints: the seek table is missing
+  // (the writer did not finish) and the index stops at the last whole frame
+  bool Recovered() const { return recovered_; }
+
+private:
+  SeekableReader() = default;
+
+  // Frames from the seek table ending the file. Checkpoints are listed in
+  // it with a decompressed size of 0 and skipped here
+  bool ReadTable(off_t end) {
+    if (end < static_cast<off_t>(8 + kSeekFooterBytes)) {
+      return false;
+    }
+    unsigned char footer[kSeekFooterBytes];
+    if (!ReadAt(footer, sizeof(footer), end - kSeekFooterBytes)) {
+      return false;
+    }
+    std::uint32_t n = 0;
+    std::uint32_t magic = 0;
+    std::memcpy(&n, footer, 4);
+    std::memcpy(&magic, footer + 5, 4);
+    const std::uint64_t tableBytes =
+        8 + std::uint64_t{n} * sizeof(FrameEntry) + kSeekFooterBytes;
+    if (magic != kSeekableMagic || (footer[4] & 0x80) != 0 ||
+        tableBytes > static_cast<std::uint64_t>(end)) {
+      return false;
+    }
+    std::vector<FrameEntry> entries(n);
+    const off_t tableAt = end - static_cast<off_t>(tableBytes);
+    if (n != 0 &&
+        !ReadAt(entries.data(), n * sizeof(FrameEntry), tableAt + 8)) {
+      return false;
+    }
+    std::uint64_t off = 0;
+    std::uint64_t raw = 0;
+    frames_.reserve(n);
+    for (const auto &e : entries) {
+      if (e.decompressed != 0) {
+        frames_.push_back({off, raw, e.compressed, e.decompressed});
+      }
+      off += e.compressed;
+      raw += e.decompressed;
+    }
+    if (off != static_cast<std::uint64_t>(tableAt)) {
+      frames_.clear();
+      return false;
+    }
+    raw_size_ = raw;
+    return true;
+  }
+
+  // Frames from the checkpoints, walking forward from the start; stops at
+  // the first torn checkpoint or frame
+  bool Recover(off_t end) {
+    std::uint64_t off = 0;
+    std::uint64_t raw = 0;
+    const auto size = static_cast<std::uint64_t>(end);
+    std::uint32_t cp[4];
+    while (off + kCheckpointBytes <= size &&
+           ReadAt(cp, sizeof(cp), static_cast<off_t>(off)) &&
+           cp[0] == kCheckpointMagic && cp[1] == 8 &&
+           off + kCheckpointBytes + cp[2] <= size) {
+      frames_.push_back({off + kCheckpointBytes, raw, cp[2], cp[3]});
+      off += kCheckpointBytes + cp[2];
+      raw += cp[3];
+    }
+    if (frames_.empty()) {
+      return false; // not written by CompressingWriter
+    }
+    raw_size_ = raw;
+    recovered_ = true;
+    return true;
+  }
+
+  bool ReadAt(void *dst, std::size_t len, off_t off) const {
+    auto *p = static_cast<char *>(dst);
+    while (len != 0) {
+      const ssize_t n = ::pread(fd_, p, len, off);
+      if (n <= 0) {
+        if (n < 0 && errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      p += n;
+      len -= static_cast<std::size_t>(n);
+      off += n;
+    }
+    return true;
+  }
+
+  int fd_ = -1;
+  std::vector<Frame> frames_;
+  std::uint64_t raw_size_ = 0;
+  bool recovered_ = false;
+  BlockCodec codec_;
+  std::vector<char> scratch_;
+};
+
+} // namespace compress
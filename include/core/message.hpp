@@ -1,10 +1,196 @@
 #pragma once
 
 #include "lockfree/ring.hpp"
-#include <boost/beast/core/flat_buffer.hpp>
-#include <boost/lockfree/spsc_queue.hpp>
+#include "mem/slab_arena.hpp"
+#include "util/branch.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <system_error>
 
-using RawOrderUpdate = boost::beast::flat_buffer;
+// One raw WebSocket message plus the receive timestamp taken by the session
+// right after the read completed. `buf` is a view of a slab slot owned by
+// the RawOrderQueue the update came from.
+struct RawOrderUpdate {
+  mem::SlabBuffer buf;
+  std::int64_t recv_ns = 0;  // epoch ns (system_clock)
+  std::int64_t event_ms = 0; // `E` of the payload, 0 = none
+};
 
 static constexpr std::size_t kRawOrderQueueCapacity = 16384;
-using RawOrderQueue = lockfree::Ring<RawOrderUpdate, kRawOrderQueueCapacity>;
\ No newline at end of file
+
+// What a session does with a message when every slot of its queue is in
+// flight (the merger is behind):
+// - drop_newest: read it into the spare slot and drop it
+// - drop_oldest: overwrite the oldest message still waiting in the queue
+//   (the merger orders by `u`, so the position does not matter); when all of
+//   them are already with the merger, drop the new one instead
+// - block: stop reading until a slot frees up (lossless; TCP pushes back)
+// Every drop is counted in RawOrderQueue::Stats; nothing allocates.
+enum class QueueOverflow { drop_newest, drop_oldest, block };
+
+inline std::optional<QueueOverflow> ParseQueueOverflow(std::string_view s) {
+  if (s == "drop-newest" || s == "drop_newest") {
+    return QueueOverflow::drop_newest;
+  }
+  if (s == "drop-oldest" || s == "drop_oldest") {
+    return QueueOverflow::drop_oldest;
+  }
+  if (s == "block") {
+    return QueueOverflow::block;
+  }
+  return std::nullopt;
+}
+
+inline const char *QueueOverflowName(QueueOverflow p) {
+  switch (p) {
+  case QueueOverflow::drop_newest:
+    return "drop-newest";
+  case QueueOverflow::drop_oldest:
+    return "drop-oldest";
+  case QueueOverflow::block:
+    return "block";
+  }
+  return "?";
+}
+
+// RawOrderQueue — a session's lockfree::Ring of RawOrderUpdate whose slots
+// are bound once, at creation, to the slots of one mem::SlabArena (plus a
+// spare slot the session reads into when every pooled slot is in flight).
+// Same SPSC protocol as the Ring: the session acquires and publishes, the
+// merger consumes and releases every update it consumed. Stats count every
+// message that does not make it from the wire to the merger's heap, by
+// cause; each counter has a single writer (session or merger thread).
+class RawOrderQueue {
+public:
+  static constexpr std::size_t kCapacity = kRawOrderQueueCapacity;
+
+  struct Stats {
+    // Session thread
+    std::atomic<std::uint64_t> published{0};
+    std::atomic<std::uint64_t> dropped_newest{0}; // read into the spare
+    std::atomic<std::uint64_t> dropped_oldest{0}; // overwritten while queued
+    std::atomic<std::uint64_t> publish_failed{0}; // never expected
+    std::atomic<std::uint64_t> blocked_ns{0};     // waiting for a slot
+    std::atomic<std::uint64_t> latency_dropped{0}; // latency queue full
+    std::atomic<std::int64_t> first_recv_ns{0};    // startup timeline
+    // Merger thread, on its own cache line: `u` already emitted / no `u`
+    alignas(lockfree::kCacheLine) std::atomic<std::uint64_t> duplicates{0};
+    std::atomic<std::uint64_t> unparsed{0};
+  };
+
+  static std::expected<std::shared_ptr<RawOrderQueue>, std::error_code>
+  Create(const mem::SlabConfig &cfg = {},
+         QueueOverflow overflow = QueueOverflow::drop_newest) {
+    auto slab = mem::SlabArena::Create(kCapacity + 1, cfg);
+    if (!slab) {
+      return std::unexpected(slab.error());
+    }
+    return std::shared_ptr<RawOrderQueue>(new RawOrderQueue(
+        std::move(*slab), overflow, !(cfg.prefault && cfg.defer_prefault)));
+  }
+
+  RawOrderQueue(const RawOrderQueue &) = delete;
+  RawOrderQueue &operator=(const RawOrderQueue &) = delete;
+
+  // Producer API
+  bool acquire(RawOrderUpdate &out) { return ring_.acquire(out); }
+  bool publish(RawOrderUpdate &&item) {
+    const std::int64_t recv_ns = item.recv_ns;
+    if (BRANCH_UNLIKELY(!ring_.publish(std::move(item)))) {
+      Count(stats_.publish_failed);
+      return false;
+    }
+    const std::uint64_t n = stats_.published.load(std::memory_order_relaxed);
+    if (BRANCH_UNLIKELY(n == 0)) {
+      stats_.first_recv_ns.store(recv_ns, std::memory_order_relaxed);
+    }
+    stats_.published.store(n + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Producer only: applies the overflow policy to a message read into the
+  // Spare() slot because acquire() failed
+  void Overflowed(const RawOrderUpdate &msg) {
+    if (overflow_ == QueueOverflow::drop_oldest &&
+        ring_.overwrite_oldest([&](RawOrderUpdate &old) {
+          old.buf.clear();
+          const auto src = msg.buf.data();
+          std::memcpy(old.buf.prepare(src.size()).data(), src.data(),
+                      src.size());
+          old.buf.commit(src.size());
+          old.recv_ns = msg.recv_ns;
+          old.event_ms = msg.event_ms;
+        })) {
+      Count(stats_.dropped_oldest);
+      return;
+    }
+    Count(stats_.dropped_newest);
+  }
+
+  // Producer only: time spent waiting for a slot under QueueOverflow::block
+  void AddBlocked(std::chrono::nanoseconds d) {
+    stats_.blocked_ns.fetch_add(static_cast<std::uint64_t>(d.count()),
+                                std::memory_order_relaxed);
+  }
+  void LatencyDropped() { Count(stats_.latency_dropped); }
+
+  // Consumer API
+  bool consume(RawOrderUpdate &out) { return ring_.consume(out); }
+  bool release(RawOrderUpdate &&item) { return ring_.release(std::move(item)); }
+  // Consumer only: the merger dropped a consumed update (then releases it)
+  void Duplicate() { Count(stats_.duplicates); }
+  void Unparsed() { Count(stats_.unparsed); }
+
+  // Producer only: the slot outside the pool. A message read into it is not
+  // published; the session uses it to keep reading when acquire() fails.
+  RawOrderUpdate Spare() const {
+    return {mem::SlabBuffer(slab_.Slot(kCapacity), slab_.SlotBytes()), 0};
+  }
+
+  // Startup: prefaults a slab created with defer_prefault, on a helper
+  // thread while the session connects, then marks the queue Ready()
+  void Prefault() {
+    slab_.Prefault();
+    ready_.store(true, std::memory_order_release);
+  }
+  // Producer: false until a deferred prefault finished; checked once per
+  // connection, before the first acquire()
+  bool Ready() const { return ready_.load(std::memory_order_acquire); }
+
+  // Largest message a slot holds (the sessions' WebSocket read limit)
+  std::size_t MaxMessage() const { return slab_.SlotBytes(); }
+  const mem::SlabArena &Slab() const { return slab_; }
+  QueueOverflow Overflow() const { return overflow_; }
+  const Stats &GetStats() const { return stats_; }
+
+  // Introspection (approximate counts)
+  std::size_t ready_size() const { return ring_.ready_size(); }
+  std::size_t free_size() const { return ring_.free_size(); }
+
+private:
+  RawOrderQueue(mem::SlabArena slab, QueueOverflow overflow, bool ready)
+      : slab_(std::move(slab)), overflow_(overflow), ready_(ready),
+        ring_(
+            [this](std::size_t i) {
+              return RawOrderUpdate{
+                  mem::SlabBuffer(slab_.Slot(i), slab_.SlotBytes()), 0};
+            },
+            overflow == QueueOverflow::drop_oldest) {}
+
+  // Single writer per counter: a relaxed load + store, no locked add
+  static void Count(std::atomic<std::uint64_t> &c) {
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  mem::SlabArena slab_;
+  QueueOverflow overflow_;
+  std::atomic<bool> ready_;
+  lockfree::Ring<RawOrderUpdate, kCapacity> ring_;
+  alignas(lockfree::kCacheLine) Stats stats_;
+};
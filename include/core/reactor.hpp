@@ -11,6 +11,7 @@
 #include <sched.h>
 #endif
 #include "util/cpu_affinity.hpp"
+#include "util/realtime.hpp"
 
 namespace net = boost::asio;
 namespace ssl = net::ssl;
@@ -45,6 +46,7 @@ public:
           CpuAffinity::PickAndPin("reactor");
         }
 #endif
+        rt::Realtime::EnterThread("reactor", rt::Role::reactor);
         ioc_.run();
       });
     }
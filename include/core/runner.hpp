@@ -1,17 +1,31 @@
 #pragma once
 
+#include "analytics/market_analytics.hpp"
+#include "capture/resume.hpp"
+#include "capture/wire_capture.hpp"
 #include "core/isession.hpp"
 #include "core/message.hpp"
 #include "core/reactor.hpp"
 #include "logging/latency_event.hpp"
+#include "logging/latency_histogram.hpp"
 #include "logging/logger.hpp"
 #include "merge/stream_merger.hpp"
+#include "net/multicast.hpp"
+#include "net/warm_start.hpp"
 #include "sessions/async_session.hpp"
 #include "sessions/sync_session.hpp"
+#include "sink/sink_factory.hpp"
+#include "util/placement.hpp"
+#include "util/realtime.hpp"
+#include "util/startup_timeline.hpp"
 #include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <iostream>
 #include <memory>
 #include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 #ifdef __linux__
 #include <pthread.h>
@@ -26,83 +40,510 @@
 // - Session (sync): dedicated jthread per session; blocking I/O, producer to
 // StreamMerger and FileLogger via SPSC queues
 // - StreamMerger: dedicated jthread; consumes all SPSC, min-heap reorder by `u`
-// on small window (20ms)
+// on small window (20ms), fans out to sinks
+// - SinkWorker: dedicated jthread per output (file, --sink, --shm), each with
+// its own bounded queue and overflow policy
 // - FileLogger: dedicated jthread; drains per-session SPSC rings with writev
-// - Main thread: sleeps to deadline, then stops reactor, joins components
+//   (per-message .lat lines; not started with --no-latency-log)
+// - Latency histograms: each session (the reactor for async) records its
+//   connection's latency, the merger the merged stream's, lock-free
+// - SyncService (--durability): dedicated jthread; fdatasyncs file outputs
+//   per the durability mode, writers only publish settled byte counts
+// - WireRecorder (--wire-capture): dedicated jthread; drains per-session raw
+//   message taps into one file per connection
+// - Placement (util/placement.hpp): reactor or sync sessions, merger and
+//   logger get their CPUs up front from the sysfs topology and the NIC's RX
+//   interrupts; --placement off falls back to per-thread least-busy picks
+// - --realtime: reactor/sessions, merger, logger and pinned sinks go
+//   SCHED_FIFO after pinning (util/realtime.hpp), the spinning ones only on a
+//   CPU of their own; memory is locked before anything is mapped
+// - Startup helpers: one thread per connection prefaults its message slab
+//   while the sessions connect (a session waits for it before its first
+//   read); one takes the /proc/stat sample when least-busy picks are used
+// - Main thread: prints the startup timeline once every connection has
+//   delivered a message, waits for the deadline or, with --seconds 0, for
+//   SIGINT/SIGTERM (reporting latency percentiles every --latency-report
+//   seconds), then stops reactor, joins components; outputs are opened
+//   (with --resume, after scanning the earlier ones) before any session
+//   starts, so a failure there exits with nothing running
 struct RunOptions {
   std::string host;
   std::string port;
   std::string target;
   int numConnections = 2;
   std::string outFile;
+  bool binaryOut = false; // outFile as a binary capture instead of NDJSON
+  io::WriterKind writer = io::WriterKind::write; // I/O path for file sinks
+  std::optional<compress::Codec> compress; // seekable block compression
+  std::optional<sink::SegmentConfig> segment; // rotate outFile into segments
   int seconds = 0;
+  bool analytics = false;
+  std::string shmName; // empty = no shared-memory publishing
+  std::vector<sink::SinkSpec> sinks; // extra outputs besides outFile
+  std::optional<mcast::Endpoint> multicast; // republish merged stream
+  std::string wireCapture; // directory for raw per-connection captures
+  // fdatasync policy for every file output (nullopt = never, no report)
+  std::optional<io::DurabilityConfig> durability;
+  // Warm restart: append to the earlier outputs and continue dedup after
+  // their last `u`; addresses and TLS tickets are kept in stateDir
+  bool resume = false;
+  std::string stateDir = "state";
+  // Per-connection message slots (size limit, hugepages, NUMA node)
+  mem::SlabConfig slab;
+  // What a session does when every slot of its queue is in flight
+  QueueOverflow queueOverflow = QueueOverflow::drop_newest;
+  // SCHED_FIFO for reactor/merger/logger, mlockall, stack prefault
+  rt::Config realtime;
+  // CPU per pipeline thread: topology-aware, explicit roles, or off
+  placement::Config placement;
+  // Per-message latency lines in latencies/*.lat (the FileLogger)
+  bool latencyLog = true;
+  // Percentile report period; 0 = only the whole-run report at the end
+  int latencyReportSeconds = 10;
+  // NDJSON file the latency reports are appended to (empty = stdout only)
+  std::string metricsPath;
 };
 
 enum class RunMode { async, sync };
 
+// Prints the final per-symbol analytics snapshot (one line per symbol)
+inline void PrintAnalytics(const analytics::MarketAnalytics &market) {
+  for (std::size_t i = 0; i < market.SymbolCount(); ++i) {
+    analytics::Snapshot s;
+    if (!market.Read(i, s)) {
+      continue;
+    }
+    std::cout << "[analytics] " << market.SymbolName(i) << " u=" << s.u
+              << " updates=" << s.updates << " mid=" << s.mid
+              << " spread=" << s.spread << " micro=" << s.microprice
+              << " imb=" << s.imbalance << " vol=" << s.ewma_vol
+              << " vwap=" << s.vwap << "\n";
+  }
+}
+
+// Prints per-sink delivery counters (one line per sink)
+inline void PrintSinkStats(const StreamMerger &merger) {
+  for (const auto &w : merger.Sinks()) {
+    const auto &st = w->GetStats();
+    std::cout << "[sink " << w->Name() << "] policy="
+              << sink::PolicyName(w->Policy())
+              << " written=" << st.written.load()
+              << " dropped=" << st.dropped.load()
+              << " conflated=" << st.conflated.load()
+              << " oversize=" << w->Oversize() << " lost=" << w->Lost()
+              << " lost_bytes=" << w->BytesDropped()
+              << " blocked_ms=" << st.blocked_ns.load() / 1'000'000
+              << " max_lag=" << st.max_lag.load()
+              << " max_delay_us=" << st.max_delay_ns.load() / 1000 << "\n";
+  }
+}
+
+// Prints per-connection queue counters: every message read from the wire
+// is published, dropped by the overflow policy or dropped by the merger
+inline void
+PrintQueueStats(const std::vector<std::shared_ptr<RawOrderQueue>> &queues) {
+  for (std::size_t i = 0; i < queues.size(); ++i) {
+    const auto &st = queues[i]->GetStats();
+    std::cout << "[queue conn " << i << "] policy="
+              << QueueOverflowName(queues[i]->Overflow())
+              << " published=" << st.published.load()
+              << " dropped_newest=" << st.dropped_newest.load()
+              << " dropped_oldest=" << st.dropped_oldest.load()
+              << " blocked_ms=" << st.blocked_ns.load() / 1'000'000
+              << " duplicates=" << st.duplicates.load()
+              << " unparsed=" << st.unparsed.load()
+              << " latency_dropped=" << st.latency_dropped.load();
+    if (st.publish_failed.load() != 0) {
+      std::cout << " publish_failed=" << st.publish_failed.load();
+    }
+    std::cout << "\n";
+  }
+}
+
+// The startup timeline is printed at the latest this long after startup
+inline constexpr std::chrono::seconds kStartupReportAfter{10};
+// How often the main thread checks for SIGINT/SIGTERM while it waits
+inline constexpr std::chrono::milliseconds kStopPoll{100};
+
+namespace detail {
+// Set by SIGINT/SIGTERM; the main thread then stops the run as at the
+// deadline
+inline volatile std::sig_atomic_t g_stop_signal = 0;
+inline void OnStopSignal(int) { g_stop_signal = 1; }
+} // namespace detail
+
+// Waits until every connection delivered its first message (or `until`),
+// then prints the startup timeline
+inline void
+PrintStartupTimeline(const std::vector<std::shared_ptr<RawOrderQueue>> &queues,
+                     std::chrono::steady_clock::time_point until) {
+  std::vector<bool> seen(queues.size(), false);
+  std::size_t pending = queues.size();
+  while (pending != 0 && std::chrono::steady_clock::now() < until) {
+    for (std::size_t i = 0; i < queues.size(); ++i) {
+      const std::int64_t ns =
+          queues[i]->GetStats().first_recv_ns.load(std::memory_order_relaxed);
+      if (!seen[i] && ns != 0) {
+        seen[i] = true;
+        --pending;
+        StartupTimeline::MarkAt(ns, "conn " + std::to_string(i) +
+                                        " first message");
+      }
+    }
+    if (pending != 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  for (const auto &line : StartupTimeline::Finish()) {
+    std::cout << "[startup] " << line << "\n";
+  }
+  if (pending != 0) {
+    std::cout << "[startup] " << pending << " of " << queues.size()
+              << " connections had no message yet\n";
+  }
+}
+
 inline int Run(const RunOptions &opt, RunMode mode) {
-  // Init
+  // SIGINT/SIGTERM end the run like the deadline, whenever they arrive
+  std::signal(SIGINT, detail::OnStopSignal);
+  std::signal(SIGTERM, detail::OnStopSignal);
+  // Real-time mode first: with memory locked, every mapping made below
+  // (slabs, rings, sink queues, thread stacks) is resident when created
+  rt::Realtime::Configure(opt.realtime);
+  if (opt.realtime.enabled) {
+    for (const auto &finding : rt::Realtime::CheckSystem()) {
+      std::cout << "[realtime] " << finding << "\n";
+    }
+    if (opt.realtime.lock_memory) {
+      (void)rt::Realtime::LockMemory();
+    }
+  }
+  // Least-busy picks (--placement off, unpinned helpers) share one
+  // /proc/stat sample; take it while everything else starts
+  std::jthread sampler;
+  if (!opt.placement.enabled || !opt.wireCapture.empty()) {
+    sampler = std::jthread([] { CpuAffinity::Sample(); });
+  }
+  // CPUs for the pipeline threads, decided before any of them starts
+  std::vector<std::string> producers;
+  if (mode == RunMode::async) {
+    producers.push_back("reactor");
+  } else {
+    for (int i = 0; i < opt.numConnections; ++i) {
+      producers.push_back("session" + std::to_string(i));
+    }
+  }
+  std::vector<std::string> consumers{"merger"};
+  if (opt.latencyLog) {
+    consumers.push_back("logger");
+  }
+  const placement::Plan plan =
+      placement::Place(opt.placement, producers, consumers);
+  for (const auto &note : plan.notes) {
+    std::cout << "[placement] " << note << "\n";
+  }
+  for (const auto &slot : plan.slots) {
+    std::cout << "[placement] " << slot.role << " -> cpu " << slot.cpu
+              << " (" << slot.why << ")\n";
+    CpuAffinity::Reserve(slot.cpu);
+    rt::Realtime::PlanCpu(slot.cpu, slot.role);
+  }
+  StartupTimeline::Mark("placement planned");
+  // Init: message slots are mapped here, once; they are prefaulted on
+  // helper threads once the sessions are connecting
   std::vector<std::shared_ptr<RawOrderQueue>> queues;
   queues.reserve(opt.numConnections);
+  const auto slab0 = std::chrono::steady_clock::now();
+  mem::SlabConfig slabCfg = opt.slab;
+  slabCfg.defer_prefault = true;
   for (int i = 0; i < opt.numConnections; ++i) {
-    queues.push_back(std::make_shared<RawOrderQueue>());
+    auto q = RawOrderQueue::Create(slabCfg, opt.queueOverflow);
+    if (!q) {
+      std::cerr << "[runner] message slab error: " << q.error().message()
+                << "\n";
+      return 1;
+    }
+    queues.push_back(std::move(*q));
+  }
+  {
+    const mem::SlabArena &slab = queues[0]->Slab();
+    std::cout << "[slab] " << opt.numConnections << " x " << slab.Slots()
+              << " slots x " << slab.SlotBytes() << " B = "
+              << (slab.Bytes() * queues.size()) / (1u << 20) << " MiB pages="
+              << (slab.OnHugepages() ? "huge"
+                  : opt.slab.hugepages ? "thp"
+                                       : "4k")
+              << " node="
+              << (slab.Node() < 0 ? std::string("any")
+                                  : std::to_string(slab.Node()))
+              << " prefault="
+              << (opt.slab.prefault ? "background" : "no") << " (mapped in "
+              << std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - slab0)
+                     .count()
+              << " ms)\n";
+  }
+  StartupTimeline::Mark("queues mapped");
+  // Latency histograms per connection and of the merged stream, reported
+  // by the main thread; per-message SPSC queues to the logger only with
+  // per-line logging
+  logging::LatencyReporter reporter;
+  if (!opt.metricsPath.empty()) {
+    if (auto ec = reporter.OpenMetrics(opt.metricsPath)) {
+      std::cerr << "[runner] metrics " << opt.metricsPath
+                << " error: " << ec.message() << "\n";
+      return 1;
+    }
   }
-  // Latency SPSC queues per session
-  std::vector<std::shared_ptr<logging::LatencyQueue>> latency_queues;
-  latency_queues.reserve(opt.numConnections);
+  std::vector<std::shared_ptr<logging::LatencyHistogram>> histograms;
+  std::vector<std::shared_ptr<logging::LatencyQueue>> latency_queues(
+      opt.numConnections);
+  histograms.reserve(opt.numConnections);
   for (int i = 0; i < opt.numConnections; ++i) {
-    latency_queues.emplace_back(std::make_shared<logging::LatencyQueue>());
+    histograms.push_back(std::make_shared<logging::LatencyHistogram>());
+    reporter.Add("conn " + std::to_string(i), histograms.back());
+    if (opt.latencyLog) {
+      latency_queues[i] = std::make_shared<logging::LatencyQueue>();
+    }
+  }
+  auto mergedLatency = std::make_shared<logging::LatencyHistogram>();
+  reporter.Add("merged", mergedLatency);
+  // Durability: one fdatasync thread for all file outputs, off the write
+  // paths
+  std::shared_ptr<io::SyncService> sync;
+  if (opt.durability.has_value()) {
+    sync = std::make_shared<io::SyncService>(*opt.durability);
+    sync->Start();
   }
   FileLogger logger;
+  logger.SetWriterKind(opt.writer);
+  logger.SetDurability(sync);
+  // Raw wire taps per session (empty = capture off)
+  std::optional<capture::WireRecorder> wire;
+  std::vector<std::shared_ptr<capture::WireTap>> taps(opt.numConnections);
+  if (!opt.wireCapture.empty()) {
+    std::error_code ec;
+    std::filesystem::create_directories(opt.wireCapture, ec);
+    wire.emplace(
+        capture::WireRecorder::Config{.writer = opt.writer, .sync = sync});
+    for (int i = 0; i < opt.numConnections; ++i) {
+      const std::string path =
+          opt.wireCapture + "/" +
+          (mode == RunMode::async ? "async_conn" : "sync_conn") + "_" +
+          std::to_string(i) + "_" + timeutil::TimestampForFile() + ".wire";
+      auto tap = wire->AddConnection(static_cast<std::uint32_t>(i), path);
+      if (!tap) {
+        std::cerr << "[runner] wire capture " << path
+                  << " error: " << tap.error().message() << "\n";
+        return 1;
+      }
+      taps[i] = std::move(*tap);
+    }
+    wire->Start();
+  }
+  // Outputs are opened (and resume points found) before any session
+  // starts: failing here returns with no connection or reactor running
+  StreamMerger merger{queues};
+  // The primary file never loses data; extra outputs default to dropping
+  std::vector<sink::SinkSpec> specs(1);
+  specs[0].kind = opt.binaryOut ? "bin" : "file";
+  specs[0].target = opt.outFile;
+  specs[0].writer = opt.writer;
+  specs[0].compress = opt.compress;
+  specs[0].segment = opt.segment;
+  specs[0].sync = sync;
+  for (sink::SinkSpec spec : opt.sinks) {
+    spec.writer = opt.writer;
+    spec.compress = opt.compress;
+    spec.sync = sync;
+    specs.push_back(std::move(spec));
+  }
+  // Warm restart: file outputs continue where the last run stopped
+  if (opt.resume) {
+    for (auto &spec : specs) {
+      if (spec.kind != "file" && spec.kind != "bin") {
+        continue;
+      }
+      const auto t0 = std::chrono::steady_clock::now();
+      auto rp = capture::FindResumePoint(spec.target, spec.kind == "bin",
+                                         spec.compress.has_value(),
+                                         spec.segment.has_value());
+      if (!rp) {
+        std::cerr << "[runner] resume " << spec.target
+                  << " error: " << rp.error().message() << "\n";
+        return 1;
+      }
+      std::cout << "[resume] " << spec.target;
+      if (rp->found) {
+        std::cout << " last_u=" << rp->last_u << " offset=" << rp->bytes
+                  << " truncated=" << rp->truncated;
+        if (spec.segment.has_value()) {
+          std::cout << " next_segment=" << rp->next_segment;
+        }
+      } else {
+        std::cout << " not found, starting fresh";
+      }
+      std::cout << " ("
+                << std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - t0)
+                       .count()
+                << " ms)\n";
+      // The primary output decides where the merged stream continues
+      if (&spec == &specs[0]) {
+        merger.SetResumePoint(rp->last_u);
+      }
+      spec.resume =
+          std::make_shared<const capture::ResumePoint>(std::move(*rp));
+    }
+  }
+  // Sink slots hold the largest message a session can read, so no output
+  // (least of all the primary file) drops a message for its size
+  const std::size_t sinkSlot =
+      sink::SinkWorker::SlotSizeFor(queues[0]->MaxMessage());
+  for (auto &spec : specs) {
+    spec.cfg.slot_size = std::max(spec.cfg.slot_size, sinkSlot);
+    auto s = sink::MakeSink(spec);
+    if (!s) {
+      std::cerr << "[runner] sink " << spec.kind << ":" << spec.target
+                << " error: " << s.error().message() << "\n";
+      return 1;
+    }
+    merger.AddSink(std::move(*s), spec.cfg);
+  }
+  // --shm is published by the merger itself; `--sink shm:NAME` goes
+  // through a sink queue and thread instead
+  if (!opt.shmName.empty()) {
+    if (auto st = merger.EnableSharedMemory(
+            opt.shmName, ipc::ShmRingConfig{.slot_size = sinkSlot});
+        !st) {
+      std::cerr << "[runner] shared memory '" << opt.shmName
+                << "' error: " << st.error().message() << "\n";
+      return 1;
+    }
+  }
+  std::unique_ptr<mcast::MulticastPublisher> publisher;
+  if (opt.multicast.has_value()) {
+    publisher = std::make_unique<mcast::MulticastPublisher>(
+        merger.Subscribe("multicast"),
+        mcast::MulticastPublisher::Config{.endpoint = *opt.multicast});
+    if (auto st = publisher->Open(); !st) {
+      std::cerr << "[runner] multicast " << opt.multicast->group << ":"
+                << opt.multicast->port << " error: " << st.error().message()
+                << "\n";
+      return 1;
+    }
+  }
+  std::shared_ptr<warm::ConnectCache> warm;
+  if (opt.resume) {
+    warm = std::make_shared<warm::ConnectCache>(opt.stateDir, opt.host,
+                                                opt.port);
+  }
   std::optional<Reactor> reactor;
   std::vector<std::unique_ptr<ISession>> sessions;
   if (mode == RunMode::async) {
     reactor.emplace();
-    reactor->Start(1);
+    if (warm) {
+      warm->Attach(reactor->GetSslContext());
+    }
+    reactor->Start(1, plan.Cpu("reactor"));
     sessions.reserve(opt.numConnections);
     for (int i = 0; i < opt.numConnections; ++i) {
-      // Attach external latency queue for this session
-      const std::string ts = ""; // file path will be set when attaching
-      (void)ts;
       sessions.emplace_back(std::make_unique<AsyncSession>(
           i, reactor->GetIoContext(), reactor->GetSslContext(), opt.host,
-          opt.port, opt.target, queues[i], latency_queues[i]));
+          opt.port, opt.target, queues[i], histograms[i], latency_queues[i],
+          taps[i], warm));
     }
   } else {
     sessions.reserve(opt.numConnections);
     for (int i = 0; i < opt.numConnections; ++i) {
-      sessions.emplace_back(std::make_unique<SyncSession>(
-          i, opt.host, opt.port, opt.target, queues[i], latency_queues[i]));
+      auto session = std::make_unique<SyncSession>(
+          i, opt.host, opt.port, opt.target, queues[i], histograms[i],
+          latency_queues[i], taps[i], warm);
+      session->SetCpu(plan.Cpu("session" + std::to_string(i)));
+      sessions.push_back(std::move(session));
     }
   }
-  // Start
-  // Register external queues with logger and open per-session files
-  for (int i = 0; i < opt.numConnections; ++i) {
-    std::string path = std::string("latencies/") +
-                       (mode == RunMode::async ? "async_conn" : "sync_conn") +
-                       "_" + std::to_string(i) + "_" +
-                       timeutil::TimestampForFile() + ".lat";
-    (void)logger.AddSession(latency_queues[i], path);
-  }
-  logger.Start();
+  // Start: connects first, everything below overlaps them
   for (auto &s : sessions) {
     s->Start();
   }
+  StartupTimeline::Mark("sessions started");
+  const auto runStart = std::chrono::steady_clock::now();
+  // Prefault the slabs while the connects are in flight; first touch from
+  // the connection's producer CPU keeps the pages on its node
+  std::vector<std::jthread> prefaulters;
+  if (opt.slab.prefault) {
+    prefaulters.reserve(queues.size());
+    for (int i = 0; i < opt.numConnections; ++i) {
+      const auto cpu =
+          plan.Cpu(mode == RunMode::async ? std::string("reactor")
+                                          : "session" + std::to_string(i));
+      prefaulters.emplace_back([q = queues[i], cpu, i] {
+        if (cpu.has_value()) {
+          (void)CpuAffinity::BindThisThreadToCpu(*cpu);
+        }
+        q->Prefault();
+        StartupTimeline::Mark("conn " + std::to_string(i) +
+                              " slots prefaulted");
+      });
+    }
+  }
+  // Register external queues with logger and open per-session files
+  if (opt.latencyLog) {
+    for (int i = 0; i < opt.numConnections; ++i) {
+      std::string path =
+          std::string("latencies/") +
+          (mode == RunMode::async ? "async_conn" : "sync_conn") + "_" +
+          std::to_string(i) + "_" + timeutil::TimestampForFile() + ".lat";
+      (void)logger.AddSession(latency_queues[i], path);
+    }
+    logger.Start(plan.Cpu("logger"));
+  }
+  if (publisher) {
+    publisher->Start();
+  }
+  std::shared_ptr<analytics::MarketAnalytics> market;
+  if (opt.analytics) {
+    market = std::make_shared<analytics::MarketAnalytics>();
+    merger.SetAnalytics(market);
+  }
   std::optional<std::chrono::steady_clock::time_point> deadline;
-  StreamMerger merger{queues, opt.outFile};
-  if (!merger.OpenOk()) {
-    return 1;
+  merger.SetLatencyHistogram(mergedLatency);
+  merger.Start(plan.Cpu("merger"));
+  StartupTimeline::Mark("merger started");
+  for (auto &t : prefaulters) {
+    t.join();
   }
-  merger.Start();
-  // Wait for deadline
   if (opt.seconds > 0) {
     deadline =
         std::chrono::steady_clock::now() + std::chrono::seconds(opt.seconds);
   }
-  if (deadline.has_value()) {
-    const auto now = std::chrono::steady_clock::now();
-    if (deadline > now) {
-      std::this_thread::sleep_until(*deadline);
+  PrintStartupTimeline(queues,
+                       std::min(deadline.value_or(
+                                    std::chrono::steady_clock::time_point::max()),
+                                std::chrono::steady_clock::now() +
+                                    kStartupReportAfter));
+  // Wait for the deadline or, without one, for SIGINT/SIGTERM; either way
+  // report the latency of each period on the way
+  {
+    const std::chrono::seconds period(opt.latencyReportSeconds);
+    const auto until =
+        deadline.value_or(std::chrono::steady_clock::time_point::max());
+    auto last = runStart;
+    while (detail::g_stop_signal == 0) {
+      const auto next =
+          period.count() > 0 ? std::min(until, last + period) : until;
+      std::this_thread::sleep_until(
+          std::min(next, std::chrono::steady_clock::now() + kStopPoll));
+      const auto now = std::chrono::steady_clock::now();
+      if (now >= until) {
+        break;
+      }
+      if (now >= next) {
+        reporter.Report(std::cout,
+                        std::chrono::duration<double>(next - last).count());
+        last = next;
+      }
     }
   }
   // Stop
@@ -111,6 +552,34 @@ inline int Run(const RunOptions &opt, RunMode mode) {
   }
   sessions.clear();
   merger.Join();
+  if (publisher) {
+    publisher->Join();
+  }
   logger.Join();
+  if (wire.has_value()) {
+    wire->Join();
+    for (const auto &t : wire->Taps()) {
+      std::cout << "[wire conn " << t->Conn() << "] recorded=" << t->Recorded()
+                << " dropped=" << t->Dropped() << "\n";
+    }
+  }
+  if (sync) {
+    sync->Stop();
+    std::cout << "[durability] " << sync->Report() << "\n";
+  }
+  PrintQueueStats(queues);
+  PrintSinkStats(merger);
+  if (const auto *shm = merger.SharedMemory()) {
+    std::cout << "[shm " << opt.shmName
+              << "] published=" << shm->Ring().Head()
+              << " oversize=" << shm->Ring().Oversize()
+              << " pages=" << (shm->OnHugepages() ? "huge" : "4k") << "\n";
+  }
+  reporter.ReportRun(std::cout, std::chrono::duration<double>(
+                                    std::chrono::steady_clock::now() - runStart)
+                                    .count());
+  if (market) {
+    PrintAnalytics(*market);
+  }
   return 0;
 }
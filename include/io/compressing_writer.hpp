@@ -0,0 +1,302 @@
+#pragma once
+
+#include "compress/block_codec.hpp"
+#include "io/writer.hpp"
+#include "util/branch.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <expected>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace io {
+
+struct CompressConfig {
+  compress::Codec codec = compress::Codec::zstd;
+  int level = 3;                       // zstd only
+  std::size_t block_bytes = 1u << 20;  // uncompressed bytes per frame
+  unsigned workers = 2;                // compression threads
+  std::chrono::milliseconds max_block_age{1000}; // Flush() cuts older blocks
+};
+
+// CompressingWriter — block compression in front of another IWriter.
+// Threading model:
+// - Caller thread (sink): memcpy into the current block; a full block is
+//   handed to the pool with one mutex/condvar exchange and the next free
+//   block is taken; finished frames are written to the inner writer in
+//   order at block boundaries and on Flush
+// - `workers` std::jthreads compress blocks, each into an independent frame
+// The caller only waits if every block slot is still being compressed
+// (stats.stalls). A block the codec fails on is written as a stored
+// (uncompressed) frame instead (stats.stored). Every frame is preceded by a
+// checkpoint holding its sizes, and on destruction the tail block is
+// compressed and a seek table (compress::FrameEntry per frame) is appended,
+// so readers can jump to any frame, and a crashed capture can still be
+// indexed from its checkpoints; see compress::SeekableReader.
+class CompressingWriter : public IWriter {
+public:
+  struct Stats {
+    std::uint64_t frames = 0;
+    std::uint64_t raw_bytes = 0;
+    std::uint64_t compressed_bytes = 0;
+    std::uint64_t stalls = 0;
+    std::uint64_t stored = 0; // compression failed: frame kept uncompressed
+    std::uint64_t errors = 0;
+  };
+
+  static std::expected<std::unique_ptr<CompressingWriter>, std::error_code>
+  Create(std::unique_ptr<IWriter> inner, CompressConfig cfg = {}) {
+    auto codec = compress::BlockCodec::Load(cfg.codec, cfg.level);
+    if (!codec) {
+      return std::unexpected(codec.error());
+    }
+    if (cfg.workers == 0 || cfg.block_bytes == 0 ||
+        cfg.block_bytes > 0xFFFFFFFFu) {
+      return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+    return std::unique_ptr<CompressingWriter>(
+        new CompressingWriter(std::move(inner), cfg, *codec));
+  }
+
+  ~CompressingWriter() override {
+    if (have_cur_ && Cur().len != 0) {
+      Submit();
+    }
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      while (write_seq_ < submit_seq_) {
+        done_cv_.wait(lock, [this] { return Slot(write_seq_).done; });
+        lock.unlock();
+        WriteCompleted();
+        lock.lock();
+      }
+      stop_ = true;
+    }
+    work_cv_.notify_all();
+    workers_.clear();
+    WriteSeekTable();
+    inner_->Flush();
+  }
+
+  CompressingWriter(const CompressingWriter &) = delete;
+  CompressingWriter &operator=(const CompressingWriter &) = delete;
+
+  void Writev(struct iovec *iov, int cnt) override {
+    for (int i = 0; i < cnt; ++i) {
+      const char *p = static_cast<const char *>(iov[i].iov_base);
+      std::size_t len = iov[i].iov_len;
+      size_ += len;
+      while (len != 0) {
+        if (BRANCH_UNLIKELY(!have_cur_)) {
+          Acquire();
+        }
+        Block &b = Cur();
+        const std::size_t n = std::min(len, cfg_.block_bytes - b.len);
+        std::memcpy(b.in.data() + b.len, p, n);
+        b.len += n;
+        p += n;
+        len -= n;
+        if (b.len == cfg_.block_bytes) {
+          Submit();
+        }
+      }
+    }
+  }
+
+  // Writes finished frames; also cuts the current block once it is older
+  // than max_block_age so a quiet stream still reaches the disk
+  void Flush() override {
+    if (have_cur_ && Cur().len != 0 &&
+        std::chrono::steady_clock::now() - cur_started_ >=
+            cfg_.max_block_age) {
+      Submit();
+    }
+    WriteCompleted();
+    inner_->Flush();
+    if (inner_->Settled() == inner_->Size()) {
+      settled_ = stats_.raw_bytes;
+    }
+  }
+
+  std::uint64_t Size() const override { return size_; }
+  // Input bytes whose frames had fully reached the file at the last Flush
+  std::uint64_t Settled() const override { return settled_; }
+  int Fd() const override { return inner_->Fd(); }
+  // Input bytes of blocks that could not even be stored, plus the (frame)
+  // bytes the inner writer dropped
+  std::uint64_t Dropped() const override {
+    return dropped_ + inner_->Dropped();
+  }
+  const Stats &GetStats() const { return stats_; }
+
+private:
+  struct Block {
+    std::vector<char> in;
+    std::vector<char> out;
+    std::size_t len = 0;     // uncompressed bytes staged
+    std::size_t out_len = 0; // frame size, 0 = could not even be stored
+    bool stored = false;     // compression failed, written uncompressed
+    bool busy = false;       // filling, queued or compressing
+    bool done = false;       // frame ready to be written
+  };
+
+  CompressingWriter(std::unique_ptr<IWriter> inner, CompressConfig cfg,
+                    compress::BlockCodec codec)
+      : inner_(std::move(inner)), cfg_(cfg), codec_(codec),
+        blocks_(cfg.workers * 2 + 1) {
+    for (Block &b : blocks_) {
+      b.in.resize(cfg_.block_bytes);
+      b.out.resize(std::max(codec_.Bound(cfg_.block_bytes),
+                            codec_.StoredBound(cfg_.block_bytes)));
+    }
+    for (unsigned i = 0; i < cfg_.workers; ++i) {
+      workers_.emplace_back([this] { WorkerLoop(); });
+    }
+  }
+
+  Block &Slot(std::uint64_t seq) { return blocks_[seq % blocks_.size()]; }
+  Block &Cur() { return Slot(submit_seq_); }
+
+  void Acquire() {
+    std::unique_lock<std::mutex> lock(mu_);
+    if (Cur().busy) {
+      ++stats_.stalls;
+      // The slot is reused by the oldest unwritten block: wait for it
+      while (Cur().busy) {
+        done_cv_.wait(lock, [this] { return Slot(write_seq_).done; });
+        lock.unlock();
+        WriteCompleted();
+        lock.lock();
+      }
+    }
+    Block &b = Cur();
+    b.busy = true;
+    b.done = false;
+    b.len = 0;
+    have_cur_ = true;
+    cur_started_ = std::chrono::steady_clock::now();
+  }
+
+  void Submit() {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      queue_.push_back(submit_seq_);
+      ++submit_seq_;
+      have_cur_ = false;
+    }
+    work_cv_.notify_one();
+    WriteCompleted();
+  }
+
+  // Writes finished frames in sequence order (caller thread only)
+  void WriteCompleted() {
+    for (;;) {
+      Block *b = nullptr;
+      {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (write_seq_ == submit_seq_ || !Slot(write_seq_).done) {
+          return;
+        }
+        b = &Slot(write_seq_);
+      }
+      if (BRANCH_LIKELY(b->out_len != 0)) {
+        const auto sizes = compress::FrameEntry{
+            static_cast<std::uint32_t>(b->out_len),
+            static_cast<std::uint32_t>(b->len)};
+        std::uint32_t cp[4] = {compress::kCheckpointMagic, 8, sizes.compressed,
+                               sizes.decompressed};
+        struct iovec iov[2] = {{cp, sizeof(cp)}, {b->out.data(), b->out_len}};
+        inner_->Writev(iov, 2);
+        index_.push_back({compress::kCheckpointBytes, 0});
+        index_.push_back(sizes);
+        ++stats_.frames;
+        stats_.stored += b->stored ? 1 : 0;
+        stats_.raw_bytes += b->len;
+        stats_.compressed_bytes += b->out_len;
+      } else {
+        ++stats_.errors;
+        dropped_ += b->len;
+      }
+      std::lock_guard<std::mutex> lock(mu_);
+      b->busy = false;
+      b->done = false;
+      ++write_seq_;
+    }
+  }
+
+  void WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mu_);
+    for (;;) {
+      work_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      Block &b = Slot(queue_.front());
+      queue_.pop_front();
+      lock.unlock();
+      b.out_len =
+          codec_.Compress(b.in.data(), b.len, b.out.data(), b.out.size());
+      b.stored = b.out_len == 0;
+      if (BRANCH_UNLIKELY(b.stored)) {
+        b.out_len =
+            codec_.Store(b.in.data(), b.len, b.out.data(), b.out.size());
+      }
+      lock.lock();
+      b.done = true;
+      done_cv_.notify_all();
+    }
+  }
+
+  void WriteSeekTable() {
+    const auto n = static_cast<std::uint32_t>(index_.size());
+    std::vector<char> t(8 + n * sizeof(compress::FrameEntry) +
+                        compress::kSeekFooterBytes);
+    char *p = t.data();
+    auto put32 = [&p](std::uint32_t v) {
+      std::memcpy(p, &v, 4);
+      p += 4;
+    };
+    put32(compress::kSkippableMagic);
+    put32(static_cast<std::uint32_t>(t.size() - 8));
+    for (const auto &e : index_) {
+      put32(e.compressed);
+      put32(e.decompressed);
+    }
+    put32(n);
+    *p++ = 0; // descriptor: no per-frame checksums
+    put32(compress::kSeekableMagic);
+    inner_->Write(t.data(), t.size());
+  }
+
+  std::unique_ptr<IWriter> inner_;
+  CompressConfig cfg_;
+  compress::BlockCodec codec_;
+  std::vector<Block> blocks_;
+  // Sequence numbers: blocks [write_seq_, submit_seq_) are queued or being
+  // compressed; Slot(submit_seq_) is being filled when have_cur_
+  std::uint64_t submit_seq_ = 0;
+  std::uint64_t write_seq_ = 0;
+  bool have_cur_ = false;
+  std::chrono::steady_clock::time_point cur_started_{};
+  std::mutex mu_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  std::deque<std::uint64_t> queue_;
+  bool stop_ = false;
+  std::vector<compress::FrameEntry> index_;
+  std::uint64_t size_ = 0;
+  std::uint64_t settled_ = 0;
+  std::uint64_t dropped_ = 0;
+  Stats stats_;
+  std::vector<std::jthread> workers_;
+};
+
+} // namespace io
@@ -0,0 +1,478 @@
+#pragma once
+
+#include "io/writer.hpp"
+#include "util/branch.hpp"
+#include "util/cpu_affinity.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace io {
+
+// When file outputs are made durable (fdatasync), off the writing threads:
+// - none: never; the kernel writes dirty pages back on its own schedule
+// - periodic: every `interval`, whatever has reached the kernel by then
+// - group: as soon as `bytes` are pending or the oldest pending byte is
+//   `interval` old; one fdatasync commits everything written before it
+enum class DurabilityMode { none, periodic, group };
+
+struct DurabilityConfig {
+  DurabilityMode mode = DurabilityMode::none;
+  std::chrono::milliseconds interval{1000};
+  std::uint64_t bytes = 1u << 20; // group only
+};
+
+inline const char *DurabilityName(DurabilityMode m) {
+  switch (m) {
+  case DurabilityMode::periodic:
+    return "periodic";
+  case DurabilityMode::group:
+    return "group";
+  default:
+    return "none";
+  }
+}
+
+// "none" | "periodic[:MS]" | "group[:MS[,BYTES]]" (BYTES may end in K/M/G)
+inline std::optional<DurabilityConfig> ParseDurability(std::string_view s) {
+  DurabilityConfig cfg;
+  const std::size_t colon = s.find(':');
+  const std::string_view mode = s.substr(0, colon);
+  if (mode == "none") {
+    return colon == std::string_view::npos ? std::optional(cfg) : std::nullopt;
+  }
+  if (mode == "periodic") {
+    cfg.mode = DurabilityMode::periodic;
+  } else if (mode == "group") {
+    cfg.mode = DurabilityMode::group;
+    cfg.interval = std::chrono::milliseconds(10);
+  } else {
+    return std::nullopt;
+  }
+  if (colon == std::string_view::npos) {
+    return cfg;
+  }
+  const std::string rest(s.substr(colon + 1));
+  char *end = nullptr;
+  const long ms = std::strtol(rest.c_str(), &end, 10);
+  if (end == rest.c_str() || ms <= 0) {
+    return std::nullopt;
+  }
+  cfg.interval = std::chrono::milliseconds(ms);
+  if (*end == ',' && cfg.mode == DurabilityMode::group) {
+    const char *b = end + 1;
+    std::uint64_t v = std::strtoull(b, &end, 10);
+    switch (*end) {
+    case 'K':
+    case 'k':
+      v <<= 10, ++end;
+      break;
+    case 'M':
+    case 'm':
+      v <<= 20, ++end;
+      break;
+    case 'G':
+    case 'g':
+      v <<= 30, ++end;
+      break;
+    default:
+      break;
+    }
+    if (end == b || v == 0) {
+      return std::nullopt;
+    }
+    cfg.bytes = v;
+  }
+  return *end == '\0' ? std::optional(cfg) : std::nullopt;
+}
+
+// One tracked file. The writing thread publishes how far its bytes have
+// reached the kernel; the sync thread owns everything else. The descriptor
+// is a dup, so syncing never races the writer closing its own.
+struct SyncTarget {
+  SyncTarget(int dupFd, std::string p) : fd(dupFd), path(std::move(p)) {}
+  ~SyncTarget() {
+    if (fd != -1) {
+      ::close(fd);
+    }
+  }
+  SyncTarget(const SyncTarget &) = delete;
+  SyncTarget &operator=(const SyncTarget &) = delete;
+
+  // Writer thread, after a Flush: `n` logical bytes are in the kernel, the
+  // oldest of those not yet durable was written at `writtenNs`
+  void Settle(std::uint64_t n, std::int64_t writtenNs) {
+    settled.store(n);
+    if (pending_since.load() == 0) {
+      std::int64_t none = 0;
+      (void)pending_since.compare_exchange_strong(none, writtenNs);
+    }
+  }
+
+  // Writer closed the file (everything it wrote is in the kernel). Once the
+  // service has stopped, the last sync happens here.
+  void Close() {
+    closed.store(true);
+    if (orphaned.load()) {
+      (void)::fdatasync(fd);
+    }
+  }
+
+  static std::int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  const int fd;
+  const std::string path;
+  std::atomic<std::uint64_t> settled{0};
+  // steady ns when the oldest not yet durable byte was written, 0 = none
+  std::atomic<std::int64_t> pending_since{0};
+  std::atomic<bool> closed{false};
+  std::atomic<bool> orphaned{false};
+  std::uint64_t durable = 0; // sync thread only
+  bool dir_synced = false;   // sync thread only
+};
+
+// SyncService
+// Threading model:
+// - One background std::jthread issues every fdatasync; writers never block
+//   on the disk, they only publish a settled byte count from Flush()
+// - The thread polls its targets (no wakeups from the write path), so the
+//   group trigger fires within one poll tick of becoming due
+// - Stats are written by the sync thread and read after Stop()
+class SyncService {
+public:
+  struct Stats {
+    std::uint64_t syncs = 0;
+    std::uint64_t errors = 0;
+    std::uint64_t max_sync_ns = 0;
+    std::uint64_t sync_ns_total = 0;
+    // fdatasync latency, bucket i counts syncs in [2^i, 2^(i+1)) us
+    std::uint64_t sync_us_log2[32] = {};
+    // Data-at-risk window: longest time from a byte being written to it
+    // being durable, and the most bytes one sync had to commit
+    std::uint64_t max_risk_ns = 0;
+    std::uint64_t max_risk_bytes = 0;
+
+    // Upper bound of the bucket holding quantile q, in us
+    std::uint64_t SyncUsQuantile(double q) const {
+      if (syncs == 0) {
+        return 0;
+      }
+      const auto rank = static_cast<std::uint64_t>(q * (syncs - 1)) + 1;
+      std::uint64_t seen = 0;
+      for (int i = 0; i < 32; ++i) {
+        seen += sync_us_log2[i];
+        if (seen >= rank) {
+          return std::uint64_t{1} << (i + 1);
+        }
+      }
+      return std::uint64_t{1} << 32;
+    }
+  };
+
+  explicit SyncService(DurabilityConfig cfg) : cfg_(cfg) {}
+  ~SyncService() { Stop(); }
+
+  const DurabilityConfig &Config() const { return cfg_; }
+
+  // Registers an open file (any thread). Returns nullptr in mode none or if
+  // the writer has no descriptor: such outputs are not tracked.
+  std::shared_ptr<SyncTarget> Track(int fd, const std::string &path) {
+    if (cfg_.mode == DurabilityMode::none || fd < 0) {
+      return nullptr;
+    }
+    const int dup = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (dup == -1) {
+      return nullptr;
+    }
+    auto t = std::make_shared<SyncTarget>(dup, path);
+    std::lock_guard<std::mutex> lock(mu_);
+    if (stopped_) {
+      t->orphaned.store(true);
+    }
+    added_.push_back(t);
+    return t;
+  }
+
+  void Start(std::optional<int> pinCpu = std::nullopt) {
+    if (cfg_.mode == DurabilityMode::none || worker_.joinable()) {
+      return;
+    }
+    worker_ = std::jthread([this, pinCpu](std::stop_token st) {
+#ifdef __linux__
+      if (pinCpu.has_value()) {
+        CpuAffinity::PinThisThreadToCpu("durability", *pinCpu);
+      }
+#endif
+      Run(st);
+    });
+  }
+
+  // Commits everything settled so far and stops; files still open sync
+  // themselves when they close
+  void Stop() {
+    if (worker_.joinable()) {
+      worker_.request_stop();
+      worker_.join();
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    if (stopped_) {
+      return;
+    }
+    stopped_ = true;
+    for (auto *list : {&targets_, &added_}) {
+      for (auto &t : *list) {
+        t->orphaned.store(true);
+        // Closed after the final pass: Close() may have missed `orphaned`
+        if (t->closed.load()) {
+          (void)::fdatasync(t->fd);
+        }
+      }
+    }
+  }
+
+  const Stats &GetStats() const { return stats_; }
+
+  // One-line summary for the end-of-run report
+  std::string Report() const {
+    char buf[320];
+    if (cfg_.mode == DurabilityMode::none) {
+      std::snprintf(buf, sizeof(buf),
+                    "mode=none at_risk=unbounded (kernel writeback, "
+                    "dirty_expire=%lldms)",
+                    static_cast<long long>(DirtyExpireMs()));
+      return buf;
+    }
+    const Stats &s = stats_;
+    char trigger[64];
+    std::snprintf(trigger, sizeof(trigger), "interval_ms=%lld",
+                  static_cast<long long>(cfg_.interval.count()));
+    if (cfg_.mode == DurabilityMode::group) {
+      const std::size_t n = std::strlen(trigger);
+      std::snprintf(trigger + n, sizeof(trigger) - n, " bytes=%llu",
+                    static_cast<unsigned long long>(cfg_.bytes));
+    }
+    std::snprintf(
+        buf, sizeof(buf),
+        "mode=%s %s syncs=%llu errors=%llu "
+        "fdatasync_us p50<=%llu p99<=%llu max=%llu avg=%llu "
+        "at_risk_max_ms=%.1f at_risk_max_bytes=%llu",
+        DurabilityName(cfg_.mode), trigger,
+        static_cast<unsigned long long>(s.syncs),
+        static_cast<unsigned long long>(s.errors),
+        static_cast<unsigned long long>(s.SyncUsQuantile(0.5)),
+        static_cast<unsigned long long>(s.SyncUsQuantile(0.99)),
+        static_cast<unsigned long long>(s.max_sync_ns / 1000),
+        static_cast<unsigned long long>(
+            s.syncs ? s.sync_ns_total / s.syncs / 1000 : 0),
+        static_cast<double>(s.max_risk_ns) / 1e6,
+        static_cast<unsigned long long>(s.max_risk_bytes));
+    return buf;
+  }
+
+private:
+  static std::int64_t DirtyExpireMs() {
+    std::int64_t cs = 3000;
+    if (FILE *f = std::fopen("/proc/sys/vm/dirty_expire_centisecs", "r")) {
+      long long v = 0;
+      if (std::fscanf(f, "%lld", &v) == 1) {
+        cs = v;
+      }
+      std::fclose(f);
+    }
+    return cs * 10;
+  }
+
+  void Run(std::stop_token st) {
+    using namespace std::chrono;
+    const std::int64_t interval = IntervalNs();
+    // Group commit polls a few times per interval; periodic wakes per tick
+    const auto tick =
+        cfg_.mode == DurabilityMode::group
+            ? std::clamp(nanoseconds(cfg_.interval) / 4,
+                         nanoseconds(microseconds(100)),
+                         nanoseconds(milliseconds(1)))
+            : nanoseconds(cfg_.interval);
+    std::int64_t nextPeriodic = SyncTarget::NowNs() + interval;
+    while (!st.stop_requested()) {
+      std::this_thread::sleep_for(tick);
+      const std::int64_t now = SyncTarget::NowNs();
+      bool periodicDue = false;
+      if (cfg_.mode == DurabilityMode::periodic && now >= nextPeriodic) {
+        periodicDue = true;
+        nextPeriodic = now + interval;
+      }
+      Pass(now, periodicDue);
+    }
+    // Final commit of everything settled so far
+    Pass(SyncTarget::NowNs(), true);
+  }
+
+  void Pass(std::int64_t now, bool all) {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      for (auto &t : added_) {
+        targets_.push_back(std::move(t));
+      }
+      added_.clear();
+    }
+    for (auto &t : targets_) {
+      const bool closed = t->closed.load();
+      const std::uint64_t settled = t->settled.load();
+      const std::int64_t since = t->pending_since.load();
+      const std::uint64_t pending = settled - t->durable;
+      bool due = closed || (all && pending != 0);
+      if (cfg_.mode == DurabilityMode::group) {
+        due = due || pending >= cfg_.bytes ||
+              (since != 0 && now - since >= IntervalNs());
+      }
+      if (due) {
+        SyncOne(*t, settled, since);
+      }
+    }
+    std::erase_if(targets_, [](const std::shared_ptr<SyncTarget> &t) {
+      return t->closed.load() && t->pending_since.load() == 0;
+    });
+  }
+
+  std::int64_t IntervalNs() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(cfg_.interval)
+        .count();
+  }
+
+  void SyncOne(SyncTarget &t, std::uint64_t snapshot, std::int64_t since) {
+    const std::int64_t t0 = SyncTarget::NowNs();
+    const int rc = ::fdatasync(t.fd);
+    const std::int64_t t1 = SyncTarget::NowNs();
+    const auto ns = static_cast<std::uint64_t>(t1 - t0);
+    ++stats_.syncs;
+    stats_.sync_ns_total += ns;
+    stats_.max_sync_ns = std::max(stats_.max_sync_ns, ns);
+    const std::uint64_t us = ns / 1000;
+    const int bucket = us == 0 ? 0 : std::min(31, 63 - __builtin_clzll(us));
+    ++stats_.sync_us_log2[bucket];
+    if (rc != 0) {
+      ++stats_.errors;
+      return;
+    }
+    if (!t.dir_synced) {
+      // A new file is only durable once its directory entry is
+      SyncParentDir(t.path);
+      t.dir_synced = true;
+    }
+    stats_.max_risk_bytes =
+        std::max(stats_.max_risk_bytes, snapshot - t.durable);
+    if (since != 0) {
+      stats_.max_risk_ns =
+          std::max(stats_.max_risk_ns, static_cast<std::uint64_t>(t1 - since));
+    }
+    t.durable = snapshot;
+    // Reset, then re-arm if the writer settled more after the snapshot
+    // (stamped with the sync start: its write time is not known here)
+    t.pending_since.store(0);
+    if (t.settled.load() != snapshot) {
+      std::int64_t none = 0;
+      (void)t.pending_since.compare_exchange_strong(none, t0);
+    }
+  }
+
+  static void SyncParentDir(const std::string &path) {
+    const std::size_t slash = path.rfind('/');
+    const std::string dir =
+        slash == std::string::npos ? "." : path.substr(0, slash ? slash : 1);
+    const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd != -1) {
+      (void)::fsync(fd);
+      ::close(fd);
+    }
+  }
+
+  DurabilityConfig cfg_;
+  std::mutex mu_; // guards added_ and stopped_
+  std::vector<std::shared_ptr<SyncTarget>> added_;
+  bool stopped_ = false;
+  std::vector<std::shared_ptr<SyncTarget>> targets_; // sync thread
+  Stats stats_;
+  std::jthread worker_;
+};
+
+// SyncedWriter — passes writes through and, on Flush, tells the target how
+// far the inner writer's bytes have reached the kernel (IWriter::Settled).
+// The write path only stamps the first write after each Flush, so the age of
+// the oldest byte can be reported even for writers that settle late.
+class SyncedWriter : public IWriter {
+public:
+  SyncedWriter(std::unique_ptr<IWriter> inner,
+               std::shared_ptr<SyncTarget> target)
+      : inner_(std::move(inner)), target_(std::move(target)) {}
+  ~SyncedWriter() override {
+    inner_.reset(); // drains the inner writer and closes its descriptor
+    target_->Close();
+  }
+
+  void Writev(struct iovec *iov, int cnt) override {
+    if (BRANCH_UNLIKELY(batch_ns_ == 0)) {
+      batch_ns_ = SyncTarget::NowNs();
+    }
+    inner_->Writev(iov, cnt);
+  }
+  void Flush() override {
+    inner_->Flush();
+    if (batch_ns_ != 0) {
+      batches_.push_back({inner_->Size(), batch_ns_});
+      batch_ns_ = 0;
+    }
+    const std::uint64_t s = inner_->Settled();
+    if (s == settled_) {
+      return;
+    }
+    // Oldest newly settled byte: first batch ending past the old mark
+    std::int64_t written = SyncTarget::NowNs();
+    for (const Batch &b : batches_) {
+      if (b.end > settled_) {
+        written = b.ns;
+        break;
+      }
+    }
+    while (!batches_.empty() && batches_.front().end <= s) {
+      batches_.pop_front();
+    }
+    settled_ = s;
+    target_->Settle(s, written);
+  }
+  std::uint64_t Size() const override { return inner_->Size(); }
+  std::uint64_t Settled() const override { return inner_->Settled(); }
+  int Fd() const override { return inner_->Fd(); }
+  std::uint64_t Dropped() const override { return inner_->Dropped(); }
+
+private:
+  std::unique_ptr<IWriter> inner_;
+  std::shared_ptr<SyncTarget> target_;
+  // Bytes written between two Flushes: (end offset, first write time)
+  struct Batch {
+    std::uint64_t end;
+    std::int64_t ns;
+  };
+  std::deque<Batch> batches_; // not yet settled
+  std::int64_t batch_ns_ = 0; // first write since the last Flush, 0 = none
+  std::uint64_t settled_ = 0;
+};
+
+} // namespace io
@@ -0,0 +1,270 @@
+#pragma once
+
+#include "io/writer.hpp"
+#include "util/branch.hpp"
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/mman.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+namespace io {
+
+struct MmapWriterConfig {
+  std::size_t segment_bytes = 64u << 20; // multiple of the page size
+  bool prefault = true;                  // touch new windows in advance
+};
+
+// MmapWriter — append through a shared file mapping instead of write(2).
+// The file is grown in large fallocate'd segments; the writer memcpy's into
+// the current segment's mapping and swaps to the next one when it fills.
+// Threading model:
+// - Writer thread (caller): memcpy only; a segment switch is a pointer swap
+//   with the window prepared ahead of time
+// - Background std::jthread: fallocates and maps the next segment, prefaults
+//   it, and unmaps retired segments (munmap's TLB shootdown stays off the
+//   writer thread)
+// On destruction the file is truncated to the bytes actually written, so
+// the preallocated tail never shows up in the final file. While running,
+// readers see the file at its preallocated size with a zero-filled tail.
+class MmapWriter : public IWriter {
+public:
+  using Config = MmapWriterConfig;
+
+  struct Stats {
+    std::atomic<std::uint64_t> segments{0};
+    std::atomic<std::uint64_t> stalls{0}; // writer waited for a window
+    std::atomic<std::uint64_t> dropped{0}; // bytes lost: no window
+  };
+
+  // Opens `path` (truncated, or appended to when `append`)
+  static std::expected<std::unique_ptr<MmapWriter>, std::error_code>
+  Open(const std::string &path, bool append = false, Config cfg = {}) {
+    const long page = ::sysconf(_SC_PAGESIZE);
+    if (cfg.segment_bytes == 0 || cfg.segment_bytes % page != 0) {
+      return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+    const int flags = O_CREAT | O_RDWR | O_CLOEXEC | (append ? 0 : O_TRUNC);
+    int fd = ::open(path.c_str(), flags, 0644);
+    if (fd == -1) {
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    std::unique_ptr<MmapWriter> w(new MmapWriter(fd, cfg));
+    const off_t end = ::lseek(fd, 0, SEEK_END);
+    w->size_ = static_cast<std::uint64_t>(end < 0 ? 0 : end);
+    w->cur_off_ = w->size_ - w->size_ % cfg.segment_bytes;
+    auto first = w->MapSegment(w->cur_off_, w->size_ - w->cur_off_);
+    if (!first) {
+      return std::unexpected(first.error());
+    }
+    w->cur_ = *first;
+    w->worker_ = std::jthread([p = w.get()](std::stop_token st) {
+      p->Prepare(st);
+    });
+    return w;
+  }
+
+  ~MmapWriter() override {
+    worker_.request_stop();
+    cv_.notify_all();
+    if (worker_.joinable()) {
+      worker_.join();
+    }
+    Unmap(cur_);
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      Unmap(next_);
+      Unmap(retired_);
+    }
+    (void)::ftruncate(fd_, static_cast<off_t>(size_));
+    ::close(fd_);
+  }
+
+  MmapWriter(const MmapWriter &) = delete;
+  MmapWriter &operator=(const MmapWriter &) = delete;
+
+  void Writev(struct iovec *iov, int cnt) override {
+    for (int i = 0; i < cnt; ++i) {
+      Append(static_cast<const char *>(iov[i].iov_base), iov[i].iov_len);
+    }
+  }
+
+  std::uint64_t Size() const override { return size_; }
+  int Fd() const override { return fd_; }
+  std::uint64_t Dropped() const override {
+    return stats_.dropped.load(std::memory_order_relaxed);
+  }
+  const Stats &GetStats() const { return stats_; }
+
+private:
+  MmapWriter(int fd, Config cfg) : fd_(fd), cfg_(cfg) {}
+
+  void Append(const char *p, std::size_t len) {
+    while (len != 0) {
+      const std::size_t pos = size_ - cur_off_;
+      const std::size_t room = cfg_.segment_bytes - pos;
+      if (BRANCH_UNLIKELY(room == 0 || cur_ == nullptr)) {
+        if (!NextSegment()) {
+          // Out of space or mapping failed: nothing can be written from here
+          // on; count it, and say why once
+          if (stats_.dropped.fetch_add(len, std::memory_order_relaxed) == 0) {
+            std::lock_guard<std::mutex> lock(mu_);
+            std::cerr << "[mmap_writer] cannot grow fd " << fd_ << ": "
+                      << error_.message() << "; dropping further writes\n";
+          }
+          return;
+        }
+        continue;
+      }
+      const std::size_t n = len < room ? len : room;
+      std::memcpy(cur_ + pos, p, n);
+      size_ += n;
+      p += n;
+      len -= n;
+    }
+  }
+
+  // Swaps in the prepared window; waits only if the background thread is
+  // behind (counted in stats.stalls)
+  bool NextSegment() {
+    std::unique_lock<std::mutex> lock(mu_);
+    if (next_ == nullptr) {
+      stats_.stalls.fetch_add(1, std::memory_order_relaxed);
+      cv_.wait(lock, [this] { return next_ != nullptr || failed_; });
+      if (next_ == nullptr) {
+        return false;
+      }
+    }
+    if (retired_ == nullptr) {
+      retired_ = cur_;
+    } else {
+      Unmap(cur_);
+    }
+    cur_ = next_;
+    cur_off_ += cfg_.segment_bytes;
+    next_ = nullptr;
+    lock.unlock();
+    cv_.notify_all();
+    return true;
+  }
+
+  // Background loop: keep exactly one window mapped ahead of the writer
+  void Prepare(std::stop_token st) {
+    std::uint64_t nextOff = cur_off_ + cfg_.segment_bytes;
+    std::unique_lock<std::mutex> lock(mu_);
+    while (!st.stop_requested()) {
+      if (retired_ != nullptr) {
+        char *old = retired_;
+        retired_ = nullptr;
+        lock.unlock();
+        Unmap(old);
+        lock.lock();
+        continue;
+      }
+      if (next_ == nullptr && !failed_) {
+        lock.unlock();
+        auto seg = MapSegment(nextOff);
+        lock.lock();
+        if (seg) {
+          next_ = *seg;
+          nextOff += cfg_.segment_bytes;
+        } else {
+          failed_ = true;
+          error_ = seg.error();
+        }
+        cv_.notify_all();
+        continue;
+      }
+      cv_.wait(lock, [&] {
+        return st.stop_requested() || retired_ != nullptr ||
+               (next_ == nullptr && !failed_);
+      });
+    }
+  }
+
+  // Maps the segment at `off`, whose first `kept` bytes already hold data
+  // (appending to an existing file)
+  std::expected<char *, std::error_code> MapSegment(std::uint64_t off,
+                                                    std::size_t kept = 0) {
+    const auto len = static_cast<off_t>(cfg_.segment_bytes);
+    if (::fallocate(fd_, 0, static_cast<off_t>(off), len) != 0) {
+      // Only filesystems without fallocate grow sparsely. Any other error
+      // (ENOSPC, EDQUOT) is final: a sparse window would SIGBUS on write.
+      if (errno != EOPNOTSUPP && errno != ENOSYS) {
+        return std::unexpected(
+            std::error_code(errno, std::generic_category()));
+      }
+      if (::ftruncate(fd_, static_cast<off_t>(off) + len) != 0) {
+        return std::unexpected(
+            std::error_code(errno, std::generic_category()));
+      }
+    }
+    void *p = ::mmap(nullptr, cfg_.segment_bytes, PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd_, static_cast<off_t>(off));
+    if (p == MAP_FAILED) {
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    stats_.segments.fetch_add(1, std::memory_order_relaxed);
+    if (cfg_.prefault) {
+      Prefault(static_cast<char *>(p), kept);
+    }
+    return static_cast<char *>(p);
+  }
+
+  // Populates page tables (and page cache) for the window so the writer's
+  // memcpy never takes a page fault. Without MADV_POPULATE_WRITE pages are
+  // touched by hand: written only past the first `kept` bytes, read below
+  // it, so appending never clobbers existing data.
+  void Prefault(char *p, std::size_t kept) const {
+#ifdef MADV_POPULATE_WRITE
+    if (::madvise(p, cfg_.segment_bytes, MADV_POPULATE_WRITE) == 0) {
+      return;
+    }
+#endif
+    const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    auto *v = reinterpret_cast<volatile char *>(p);
+    for (std::size_t i = 0; i < cfg_.segment_bytes; i += page) {
+      if (i + page <= kept) {
+        (void)v[i];
+      } else {
+        v[kept > i ? kept : i] = 0;
+      }
+    }
+  }
+
+  void Unmap(char *&p) {
+    if (p != nullptr) {
+      ::munmap(p, cfg_.segment_bytes);
+      p = nullptr;
+    }
+  }
+
+  int fd_ = -1;
+  Config cfg_;
+  // Writer-thread state
+  char *cur_ = nullptr;
+  std::uint64_t cur_off_ = 0;
+  std::uint64_t size_ = 0;
+  // Handoff with the background thread (guarded by mu_)
+  std::mutex mu_;
+  std::condition_variable cv_;
+  char *next_ = nullptr;
+  char *retired_ = nullptr;
+  bool failed_ = false;
+  std::error_code error_; // why failed_ was set
+  Stats stats_;
+  std::jthread worker_;
+};
+
+} // namespace io
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "io/compressing_writer.hpp"
+#include "io/durability.hpp"
+#include "io/mmap_writer.hpp"
+#include "io/streaming_writer.hpp"
+#include "io/uring_writer.hpp"
+#include "io/writer.hpp"
+#include <cerrno>
+#include <expected>
+#include <fcntl.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace io {
+
+// How file outputs reach the disk:
+// - write: writev(2) per batch (default)
+// - mmap: memcpy into a preallocated shared mapping (MmapWriter)
+// - uring: asynchronous writes from registered buffers (UringWriter)
+// - stream: writev with windowed writeback + page cache drop (StreamingWriter)
+// - direct: O_DIRECT from aligned staging buffers (DirectWriter)
+enum class WriterKind { write, mmap, uring, stream, direct };
+
+inline std::optional<WriterKind> ParseWriterKind(std::string_view s) {
+  if (s == "write") {
+    return WriterKind::write;
+  }
+  if (s == "mmap") {
+    return WriterKind::mmap;
+  }
+  if (s == "uring") {
+    return WriterKind::uring;
+  }
+  if (s == "stream") {
+    return WriterKind::stream;
+  }
+  if (s == "direct") {
+    return WriterKind::direct;
+  }
+  return std::nullopt;
+}
+
+inline const char *WriterKindName(WriterKind k) {
+  switch (k) {
+  case WriterKind::write:
+    return "write";
+  case WriterKind::mmap:
+    return "mmap";
+  case WriterKind::uring:
+    return "uring";
+  case WriterKind::stream:
+    return "stream";
+  case WriterKind::direct:
+    return "direct";
+  }
+  return "?";
+}
+
+// Creates `path` (truncated, or appended to when `append`) and returns a
+// writer of the requested kind
+inline std::expected<std::unique_ptr<IWriter>, std::error_code>
+OpenRawWriter(const std::string &path, WriterKind kind, bool append = false) {
+  auto widen = [](auto r)
+      -> std::expected<std::unique_ptr<IWriter>, std::error_code> {
+    if (!r) {
+      return std::unexpected(r.error());
+    }
+    return std::unique_ptr<IWriter>(std::move(*r));
+  };
+  if (kind == WriterKind::mmap) {
+    return widen(MmapWriter::Open(path, append));
+  }
+  if (kind == WriterKind::uring) {
+    return widen(UringWriter::Open(path, append));
+  }
+  if (kind == WriterKind::stream) {
+    return widen(StreamingWriter::Open(path, append));
+  }
+  if (kind == WriterKind::direct) {
+    return widen(DirectWriter::Open(path, append));
+  }
+  const int flags = O_CREAT | O_WRONLY | O_CLOEXEC | (append ? O_APPEND : O_TRUNC);
+  int fd = ::open(path.c_str(), flags, 0644);
+  if (fd == -1) {
+    return std::unexpected(std::error_code(errno, std::generic_category()));
+  }
+  return std::unique_ptr<IWriter>(std::make_unique<FdWriter>(fd));
+}
+
+// As OpenRawWriter, optionally behind block compression (seekable frames).
+// A compressed file cannot be appended to: its seek table ends the file.
+// With a SyncService the file is registered for its durability mode.
+inline std::expected<std::unique_ptr<IWriter>, std::error_code>
+OpenWriter(const std::string &path, WriterKind kind, bool append = false,
+           std::optional<compress::Codec> codec = std::nullopt,
+           SyncService *sync = nullptr) {
+  if (codec.has_value() && append) {
+    return std::unexpected(std::make_error_code(std::errc::not_supported));
+  }
+  auto w = OpenRawWriter(path, kind, append);
+  if (w && codec.has_value()) {
+    auto c = CompressingWriter::Create(std::move(*w), {.codec = *codec});
+    if (!c) {
+      return std::unexpected(c.error());
+    }
+    w = std::unique_ptr<IWriter>(std::move(*c));
+  }
+  if (!w || sync == nullptr) {
+    return w;
+  }
+  if (auto target = sync->Track((*w)->Fd(), path)) {
+    return std::unique_ptr<IWriter>(
+        std::make_unique<SyncedWriter>(std::move(*w), std::move(target)));
+  }
+  return w;
+}
+
+} // namespace io
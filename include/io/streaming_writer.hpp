@@ -0,0 +1,248 @@
+#pragma once
+
+#include "io/file_writer.hpp"
+#include "io/writer.hpp"
+#include "util/branch.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <sys/uio.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace io {
+
+// StreamingWriter — writev(2) appends that keep the page cache footprint of
+// an unbounded capture flat. Output is cut into fixed windows; when the
+// cursor crosses a window boundary:
+// - the window just completed gets sync_file_range(WRITE): writeback starts
+//   now, in small steady chunks, instead of when the kernel's dirty limits
+//   force a large flush in the middle of a write
+// - the window before it (already under writeback for a whole window) is
+//   waited on and dropped from the page cache with posix_fadvise(DONTNEED)
+// Dirty + cached pages therefore stay around two windows regardless of
+// capture length.
+class StreamingWriter : public IWriter {
+public:
+  static constexpr std::uint64_t kDefaultWindow = 8u << 20;
+
+  static std::expected<std::unique_ptr<StreamingWriter>, std::error_code>
+  Open(const std::string &path, bool append = false,
+       std::uint64_t window = kDefaultWindow) {
+    const int flags =
+        O_CREAT | O_WRONLY | O_CLOEXEC | (append ? O_APPEND : O_TRUNC);
+    int fd = ::open(path.c_str(), flags, 0644);
+    if (fd == -1) {
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    const off_t end = ::lseek(fd, 0, SEEK_END);
+    const std::uint64_t off = static_cast<std::uint64_t>(end < 0 ? 0 : end);
+    return std::unique_ptr<StreamingWriter>(
+        new StreamingWriter(fd, off, window));
+  }
+
+  ~StreamingWriter() override { ::close(fd_); }
+
+  StreamingWriter(const StreamingWriter &) = delete;
+  StreamingWriter &operator=(const StreamingWriter &) = delete;
+
+  void Writev(struct iovec *iov, int cnt) override {
+    for (int i = 0; i < cnt; ++i) {
+      off_ += iov[i].iov_len;
+      size_ += iov[i].iov_len;
+    }
+    WritevAll(fd_, iov, cnt);
+    if (BRANCH_UNLIKELY(off_ - kicked_ >= window_)) {
+      Advance();
+    }
+  }
+
+  std::uint64_t Size() const override { return size_; }
+  int Fd() const override { return fd_; }
+
+private:
+  StreamingWriter(int fd, std::uint64_t off, std::uint64_t window)
+      : fd_(fd), window_(window), off_(off),
+        kicked_(off - off % window), dropped_(kicked_) {}
+
+  void Advance() {
+    while (off_ - kicked_ >= window_) {
+      // Start writeback of the completed window
+      (void)::sync_file_range(fd_, static_cast<off64_t>(kicked_),
+                              static_cast<off64_t>(window_),
+                              SYNC_FILE_RANGE_WRITE);
+      kicked_ += window_;
+      // Retire everything older than the previous window
+      if (kicked_ - dropped_ > window_) {
+        const std::uint64_t len = kicked_ - window_ - dropped_;
+        (void)::sync_file_range(fd_, static_cast<off64_t>(dropped_),
+                                static_cast<off64_t>(len),
+                                SYNC_FILE_RANGE_WAIT_BEFORE |
+                                    SYNC_FILE_RANGE_WRITE |
+                                    SYNC_FILE_RANGE_WAIT_AFTER);
+        (void)::posix_fadvise(fd_, static_cast<off_t>(dropped_),
+                              static_cast<off_t>(len), POSIX_FADV_DONTNEED);
+        dropped_ += len;
+      }
+    }
+  }
+
+  int fd_ = -1;
+  std::uint64_t window_;
+  std::uint64_t off_;     // file offset of the write cursor
+  std::uint64_t kicked_;  // writeback started for [.., kicked_)
+  std::uint64_t dropped_; // dropped from the page cache for [.., dropped_)
+  std::uint64_t size_ = 0;
+};
+
+// DirectWriter — O_DIRECT appends that bypass the page cache entirely.
+// Data is staged in an aligned buffer and written in whole blocks once the
+// buffer fills (or on Flush); the sub-block tail stays staged until more data
+// arrives or the writer closes, where the last block is written padded and
+// the file truncated to its real size. Memory use is the staging buffer, and
+// write latency is the device's, independent of capture length. A failed
+// write loses the blocks it did not write (Dropped(), reported once); the
+// file offset stays at the last block that was written.
+class DirectWriter : public IWriter {
+public:
+  static constexpr std::size_t kAlign = 4096;
+  static constexpr std::size_t kDefaultBuffer = 1u << 20;
+
+  static std::expected<std::unique_ptr<DirectWriter>, std::error_code>
+  Open(const std::string &path, bool append = false,
+       std::size_t buffer = kDefaultBuffer) {
+    if (buffer == 0 || buffer % kAlign != 0) {
+      return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+    const int flags =
+        O_CREAT | O_RDWR | O_DIRECT | O_CLOEXEC | (append ? 0 : O_TRUNC);
+    int fd = ::open(path.c_str(), flags, 0644);
+    if (fd == -1) {
+      // e.g. EINVAL on filesystems without O_DIRECT support (tmpfs)
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    std::unique_ptr<DirectWriter> w(new DirectWriter(fd, buffer));
+    const off_t end = ::lseek(fd, 0, SEEK_END);
+    const std::uint64_t size = static_cast<std::uint64_t>(end < 0 ? 0 : end);
+    w->off_ = size - size % kAlign;
+    const auto tail = static_cast<std::size_t>(size % kAlign);
+    if (tail != 0) {
+      const ssize_t n =
+          ::pread(fd, w->buf_, kAlign, static_cast<off_t>(w->off_));
+      if (n != static_cast<ssize_t>(tail)) {
+        // Nothing staged: the destructor frees buf_ and leaves the file alone
+        const int e = n < 0 ? errno : EIO;
+        return std::unexpected(std::error_code(e, std::generic_category()));
+      }
+    }
+    w->used_ = tail;
+    return w;
+  }
+
+  ~DirectWriter() override {
+    if (used_ != 0) {
+      const std::size_t tail = used_;
+      const std::size_t padded = (tail + kAlign - 1) / kAlign * kAlign;
+      std::memset(buf_ + tail, 0, padded - tail);
+      const std::size_t wrote = WriteBlocks(padded);
+      const std::uint64_t end = off_ - wrote + std::min(wrote, tail);
+      (void)::ftruncate(fd_, static_cast<off_t>(end));
+    }
+    ::close(fd_);
+    ::operator delete(buf_, std::align_val_t{kAlign});
+  }
+
+  DirectWriter(const DirectWriter &) = delete;
+  DirectWriter &operator=(const DirectWriter &) = delete;
+
+  void Writev(struct iovec *iov, int cnt) override {
+    for (int i = 0; i < cnt; ++i) {
+      const char *p = static_cast<const char *>(iov[i].iov_base);
+      std::size_t len = iov[i].iov_len;
+      size_ += len;
+      while (len != 0) {
+        const std::size_t n = std::min(len, cap_ - used_);
+        std::memcpy(buf_ + used_, p, n);
+        used_ += n;
+        p += n;
+        len -= n;
+        if (used_ == cap_) {
+          WriteBlocks(cap_);
+        }
+      }
+    }
+  }
+
+  // Writes all whole blocks; keeps the sub-block tail staged
+  void Flush() override {
+    const std::size_t whole = used_ - used_ % kAlign;
+    if (whole != 0) {
+      WriteBlocks(whole);
+    }
+  }
+
+  std::uint64_t Size() const override { return size_; }
+  // The staged sub-block tail has not reached the file yet
+  std::uint64_t Settled() const override {
+    return size_ - std::min(size_, used_ + dropped_);
+  }
+  int Fd() const override { return fd_; }
+  std::uint64_t Dropped() const override { return dropped_; }
+
+private:
+  DirectWriter(int fd, std::size_t buffer)
+      : fd_(fd), cap_(buffer),
+        buf_(static_cast<char *>(
+            ::operator new(buffer, std::align_val_t{kAlign}))) {}
+
+  // Writes buf_[0, len) at off_ (len is block-aligned) and moves the rest of
+  // the staged bytes to the front; returns the bytes written. On failure
+  // off_ only advances past the whole blocks that were written and the rest
+  // of the `len` bytes is dropped
+  std::size_t WriteBlocks(std::size_t len) {
+    std::size_t done = 0;
+    while (done < len) {
+      const ssize_t n = ::pwrite(fd_, buf_ + done, len - done,
+                                 static_cast<off_t>(off_ + done));
+      if (n <= 0) {
+        if (n < 0 && errno == EINTR) {
+          continue;
+        }
+        const int e = n < 0 ? errno : ENOSPC;
+        done -= done % kAlign;
+        if (dropped_ == 0) {
+          std::cerr << "[direct_writer] write failed on fd " << fd_ << ": "
+                    << std::strerror(e) << "; data lost\n";
+        }
+        dropped_ += len - done;
+        break;
+      }
+      done += static_cast<std::size_t>(n);
+    }
+    off_ += done;
+    const std::size_t rest = used_ > len ? used_ - len : 0;
+    if (rest != 0) {
+      std::memmove(buf_, buf_ + len, rest);
+    }
+    used_ = rest;
+    return done;
+  }
+
+  int fd_ = -1;
+  std::size_t cap_;
+  char *buf_;
+  std::size_t used_ = 0;
+  std::uint64_t off_ = 0; // aligned file offset of buf_[0]
+  std::uint64_t size_ = 0;
+  std::uint64_t dropped_ = 0; // bytes lost to failed writes
+};
+
+} // namespace io
@@ -0,0 +1,460 @@
+#pragma once
+
+#include "io/writer.hpp"
+#include "util/branch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <fcntl.h>
+#include <iostream>
+#include <linux/io_uring.h>
+#include <memory>
+#include <new>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace io {
+
+namespace detail {
+
+// Uring — the few io_uring operations the writer needs, on raw syscalls
+// (no liburing dependency). Single-threaded: one submitter, one reaper.
+class Uring {
+public:
+  static std::expected<Uring, std::error_code> Create(unsigned entries) {
+    Uring r;
+    io_uring_params p{};
+    r.fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+    if (r.fd_ < 0) {
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    r.sq_len_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r.cq_len_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+      r.sq_len_ = r.cq_len_ = std::max(r.sq_len_, r.cq_len_);
+    }
+    r.sq_ = ::mmap(nullptr, r.sq_len_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, r.fd_, IORING_OFF_SQ_RING);
+    if (r.sq_ == MAP_FAILED) {
+      r.sq_ = nullptr;
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    if (single) {
+      r.cq_ = r.sq_;
+    } else {
+      r.cq_ = ::mmap(nullptr, r.cq_len_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, r.fd_, IORING_OFF_CQ_RING);
+      if (r.cq_ == MAP_FAILED) {
+        r.cq_ = nullptr;
+        return std::unexpected(
+            std::error_code(errno, std::generic_category()));
+      }
+    }
+    r.sqes_len_ = p.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = ::mmap(nullptr, r.sqes_len_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, r.fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    r.sqes_ = static_cast<io_uring_sqe *>(sqes);
+    auto *sq = static_cast<char *>(r.sq_);
+    auto *cq = static_cast<char *>(r.cq_);
+    r.sq_tail_ = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+    r.sq_mask_ = *reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+    r.sq_array_ = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+    r.cq_head_ = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+    r.cq_tail_ = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+    r.cq_mask_ = *reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+    r.cqes_ = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+    return r;
+  }
+
+  Uring() = default;
+  Uring(Uring &&o) noexcept { *this = std::move(o); }
+  Uring &operator=(Uring &&o) noexcept {
+    std::swap(fd_, o.fd_);
+    std::swap(sq_, o.sq_);
+    std::swap(cq_, o.cq_);
+    std::swap(sq_len_, o.sq_len_);
+    std::swap(cq_len_, o.cq_len_);
+    std::swap(sqes_len_, o.sqes_len_);
+    std::swap(sqes_, o.sqes_);
+    std::swap(sq_tail_, o.sq_tail_);
+    std::swap(sq_mask_, o.sq_mask_);
+    std::swap(sq_array_, o.sq_array_);
+    std::swap(cq_head_, o.cq_head_);
+    std::swap(cq_tail_, o.cq_tail_);
+    std::swap(cq_mask_, o.cq_mask_);
+    std::swap(cqes_, o.cqes_);
+    return *this;
+  }
+  ~Uring() {
+    if (sqes_ != nullptr) {
+      ::munmap(sqes_, sqes_len_);
+    }
+    if (cq_ != nullptr && cq_ != sq_) {
+      ::munmap(cq_, cq_len_);
+    }
+    if (sq_ != nullptr) {
+      ::munmap(sq_, sq_len_);
+    }
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  // Registers fixed buffers (pinned once instead of per write)
+  bool RegisterBuffers(const struct iovec *iov, unsigned n) {
+    return ::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS,
+                     iov, n) == 0;
+  }
+
+  // Queues one write; caller guarantees a free SQ entry
+  void PrepWrite(int fd, const void *buf, unsigned len, std::uint64_t off,
+                 int bufIndex, std::uint64_t userData) {
+    const unsigned tail = *sq_tail_;
+    const unsigned idx = tail & sq_mask_;
+    io_uring_sqe &sqe = sqes_[idx];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = bufIndex >= 0 ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe.fd = fd;
+    sqe.addr = reinterpret_cast<std::uint64_t>(buf);
+    sqe.len = len;
+    sqe.off = off;
+    sqe.buf_index = static_cast<std::uint16_t>(bufIndex < 0 ? 0 : bufIndex);
+    sqe.user_data = userData;
+    sq_array_[idx] = idx;
+    std::atomic_ref<unsigned>(*sq_tail_).store(tail + 1,
+                                               std::memory_order_release);
+    ++pending_;
+  }
+
+  // Submits queued entries; with `waitFor` > 0 also blocks for completions
+  int Enter(unsigned waitFor) {
+    const unsigned flags = waitFor != 0 ? IORING_ENTER_GETEVENTS : 0;
+    if (pending_ == 0 && waitFor == 0) {
+      return 0;
+    }
+    for (;;) {
+      const long rc = ::syscall(__NR_io_uring_enter, fd_, pending_, waitFor,
+                                flags, nullptr, 0);
+      if (rc >= 0) {
+        pending_ -= static_cast<unsigned>(rc);
+        return static_cast<int>(rc);
+      }
+      if (errno != EINTR) {
+        return -errno;
+      }
+    }
+  }
+
+  // Calls fn(const io_uring_cqe&) for every available completion
+  template <typename Fn> unsigned Reap(Fn &&fn) {
+    unsigned head = *cq_head_;
+    const unsigned tail =
+        std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+    unsigned n = 0;
+    for (; head != tail; ++head, ++n) {
+      fn(cqes_[head & cq_mask_]);
+    }
+    std::atomic_ref<unsigned>(*cq_head_).store(head, std::memory_order_release);
+    return n;
+  }
+
+private:
+  int fd_ = -1;
+  void *sq_ = nullptr;
+  void *cq_ = nullptr;
+  std::size_t sq_len_ = 0;
+  std::size_t cq_len_ = 0;
+  std::size_t sqes_len_ = 0;
+  io_uring_sqe *sqes_ = nullptr;
+  unsigned *sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned *sq_array_ = nullptr;
+  unsigned *cq_head_ = nullptr;
+  unsigned *cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  io_uring_cqe *cqes_ = nullptr;
+  unsigned pending_ = 0;
+};
+
+} // namespace detail
+
+struct UringWriterConfig {
+  unsigned buffers = 16;                // in-flight writes, max
+  std::size_t buffer_bytes = 256u << 10; // staging buffer size
+};
+
+// UringWriter — asynchronous appends through io_uring.
+// Writev copies into one of a fixed set of registered staging buffers; a full
+// buffer (or Flush) is submitted as one IORING_OP_WRITE_FIXED at an explicit
+// file offset and the caller continues immediately. Buffers return to the
+// free list when their completion is reaped; short writes are resubmitted
+// for the remainder. The caller only waits when every buffer is in flight
+// (counted in stats.stalls). Explicit offsets keep the file ordered no
+// matter in which order the kernel completes the writes.
+// A failed or zero-length completion loses that buffer's remaining bytes
+// (stats.errors, Dropped()). If the ring itself fails, the writer fails for
+// good: in-flight writes are counted as lost and later writes are dropped.
+class UringWriter : public IWriter {
+public:
+  using Config = UringWriterConfig;
+
+  struct Stats {
+    std::uint64_t submitted = 0;
+    std::uint64_t completed = 0;
+    std::uint64_t short_writes = 0;
+    std::uint64_t errors = 0;
+    std::uint64_t stalls = 0;
+    std::uint64_t dropped = 0; // bytes lost: write errors or failed ring
+  };
+
+  // Opens `path` (truncated, or appended to when `append`)
+  static std::expected<std::unique_ptr<UringWriter>, std::error_code>
+  Open(const std::string &path, bool append = false, Config cfg = {}) {
+    const int flags = O_CREAT | O_WRONLY | O_CLOEXEC | (append ? 0 : O_TRUNC);
+    int fd = ::open(path.c_str(), flags, 0644);
+    if (fd == -1) {
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    const off_t end = ::lseek(fd, 0, SEEK_END);
+    auto ring = detail::Uring::Create(cfg.buffers);
+    if (!ring) {
+      ::close(fd);
+      return std::unexpected(ring.error());
+    }
+    return std::unique_ptr<UringWriter>(new UringWriter(
+        fd, static_cast<std::uint64_t>(end < 0 ? 0 : end), std::move(*ring),
+        cfg));
+  }
+
+  ~UringWriter() override {
+    SubmitCurrent();
+    while (in_flight_ != 0) {
+      WaitOne();
+    }
+    ring_ = detail::Uring{};
+    ::operator delete(mem_, std::align_val_t{4096});
+    ::close(fd_);
+  }
+
+  UringWriter(const UringWriter &) = delete;
+  UringWriter &operator=(const UringWriter &) = delete;
+
+  void Writev(struct iovec *iov, int cnt) override {
+    for (int i = 0; i < cnt; ++i) {
+      const char *p = static_cast<const char *>(iov[i].iov_base);
+      std::size_t len = iov[i].iov_len;
+      size_ += len;
+      if (BRANCH_UNLIKELY(failed_)) {
+        stats_.dropped += len;
+        continue;
+      }
+      while (len != 0) {
+        if (BRANCH_UNLIKELY(cur_ < 0)) {
+          Acquire();
+          if (BRANCH_UNLIKELY(failed_)) {
+            stats_.dropped += len;
+            break;
+          }
+        }
+        Buf &b = bufs_[static_cast<std::size_t>(cur_)];
+        const std::size_t room = cfg_.buffer_bytes - b.len;
+        const std::size_t n = len < room ? len : room;
+        std::memcpy(b.data + b.len, p, n);
+        b.len += n;
+        p += n;
+        len -= n;
+        if (b.len == cfg_.buffer_bytes) {
+          SubmitCurrent();
+        }
+      }
+    }
+  }
+
+  // Submits the partially filled buffer and reaps finished writes; never
+  // waits for the disk
+  void Flush() override {
+    SubmitCurrent();
+    ReapCompleted();
+  }
+
+  std::uint64_t Size() const override { return size_; }
+  // Staged, in-flight and lost bytes have not reached the file
+  std::uint64_t Settled() const override {
+    const std::uint64_t staged =
+        cur_ >= 0 ? bufs_[static_cast<std::size_t>(cur_)].len : 0;
+    return size_ -
+           std::min(size_, staged + in_flight_bytes_ + stats_.dropped);
+  }
+  int Fd() const override { return fd_; }
+  std::uint64_t Dropped() const override { return stats_.dropped; }
+  const Stats &GetStats() const { return stats_; }
+  bool Registered() const { return registered_; }
+
+private:
+  struct Buf {
+    char *data;
+    std::size_t len;  // bytes staged
+    std::size_t done; // bytes confirmed written (while in flight)
+    std::uint64_t off;
+  };
+
+  UringWriter(int fd, std::uint64_t off, detail::Uring ring, Config cfg)
+      : fd_(fd), cfg_(cfg), ring_(std::move(ring)), file_off_(off) {
+    mem_ = static_cast<char *>(::operator new(
+        cfg_.buffers * cfg_.buffer_bytes, std::align_val_t{4096}));
+    std::vector<struct iovec> iov(cfg_.buffers);
+    bufs_.resize(cfg_.buffers);
+    for (unsigned i = 0; i < cfg_.buffers; ++i) {
+      bufs_[i] = Buf{mem_ + i * cfg_.buffer_bytes, 0, 0, 0};
+      iov[i] = {bufs_[i].data, cfg_.buffer_bytes};
+      free_.push_back(static_cast<int>(cfg_.buffers - 1 - i));
+    }
+    // Falls back to plain IORING_OP_WRITE when pinning is not allowed
+    // (RLIMIT_MEMLOCK)
+    registered_ = ring_.RegisterBuffers(iov.data(), cfg_.buffers);
+  }
+
+  void Acquire() {
+    if (free_.empty()) {
+      ReapCompleted();
+    }
+    if (free_.empty()) {
+      ++stats_.stalls;
+      while (free_.empty() && !failed_) {
+        WaitOne();
+      }
+      if (failed_) {
+        return;
+      }
+    }
+    cur_ = free_.back();
+    free_.pop_back();
+    bufs_[static_cast<std::size_t>(cur_)].len = 0;
+  }
+
+  void SubmitCurrent() {
+    if (cur_ < 0) {
+      return;
+    }
+    Buf &b = bufs_[static_cast<std::size_t>(cur_)];
+    if (b.len == 0) {
+      return;
+    }
+    b.off = file_off_;
+    b.done = 0;
+    file_off_ += b.len;
+    Queue(cur_);
+    cur_ = -1;
+    (void)ring_.Enter(0);
+  }
+
+  void Queue(int idx) {
+    Buf &b = bufs_[static_cast<std::size_t>(idx)];
+    ring_.PrepWrite(fd_, b.data + b.done, static_cast<unsigned>(b.len - b.done),
+                    b.off + b.done, registered_ ? idx : -1,
+                    static_cast<std::uint64_t>(idx));
+    ++in_flight_;
+    in_flight_bytes_ += b.len - b.done;
+    ++stats_.submitted;
+  }
+
+  void WaitOne() {
+    const int rc = ring_.Enter(1);
+    if (BRANCH_UNLIKELY(rc < 0)) {
+      // Ring unusable: nothing in flight will complete, so fail for good
+      // rather than wait in Acquire for buffers that never come back
+      Fail(std::error_code(-rc, std::generic_category()));
+      return;
+    }
+    ReapCompleted();
+  }
+
+  void Fail(std::error_code ec) {
+    stats_.errors += in_flight_;
+    Lose(in_flight_bytes_, ec);
+    in_flight_ = 0;
+    in_flight_bytes_ = 0;
+    if (cur_ >= 0) {
+      Lose(bufs_[static_cast<std::size_t>(cur_)].len, ec);
+      cur_ = -1;
+    }
+    failed_ = true;
+  }
+
+  // Counts `bytes` as lost; the first loss is reported once
+  void Lose(std::uint64_t bytes, std::error_code ec) {
+    if (stats_.dropped == 0 && bytes != 0) {
+      std::cerr << "[uring_writer] write failed on fd " << fd_ << ": "
+                << ec.message() << "; data lost\n";
+    }
+    stats_.dropped += bytes;
+  }
+
+  void ReapCompleted() {
+    bool resubmit = false;
+    ring_.Reap([&](const io_uring_cqe &cqe) {
+      const int idx = static_cast<int>(cqe.user_data);
+      Buf &b = bufs_[static_cast<std::size_t>(idx)];
+      --in_flight_;
+      in_flight_bytes_ -= b.len - b.done; // re-added if requeued
+      ++stats_.completed;
+      if (cqe.res == -EAGAIN || cqe.res == -EINTR) {
+        Queue(idx);
+        resubmit = true;
+        return;
+      }
+      if (BRANCH_UNLIKELY(cqe.res <= 0)) {
+        // An error, or no progress at all (e.g. the filesystem is full):
+        // resubmitting would not converge, so the rest of the buffer is lost
+        ++stats_.errors;
+        Lose(b.len - b.done,
+             cqe.res < 0 ? std::error_code(-cqe.res, std::generic_category())
+                         : std::make_error_code(std::errc::io_error));
+        free_.push_back(idx);
+        return;
+      }
+      b.done += static_cast<std::size_t>(cqe.res);
+      if (b.done < b.len) {
+        ++stats_.short_writes;
+        Queue(idx);
+        resubmit = true;
+        return;
+      }
+      free_.push_back(idx);
+    });
+    if (resubmit) {
+      (void)ring_.Enter(0);
+    }
+  }
+
+  int fd_ = -1;
+  Config cfg_;
+  detail::Uring ring_;
+  char *mem_ = nullptr;
+  std::vector<Buf> bufs_;
+  std::vector<int> free_;
+  int cur_ = -1;
+  unsigned in_flight_ = 0;
+  std::uint64_t in_flight_bytes_ = 0;
+  bool registered_ = false;
+  bool failed_ = false; // ring unusable; writes are dropped
+  std::uint64_t file_off_ = 0;
+  std::uint64_t size_ = 0;
+  Stats stats_;
+};
+
+} // namespace io
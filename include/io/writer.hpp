@@ -0,0 +1,62 @@
+#pragma once
+
+#include "io/file_writer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace io {
+
+// IWriter — append-only byte stream behind the file outputs (sinks). All
+// calls come from a single thread; Writev may modify `iov` in place.
+class IWriter {
+public:
+  virtual ~IWriter() = default;
+  virtual void Writev(struct iovec *iov, int cnt) = 0;
+  // Called when the producer runs idle and before destruction
+  virtual void Flush() {}
+  // Logical bytes appended so far
+  virtual std::uint64_t Size() const = 0;
+  // Logical bytes already handed to the kernel, i.e. covered by an
+  // fdatasync(Fd()); writers that stage or submit asynchronously trail Size()
+  virtual std::uint64_t Settled() const { return Size(); }
+  // Descriptor the bytes end up in (for durability), -1 if none
+  virtual int Fd() const { return -1; }
+  // Bytes accepted but lost to an I/O error (disk full, mapping failed);
+  // the writer logs the first error
+  virtual std::uint64_t Dropped() const { return 0; }
+
+  void Write(const void *data, std::size_t len) {
+    struct iovec v{const_cast<void *>(data), len};
+    Writev(&v, 1);
+  }
+};
+
+// FdWriter — plain writev(2) on an owned descriptor (file, pipe)
+class FdWriter : public IWriter {
+public:
+  explicit FdWriter(int fd) : fd_(fd) {}
+  ~FdWriter() override {
+    if (fd_ != -1) {
+      ::close(fd_);
+    }
+  }
+  FdWriter(const FdWriter &) = delete;
+  FdWriter &operator=(const FdWriter &) = delete;
+
+  void Writev(struct iovec *iov, int cnt) override {
+    for (int i = 0; i < cnt; ++i) {
+      size_ += iov[i].iov_len;
+    }
+    WritevAll(fd_, iov, cnt);
+  }
+  std::uint64_t Size() const override { return size_; }
+  int Fd() const override { return fd_; }
+
+private:
+  int fd_ = -1;
+  std::uint64_t size_ = 0;
+};
+
+} // namespace io
@@ -0,0 +1,272 @@
+#pragma once
+
+#include "lockfree/broadcast_ring.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// namespace ipc — named shared-memory broadcast ring for out-of-process
+// consumers of the merged stream. The region uses the same layout as the
+// in-process lockfree::BroadcastRing, so readers get identical overrun
+// detection. Placement: hugetlbfs (/dev/hugepages/<name>) when requested and
+// mounted, otherwise POSIX shm (/dev/shm/<name>) with MADV_HUGEPAGE as a hint.
+// Readers map the region read-only and may attach or detach at any time; the
+// writer never learns about them. A new writer unlinks the old region and
+// creates a fresh one instead of truncating it, so a reader still mapping
+// the old region keeps valid (if stale) pages rather than taking SIGBUS.
+namespace ipc {
+
+inline constexpr const char *kHugetlbfsDir = "/dev/hugepages/";
+inline constexpr std::size_t kHugePageSize = 2u << 20;
+
+struct ShmRingConfig {
+  std::size_t slot_count = 65536; // power of two
+  std::size_t slot_size = 512;    // bytes per slot incl. 32-byte header
+  bool hugepages = true;          // try hugetlbfs first
+};
+
+namespace detail {
+
+inline std::error_code LastError() {
+  return std::error_code(errno, std::generic_category());
+}
+
+// A mapped region plus how it was obtained (to unlink it correctly)
+struct Mapping {
+  void *addr = MAP_FAILED;
+  std::size_t size = 0;
+  std::string path;     // hugetlbfs path, empty for shm_open
+  std::string shm_name; // "/name" for shm_open, empty for hugetlbfs
+  dev_t dev = 0;        // identity of the object, so a writer only unlinks
+  ino_t ino = 0;        // its own region and not a newer writer's
+
+  Mapping() = default;
+  Mapping(Mapping &&o) noexcept { *this = std::move(o); }
+  Mapping &operator=(Mapping &&o) noexcept {
+    std::swap(addr, o.addr);
+    std::swap(size, o.size);
+    std::swap(path, o.path);
+    std::swap(shm_name, o.shm_name);
+    std::swap(dev, o.dev);
+    std::swap(ino, o.ino);
+    return *this;
+  }
+  ~Mapping() {
+    if (addr != MAP_FAILED) {
+      ::munmap(addr, size);
+    }
+  }
+};
+
+inline std::expected<Mapping, std::error_code>
+MapFd(int fd, std::size_t size, int prot, bool truncate) {
+  if (truncate && ::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    auto ec = LastError();
+    ::close(fd);
+    return std::unexpected(ec);
+  }
+  struct stat st{};
+  (void)::fstat(fd, &st);
+  void *p = ::mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+  auto ec = LastError();
+  ::close(fd);
+  if (p == MAP_FAILED) {
+    return std::unexpected(ec);
+  }
+  Mapping m;
+  m.addr = p;
+  m.size = size;
+  m.dev = st.st_dev;
+  m.ino = st.st_ino;
+  return m;
+}
+
+// True when `fd` is the object `m` was mapped from; closes `fd`
+inline bool SameObject(int fd, const Mapping &m) {
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st{};
+  const bool same =
+      ::fstat(fd, &st) == 0 && st.st_dev == m.dev && st.st_ino == m.ino;
+  ::close(fd);
+  return same;
+}
+
+inline std::size_t FileSize(int fd) {
+  struct stat st{};
+  if (::fstat(fd, &st) != 0) {
+    return 0;
+  }
+  return static_cast<std::size_t>(st.st_size);
+}
+
+} // namespace detail
+
+// ShmRingWriter — owned by the StreamMerger thread (single producer)
+class ShmRingWriter {
+public:
+  static std::expected<ShmRingWriter, std::error_code>
+  Create(const std::string &name, ShmRingConfig cfg = {}) {
+    const std::size_t bytes =
+        lockfree::BroadcastRing::RegionSize(cfg.slot_count, cfg.slot_size);
+    if (cfg.hugepages) {
+      const std::size_t huge =
+          (bytes + kHugePageSize - 1) & ~(kHugePageSize - 1);
+      const std::string path = std::string(kHugetlbfsDir) + name;
+      (void)::unlink(path.c_str());
+      int fd = ::open(path.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC,
+                      0644);
+      if (fd >= 0) {
+        auto m = detail::MapFd(fd, huge, PROT_READ | PROT_WRITE, true);
+        if (m) {
+          m->path = path;
+          return ShmRingWriter(std::move(*m), cfg, true);
+        }
+        ::unlink(path.c_str());
+      }
+    }
+    const std::string shm = "/" + name;
+    (void)::shm_unlink(shm.c_str());
+    int fd = ::shm_open(shm.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC,
+                        0644);
+    if (fd < 0) {
+      return std::unexpected(detail::LastError());
+    }
+    auto m = detail::MapFd(fd, bytes, PROT_READ | PROT_WRITE, true);
+    if (!m) {
+      ::shm_unlink(shm.c_str());
+      return std::unexpected(m.error());
+    }
+    m->shm_name = shm;
+#ifdef MADV_HUGEPAGE
+    if (cfg.hugepages) {
+      (void)::madvise(m->addr, m->size, MADV_HUGEPAGE);
+    }
+#endif
+    return ShmRingWriter(std::move(*m), cfg, false);
+  }
+
+  ShmRingWriter(ShmRingWriter &&) = default;
+  ShmRingWriter &operator=(ShmRingWriter &&) = default;
+
+  ~ShmRingWriter() {
+    if (map_.addr == MAP_FAILED) {
+      return;
+    }
+    // A newer writer may have replaced the name with its own region
+    if (!map_.path.empty()) {
+      if (detail::SameObject(
+              ::open(map_.path.c_str(), O_RDONLY | O_CLOEXEC), map_)) {
+        ::unlink(map_.path.c_str());
+      }
+    } else if (!map_.shm_name.empty()) {
+      if (detail::SameObject(
+              ::shm_open(map_.shm_name.c_str(), O_RDONLY | O_CLOEXEC, 0),
+              map_)) {
+        ::shm_unlink(map_.shm_name.c_str());
+      }
+    }
+  }
+
+  bool Publish(std::uint64_t u, std::uint32_t src, std::int64_t recv_ns,
+               const void *data, std::size_t len) {
+    return ring_.Publish(u, src, recv_ns, data, len);
+  }
+
+  bool OnHugepages() const { return huge_; }
+  const lockfree::BroadcastRing &Ring() const { return ring_; }
+
+private:
+  ShmRingWriter(detail::Mapping m, const ShmRingConfig &cfg, bool huge)
+      : map_(std::move(m)), ring_(Prefault(map_, cfg)), huge_(huge) {}
+
+  // Touches every page up front (no faults on the merger thread) and formats
+  static void *Prefault(detail::Mapping &m, const ShmRingConfig &cfg) {
+    std::memset(m.addr, 0, m.size);
+    lockfree::BroadcastRing::Format(m.addr, cfg.slot_count, cfg.slot_size);
+    return m.addr;
+  }
+
+  detail::Mapping map_;
+  lockfree::BroadcastRing ring_;
+  bool huge_ = false;
+};
+
+// ShmRingReader — attaches read-only to a writer's region by name. Starts at
+// the current head; Poll() semantics match lockfree::BroadcastReader.
+class ShmRingReader {
+public:
+  static std::expected<ShmRingReader, std::error_code>
+  Attach(const std::string &name) {
+    const std::string path = std::string(kHugetlbfsDir) + name;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      fd = ::shm_open(("/" + name).c_str(), O_RDONLY | O_CLOEXEC, 0);
+    }
+    if (fd < 0) {
+      return std::unexpected(detail::LastError());
+    }
+    const std::size_t size = detail::FileSize(fd);
+    if (size < lockfree::BroadcastRing::HeaderBytes()) {
+      ::close(fd);
+      return std::unexpected(
+          std::make_error_code(std::errc::resource_unavailable_try_again));
+    }
+    auto m = detail::MapFd(fd, size, PROT_READ, false);
+    if (!m) {
+      return std::unexpected(m.error());
+    }
+    if (!lockfree::BroadcastRing::IsValid(m->addr)) {
+      return std::unexpected(
+          std::make_error_code(std::errc::resource_unavailable_try_again));
+    }
+    // The slots must lie inside the object: a header describing more than
+    // the file holds would fault on the first read past its end
+    const auto *h =
+        static_cast<const lockfree::BroadcastRing::Header *>(m->addr);
+    if (h->slot_size < sizeof(lockfree::BroadcastRing::SlotHeader) ||
+        h->slot_count > (size - lockfree::BroadcastRing::HeaderBytes()) /
+                            h->slot_size ||
+        lockfree::BroadcastRing::RegionSize(h->slot_count, h->slot_size) >
+            size) {
+      return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+    return ShmRingReader(std::move(*m));
+  }
+
+  // The reader keeps a pointer to the heap-held ring, so moves are shallow
+  ShmRingReader(ShmRingReader &&) = default;
+  ShmRingReader &operator=(ShmRingReader &&) = default;
+
+  template <typename Fn> std::size_t Poll(Fn &&fn, std::size_t max = 64) {
+    return reader_.Poll(std::forward<Fn>(fn), max);
+  }
+
+  std::uint64_t Lag() const { return reader_.Lag(); }
+  const lockfree::BroadcastReader::Stats &Stats() const {
+    return reader_.GetStats();
+  }
+
+private:
+  explicit ShmRingReader(detail::Mapping m)
+      : map_(std::move(m)),
+        ring_(std::make_unique<lockfree::BroadcastRing>(map_.addr)),
+        reader_(*ring_) {}
+
+  detail::Mapping map_;
+  std::unique_ptr<lockfree::BroadcastRing> ring_;
+  lockfree::BroadcastReader reader_;
+};
+
+} // namespace ipc
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "util/branch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+
+// lockfree::BroadcastRing — single-producer/multi-consumer broadcast ring of
+// fixed-size slots laid out in one contiguous region:
+//   [Header][slot 0][slot 1]...[slot N-1]
+// The producer never waits: it overwrites the oldest slot. Each reader keeps
+// its own cursor and validates every slot with a per-slot stamp, so a reader
+// that falls more than N messages behind detects the overrun instead of
+// reading garbage. The layout is position independent, so the same region can
+// live on the heap (in-process fan-out) or in shared memory (other processes).
+namespace lockfree {
+
+// One delivered message. `payload` points into the reader's copy of the slot
+// and is only valid inside the reader callback.
+struct BroadcastMessage {
+  std::uint64_t seq;      // ring sequence number (0-based, gap-free)
+  std::uint64_t u;        // updateId of the payload
+  std::uint32_t src;      // producer connection index
+  std::int64_t recv_ns;   // receive timestamp (epoch ns)
+  std::string_view payload;
+};
+
+class BroadcastRing {
+public:
+  static constexpr std::uint64_t kMagic = 0x474E495242535742ull; // "BWSBRING"
+  static constexpr std::uint32_t kVersion = 1;
+  static constexpr std::uint64_t kWriting = ~0ull;
+
+  struct Header {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t slot_size;  // bytes per slot including SlotHeader
+    std::uint64_t slot_count; // power of two
+    alignas(64) std::atomic<std::uint64_t> head; // next sequence to publish
+    alignas(64) std::atomic<std::uint64_t> oversize; // dropped: too large
+  };
+
+  struct SlotHeader {
+    std::atomic<std::uint64_t> stamp; // seq + 1 when complete, kWriting else
+    std::uint32_t len;
+    std::uint32_t src;
+    std::uint64_t u;
+    std::int64_t recv_ns;
+  };
+
+  static constexpr std::size_t HeaderBytes() {
+    return (sizeof(Header) + 63) & ~std::size_t{63};
+  }
+
+  static constexpr std::size_t RegionSize(std::size_t slotCount,
+                                          std::size_t slotSize) {
+    return HeaderBytes() + slotCount * slotSize;
+  }
+
+  // Initializes a zeroed region of RegionSize() bytes. slotCount must be a
+  // power of two and slotSize a multiple of 64 larger than SlotHeader.
+  static void Format(void *mem, std::size_t slotCount, std::size_t slotSize) {
+    auto *h = new (mem) Header{};
+    h->slot_size = static_cast<std::uint32_t>(slotSize);
+    h->slot_count = slotCount;
+    h->head.store(0, std::memory_order_relaxed);
+    h->oversize.store(0, std::memory_order_relaxed);
+    auto *base = static_cast<std::byte *>(mem) + HeaderBytes();
+    for (std::size_t i = 0; i < slotCount; ++i) {
+      auto *s = new (base + i * slotSize) SlotHeader{};
+      s->stamp.store(0, std::memory_order_relaxed);
+    }
+    h->version = kVersion;
+    // Magic last: attachers treat the region as valid only once it is set
+    std::atomic_thread_fence(std::memory_order_release);
+    h->magic = kMagic;
+  }
+
+  // Attaches to a formatted region (does not take ownership)
+  explicit BroadcastRing(void *mem)
+      : hdr_(static_cast<Header *>(mem)),
+        slots_(static_cast<std::byte *>(mem) + HeaderBytes()),
+        slot_size_(hdr_->slot_size), mask_(hdr_->slot_count - 1) {}
+
+  static bool IsValid(const void *mem) {
+    const auto *h = static_cast<const Header *>(mem);
+    return h->magic == kMagic && h->version == kVersion &&
+           h->slot_count != 0 && (h->slot_count & (h->slot_count - 1)) == 0;
+  }
+
+  std::size_t Capacity() const { return mask_ + 1; }
+  std::size_t MaxPayload() const { return slot_size_ - sizeof(SlotHeader); }
+  std::uint64_t Head() const {
+    return hdr_->head.load(std::memory_order_acquire);
+  }
+  std::uint64_t Oversize() const {
+    return hdr_->oversize.load(std::memory_order_relaxed);
+  }
+
+  // Producer API (single producer). Returns false (and counts it) when the
+  // payload does not fit into a slot.
+  bool Publish(std::uint64_t u, std::uint32_t src, std::int64_t recv_ns,
+               const void *data, std::size_t len) {
+    if (BRANCH_UNLIKELY(len > MaxPayload())) {
+      hdr_->oversize.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    const std::uint64_t seq = hdr_->head.load(std::memory_order_relaxed);
+    std::byte *slot = SlotAt(seq);
+    auto *sh = reinterpret_cast<SlotHeader *>(slot);
+    sh->stamp.store(kWriting, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    sh->len = static_cast<std::uint32_t>(len);
+    sh->src = src;
+    sh->u = u;
+    sh->recv_ns = recv_ns;
+    std::memcpy(slot + sizeof(SlotHeader), data, len);
+    sh->stamp.store(seq + 1, std::memory_order_release);
+    hdr_->head.store(seq + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Reader-side slot access (used by BroadcastReader)
+  const std::byte *SlotAt(std::uint64_t seq) const {
+    return slots_ + (seq & mask_) * slot_size_;
+  }
+
+private:
+  std::byte *SlotAt(std::uint64_t seq) {
+    return slots_ + (seq & mask_) * slot_size_;
+  }
+
+  Header *hdr_;
+  std::byte *slots_;
+  std::size_t slot_size_;
+  std::uint64_t mask_;
+};
+
+// BroadcastReader — one consumer cursor over a BroadcastRing. Not thread-safe;
+// each consuming thread owns its reader. Each slot is copied out and its
+// stamp checked again before the callback runs (seqlock), so the callback
+// only ever sees complete messages.
+class BroadcastReader {
+public:
+  struct Stats {
+    std::uint64_t delivered = 0;
+    std::uint64_t lost = 0; // messages overwritten before they were read
+    std::uint64_t torn = 0; // of those, overwritten while being copied
+  };
+
+  // Starts at the current head: only messages published after attach are seen
+  explicit BroadcastReader(const BroadcastRing &ring)
+      : ring_(&ring), cursor_(ring.Head()),
+        copy_(new char[ring.MaxPayload()]) {}
+
+  // Delivers up to `max` messages to fn(const BroadcastMessage&); returns the
+  // number delivered.
+  template <typename Fn> std::size_t Poll(Fn &&fn, std::size_t max = 64) {
+    std::size_t n = 0;
+    std::uint64_t head = ring_->Head();
+    while (n < max && cursor_ < head) {
+      const std::uint64_t cap = ring_->Capacity();
+      if (BRANCH_UNLIKELY(head - cursor_ > cap)) {
+        stats_.lost += head - cap - cursor_;
+        cursor_ = head - cap;
+      }
+      const std::byte *slot = ring_->SlotAt(cursor_);
+      const auto *sh = reinterpret_cast<const BroadcastRing::SlotHeader *>(slot);
+      const std::uint64_t st1 = sh->stamp.load(std::memory_order_acquire);
+      if (BRANCH_UNLIKELY(st1 != cursor_ + 1)) {
+        // Lapped between the head load and the slot read
+        ++stats_.lost;
+        ++cursor_;
+        head = ring_->Head();
+        continue;
+      }
+      const std::uint64_t u = sh->u;
+      const std::uint32_t src = sh->src;
+      const std::int64_t recvNs = sh->recv_ns;
+      const std::size_t len =
+          std::min<std::size_t>(sh->len, ring_->MaxPayload());
+      std::memcpy(copy_.get(), slot + sizeof(BroadcastRing::SlotHeader), len);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (BRANCH_UNLIKELY(sh->stamp.load(std::memory_order_relaxed) != st1)) {
+        // Overwritten while being copied: an overrun, never delivered
+        ++stats_.torn;
+        ++stats_.lost;
+        ++cursor_;
+        head = ring_->Head();
+        continue;
+      }
+      fn(BroadcastMessage{cursor_, u, src, recvNs,
+                          std::string_view{copy_.get(), len}});
+      ++stats_.delivered;
+      ++cursor_;
+      ++n;
+    }
+    return n;
+  }
+
+  // Messages published but not yet consumed by this reader
+  std::uint64_t Lag() const { return ring_->Head() - cursor_; }
+  std::uint64_t Cursor() const { return cursor_; }
+  const Stats &GetStats() const { return stats_; }
+
+private:
+  const BroadcastRing *ring_;
+  std::uint64_t cursor_;
+  std::unique_ptr<char[]> copy_; // one slot's payload, validated
+  Stats stats_;
+};
+
+} // namespace lockfree
@@ -1,65 +1,180 @@
 #pragma once
 
-#include <boost/lockfree/spsc_queue.hpp>
+#include "lockfree/spsc_queue.hpp"
+#include "util/branch.hpp"
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <type_traits>
 #include <utility>
 
-// lockfree::Ring — zero-allocation SPSC object recycler built on two SPSC
-// queues:
-// - free_: holds reusable slots (T objects owned by the ring)
-// - ready_: holds produced items for the consumer
-// Usage pattern (single producer, single consumer):
+// lockfree::Ring — zero-allocation SPSC object recycler over one array of
+// Capacity slots (T objects owned by the ring) and four free-running
+// indices, no second queue:
+//   released ≤ consumed ≤ published ≤ acquired ≤ released + Capacity
+// - acquire() moves the slot at `acquired` out (it was released earlier)
+// - publish() moves the filled item into the slot at `published`
+// - consume() moves the slot at `consumed` out
+// - release() moves the processed item into the slot at `released`
+// Objects are interchangeable handles (e.g. views of preallocated storage),
+// so publish/release may hand back any object in any order; only the counts
+// must match: every acquired object is published once, every consumed one
+// released once. Usage pattern (single producer, single consumer):
 //   Producer: acquire(out) → fill out → publish(std::move(out))
 //   Consumer: consume(out) → process out → release(std::move(out))
-// On construction the ring pre-populates free_ with Capacity
-// default-constructed T to avoid allocations at runtime. T must be movable.
+// Only `published` and `released` cross sides (plus `consumed` on evictable
+// rings, below); each side caches the other's index as SpscQueue does and
+// refreshes it when the cache says empty/full.
+// On construction the ring is filled with Capacity default-constructed T
+// (or T made by a factory, e.g. bound to preallocated storage) to avoid
+// allocations at runtime. T must be movable; Capacity a power of two.
+// An evictable ring (constructed with `evictable`) additionally lets the
+// producer overwrite the oldest unconsumed item in place when every slot is
+// in flight (drop-oldest); the consumer then takes items with a CAS instead
+// of a plain store so it never reads a slot the producer has claimed.
 namespace lockfree {
 
 template <typename T, std::size_t Capacity> class Ring {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "Ring capacity must be a power of two");
+
 public:
   using value_type = T;
   static constexpr std::size_t kCapacity = Capacity;
-  using Queue =
-      boost::lockfree::spsc_queue<T, boost::lockfree::capacity<kCapacity>>;
 
-  Ring() {
-    // Pre-populate free_ with Capacity default-constructed objects
+  explicit Ring(bool evictable = false) : evictable_(evictable) {}
+
+  // Fills the slots with make(i) for i in [0, Capacity)
+  template <typename Make>
+    requires std::is_invocable_r_v<T, Make &, std::size_t>
+  explicit Ring(Make &&make, bool evictable = false) : evictable_(evictable) {
     for (std::size_t i = 0; i < kCapacity; ++i) {
-      T slot{};
-      (void)free_.push(std::move(slot));
+      slots_[i] = make(i);
     }
   }
 
-  // Non-copyable, movable
+  // Non-copyable, non-movable (shared indices)
   Ring(const Ring &) = delete;
   Ring &operator=(const Ring &) = delete;
-  Ring(Ring &&) = default;
-  Ring &operator=(Ring &&) = default;
 
   // Producer API
-  // Try to acquire an empty slot from free_. Returns false if none available.
-  bool acquire(T &out) { return free_.pop(out); }
+  // Try to acquire an empty slot. Returns false if all are in flight.
+  bool acquire(T &out) {
+    const std::size_t a = prod_.acquired.load(std::memory_order_relaxed);
+    if (a - prod_.released_cache == kCapacity) {
+      prod_.released_cache = cons_.released.load(std::memory_order_acquire);
+      if (a - prod_.released_cache == kCapacity) {
+        return false;
+      }
+    }
+    out = std::move(slots_[a & kMask]);
+    prod_.acquired.store(a + 1, std::memory_order_relaxed);
+    return true;
+  }
 
-  // Publish a filled item to the ready_ queue. Returns false if queue is full.
-  bool publish(T &&item) { return ready_.push(std::move(item)); }
+  // Publish a filled item. Returns false if nothing is acquired (misuse).
+  bool publish(T &&item) {
+    const std::size_t p = prod_.published.load(std::memory_order_relaxed);
+    if (p == prod_.acquired.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    slots_[p & kMask] = std::move(item);
+    prod_.published.store(p + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Evictable rings only: claims the oldest published, not yet consumed
+  // item, lets fn(T &) overwrite it in place and hands it back to the
+  // consumer. Returns false when nothing is waiting (every in-flight item is
+  // already with the consumer).
+  template <typename Fn> bool overwrite_oldest(Fn &&fn) {
+    const std::size_t p = prod_.published.load(std::memory_order_relaxed);
+    std::size_t c = cons_.consumed.load(std::memory_order_acquire);
+    for (;;) {
+      if (c == p) {
+        return false;
+      }
+      if (cons_.consumed.compare_exchange_weak(c, c | kClaimed,
+                                               std::memory_order_acquire,
+                                               std::memory_order_acquire)) {
+        break;
+      }
+    }
+    fn(slots_[c & kMask]);
+    cons_.consumed.store(c, std::memory_order_release);
+    return true;
+  }
 
   // Consumer API
   // Try to consume the next ready item. Returns false if none available.
-  bool consume(T &out) { return ready_.pop(out); }
+  bool consume(T &out) {
+    std::size_t c = cons_.consumed.load(std::memory_order_acquire);
+    if (c == cons_.published_cache) {
+      cons_.published_cache = prod_.published.load(std::memory_order_acquire);
+      if (c == cons_.published_cache) {
+        return false;
+      }
+    }
+    if (evictable_) {
+      // Claimed by overwrite_oldest: the item comes back in a moment
+      if (BRANCH_UNLIKELY((c & kClaimed) != 0) ||
+          !cons_.consumed.compare_exchange_strong(c, c + 1,
+                                                  std::memory_order_acquire)) {
+        return false;
+      }
+    } else {
+      cons_.consumed.store(c + 1, std::memory_order_relaxed);
+    }
+    out = std::move(slots_[c & kMask]);
+    return true;
+  }
 
-  // Release a processed item back to free_. Returns false if free_ is full
-  // (should not happen if used as designed with matching
-  // acquire/publish/consume/release).
-  bool release(T &&item) { return free_.push(std::move(item)); }
+  // Release a processed item back to the producer. Returns false if nothing
+  // is consumed (misuse).
+  bool release(T &&item) {
+    const std::size_t r = cons_.released.load(std::memory_order_relaxed);
+    if (r == (cons_.consumed.load(std::memory_order_relaxed) & ~kClaimed)) {
+      return false;
+    }
+    slots_[r & kMask] = std::move(item);
+    cons_.released.store(r + 1, std::memory_order_release);
+    return true;
+  }
 
-  // Introspection (approximate counts)
-  std::size_t ready_size() const { return ready_.read_available(); }
-  std::size_t free_size() const { return free_.read_available(); }
+  // Introspection (approximate counts from the other side)
+  std::size_t ready_size() const {
+    return prod_.published.load(std::memory_order_acquire) -
+           (cons_.consumed.load(std::memory_order_relaxed) & ~kClaimed);
+  }
+  std::size_t free_size() const {
+    return kCapacity - (prod_.acquired.load(std::memory_order_relaxed) -
+                        cons_.released.load(std::memory_order_acquire));
+  }
 
 private:
-  // Separate queues prevent false sharing of head/tail indices across roles
-  Queue free_;
-  Queue ready_;
+  static constexpr std::size_t kMask = Capacity - 1;
+  // Set in `consumed` while the producer overwrites that item
+  static constexpr std::size_t kClaimed = std::size_t{1}
+                                          << (sizeof(std::size_t) * 8 - 1);
+
+  // Producer-written indices plus its view of `released`
+  struct alignas(kCacheLine) Producer {
+    std::atomic<std::size_t> acquired{0};
+    std::atomic<std::size_t> published{0};
+    std::size_t released_cache = 0;
+  };
+  // Consumer-written indices plus its view of `published`; the producer
+  // claims `consumed` only in overwrite_oldest()
+  struct alignas(kCacheLine) Consumer {
+    std::atomic<std::size_t> consumed{0};
+    std::atomic<std::size_t> released{0};
+    std::size_t published_cache = 0;
+  };
+
+  Producer prod_;
+  Consumer cons_;
+  const bool evictable_;
+  alignas(kCacheLine) std::array<T, Capacity> slots_{};
 };
 
 } // namespace lockfree
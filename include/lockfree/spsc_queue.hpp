@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// lockfree::SpscQueue — bounded single-producer/single-consumer FIFO with a
+// compile-time, power-of-two capacity. Drop-in for the subset of
+// boost::lockfree::spsc_queue the pipeline uses (push, pop,
+// read_available, write_available), tuned for the hot path:
+// - head (consumer) and tail (producer) live on separate cache lines, each
+//   next to its owner's private copy of the other side's index
+// - the remote index is re-read only when the cached copy says the queue is
+//   full (producer) or empty (consumer), so a steady stream costs one shared
+//   cache-line transfer per batch instead of one per element
+// - push_bulk/pop_bulk move up to n elements with a single index publish
+// Indices run freely and are masked on access; all Capacity slots are usable.
+namespace lockfree {
+
+inline constexpr std::size_t kCacheLine = 64;
+
+template <typename T, std::size_t Capacity> class SpscQueue {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "SpscQueue capacity must be a power of two");
+
+public:
+  using value_type = T;
+  static constexpr std::size_t kCapacity = Capacity;
+
+  SpscQueue() = default;
+  SpscQueue(const SpscQueue &) = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+
+  // Producer API
+  bool push(const T &v) { return emplace(v); }
+  bool push(T &&v) { return emplace(std::move(v)); }
+
+  // Moves up to n elements from `in`; returns how many were queued
+  std::size_t push_bulk(T *in, std::size_t n) {
+    const std::size_t t = prod_.tail.load(std::memory_order_relaxed);
+    n = std::min(n, WriteRoom(t, n));
+    for (std::size_t i = 0; i < n; ++i) {
+      slots_[(t + i) & kMask] = std::move(in[i]);
+    }
+    if (n != 0) {
+      prod_.tail.store(t + n, std::memory_order_release);
+    }
+    return n;
+  }
+
+  // Consumer API
+  bool pop(T &out) {
+    const std::size_t h = cons_.head.load(std::memory_order_relaxed);
+    if (ReadRoom(h, 1) == 0) {
+      return false;
+    }
+    out = std::move(slots_[h & kMask]);
+    cons_.head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Moves up to n elements into `out`; returns how many were taken
+  std::size_t pop_bulk(T *out, std::size_t n) {
+    const std::size_t h = cons_.head.load(std::memory_order_relaxed);
+    n = std::min(n, ReadRoom(h, n));
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = std::move(slots_[(h + i) & kMask]);
+    }
+    if (n != 0) {
+      cons_.head.store(h + n, std::memory_order_release);
+    }
+    return n;
+  }
+
+  // Introspection: exact on the owning side, approximate elsewhere
+  std::size_t read_available() const {
+    return prod_.tail.load(std::memory_order_acquire) -
+           cons_.head.load(std::memory_order_acquire);
+  }
+  std::size_t write_available() const { return kCapacity - read_available(); }
+
+private:
+  static constexpr std::size_t kMask = Capacity - 1;
+
+  template <typename U> bool emplace(U &&v) {
+    const std::size_t t = prod_.tail.load(std::memory_order_relaxed);
+    if (WriteRoom(t, 1) == 0) {
+      return false;
+    }
+    slots_[t & kMask] = std::forward<U>(v);
+    prod_.tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Free slots seen by the producer; refreshes the cached head only when
+  // the cached value does not leave room for `want`
+  std::size_t WriteRoom(std::size_t t, std::size_t want) {
+    std::size_t room = kCapacity - (t - prod_.head_cache);
+    if (room < want) {
+      prod_.head_cache = cons_.head.load(std::memory_order_acquire);
+      room = kCapacity - (t - prod_.head_cache);
+    }
+    return room;
+  }
+
+  // Ready elements seen by the consumer; same caching on the tail
+  std::size_t ReadRoom(std::size_t h, std::size_t want) {
+    std::size_t room = cons_.tail_cache - h;
+    if (room < want) {
+      cons_.tail_cache = prod_.tail.load(std::memory_order_acquire);
+      room = cons_.tail_cache - h;
+    }
+    return room;
+  }
+
+  struct alignas(kCacheLine) Producer {
+    std::atomic<std::size_t> tail{0}; // next slot to write
+    std::size_t head_cache = 0;       // last head seen
+  };
+  struct alignas(kCacheLine) Consumer {
+    std::atomic<std::size_t> head{0}; // next slot to read
+    std::size_t tail_cache = 0;       // last tail seen
+  };
+
+  Producer prod_;
+  Consumer cons_;
+  alignas(kCacheLine) std::array<T, Capacity> slots_{};
+};
+
+} // namespace lockfree
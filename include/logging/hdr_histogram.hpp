@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace logging {
+
+// HdrHistogram — fixed-size HDR (high dynamic range) histogram of integer
+// values in [0, Highest] with `Digits` significant decimal digits: values
+// below 2·10^Digits (rounded up to a power of two) get a bucket each, every
+// power of two above that is split into as many linear sub-buckets. All
+// buckets are an inline array sized at compile time, so recording never
+// allocates; values above Highest are recorded as Highest.
+// Threading model:
+// - Record() is single-writer per histogram (one session, or the merger);
+//   each count is a relaxed load + store, no read-modify-write
+// - CopyTo() may run on any thread concurrently with the writer; it sees
+//   every record that happened before it, and possibly some of those made
+//   during the copy
+template <std::uint64_t Highest, unsigned Digits = 3> class HdrHistogram {
+  static constexpr std::uint64_t SubBucketCount() {
+    std::uint64_t largest = 2;
+    for (unsigned i = 0; i < Digits; ++i) {
+      largest *= 10;
+    }
+    return std::bit_ceil(largest);
+  }
+
+public:
+  static constexpr std::uint64_t kSubBuckets = SubBucketCount();
+  static constexpr std::uint64_t kSubHalf = kSubBuckets / 2;
+  static constexpr int kSubHalfBits = std::countr_zero(kSubHalf);
+  static constexpr std::size_t kBuckets = [] {
+    std::size_t n = 1;
+    for (std::uint64_t untrackable = kSubBuckets; untrackable <= Highest;
+         untrackable <<= 1) {
+      ++n;
+    }
+    return n;
+  }();
+  static constexpr std::size_t kCounts = (kBuckets + 1) * kSubHalf;
+
+  static_assert(Digits >= 1 && Digits <= 5, "1 to 5 significant digits");
+  static_assert(Highest >= kSubBuckets, "Highest below the linear range");
+
+  // Plain copy of the counts: percentiles and interval deltas
+  struct Snapshot {
+    std::array<std::uint64_t, kCounts> counts{};
+
+    std::uint64_t Total() const {
+      std::uint64_t n = 0;
+      for (const std::uint64_t c : counts) {
+        n += c;
+      }
+      return n;
+    }
+
+    // Value at percentile `p` (0..100): the highest value equivalent to the
+    // bucket holding the ceil(p% · total)-th smallest record; 0 when empty
+    std::uint64_t Percentile(double p) const {
+      const std::uint64_t total = Total();
+      if (total == 0) {
+        return 0;
+      }
+      auto rank = static_cast<std::uint64_t>(
+          std::ceil(p / 100.0 * static_cast<double>(total)));
+      rank = rank == 0 ? 1 : rank > total ? total : rank;
+      std::uint64_t seen = 0;
+      for (std::size_t i = 0; i < kCounts; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+          return HighestAt(i);
+        }
+      }
+      return HighestAt(kCounts - 1);
+    }
+
+    std::uint64_t Max() const {
+      for (std::size_t i = kCounts; i-- > 0;) {
+        if (counts[i] != 0) {
+          return HighestAt(i);
+        }
+      }
+      return 0;
+    }
+
+    // Records since `earlier` (an older snapshot of the same histogram)
+    Snapshot &operator-=(const Snapshot &earlier) {
+      for (std::size_t i = 0; i < kCounts; ++i) {
+        counts[i] -= earlier.counts[i];
+      }
+      return *this;
+    }
+  };
+
+  void Record(std::uint64_t v) noexcept {
+    std::atomic<std::uint64_t> &c = counts_[Index(v)];
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  void CopyTo(Snapshot &out) const {
+    for (std::size_t i = 0; i < kCounts; ++i) {
+      out.counts[i] = counts_[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  static std::size_t Index(std::uint64_t v) {
+    v = v > Highest ? Highest : v;
+    const int pow2 = 64 - std::countl_zero(v | (kSubBuckets - 1));
+    const int bucket = pow2 - (kSubHalfBits + 1);
+    const std::uint64_t sub = v >> bucket;
+    return (static_cast<std::size_t>(bucket + 1) << kSubHalfBits) +
+           static_cast<std::size_t>(sub - kSubHalf);
+  }
+
+  // Smallest and largest value recorded into count `i`
+  static std::uint64_t LowestAt(std::size_t i) {
+    int bucket = static_cast<int>(i >> kSubHalfBits) - 1;
+    std::uint64_t sub = (i & (kSubHalf - 1)) + kSubHalf;
+    if (bucket < 0) {
+      sub -= kSubHalf;
+      bucket = 0;
+    }
+    return sub << bucket;
+  }
+  static std::uint64_t HighestAt(std::size_t i) {
+    const int bucket = i < 2 * kSubHalf
+                           ? 0
+                           : static_cast<int>(i >> kSubHalfBits) - 1;
+    return LowestAt(i) + (std::uint64_t{1} << bucket) - 1;
+  }
+
+private:
+  std::array<std::atomic<std::uint64_t>, kCounts> counts_{};
+};
+
+} // namespace logging
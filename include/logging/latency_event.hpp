@@ -1,6 +1,6 @@
 #pragma once
 
-#include <boost/lockfree/spsc_queue.hpp>
+#include "lockfree/spsc_queue.hpp"
 #include <cstdint>
 
 namespace logging {
@@ -12,7 +12,7 @@ struct LatencyEvent {
 
 inline constexpr std::size_t kLatencyRingCapacity = 1u << 16;
 
-using LatencyQueue = boost::lockfree::spsc_queue<
-    LatencyEvent, boost::lockfree::capacity<kLatencyRingCapacity>>;
+// Session → logger; the logger drains it with pop_bulk
+using LatencyQueue = lockfree::SpscQueue<LatencyEvent, kLatencyRingCapacity>;
 
 } // namespace logging
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "logging/hdr_histogram.hpp"
+#include "util/branch.hpp"
+#include "util/latency.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace logging {
+
+// Latencies are kept in microseconds up to a minute, 3 significant digits
+inline constexpr std::uint64_t kLatencyHighestUs = 60'000'000;
+
+// LatencyHistogram — receive latency (arrival − event time `E`) of one
+// connection, or of the merged stream, recorded where the message is handled
+// instead of going through the logger.
+// Threading model:
+// - Record() is called by the one thread that owns the histogram (a session,
+//   the reactor for its connection, or the merger); it never allocates
+// - Read by LatencyReporter on the main thread
+class LatencyHistogram {
+public:
+  using Hdr = HdrHistogram<kLatencyHighestUs>;
+
+  // `event_ms` 0 = the message had no `E`; arrivals before `E` (clock skew
+  // against the exchange) are counted and recorded as 0
+  void Record(std::int64_t recv_ns, std::int64_t event_ms) noexcept {
+    if (BRANCH_UNLIKELY(event_ms == 0)) {
+      Bump(untimed_);
+      return;
+    }
+    std::int64_t us = recv_ns / 1000 - event_ms * 1000;
+    if (BRANCH_UNLIKELY(us < 0)) {
+      Bump(ahead_);
+      us = 0;
+    }
+    hdr_.Record(static_cast<std::uint64_t>(us));
+  }
+
+  void CopyTo(Hdr::Snapshot &out) const { hdr_.CopyTo(out); }
+  std::uint64_t Untimed() const {
+    return untimed_.load(std::memory_order_relaxed);
+  }
+  std::uint64_t Ahead() const {
+    return ahead_.load(std::memory_order_relaxed);
+  }
+
+private:
+  static void Bump(std::atomic<std::uint64_t> &c) {
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  Hdr hdr_;
+  std::atomic<std::uint64_t> untimed_{0};
+  std::atomic<std::uint64_t> ahead_{0};
+};
+
+// LatencyReporter — periodic percentile report over registered histograms:
+// one `[latency NAME]` line per histogram on stdout and, with a metrics
+// path, one NDJSON object per histogram appended to that file.
+// Threading model:
+// - Main thread only; reads the histograms with CopyTo while their writers
+//   keep recording. Each report covers the records since the previous one
+//   (Report) or since the start (ReportRun)
+class LatencyReporter {
+public:
+  using Snapshot = LatencyHistogram::Hdr::Snapshot;
+
+  LatencyReporter()
+      : now_(std::make_unique<Snapshot>()),
+        window_(std::make_unique<Snapshot>()) {}
+
+  ~LatencyReporter() {
+    if (metrics_ != nullptr) {
+      std::fclose(metrics_);
+    }
+  }
+
+  // Appends reports to `path` as NDJSON (created if missing)
+  std::error_code OpenMetrics(const std::string &path) {
+    metrics_ = std::fopen(path.c_str(), "a");
+    if (metrics_ == nullptr) {
+      return {errno, std::generic_category()};
+    }
+    return {};
+  }
+
+  void Add(std::string name, std::shared_ptr<const LatencyHistogram> h) {
+    entries_.push_back({std::move(name), std::move(h),
+                        std::make_unique<Snapshot>()});
+  }
+
+  // Percentiles of the records since the last Report()
+  void Report(std::ostream &out, double windowSeconds) {
+    for (Entry &e : entries_) {
+      e.h->CopyTo(*now_);
+      *window_ = *now_;
+      *window_ -= *e.last;
+      *e.last = *now_;
+      Emit(out, e, *window_, "window", windowSeconds);
+    }
+  }
+
+  // Percentiles of every record of the run
+  void ReportRun(std::ostream &out, double runSeconds) {
+    for (Entry &e : entries_) {
+      e.h->CopyTo(*now_);
+      Emit(out, e, *now_, "run", runSeconds);
+    }
+  }
+
+private:
+  struct Entry {
+    std::string name;
+    std::shared_ptr<const LatencyHistogram> h;
+    std::unique_ptr<Snapshot> last; // counts at the previous Report()
+  };
+
+  static constexpr double kPercentiles[] = {50.0, 90.0, 99.0, 99.9};
+
+  void Emit(std::ostream &out, const Entry &e, const Snapshot &s,
+            const char *span, double seconds) {
+    std::uint64_t p[4];
+    for (std::size_t i = 0; i < 4; ++i) {
+      p[i] = s.Percentile(kPercentiles[i]);
+    }
+    const std::uint64_t n = s.Total();
+    const std::uint64_t max = s.Max();
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "[latency %s] %s=%.0fs n=%llu p50=%.3f p90=%.3f p99=%.3f "
+                  "p99.9=%.3f max=%.3f ms untimed=%llu ahead=%llu\n",
+                  e.name.c_str(), span, seconds,
+                  static_cast<unsigned long long>(n), p[0] / 1e3, p[1] / 1e3,
+                  p[2] / 1e3, p[3] / 1e3, max / 1e3,
+                  static_cast<unsigned long long>(e.h->Untimed()),
+                  static_cast<unsigned long long>(e.h->Ahead()));
+    out << line;
+    if (metrics_ == nullptr) {
+      return;
+    }
+    std::fprintf(metrics_,
+                 "{\"ts_ms\":%lld,\"metric\":\"latency\",\"name\":\"%s\","
+                 "\"span\":\"%s\",\"seconds\":%.3f,\"n\":%llu,\"p50_us\":%llu,"
+                 "\"p90_us\":%llu,\"p99_us\":%llu,\"p999_us\":%llu,"
+                 "\"max_us\":%llu,\"untimed\":%llu,\"ahead\":%llu}\n",
+                 static_cast<long long>(lat::EpochMillisUtc()), e.name.c_str(),
+                 span, seconds, static_cast<unsigned long long>(n),
+                 static_cast<unsigned long long>(p[0]),
+                 static_cast<unsigned long long>(p[1]),
+                 static_cast<unsigned long long>(p[2]),
+                 static_cast<unsigned long long>(p[3]),
+                 static_cast<unsigned long long>(max),
+                 static_cast<unsigned long long>(e.h->Untimed()),
+                 static_cast<unsigned long long>(e.h->Ahead()));
+    std::fflush(metrics_);
+  }
+
+  std::vector<Entry> entries_;
+  // Scratch copies, on the heap: a snapshot is ~140 KiB
+  std::unique_ptr<Snapshot> now_;
+  std::unique_ptr<Snapshot> window_;
+  std::FILE *metrics_ = nullptr;
+};
+
+} // namespace logging
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <atomic>
-#include <boost/lockfree/spsc_queue.hpp>
 #include <cstdint>
 #include <fcntl.h>
 #include <memory>
@@ -15,10 +14,12 @@
 #include <pthread.h>
 #include <sched.h>
 #endif
-#include "io/file_writer.hpp"
+#include "io/open_writer.hpp"
+#include "io/writer.hpp"
 #include "logging/latency_event.hpp"
 #include "util/branch.hpp"
 #include "util/cpu_affinity.hpp"
+#include "util/realtime.hpp"
 
 using logging::LatencyEvent;
 
@@ -44,6 +45,7 @@ public:
         CpuAffinity::PickAndPin("file_logger");
       }
 #endif
+      rt::Realtime::EnterThread("file_logger", rt::Role::logger);
       static_cast<Derived *>(this)->RunLoop();
     });
   }
@@ -63,7 +65,8 @@ protected:
 // FileLogger
 // Threading model:
 // - Single background thread performs round-robin draining of per-session SPSC
-//   queues and writes batched lines via writev
+//   queues and writes batched lines through an io::IWriter (writev by
+//   default, see SetWriterKind)
 // - Each session is a single producer to its own SPSC; the logger is the single
 //   consumer for all queues
 class FileLogger : public LoggerBase<FileLogger> {
@@ -76,14 +79,21 @@ public:
     CloseAll();
   }
 
+  // Selects the I/O path for files added afterwards (AddSession)
+  void SetWriterKind(io::WriterKind kind) { writer_kind_ = kind; }
+  // Registers files added afterwards with a durability service
+  void SetDurability(std::shared_ptr<io::SyncService> sync) {
+    sync_ = std::move(sync);
+  }
+
   // Add a session by attaching an external SPSC queue. Logger does not own
   // the queue storage beyond shared ownership.
   uint16_t AddSession(std::shared_ptr<logging::LatencyQueue> externalQueue,
                       const std::string &path) {
-    int fd =
-        ::open(path.c_str(), O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC, 0644);
-    uint16_t id = static_cast<uint16_t>(fds_.size());
-    fds_.push_back(fd);
+    auto w = io::OpenWriter(path, writer_kind_, /*append=*/true, std::nullopt,
+                            sync_.get());
+    uint16_t id = static_cast<uint16_t>(writers_.size());
+    writers_.push_back(w ? std::move(*w) : nullptr);
     ext_queues_.push_back(std::move(externalQueue));
     return id;
   }
@@ -112,14 +122,7 @@ public:
   }
 
 private:
-  void CloseAll() {
-    for (int &fd : fds_) {
-      if (fd != -1) {
-        ::close(fd);
-        fd = -1;
-      }
-    }
-  }
+  void CloseAll() { writers_.clear(); }
 
   static uint16_t ItoaFast(std::int64_t v, char out[32]) {
     char tmp[32];
@@ -147,33 +150,36 @@ private:
       return;
     }
     auto &q = *ext_queues_[i];
-    int fd = fds_[i];
-    if (BRANCH_UNLIKELY(fd == -1)) {
+    io::IWriter *w = writers_[i].get();
+    if (BRANCH_UNLIKELY(w == nullptr)) {
       return;
     }
-    LatencyEvent ev;
+    LatencyEvent evs[128];
     struct iovec iov[128];
     char linebuf[128][32];
     uint16_t lens[128];
-    int cnt = 0;
-    // batch consume to reduce syscalls and atomics
-    while (q.pop(ev)) {
-      std::int64_t delta = ev.arrival_ms - ev.event_ms;
-      lens[cnt] = ItoaFast(std::abs(delta), linebuf[cnt]);
-      linebuf[cnt][lens[cnt]++] = '\n';
-      iov[cnt] = {(void *)linebuf[cnt], lens[cnt]};
-      ++cnt;
-      if (cnt == 128) {
-        io::WritevAll(fd, iov, cnt);
-        cnt = 0;
+    bool wrote = false;
+    // batch consume to reduce syscalls and atomics: one index publish and
+    // one writev per 128 events
+    std::size_t cnt;
+    while ((cnt = q.pop_bulk(evs, 128)) != 0) {
+      for (std::size_t k = 0; k < cnt; ++k) {
+        std::int64_t delta = evs[k].arrival_ms - evs[k].event_ms;
+        lens[k] = ItoaFast(std::abs(delta), linebuf[k]);
+        linebuf[k][lens[k]++] = '\n';
+        iov[k] = {(void *)linebuf[k], lens[k]};
       }
+      w->Writev(iov, static_cast<int>(cnt));
+      wrote = true;
     }
-    if (cnt > 0) {
-      io::WritevAll(fd, iov, cnt);
+    if (wrote) {
+      w->Flush();
     }
   }
 
   std::vector<std::shared_ptr<logging::LatencyQueue>> ext_queues_;
-  std::vector<int> fds_;
+  std::vector<std::unique_ptr<io::IWriter>> writers_;
+  io::WriterKind writer_kind_ = io::WriterKind::write;
+  std::shared_ptr<io::SyncService> sync_;
   std::atomic<bool> alive_{true};
 };
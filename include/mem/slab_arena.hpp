@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <boost/asio/buffer.hpp>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#endif
+
+// namespace mem — fixed-capacity storage for the message path. A SlabArena is
+// one anonymous mapping cut into equal, cache-line-aligned slots; a
+// SlabBuffer is the Beast/Asio dynamic buffer a session reads into, bound to
+// one slot. Slots never grow: a message larger than a slot fails the read
+// (the sessions cap the WebSocket message size to match), so nothing on the
+// message path allocates after startup.
+namespace mem {
+
+inline constexpr std::size_t kCacheLine = 64;
+inline constexpr std::size_t kHugePageSize = 2u << 20;
+
+struct SlabConfig {
+  std::size_t slot_bytes = 2048; // largest message a slot can hold
+  bool hugepages = false; // MAP_HUGETLB, else transparent hugepages (hint)
+  bool prefault = true;   // touch every page at creation
+  bool defer_prefault = false; // with prefault: left to Prefault() (startup)
+  int numa_node = -1;     // bind the pages to this node, -1 = first touch
+};
+
+// SlabArena
+// Threading model:
+// - Created (mapped, bound, prefaulted) on the thread that builds the queue,
+//   or prefaulted later by one other thread (defer_prefault) before any slot
+//   is used; afterwards it is plain memory, slot ownership is tracked by
+//   whoever hands the slots out (RawOrderQueue)
+class SlabArena {
+public:
+  static std::expected<SlabArena, std::error_code>
+  Create(std::size_t slots, const SlabConfig &cfg) {
+    if (slots == 0 || cfg.slot_bytes == 0) {
+      return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+    SlabArena a;
+    a.slot_bytes_ = cfg.slot_bytes;
+    a.stride_ = (cfg.slot_bytes + kCacheLine - 1) & ~(kCacheLine - 1);
+    a.slots_ = slots;
+    const std::size_t bytes = a.stride_ * slots;
+    if (cfg.hugepages) {
+      a.len_ = (bytes + kHugePageSize - 1) & ~(kHugePageSize - 1);
+      a.base_ = ::mmap(nullptr, a.len_, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      a.huge_ = a.base_ != MAP_FAILED;
+    }
+    if (a.base_ == MAP_FAILED) {
+      // No reserved hugepages (or not asked for): regular pages
+      const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+      a.len_ = (bytes + page - 1) & ~(page - 1);
+      a.base_ = ::mmap(nullptr, a.len_, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (a.base_ == MAP_FAILED) {
+        return std::unexpected(std::error_code(errno, std::generic_category()));
+      }
+#ifdef MADV_HUGEPAGE
+      if (cfg.hugepages) {
+        (void)::madvise(a.base_, a.len_, MADV_HUGEPAGE);
+      }
+#endif
+    }
+#ifdef __linux__
+    if (cfg.numa_node >= 0) {
+      // Before the first touch, so the pages are allocated on the node
+      unsigned long mask[16] = {};
+      const auto node = static_cast<unsigned>(cfg.numa_node);
+      if (node >= sizeof(mask) * 8) {
+        return std::unexpected(
+            std::make_error_code(std::errc::invalid_argument));
+      }
+      mask[node / (8 * sizeof(unsigned long))] |=
+          1ul << (node % (8 * sizeof(unsigned long)));
+      if (::syscall(SYS_mbind, a.base_, a.len_, MPOL_BIND, mask,
+                    sizeof(mask) * 8, 0) != 0) {
+        return std::unexpected(std::error_code(errno, std::generic_category()));
+      }
+      a.node_ = cfg.numa_node;
+    }
+#endif
+    if (cfg.prefault && !cfg.defer_prefault) {
+      a.Prefault();
+    }
+    return a;
+  }
+
+  SlabArena() = default;
+  SlabArena(SlabArena &&o) noexcept { *this = std::move(o); }
+  SlabArena &operator=(SlabArena &&o) noexcept {
+    std::swap(base_, o.base_);
+    std::swap(len_, o.len_);
+    std::swap(slot_bytes_, o.slot_bytes_);
+    std::swap(stride_, o.stride_);
+    std::swap(slots_, o.slots_);
+    std::swap(huge_, o.huge_);
+    std::swap(node_, o.node_);
+    return *this;
+  }
+  ~SlabArena() {
+    if (base_ != MAP_FAILED) {
+      ::munmap(base_, len_);
+    }
+  }
+
+  // Faults every page in now, not on the first reads of a connection:
+  // MADV_POPULATE_WRITE (Linux 5.14+, no user-space loop) or one write per
+  // page. Content is undefined afterwards; call it before handing slots out.
+  void Prefault() {
+#ifdef MADV_POPULATE_WRITE
+    if (::madvise(base_, len_, MADV_POPULATE_WRITE) == 0) {
+      return;
+    }
+#endif
+    const std::size_t step =
+        huge_ ? kHugePageSize
+              : static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    auto *p = static_cast<volatile char *>(base_);
+    for (std::size_t off = 0; off < len_; off += step) {
+      p[off] = 0;
+    }
+  }
+
+  std::byte *Slot(std::size_t i) const {
+    return static_cast<std::byte *>(base_) + i * stride_;
+  }
+  std::size_t SlotBytes() const { return slot_bytes_; }
+  std::size_t Slots() const { return slots_; }
+  std::size_t Bytes() const { return len_; }
+  bool OnHugepages() const { return huge_; } // MAP_HUGETLB succeeded
+  int Node() const { return node_; }         // -1 = not bound
+
+private:
+  void *base_ = MAP_FAILED;
+  std::size_t len_ = 0;
+  std::size_t slot_bytes_ = 0;
+  std::size_t stride_ = 0;
+  std::size_t slots_ = 0;
+  bool huge_ = false;
+  int node_ = -1;
+};
+
+// SlabBuffer — DynamicBuffer (Asio v1) over caller-owned storage of fixed
+// capacity. Contiguous like beast::flat_buffer; trivially copyable, so a
+// slot handle moves through the rings as three words. prepare() compacts
+// consumed bytes and throws std::length_error past capacity (the
+// WebSocket stream checks max_size() first and reports buffer_overflow).
+class SlabBuffer {
+public:
+  using const_buffers_type = boost::asio::const_buffer;
+  using mutable_buffers_type = boost::asio::mutable_buffer;
+
+  SlabBuffer() = default;
+  SlabBuffer(std::byte *p, std::size_t n)
+      : base_(reinterpret_cast<char *>(p)),
+        cap_(static_cast<std::uint32_t>(n)) {}
+
+  std::size_t size() const { return size_; }
+  std::size_t max_size() const { return cap_; }
+  std::size_t capacity() const { return cap_; }
+
+  const_buffers_type data() const { return {base_ + in_, size_}; }
+  const_buffers_type cdata() const { return data(); }
+  mutable_buffers_type data() { return {base_ + in_, size_}; }
+
+  mutable_buffers_type prepare(std::size_t n) {
+    if (size_ + n > cap_) {
+      throw std::length_error("SlabBuffer overflow");
+    }
+    if (in_ + size_ + n > cap_) {
+      std::memmove(base_, base_ + in_, size_);
+      in_ = 0;
+    }
+    out_ = static_cast<std::uint32_t>(n);
+    return {base_ + in_ + size_, n};
+  }
+
+  void commit(std::size_t n) {
+    size_ += static_cast<std::uint32_t>(std::min<std::size_t>(n, out_));
+    out_ = 0;
+  }
+
+  void consume(std::size_t n) {
+    if (n >= size_) {
+      in_ = 0;
+      size_ = 0;
+    } else {
+      in_ += static_cast<std::uint32_t>(n);
+      size_ -= static_cast<std::uint32_t>(n);
+    }
+  }
+
+  void clear() {
+    in_ = 0;
+    size_ = 0;
+    out_ = 0;
+  }
+
+private:
+  char *base_ = nullptr;
+  std::uint32_t cap_ = 0;
+  std::uint32_t in_ = 0;   // start of the readable bytes
+  std::uint32_t size_ = 0; // readable bytes
+  std::uint32_t out_ = 0;  // prepared, not yet committed
+};
+
+} // namespace mem
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "lockfree/broadcast_ring.hpp"
+#include "util/branch.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+
+// namespace merge — in-process consumer API on the merged stream.
+// StreamMerger publishes every ordered, deduplicated message into one
+// BroadcastRing; each StreamConsumer owns a cursor and receives views of
+// validated copies of the ring slots. The merger never waits for consumers:
+// a consumer that falls behind by more than the ring capacity loses messages
+// and sees it in Stats().
+namespace merge {
+
+using MessageView = lockfree::BroadcastMessage;
+
+struct BroadcastConfig {
+  std::size_t slot_count = 8192; // power of two
+  std::size_t slot_size = 512;   // bytes per slot incl. 32-byte header
+};
+
+// ConsumerHub — owns the heap-backed ring and a fixed table of registered
+// consumer cursors used by the producer for slow-consumer detection.
+class ConsumerHub {
+public:
+  static constexpr std::size_t kMaxConsumers = 16;
+
+  explicit ConsumerHub(BroadcastConfig cfg = {})
+      : size_(lockfree::BroadcastRing::RegionSize(cfg.slot_count,
+                                                  cfg.slot_size)),
+        mem_(static_cast<std::byte *>(
+            ::operator new(size_, std::align_val_t{64}))) {
+    std::fill(mem_, mem_ + size_, std::byte{0});
+    lockfree::BroadcastRing::Format(mem_, cfg.slot_count, cfg.slot_size);
+    ring_.emplace(mem_);
+    slow_threshold_ = cfg.slot_count / 2;
+  }
+
+  ~ConsumerHub() {
+    ring_.reset();
+    ::operator delete(mem_, std::align_val_t{64});
+  }
+
+  ConsumerHub(const ConsumerHub &) = delete;
+  ConsumerHub &operator=(const ConsumerHub &) = delete;
+
+  lockfree::BroadcastRing &Ring() { return *ring_; }
+
+  // Producer side: publish one message; every kScanEvery messages the cursor
+  // table is scanned and consumers lagging past half the ring are flagged.
+  void Publish(std::uint64_t u, std::uint32_t src, std::int64_t recv_ns,
+               const void *data, std::size_t len) {
+    ring_->Publish(u, src, recv_ns, data, len);
+    if (BRANCH_UNLIKELY((++published_ & (kScanEvery - 1)) == 0)) {
+      ScanSlowConsumers();
+    }
+  }
+
+  // Registration (any thread). Returns the table index or -1 if full.
+  int Register(std::uint64_t start) {
+    for (std::size_t i = 0; i < kMaxConsumers; ++i) {
+      bool expected = false;
+      if (cursors_[i].active.compare_exchange_strong(
+              expected, true, std::memory_order_acq_rel)) {
+        cursors_[i].cursor.store(start, std::memory_order_relaxed);
+        cursors_[i].slow.store(false, std::memory_order_relaxed);
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+
+  void Unregister(int id) {
+    if (id >= 0) {
+      cursors_[id].active.store(false, std::memory_order_release);
+    }
+  }
+
+  void UpdateCursor(int id, std::uint64_t cursor) {
+    if (id >= 0) {
+      cursors_[id].cursor.store(cursor, std::memory_order_relaxed);
+    }
+  }
+
+  bool IsSlow(int id) const {
+    return id >= 0 && cursors_[id].slow.load(std::memory_order_relaxed);
+  }
+
+  // Number of slow-consumer transitions observed by the producer
+  std::uint64_t SlowEvents() const {
+    return slow_events_.load(std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr std::uint64_t kScanEvery = 1024;
+
+  struct alignas(64) CursorSlot {
+    std::atomic<bool> active{false};
+    std::atomic<bool> slow{false};
+    std::atomic<std::uint64_t> cursor{0};
+  };
+
+  void ScanSlowConsumers() {
+    const std::uint64_t head = ring_->Head();
+    for (auto &c : cursors_) {
+      if (!c.active.load(std::memory_order_acquire)) {
+        continue;
+      }
+      const std::uint64_t cur = c.cursor.load(std::memory_order_relaxed);
+      const bool slow = head > cur && head - cur > slow_threshold_;
+      if (slow && !c.slow.load(std::memory_order_relaxed)) {
+        slow_events_.fetch_add(1, std::memory_order_relaxed);
+      }
+      c.slow.store(slow, std::memory_order_relaxed);
+    }
+  }
+
+  std::size_t size_;
+  std::byte *mem_;
+  std::optional<lockfree::BroadcastRing> ring_;
+  std::uint64_t published_ = 0;
+  std::uint64_t slow_threshold_ = 0;
+  std::array<CursorSlot, kMaxConsumers> cursors_{};
+  std::atomic<std::uint64_t> slow_events_{0};
+};
+
+// StreamConsumer — a registered reader of the merged stream. Owned and polled
+// by exactly one thread; unregisters on destruction.
+class StreamConsumer {
+public:
+  StreamConsumer(std::shared_ptr<ConsumerHub> hub, std::string name)
+      : hub_(std::move(hub)), name_(std::move(name)), reader_(hub_->Ring()) {
+    id_ = hub_->Register(reader_.Cursor());
+  }
+
+  ~StreamConsumer() { hub_->Unregister(id_); }
+
+  StreamConsumer(const StreamConsumer &) = delete;
+  StreamConsumer &operator=(const StreamConsumer &) = delete;
+
+  // False when the hub's consumer table was full at registration
+  bool Registered() const { return id_ >= 0; }
+
+  // Delivers up to `max` ordered messages to fn(const MessageView&). A slot
+  // is copied and re-checked before fn runs, so a message overwritten
+  // mid-read is counted as lost (and torn), never delivered. Views point
+  // into the reader's copy and must not be retained after fn returns.
+  template <typename Fn> std::size_t Poll(Fn &&fn, std::size_t max = 64) {
+    const std::size_t n = reader_.Poll(std::forward<Fn>(fn), max);
+    if (n != 0) {
+      hub_->UpdateCursor(id_, reader_.Cursor());
+    }
+    return n;
+  }
+
+  std::uint64_t Lag() const { return reader_.Lag(); }
+  // Set by the producer when this consumer lags past half the ring
+  bool Slow() const { return hub_->IsSlow(id_); }
+  const lockfree::BroadcastReader::Stats &Stats() const {
+    return reader_.GetStats();
+  }
+  const std::string &Name() const { return name_; }
+
+private:
+  std::shared_ptr<ConsumerHub> hub_;
+  std::string name_;
+  lockfree::BroadcastReader reader_;
+  int id_ = -1;
+};
+
+} // namespace merge
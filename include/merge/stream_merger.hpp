@@ -1,10 +1,18 @@
 #pragma once
 
+#include "analytics/market_analytics.hpp"
 #include "core/message.hpp"
+#include "ipc/shm_ring.hpp"
+#include "logging/latency_histogram.hpp"
+#include "merge/stream_consumer.hpp"
+#include "sink/sink_worker.hpp"
 #include "util/branch.hpp"
 #include <atomic>
 #include <charconv>
 #include <chrono>
+#include <expected>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <queue>
 #include <string>
@@ -15,10 +23,8 @@
 #include <pthread.h>
 #include <sched.h>
 #endif
-#include "io/file_writer.hpp"
 #include "util/cpu_affinity.hpp"
-#include <fcntl.h>
-#include <unistd.h>
+#include "util/realtime.hpp"
 
 // StreamMerger merges messages from N SPSC queues into a single NDJSON stream
 // with the lowest possible latency subject to correctness:
@@ -26,30 +32,90 @@
 // - Uses a small time-based hold-back window to reorder minor out-of-order
 // bursts
 // - Deduplicates by `u` with a first-wins policy (late duplicates are dropped)
-// - Emits batched writes via a single coalesced buffer per flush
+// - Records the merged stream's latency: for each emitted `u`, the earliest
+//   arrival among the copies the connections delivered within the window
+// - Fans every emitted message out to the attached sinks (file, compressed
+//   file, socket, shared memory), each drained by its own thread with its own
+//   overflow policy, so a slow output never stalls the others
+// - With --shm, also publishes it straight into a shared-memory ring on its
+//   own thread (one copy, no sink queue or thread hop)
 class StreamMerger {
 public:
-  // Construct merger with producer queues and output file path
-  StreamMerger(std::vector<std::shared_ptr<RawOrderQueue>> queues,
-               std::string out_file)
-      : queues_(std::move(queues)) {
-    fd_ = ::open(out_file.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC,
-                 0644);
+  // Construct merger with producer queues; outputs are attached with AddSink
+  explicit StreamMerger(std::vector<std::shared_ptr<RawOrderQueue>> queues)
+      : queues_(std::move(queues)), minheap_(MinCmp{}, ReservedHeap()) {}
+
+  ~StreamMerger() { Join(); }
+
+  // Attaches an output. The sink gets its own bounded queue and thread; see
+  // sink::OverflowPolicy for what happens when it falls behind. Must be
+  // called before Start().
+  sink::SinkWorker &AddSink(std::unique_ptr<sink::ISink> s,
+                            sink::SinkConfig cfg = {}) {
+    sinks_.push_back(std::make_unique<sink::SinkWorker>(std::move(s), cfg));
+    return *sinks_.back();
+  }
+
+  // Attached sinks, in AddSink order (for stats reporting)
+  const std::vector<std::unique_ptr<sink::SinkWorker>> &Sinks() const {
+    return sinks_;
+  }
+
+  // Attaches an analytics stage fed with every emitted message on the merger
+  // thread. Must be called before Start().
+  void SetAnalytics(std::shared_ptr<analytics::MarketAnalytics> a) {
+    analytics_ = std::move(a);
   }
 
-  ~StreamMerger() {
-    Join();
-    if (fd_ != -1) {
-      ::close(fd_);
-      fd_ = -1;
+  // Histogram of the merged stream's latency ("earliest of K"), written on
+  // the merger thread. Must be called before Start().
+  void SetLatencyHistogram(std::shared_ptr<logging::LatencyHistogram> h) {
+    latency_ = std::move(h);
+  }
+
+  // Warm restart: continues dedup after the last `u` an earlier run wrote, so
+  // the overlap the new connections replay is dropped rather than re-emitted.
+  // Must be called before Start().
+  void SetResumePoint(std::uint64_t lastU) { last_emitted_u_ = lastU; }
+
+  // Publishes every emitted message into a named shared-memory broadcast ring
+  // (see ipc::ShmRingReader) on the merger thread, before the sinks: readers
+  // see it one copy after the merge. Must be called before Start().
+  std::expected<void, std::error_code>
+  EnableSharedMemory(const std::string &name, ipc::ShmRingConfig cfg = {}) {
+    auto w = ipc::ShmRingWriter::Create(name, cfg);
+    if (!w) {
+      return std::unexpected(w.error());
     }
+    shm_.emplace(std::move(*w));
+    return {};
   }
 
-  // Returns true if output file is opened successfully
-  bool OpenOk() const { return fd_ != -1; }
+  // The shared-memory writer, null without EnableSharedMemory (for stats)
+  const ipc::ShmRingWriter *SharedMemory() const {
+    return shm_.has_value() ? &*shm_ : nullptr;
+  }
 
-  // Starts the merger worker thread; optionally pins it to a CPU
+  // Registers an in-process consumer of the ordered, deduplicated stream. May
+  // be called from any thread at any time; the consumer sees messages emitted
+  // after registration. The broadcast ring is created on first use.
+  std::unique_ptr<merge::StreamConsumer>
+  Subscribe(std::string name, merge::BroadcastConfig cfg = {}) {
+    std::lock_guard<std::mutex> lock(hub_mu_);
+    if (!hub_owner_) {
+      hub_owner_ = std::make_shared<merge::ConsumerHub>(cfg);
+      hub_.store(hub_owner_.get(), std::memory_order_release);
+    }
+    return std::make_unique<merge::StreamConsumer>(hub_owner_,
+                                                   std::move(name));
+  }
+
+  // Starts the sink threads and the merger worker thread; optionally pins the
+  // merger to a CPU
   void Start(std::optional<int> pinCpu = std::nullopt) {
+    for (auto &s : sinks_) {
+      s->Start();
+    }
     worker_ = std::jthread([this, pinCpu] {
 #ifdef __linux__
       if (pinCpu.has_value()) {
@@ -58,16 +124,21 @@ public:
         CpuAffinity::PickAndPin("stream_merger");
       }
 #endif
+      rt::Realtime::EnterThread("stream_merger", rt::Role::merger);
       this->Run();
     });
   }
 
-  // Requests graceful stop and joins the worker thread
+  // Requests graceful stop, joins the worker thread, then lets every sink
+  // drain its queue and joins the sink threads
   void Join() {
     stop_requested_.store(true, std::memory_order_relaxed);
     if (worker_.joinable()) {
       worker_.join();
     }
+    for (auto &s : sinks_) {
+      s->Stop();
+    }
   }
 
   // Main run loop: ingest → flush ready; on stop and empty queues → drain all
@@ -75,6 +146,9 @@ public:
     for (;;) {
       IngestQueues();
       FlushReady();
+      for (auto &s : sinks_) {
+        s->Service();
+      }
       if (stop_requested_.load(std::memory_order_relaxed) && AllQueuesEmpty()) {
         DrainAll();
         break;
@@ -94,7 +168,7 @@ private:
     std::uint64_t u;               // updateId used for ordering/dedup
     Clock::time_point first_seen;  // arrival time at the merger
     std::size_t src;               // source queue index to release back
-    boost::beast::flat_buffer buf; // raw NDJSON payload (contiguous)
+    RawOrderUpdate msg;            // raw NDJSON payload (contiguous) + recv ts
   };
 
   // Fast parsing of updateId `u` from the payload
@@ -121,6 +195,49 @@ private:
     return std::nullopt;
   }
 
+  // Emits one message in stream order: copies it into every sink queue and
+  // the in-process stages, then returns the buffer to its producer ring
+  void Emit(BufEntry &e) {
+    auto b = e.msg.buf.data();
+    const std::string_view payload{static_cast<const char *>(b.data()),
+                                   b.size()};
+    const auto src = static_cast<std::uint32_t>(e.src);
+    if (shm_.has_value()) {
+      (void)shm_->Publish(e.u, src, e.msg.recv_ns, b.data(), b.size());
+    }
+    for (auto &s : sinks_) {
+      s->Push(e.u, src, e.msg.recv_ns, payload);
+    }
+    if (analytics_) {
+      analytics_->OnMessage(payload);
+    }
+    if (auto *hub = hub_.load(std::memory_order_acquire)) {
+      hub->Publish(e.u, src, e.msg.recv_ns, b.data(), b.size());
+    }
+    queues_[e.src]->release(std::move(e.msg));
+  }
+
+  // Drops the other connections' copies of `e.u` still in the heap (they
+  // would be dropped as duplicates next) and records the earliest arrival
+  // of all copies as the merged stream's latency for it
+  void RecordEarliest(const BufEntry &e) {
+    std::int64_t recvNs = e.msg.recv_ns;
+    std::int64_t eventMs = e.msg.event_ms;
+    while (!minheap_.empty() && minheap_.top().u == e.u) {
+      const BufEntry &dup = minheap_.top();
+      if (dup.msg.recv_ns < recvNs) {
+        recvNs = dup.msg.recv_ns;
+        eventMs = dup.msg.event_ms;
+      }
+      queues_[dup.src]->Duplicate();
+      queues_[dup.src]->release(std::move(const_cast<BufEntry &>(dup).msg));
+      minheap_.pop();
+    }
+    if (latency_) {
+      latency_->Record(recvNs, eventMs);
+    }
+  }
+
   // Returns true if all producer SPSC queues are currently empty
   bool AllQueuesEmpty() const {
     for (const auto &q : queues_) {
@@ -132,22 +249,29 @@ private:
   }
 
   // Ingests messages from all queues, parses `u`, and pushes to the min-heap
-  // only if u > last_emitted_u_ (late duplicates dropped on push)
+  // only if u > last_emitted_u_ (late duplicates dropped on push). Every
+  // consumed update ends in exactly one release(), emitted or not.
   void IngestQueues() {
     for (std::size_t i = 0; i < queues_.size(); ++i) {
       RawOrderUpdate m;
       while (queues_[i]->consume(m)) {
-        auto cb = m.data();
+        auto cb = m.buf.data();
         const char *data = static_cast<const char *>(cb.data());
         std::size_t len = cb.size();
         auto ou = ExtractUpdateId(std::string_view{data, len});
-        if (!ou.has_value()) {
+        // Dropped messages are counted and go straight back to their
+        // producer: the slots are a fixed pool
+        if (BRANCH_UNLIKELY(!ou.has_value())) {
+          queues_[i]->Unparsed();
+          queues_[i]->release(std::move(m));
           continue;
         }
-        const std::uint64_t u = *ou;
-        if (u <= last_emitted_u_) {
+        if (*ou <= last_emitted_u_) {
+          queues_[i]->Duplicate();
+          queues_[i]->release(std::move(m));
           continue;
         }
+        const std::uint64_t u = *ou;
         BufEntry e{u, Clock::now(), i, std::move(m)};
         minheap_.push(std::move(e));
       }
@@ -155,25 +279,16 @@ private:
   }
 
   // Flushes ready entries: pops from the min-heap (which orders by smallest
-  // `u`) while entries are older than the hold-back window, coalesces them into
-  // one buffer, and writes once. Updates last_emitted_u_. Late duplicates (same
-  // `u` still in heap) are dropped on a subsequent iteration when observed.
+  // `u`) while entries are older than the hold-back window and emits them in
+  // order. Updates last_emitted_u_. Copies of the emitted `u` still in the
+  // heap are dropped with it; later ones are dropped when observed.
   void FlushReady() {
-    if (BRANCH_UNLIKELY(fd_ == -1)) {
-      return;
-    }
     const auto now = Clock::now();
-    std::uint64_t last_u = last_emitted_u_;
-    // Batch up to 64 entries with writev: [payload, "\n"] pairs
-    std::vector<BufEntry> batch_entries;
-    batch_entries.reserve(64);
-    struct iovec iov[128];
-    int iov_cnt = 0;
-    static const char newline = '\n';
-
     while (!minheap_.empty()) {
       const BufEntry &top = minheap_.top();
-      if (BRANCH_UNLIKELY(top.u <= last_u)) {
+      if (BRANCH_UNLIKELY(top.u <= last_emitted_u_)) {
+        queues_[top.src]->Duplicate();
+        queues_[top.src]->release(std::move(const_cast<BufEntry &>(top).msg));
         minheap_.pop();
         continue;
       }
@@ -182,74 +297,47 @@ private:
       }
       BufEntry e = std::move(const_cast<BufEntry &>(top));
       minheap_.pop();
-      auto b = e.buf.data();
-      iov[iov_cnt++] = {(void *)b.data(), b.size()};
-      iov[iov_cnt++] = {(void *)&newline, 1};
-      last_u = e.u;
-      batch_entries.emplace_back(std::move(e));
-      if (iov_cnt >= 128) {
-        io::WritevAll(fd_, iov, iov_cnt);
-        // release consumed buffers back to producer rings
-        for (auto &be : batch_entries) {
-          queues_[be.src]->release(std::move(be.buf));
-        }
-        iov_cnt = 0;
-        batch_entries.clear();
-      }
-    }
-
-    if (iov_cnt > 0) {
-      io::WritevAll(fd_, iov, iov_cnt);
-      for (auto &be : batch_entries) {
-        queues_[be.src]->release(std::move(be.buf));
-      }
-      batch_entries.clear();
-      last_emitted_u_ = last_u;
+      last_emitted_u_ = e.u;
+      RecordEarliest(e);
+      Emit(e);
     }
   }
 
   // Final drain without hold-back: emits remaining entries in min-heap order
   // (monotonic by `u`), skipping any late duplicates
   void DrainAll() {
-    if (fd_ == -1) {
-      return;
-    }
-    struct iovec iov[128];
-    static const char newline = '\n';
     while (!minheap_.empty()) {
-      int iov_cnt = 0;
-      std::uint64_t last_u = last_emitted_u_;
-      std::vector<BufEntry> batch_entries;
-      batch_entries.reserve(64);
-      while (!minheap_.empty() && iov_cnt <= 126) {
-        BufEntry e = std::move(const_cast<BufEntry &>(minheap_.top()));
-        minheap_.pop();
-        if (e.u > last_u) {
-          auto b = e.buf.data();
-          iov[iov_cnt++] = {(void *)b.data(), b.size()};
-          iov[iov_cnt++] = {(void *)&newline, 1};
-          last_u = e.u;
-          batch_entries.emplace_back(std::move(e));
-        }
-      }
-      if (iov_cnt > 0) {
-        io::WritevAll(fd_, iov, iov_cnt);
-        for (auto &be : batch_entries) {
-          queues_[be.src]->release(std::move(be.buf));
-        }
-        last_emitted_u_ = last_u;
+      BufEntry e = std::move(const_cast<BufEntry &>(minheap_.top()));
+      minheap_.pop();
+      if (e.u > last_emitted_u_) {
+        last_emitted_u_ = e.u;
+        RecordEarliest(e);
+        Emit(e);
+      } else {
+        queues_[e.src]->Duplicate();
+        queues_[e.src]->release(std::move(e.msg));
       }
     }
   }
 
   // Producer queues feeding the merger
   std::vector<std::shared_ptr<RawOrderQueue>> queues_;
-  // Output file descriptor (append-only)
-  int fd_ = -1;
+  // Outputs, each with its own queue, thread and overflow policy
+  std::vector<std::unique_ptr<sink::SinkWorker>> sinks_;
   // Worker thread handling ingestion and flush
   std::jthread worker_;
   // Stop flag requested by Join()
   std::atomic<bool> stop_requested_{false};
+  // Optional analytics stage updated with every emitted message
+  std::shared_ptr<analytics::MarketAnalytics> analytics_;
+  // Optional merged-stream latency, recorded per emitted message
+  std::shared_ptr<logging::LatencyHistogram> latency_;
+  // In-process consumer fan-out; hub_ is read lock-free on the merger thread
+  std::mutex hub_mu_;
+  std::shared_ptr<merge::ConsumerHub> hub_owner_;
+  std::atomic<merge::ConsumerHub *> hub_{nullptr};
+  // Optional out-of-process fan-out through shared memory
+  std::optional<ipc::ShmRingWriter> shm_;
 
   // Last successfully emitted updateId `u` to ensure monotonic stream
   std::uint64_t last_emitted_u_ = 0;
@@ -259,6 +347,13 @@ private:
       return a.u > b.u;
     }
   };
+  // Every heap entry holds a queue slot, so the heap never outgrows the
+  // queues' combined capacity: reserved once, no growth on the message path
+  std::vector<BufEntry> ReservedHeap() const {
+    std::vector<BufEntry> v;
+    v.reserve(queues_.size() * RawOrderQueue::kCapacity);
+    return v;
+  }
   // Reordering buffer: min-heap ensures monotonic emission by `u`
   std::priority_queue<BufEntry, std::vector<BufEntry>, MinCmp> minheap_;
 };
@@ -0,0 +1,610 @@
+#pragma once
+
+#include "codec/binary_record.hpp"
+#include "merge/stream_consumer.hpp"
+#include "util/branch.hpp"
+#include "util/cpu_affinity.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <memory>
+#include <netinet/in.h>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// namespace mcast — UDP multicast republisher of the merged stream and the
+// matching receiver.
+// Wire format (little-endian): every datagram starts with DatagramHeader.
+// - kQuotes: `count` codec::QuoteRecord follow; `seq` numbers quote datagrams
+//   gap-free starting at 1, so receivers detect loss per datagram.
+// - kSymbols: `count` SymbolDef follow (id → name), resent periodically.
+// - kRetransmitRequest / kUnavailable: unicast side channel; `seq`/`count`
+//   describe the requested range. The publisher keeps the last `history` quote
+//   datagrams and resends them to the requester, or answers kUnavailable.
+namespace mcast {
+
+inline constexpr std::uint16_t kMagic = 0x5742; // "BW"
+inline constexpr std::uint8_t kVersion = 1;
+inline constexpr std::size_t kMaxDatagram = 1472; // 1500 MTU - IP - UDP
+
+enum DatagramType : std::uint8_t {
+  kQuotes = 1,
+  kSymbols = 2,
+  kRetransmitRequest = 3,
+  kUnavailable = 4,
+};
+
+struct DatagramHeader {
+  std::uint16_t magic;
+  std::uint8_t version;
+  std::uint8_t type;
+  std::uint16_t count;
+  std::uint16_t reserved;
+  std::uint64_t seq;
+};
+static_assert(sizeof(DatagramHeader) == 16, "DatagramHeader layout changed");
+
+struct SymbolDef {
+  std::uint16_t id;
+  std::uint8_t len;
+  std::uint8_t reserved;
+  char name[16];
+};
+static_assert(sizeof(SymbolDef) == 20, "SymbolDef layout changed");
+
+inline constexpr std::size_t kRecordsPerDatagram =
+    (kMaxDatagram - sizeof(DatagramHeader)) / sizeof(codec::QuoteRecord);
+inline constexpr std::size_t kSymbolsPerDatagram =
+    (kMaxDatagram - sizeof(DatagramHeader)) / sizeof(SymbolDef);
+inline constexpr std::uint16_t kMaxRetransmit = 256;
+
+struct Endpoint {
+  std::string group = "239.255.42.1"; // multicast group
+  std::uint16_t port = 31001;         // multicast port
+  std::string iface = "127.0.0.1";    // local interface address
+  std::uint16_t retransmit_port = 31002;
+};
+
+namespace detail {
+
+inline std::error_code LastError() {
+  return std::error_code(errno, std::generic_category());
+}
+
+inline std::expected<in_addr, std::error_code> ParseIpv4(const std::string &s) {
+  in_addr a{};
+  if (::inet_pton(AF_INET, s.c_str(), &a) != 1) {
+    return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+  }
+  return a;
+}
+
+inline sockaddr_in MakeAddr(in_addr a, std::uint16_t port) {
+  sockaddr_in sa{};
+  sa.sin_family = AF_INET;
+  sa.sin_addr = a;
+  sa.sin_port = htons(port);
+  return sa;
+}
+
+inline std::expected<int, std::error_code> UdpSocket(std::uint16_t bindPort,
+                                                     in_addr bindAddr) {
+  int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return std::unexpected(LastError());
+  }
+  int one = 1;
+  (void)::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in sa = MakeAddr(bindAddr, bindPort);
+  if (::bind(fd, reinterpret_cast<sockaddr *>(&sa), sizeof(sa)) != 0) {
+    auto ec = LastError();
+    ::close(fd);
+    return std::unexpected(ec);
+  }
+  return fd;
+}
+
+inline void CloseFd(int &fd) {
+  if (fd != -1) {
+    ::close(fd);
+    fd = -1;
+  }
+}
+
+} // namespace detail
+
+// "GROUP:PORT" → Endpoint with the retransmit port at PORT + 1; nullopt when
+// GROUP is not an IPv4 address or PORT is not a number in 1..65534
+inline std::optional<Endpoint> ParseEndpoint(std::string_view spec,
+                                             std::string iface) {
+  const std::size_t colon = spec.rfind(':');
+  if (colon == std::string_view::npos) {
+    return std::nullopt;
+  }
+  Endpoint ep;
+  ep.group = std::string(spec.substr(0, colon));
+  const std::string_view port = spec.substr(colon + 1);
+  unsigned v = 0;
+  const auto [end, ec] =
+      std::from_chars(port.data(), port.data() + port.size(), v);
+  if (ec != std::errc{} || end != port.data() + port.size() || v == 0 ||
+      v > 65534 || !detail::ParseIpv4(ep.group)) {
+    return std::nullopt;
+  }
+  ep.port = static_cast<std::uint16_t>(v);
+  ep.retransmit_port = static_cast<std::uint16_t>(v + 1);
+  ep.iface = std::move(iface);
+  return ep;
+}
+
+// MulticastPublisher
+// Threading model:
+// - Owns one std::jthread that polls its merge::StreamConsumer, encodes
+//   records into quote datagrams built in place inside the history ring, and
+//   sends each batch with a single sendmmsg(2)
+// - The same thread serves retransmit requests (non-blocking recvfrom)
+// - The merger is never blocked; if this thread falls behind, the consumer
+//   reports lost messages
+class MulticastPublisher {
+public:
+  struct Config {
+    Endpoint endpoint;
+    int ttl = 1;
+    bool loopback = true;      // deliver to local receivers (tests, tools)
+    std::size_t history = 4096; // quote datagrams kept for retransmit
+  };
+
+  struct Stats {
+    std::atomic<std::uint64_t> datagrams{0};
+    std::atomic<std::uint64_t> records{0};
+    std::atomic<std::uint64_t> sendmmsg_calls{0};
+    std::atomic<std::uint64_t> retransmitted{0};
+    std::atomic<std::uint64_t> unavailable{0};
+    std::atomic<std::uint64_t> skipped{0}; // not bookTicker / symbol overflow
+  };
+
+  MulticastPublisher(std::unique_ptr<merge::StreamConsumer> consumer,
+                     Config cfg)
+      : consumer_(std::move(consumer)), cfg_(std::move(cfg)),
+        history_(cfg_.history), history_len_(cfg_.history, 0) {}
+
+  ~MulticastPublisher() {
+    Join();
+    detail::CloseFd(data_fd_);
+    detail::CloseFd(rtx_fd_);
+  }
+
+  MulticastPublisher(const MulticastPublisher &) = delete;
+  MulticastPublisher &operator=(const MulticastPublisher &) = delete;
+
+  std::expected<void, std::error_code> Open() {
+    auto group = detail::ParseIpv4(cfg_.endpoint.group);
+    auto iface = detail::ParseIpv4(cfg_.endpoint.iface);
+    if (!group || !iface) {
+      return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+    auto data = detail::UdpSocket(0, *iface);
+    if (!data) {
+      return std::unexpected(data.error());
+    }
+    data_fd_ = *data;
+    unsigned char ttl = static_cast<unsigned char>(cfg_.ttl);
+    unsigned char loop = cfg_.loopback ? 1 : 0;
+    if (::setsockopt(data_fd_, IPPROTO_IP, IP_MULTICAST_IF, &*iface,
+                     sizeof(in_addr)) != 0 ||
+        ::setsockopt(data_fd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl,
+                     sizeof(ttl)) != 0 ||
+        ::setsockopt(data_fd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop,
+                     sizeof(loop)) != 0) {
+      return std::unexpected(detail::LastError());
+    }
+    dest_ = detail::MakeAddr(*group, cfg_.endpoint.port);
+    in_addr any{};
+    any.s_addr = htonl(INADDR_ANY);
+    auto rtx = detail::UdpSocket(cfg_.endpoint.retransmit_port, any);
+    if (!rtx) {
+      return std::unexpected(rtx.error());
+    }
+    rtx_fd_ = *rtx;
+    return {};
+  }
+
+  void Start(std::optional<int> pinCpu = std::nullopt) {
+    worker_ = std::jthread([this, pinCpu](std::stop_token st) {
+#ifdef __linux__
+      if (pinCpu.has_value()) {
+        CpuAffinity::PinThisThreadToCpu("mcast_publisher", *pinCpu);
+      }
+#endif
+      Run(st);
+    });
+  }
+
+  // Stops after draining what the consumer has already received
+  void Join() {
+    if (worker_.joinable()) {
+      worker_.request_stop();
+      worker_.join();
+    }
+  }
+
+  const Stats &GetStats() const { return stats_; }
+
+private:
+  static constexpr std::size_t kBatch = 32;
+  using Datagram = std::array<std::byte, kMaxDatagram>;
+
+  void Run(std::stop_token st) {
+    auto lastSymbols = std::chrono::steady_clock::now();
+    for (;;) {
+      const std::size_t n = consumer_->Poll(
+          [this](const merge::MessageView &m) { Encode(m); }, 256);
+      SealCurrent();
+      Flush();
+      ServeRetransmits();
+      const auto now = std::chrono::steady_clock::now();
+      if (now - lastSymbols > std::chrono::seconds(1)) {
+        SendSymbols();
+        lastSymbols = now;
+      }
+      if (n == 0) {
+        if (st.stop_requested() && consumer_->Lag() == 0) {
+          break;
+        }
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  void Encode(const merge::MessageView &m) {
+    auto bt = codec::ParseBookTicker(m.payload);
+    if (BRANCH_UNLIKELY(!bt.has_value())) {
+      stats_.skipped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    const std::uint16_t before = symbols_.Size();
+    auto id = symbols_.Intern(bt->symbol);
+    if (BRANCH_UNLIKELY(!id.has_value())) {
+      stats_.skipped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    symbols_dirty_ |= symbols_.Size() != before;
+    if (cur_count_ == 0) {
+      OpenCurrent();
+    }
+    const codec::QuoteRecord r = codec::MakeQuoteRecord(
+        *bt, *id, static_cast<std::uint8_t>(m.src), m.recv_ns);
+    std::memcpy(CurrentRecords() + cur_count_ * sizeof(r), &r, sizeof(r));
+    ++cur_count_;
+    stats_.records.fetch_add(1, std::memory_order_relaxed);
+    if (cur_count_ == kRecordsPerDatagram) {
+      SealCurrent();
+      if (pending_ == kBatch) {
+        Flush();
+      }
+    }
+  }
+
+  // Quote datagrams are built directly in their history slot
+  Datagram &Slot(std::uint64_t seq) { return history_[seq % history_.size()]; }
+
+  void OpenCurrent() { cur_seq_ = next_seq_++; }
+
+  std::byte *CurrentRecords() {
+    return Slot(cur_seq_).data() + sizeof(DatagramHeader);
+  }
+
+  void SealCurrent() {
+    if (cur_count_ == 0) {
+      return;
+    }
+    Datagram &d = Slot(cur_seq_);
+    const DatagramHeader h{kMagic, kVersion, kQuotes,
+                           static_cast<std::uint16_t>(cur_count_), 0,
+                           cur_seq_};
+    std::memcpy(d.data(), &h, sizeof(h));
+    const std::size_t len =
+        sizeof(h) + cur_count_ * sizeof(codec::QuoteRecord);
+    history_len_[cur_seq_ % history_.size()] = len;
+    iov_[pending_] = {d.data(), len};
+    ++pending_;
+    cur_count_ = 0;
+  }
+
+  void Flush() {
+    if (pending_ == 0) {
+      return;
+    }
+    // Receivers must know new symbol ids before the quotes that use them
+    if (symbols_dirty_) {
+      SendSymbols();
+      symbols_dirty_ = false;
+    }
+    std::array<mmsghdr, kBatch> msgs{};
+    for (std::size_t i = 0; i < pending_; ++i) {
+      msgs[i].msg_hdr.msg_name = &dest_;
+      msgs[i].msg_hdr.msg_namelen = sizeof(dest_);
+      msgs[i].msg_hdr.msg_iov = &iov_[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    std::size_t sent = 0;
+    while (sent < pending_) {
+      int rc = ::sendmmsg(data_fd_, msgs.data() + sent,
+                          static_cast<unsigned>(pending_ - sent), 0);
+      stats_.sendmmsg_calls.fetch_add(1, std::memory_order_relaxed);
+      if (rc < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+          continue;
+        }
+        break; // datagrams stay in history; receivers can recover them
+      }
+      sent += static_cast<std::size_t>(rc);
+    }
+    stats_.datagrams.fetch_add(pending_, std::memory_order_relaxed);
+    pending_ = 0;
+  }
+
+  void SendSymbols() {
+    const std::uint16_t n = symbols_.Size();
+    for (std::uint16_t first = 0; first < n;
+         first += static_cast<std::uint16_t>(kSymbolsPerDatagram)) {
+      Datagram d;
+      const std::uint16_t cnt = static_cast<std::uint16_t>(
+          std::min<std::size_t>(kSymbolsPerDatagram, n - first));
+      const DatagramHeader h{kMagic, kVersion, kSymbols, cnt, 0, 0};
+      std::memcpy(d.data(), &h, sizeof(h));
+      for (std::uint16_t i = 0; i < cnt; ++i) {
+        SymbolDef def{};
+        const auto name = symbols_.Get(static_cast<std::uint16_t>(first + i));
+        def.id = static_cast<std::uint16_t>(first + i);
+        def.len = static_cast<std::uint8_t>(name.size());
+        std::memcpy(def.name, name.data(), name.size());
+        std::memcpy(d.data() + sizeof(h) + i * sizeof(def), &def, sizeof(def));
+      }
+      (void)::sendto(data_fd_, d.data(), sizeof(h) + cnt * sizeof(SymbolDef),
+                     0, reinterpret_cast<sockaddr *>(&dest_), sizeof(dest_));
+    }
+  }
+
+  void ServeRetransmits() {
+    for (;;) {
+      DatagramHeader req{};
+      sockaddr_in from{};
+      socklen_t fromLen = sizeof(from);
+      ssize_t n = ::recvfrom(rtx_fd_, &req, sizeof(req), 0,
+                             reinterpret_cast<sockaddr *>(&from), &fromLen);
+      if (n < static_cast<ssize_t>(sizeof(req))) {
+        return;
+      }
+      if (req.magic != kMagic || req.type != kRetransmitRequest) {
+        continue;
+      }
+      const std::uint64_t oldest =
+          next_seq_ > history_.size() ? next_seq_ - history_.size() : 1;
+      const std::uint16_t cnt = std::min(req.count, kMaxRetransmit);
+      for (std::uint64_t s = req.seq; s < req.seq + cnt; ++s) {
+        if (s < oldest || s >= next_seq_ || s == CurrentOpenSeq()) {
+          const DatagramHeader na{kMagic, kVersion, kUnavailable, 1, 0, s};
+          (void)::sendto(rtx_fd_, &na, sizeof(na), 0,
+                         reinterpret_cast<sockaddr *>(&from), fromLen);
+          stats_.unavailable.fetch_add(1, std::memory_order_relaxed);
+          continue;
+        }
+        (void)::sendto(rtx_fd_, Slot(s).data(),
+                       history_len_[s % history_.size()], 0,
+                       reinterpret_cast<sockaddr *>(&from), fromLen);
+        stats_.retransmitted.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::uint64_t CurrentOpenSeq() const {
+    return cur_count_ != 0 ? cur_seq_ : 0;
+  }
+
+  std::unique_ptr<merge::StreamConsumer> consumer_;
+  Config cfg_;
+  int data_fd_ = -1;
+  int rtx_fd_ = -1;
+  sockaddr_in dest_{};
+  std::vector<Datagram> history_;
+  std::vector<std::size_t> history_len_;
+  std::array<iovec, kBatch> iov_{};
+  std::size_t pending_ = 0;
+  std::uint64_t next_seq_ = 1;
+  std::uint64_t cur_seq_ = 0;
+  std::size_t cur_count_ = 0;
+  codec::SymbolTable symbols_;
+  bool symbols_dirty_ = false;
+  Stats stats_;
+  std::jthread worker_;
+};
+
+// MulticastReceiver — joins the group, delivers records in arrival order and
+// requests retransmission of missing quote datagrams over the unicast side
+// channel. Owned and polled by one thread.
+class MulticastReceiver {
+public:
+  struct Config {
+    Endpoint endpoint;
+    std::string publisher = "127.0.0.1"; // retransmit server address
+    // Fault injection: discard every Nth quote datagram on arrival, as if
+    // the network had lost it (0 = off); exercises gap recovery locally
+    unsigned drop_every = 0;
+  };
+
+  struct Stats {
+    std::uint64_t datagrams = 0;
+    std::uint64_t records = 0;
+    std::uint64_t gaps = 0;          // quote datagrams detected missing
+    std::uint64_t recovered = 0;     // missing datagrams retransmitted
+    std::uint64_t unrecoverable = 0; // publisher no longer had them
+  };
+
+  explicit MulticastReceiver(Config cfg) : cfg_(std::move(cfg)) {}
+
+  ~MulticastReceiver() {
+    detail::CloseFd(data_fd_);
+    detail::CloseFd(rtx_fd_);
+  }
+
+  MulticastReceiver(const MulticastReceiver &) = delete;
+  MulticastReceiver &operator=(const MulticastReceiver &) = delete;
+
+  std::expected<void, std::error_code> Open() {
+    auto group = detail::ParseIpv4(cfg_.endpoint.group);
+    auto iface = detail::ParseIpv4(cfg_.endpoint.iface);
+    auto pub = detail::ParseIpv4(cfg_.publisher);
+    if (!group || !iface || !pub) {
+      return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+    auto data = detail::UdpSocket(cfg_.endpoint.port, *group);
+    if (!data) {
+      return std::unexpected(data.error());
+    }
+    data_fd_ = *data;
+    ip_mreq mreq{};
+    mreq.imr_multiaddr = *group;
+    mreq.imr_interface = *iface;
+    if (::setsockopt(data_fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq,
+                     sizeof(mreq)) != 0) {
+      return std::unexpected(detail::LastError());
+    }
+    in_addr any{};
+    any.s_addr = htonl(INADDR_ANY);
+    auto rtx = detail::UdpSocket(0, any);
+    if (!rtx) {
+      return std::unexpected(rtx.error());
+    }
+    rtx_fd_ = *rtx;
+    publisher_ = detail::MakeAddr(*pub, cfg_.endpoint.retransmit_port);
+    return {};
+  }
+
+  // Delivers received records to
+  //   fn(const codec::QuoteRecord&, std::string_view symbol,
+  //      std::uint64_t seq, bool retransmitted)
+  // Returns the number of datagrams processed.
+  template <typename Fn> std::size_t Poll(Fn &&fn) {
+    std::size_t n = PollSocket(data_fd_, false, fn);
+    n += PollSocket(rtx_fd_, true, fn);
+    return n;
+  }
+
+  const Stats &GetStats() const { return stats_; }
+  std::string_view Symbol(std::uint16_t id) const { return symbols_.Get(id); }
+
+private:
+  static constexpr std::size_t kBatch = 16;
+  using Datagram = std::array<std::byte, kMaxDatagram>;
+
+  template <typename Fn>
+  std::size_t PollSocket(int fd, bool sideChannel, Fn &fn) {
+    std::array<mmsghdr, kBatch> msgs{};
+    std::array<iovec, kBatch> iov{};
+    for (std::size_t i = 0; i < kBatch; ++i) {
+      iov[i] = {bufs_[i].data(), bufs_[i].size()};
+      msgs[i].msg_hdr.msg_iov = &iov[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int rc = ::recvmmsg(fd, msgs.data(), kBatch, MSG_DONTWAIT, nullptr);
+    if (rc <= 0) {
+      return 0;
+    }
+    for (int i = 0; i < rc; ++i) {
+      Handle(bufs_[i].data(), msgs[i].msg_len, sideChannel, fn);
+    }
+    return static_cast<std::size_t>(rc);
+  }
+
+  template <typename Fn>
+  void Handle(const std::byte *p, std::size_t len, bool sideChannel, Fn &fn) {
+    DatagramHeader h{};
+    if (len < sizeof(h)) {
+      return;
+    }
+    std::memcpy(&h, p, sizeof(h));
+    if (h.magic != kMagic || h.version != kVersion) {
+      return;
+    }
+    ++stats_.datagrams;
+    if (h.type == kSymbols) {
+      for (std::uint16_t i = 0; i < h.count; ++i) {
+        SymbolDef def{};
+        if (sizeof(h) + (i + 1u) * sizeof(def) > len) {
+          break;
+        }
+        std::memcpy(&def, p + sizeof(h) + i * sizeof(def), sizeof(def));
+        symbols_.Define(def.id, std::string_view{def.name, def.len});
+      }
+      return;
+    }
+    if (h.type == kUnavailable) {
+      stats_.unrecoverable += h.count;
+      return;
+    }
+    if (h.type != kQuotes ||
+        sizeof(h) + h.count * sizeof(codec::QuoteRecord) > len) {
+      return;
+    }
+    if (!sideChannel) {
+      if (BRANCH_UNLIKELY(cfg_.drop_every != 0) &&
+          ++arrived_ % cfg_.drop_every == 0) {
+        return;
+      }
+      if (expected_ != 0 && h.seq > expected_) {
+        RequestRetransmit(expected_, h.seq - expected_);
+      } else if (expected_ != 0 && h.seq < expected_) {
+        return; // duplicate
+      }
+      expected_ = h.seq + 1;
+    } else {
+      ++stats_.recovered;
+    }
+    for (std::uint16_t i = 0; i < h.count; ++i) {
+      codec::QuoteRecord r;
+      std::memcpy(&r, p + sizeof(h) + i * sizeof(r), sizeof(r));
+      ++stats_.records;
+      fn(r, symbols_.Get(r.symbol_id), h.seq, sideChannel);
+    }
+  }
+
+  void RequestRetransmit(std::uint64_t from, std::uint64_t count) {
+    stats_.gaps += count;
+    while (count > 0) {
+      const std::uint16_t c =
+          static_cast<std::uint16_t>(std::min<std::uint64_t>(count, kMaxRetransmit));
+      const DatagramHeader req{kMagic, kVersion, kRetransmitRequest, c, 0, from};
+      (void)::sendto(rtx_fd_, &req, sizeof(req), 0,
+                     reinterpret_cast<sockaddr *>(&publisher_),
+                     sizeof(publisher_));
+      from += c;
+      count -= c;
+    }
+  }
+
+  Config cfg_;
+  int data_fd_ = -1;
+  int rtx_fd_ = -1;
+  sockaddr_in publisher_{};
+  std::uint64_t expected_ = 0;
+  std::uint64_t arrived_ = 0; // quote datagrams on the group (drop_every)
+  std::array<Datagram, kBatch> bufs_{};
+  codec::SymbolTable symbols_;
+  Stats stats_;
+};
+
+} // namespace mcast
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <openssl/ssl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// namespace warm — connection state kept on disk across restarts so a
+// restarted process skips the slow parts of connection setup:
+// - resolved addresses of the stream host (`<dir>/<host>_<port>.addr`), used
+//   instead of DNS while younger than kEndpointTtl and dropped as soon as a
+//   connect to them fails
+// - the latest TLS session ticket (`<dir>/<host>_<port>.tls`, DER), offered
+//   on the next handshake so the server can resume instead of running a
+//   full key exchange and certificate verification
+// Files are replaced atomically (write to a temporary, rename), so a crash
+// never leaves a half-written one behind, and are readable by the owner only.
+namespace warm {
+
+namespace net = boost::asio;
+namespace ssl = net::ssl;
+using tcp = net::ip::tcp;
+
+// ConnectCache
+// Threading model:
+// - Shared by every session of one host; all members lock a mutex, so
+//   async sessions (reactor thread) and sync sessions (own threads) can use
+//   one instance
+// - The TLS ticket arrives through OpenSSL's new-session callback on
+//   whichever thread reads the connection, once or twice per handshake; it
+//   is written to disk there (a few small syscalls, off the per-message path)
+class ConnectCache {
+public:
+  static constexpr std::chrono::minutes kEndpointTtl{10};
+
+  // Loads what an earlier run stored in `dir` (created if missing)
+  ConnectCache(const std::string &dir, const std::string &host,
+               const std::string &port) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    const std::string base = dir + "/" + host + "_" + port;
+    addr_path_ = base + ".addr";
+    tls_path_ = base + ".tls";
+    LoadEndpoints();
+    LoadSession();
+  }
+
+  ~ConnectCache() {
+    if (session_ != nullptr) {
+      SSL_SESSION_free(session_);
+    }
+  }
+
+  ConnectCache(const ConnectCache &) = delete;
+  ConnectCache &operator=(const ConnectCache &) = delete;
+
+  // Addresses to connect to without resolving; empty when none are cached
+  // or they are older than kEndpointTtl
+  std::vector<tcp::endpoint> Endpoints() {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (Now() - resolved_at_ > kEndpointTtl) {
+      endpoints_.clear();
+    }
+    return endpoints_;
+  }
+
+  // Remembers a fresh resolution (memory and disk)
+  void StoreEndpoints(const tcp::resolver::results_type &results) {
+    std::string text;
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      endpoints_.clear();
+      for (const auto &r : results) {
+        endpoints_.push_back(r.endpoint());
+      }
+      resolved_at_ = Now();
+      text = std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
+                                resolved_at_.time_since_epoch())
+                                .count()) +
+             "\n";
+      for (const auto &e : endpoints_) {
+        text += e.address().to_string() + " " + std::to_string(e.port()) +
+                "\n";
+      }
+    }
+    Replace(addr_path_, text.data(), text.size());
+  }
+
+  // The cached addresses did not connect: resolve next time
+  void ForgetEndpoints() {
+    std::lock_guard<std::mutex> lock(mu_);
+    endpoints_.clear();
+  }
+
+  // Routes new client sessions of `ctx` into this cache. OpenSSL's internal
+  // client cache is bypassed: it is per context and never consulted for
+  // clients anyway.
+  void Attach(ssl::context &ctx) {
+    SSL_CTX *c = ctx.native_handle();
+    SSL_CTX_set_ex_data(c, ExIndex(), this);
+    SSL_CTX_set_session_cache_mode(
+        c, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(c, &ConnectCache::OnNewSession);
+  }
+
+  // Offers the stored ticket on `ssl` before its handshake; false when there
+  // is none or it has expired. SSL_session_reused() tells afterwards whether
+  // the server accepted it.
+  bool Apply(SSL *ssl) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (session_ == nullptr) {
+      return false;
+    }
+    const std::int64_t expires =
+        static_cast<std::int64_t>(SSL_SESSION_get_time(session_)) +
+        static_cast<std::int64_t>(SSL_SESSION_get_timeout(session_));
+    if (expires <= static_cast<std::int64_t>(std::time(nullptr)) ||
+        !SSL_SESSION_is_resumable(session_)) {
+      return false;
+    }
+    // A copy: OpenSSL marks the session of a connection that ends without a
+    // clean shutdown as not resumable, which must not reach the cached one
+    SSL_SESSION *copy = SSL_SESSION_dup(session_);
+    if (copy == nullptr) {
+      return false;
+    }
+    const bool ok = SSL_set_session(ssl, copy) == 1;
+    SSL_SESSION_free(copy);
+    return ok;
+  }
+
+private:
+  using SysClock = std::chrono::system_clock;
+
+  static SysClock::time_point Now() { return SysClock::now(); }
+
+  static int ExIndex() {
+    static const int idx =
+        SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return idx;
+  }
+
+  // Keeps a copy of every new ticket; the connection's own session object
+  // stays with OpenSSL (return 0), see Apply()
+  static int OnNewSession(SSL *ssl, SSL_SESSION *sess) {
+    auto *self = static_cast<ConnectCache *>(
+        SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), ExIndex()));
+    if (self != nullptr) {
+      self->StoreSession(sess);
+    }
+    return 0;
+  }
+
+  void StoreSession(const SSL_SESSION *sess) {
+    const int len = i2d_SSL_SESSION(sess, nullptr);
+    if (len <= 0) {
+      return;
+    }
+    std::vector<unsigned char> der(static_cast<std::size_t>(len));
+    unsigned char *p = der.data();
+    SSL_SESSION *copy = SSL_SESSION_dup(sess);
+    if (copy == nullptr || i2d_SSL_SESSION(sess, &p) != len) {
+      SSL_SESSION_free(copy);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      if (session_ != nullptr) {
+        SSL_SESSION_free(session_);
+      }
+      session_ = copy;
+    }
+    Replace(tls_path_, der.data(), der.size());
+  }
+
+  void LoadEndpoints() {
+    std::ifstream in(addr_path_);
+    long long secs = 0;
+    if (!(in >> secs)) {
+      return;
+    }
+    resolved_at_ = SysClock::time_point(std::chrono::seconds(secs));
+    std::string addr;
+    unsigned port = 0;
+    while (in >> addr >> port) {
+      boost::system::error_code ec;
+      const auto a = net::ip::make_address(addr, ec);
+      if (!ec) {
+        endpoints_.emplace_back(a, static_cast<std::uint16_t>(port));
+      }
+    }
+  }
+
+  void LoadSession() {
+    std::ifstream in(tls_path_, std::ios::binary);
+    const std::vector<unsigned char> der{std::istreambuf_iterator<char>(in),
+                                         std::istreambuf_iterator<char>()};
+    const unsigned char *p = der.data();
+    if (!der.empty()) {
+      session_ = d2i_SSL_SESSION(nullptr, &p, static_cast<long>(der.size()));
+    }
+  }
+
+  // Owner-only (0600): the TLS session holds the master secret. fchmod
+  // also covers a temporary left behind, with wider modes, by an older run.
+  static void Replace(const std::string &path, const void *data,
+                      std::size_t len) {
+    const std::string tmp = path + ".tmp";
+    const int fd =
+        ::open(tmp.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd == -1) {
+      return;
+    }
+    bool ok = ::fchmod(fd, 0600) == 0;
+    const char *p = static_cast<const char *>(data);
+    for (std::size_t done = 0; ok && done < len;) {
+      const ssize_t n = ::write(fd, p + done, len - done);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      ok = n > 0;
+      done += ok ? static_cast<std::size_t>(n) : 0;
+    }
+    if (::close(fd) == 0 && ok) {
+      std::rename(tmp.c_str(), path.c_str());
+    } else {
+      ::unlink(tmp.c_str());
+    }
+  }
+
+  std::string addr_path_;
+  std::string tls_path_;
+  std::mutex mu_;
+  std::vector<tcp::endpoint> endpoints_;
+  SysClock::time_point resolved_at_{};
+  SSL_SESSION *session_ = nullptr;
+};
+
+} // namespace warm
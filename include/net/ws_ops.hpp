@@ -38,8 +38,10 @@ AsyncResolve(tcp::resolver &resolver, const std::string &host,
   return r;
 }
 
-inline Status AsyncConnect(tcp::socket &sock,
-                           const tcp::resolver::results_type &endpoints,
+// `endpoints` is a resolver result or any sequence of tcp::endpoint (e.g.
+// the addresses of a warm::ConnectCache)
+template <typename Endpoints>
+inline Status AsyncConnect(tcp::socket &sock, const Endpoints &endpoints,
                            net::yield_context yield) {
   beast::error_code ec;
   auto it = net::async_connect(sock, endpoints, yield[ec]);
@@ -74,8 +76,8 @@ Resolve(tcp::resolver &resolver, const std::string &host,
   return r;
 }
 
-inline Status Connect(tcp::socket &sock,
-                      const tcp::resolver::results_type &endpoints) {
+template <typename Endpoints>
+inline Status Connect(tcp::socket &sock, const Endpoints &endpoints) {
   beast::error_code ec;
   net::connect(sock, endpoints, ec);
   return MakeStatus(ec);
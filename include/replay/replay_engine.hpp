@@ -0,0 +1,281 @@
+#pragma once
+
+#include "analytics/market_analytics.hpp"
+#include "capture/capture_reader.hpp"
+#include "codec/binary_record.hpp"
+#include "merge/stream_consumer.hpp"
+#include "sink/sink_worker.hpp"
+#include "util/branch.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#ifdef __linux__
+#include "util/cpu_affinity.hpp"
+#endif
+
+// namespace replay — feeds a recorded capture through the interfaces a live
+// StreamMerger feeds (sinks, analytics, in-process consumers), so strategy
+// code and stages run on real data without the network.
+namespace replay {
+
+struct ReplayConfig {
+  // 1 = original timing, 10 = ten times faster, 0 = as fast as possible
+  double speed = 0.0;
+  std::uint64_t from_u = 0; // first update id replayed
+  std::uint64_t to_u = std::numeric_limits<std::uint64_t>::max();
+  // Input is madvise(WILLNEED)d this far ahead of the replay cursor
+  std::size_t prefetch_bytes = 64u << 20;
+};
+
+// ReplayEngine
+// Threading model:
+// - One replay thread (Start/Join, or Run on the caller's thread) walks the
+//   reader's index in stream order and emits every record: the handler is
+//   called in place with the zero-copy RecordView; sinks, analytics and
+//   consumers get the same calls StreamMerger::Emit makes
+// - Sinks keep their own threads and overflow policies; consumers poll the
+//   broadcast ring from their own threads
+// - Pacing (speed > 0) follows the capture clock: receive time for binary
+//   captures that carry it, otherwise the exchange event time E; the replay
+//   thread sleeps until shortly before each due time and then spins
+// - The input stays memory-mapped: the next window of the file is requested
+//   with MADV_WILLNEED as the cursor advances and upcoming records are
+//   prefetched into cache a few records ahead
+class ReplayEngine {
+public:
+  using Handler = std::function<void(const capture::RecordView &)>;
+
+  struct Stats {
+    std::atomic<std::uint64_t> messages{0};
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::uint64_t> elapsed_ns{0};
+    std::atomic<std::uint64_t> max_late_ns{0}; // paced: worst lag behind plan
+  };
+
+  // `reader` must have its index built and outlive the engine
+  explicit ReplayEngine(const capture::CaptureReader &reader,
+                        ReplayConfig cfg = {})
+      : reader_(reader), cfg_(cfg) {}
+
+  ~ReplayEngine() { Join(); }
+
+  // Same attachment API as StreamMerger; must be called before Start/Run
+  sink::SinkWorker &AddSink(std::unique_ptr<sink::ISink> s,
+                            sink::SinkConfig cfg = {}) {
+    sinks_.push_back(std::make_unique<sink::SinkWorker>(std::move(s), cfg));
+    return *sinks_.back();
+  }
+  const std::vector<std::unique_ptr<sink::SinkWorker>> &Sinks() const {
+    return sinks_;
+  }
+  void SetAnalytics(std::shared_ptr<analytics::MarketAnalytics> a) {
+    analytics_ = std::move(a);
+  }
+  std::unique_ptr<merge::StreamConsumer>
+  Subscribe(std::string name, merge::BroadcastConfig cfg = {}) {
+    std::lock_guard<std::mutex> lock(hub_mu_);
+    if (!hub_owner_) {
+      hub_owner_ = std::make_shared<merge::ConsumerHub>(cfg);
+      hub_.store(hub_owner_.get(), std::memory_order_release);
+    }
+    return std::make_unique<merge::StreamConsumer>(hub_owner_,
+                                                   std::move(name));
+  }
+
+  // Strategy hook: called on the replay thread for every record, first
+  void SetHandler(Handler h) { handler_ = std::move(h); }
+
+  // Replays on a dedicated thread (optionally pinned)
+  void Start(std::optional<int> pinCpu = std::nullopt) {
+    for (auto &s : sinks_) {
+      s->Start();
+    }
+    worker_ = std::jthread([this, pinCpu] {
+#ifdef __linux__
+      if (pinCpu.has_value()) {
+        CpuAffinity::PinThisThreadToCpu("replay", *pinCpu);
+      }
+#endif
+      Replay();
+    });
+  }
+
+  // Replays on the calling thread; returns when the range is done or Stop()
+  void Run() {
+    for (auto &s : sinks_) {
+      s->Start();
+    }
+    Replay();
+    StopSinks();
+  }
+
+  // Waits for the replay thread, then lets every sink drain and stops it
+  void Join() {
+    if (worker_.joinable()) {
+      worker_.join();
+    }
+    StopSinks();
+  }
+
+  // Ends the replay early (any thread)
+  void Stop() { stop_.store(true, std::memory_order_relaxed); }
+  bool Done() const { return done_.load(std::memory_order_acquire); }
+  const Stats &GetStats() const { return stats_; }
+
+private:
+  using Clock = std::chrono::steady_clock;
+  static constexpr std::size_t kPrefetchAhead = 8; // records
+  static constexpr std::uint64_t kServiceEvery = 64;
+  // Sleep only when the next due time is further out than this; the rest is
+  // spun, so pacing is accurate to well below a scheduler quantum
+  static constexpr std::chrono::microseconds kSpinWindow{200};
+
+  static std::int64_t ClockNs(const capture::RecordView &v) {
+    if (v.binary && v.Quote()->recv_ns != 0) {
+      return v.Quote()->recv_ns;
+    }
+    return v.event_ms * 1'000'000;
+  }
+
+  void Replay() {
+    const auto &index = reader_.Index();
+    const std::string_view data = reader_.Data();
+    const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    std::size_t advised = 0; // input bytes already requested
+    const bool paced = cfg_.speed > 0.0;
+
+    std::size_t i = reader_.LowerBoundU(cfg_.from_u);
+    const auto t0 = Clock::now();
+    std::int64_t clock0 = 0;
+    std::uint64_t n = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t maxLate = 0;
+    for (; i < index.size(); ++i) {
+      if (BRANCH_UNLIKELY(stop_.load(std::memory_order_relaxed))) {
+        break;
+      }
+      const capture::RecordRef &ref = index[i];
+      if (BRANCH_UNLIKELY(ref.u > cfg_.to_u)) {
+        break;
+      }
+      if (BRANCH_UNLIKELY(ref.offset >= advised) && data.size() != 0) {
+        const std::size_t from = ref.offset & ~(page - 1);
+        const std::size_t len =
+            std::min(cfg_.prefetch_bytes, data.size() - from);
+        (void)::madvise(const_cast<char *>(data.data()) + from, len,
+                        MADV_WILLNEED);
+        // Re-arm halfway through the window (never, once it reaches the end)
+        advised = from + len == data.size() ? data.size() : from + len / 2;
+      }
+      if (i + kPrefetchAhead < index.size()) {
+        __builtin_prefetch(data.data() + index[i + kPrefetchAhead].offset);
+      }
+      const capture::RecordView v = reader_.At(i);
+      if (paced) {
+        if (BRANCH_UNLIKELY(n == 0)) {
+          clock0 = ClockNs(v);
+        }
+        const auto due =
+            t0 + std::chrono::nanoseconds(static_cast<std::int64_t>(
+                     static_cast<double>(ClockNs(v) - clock0) / cfg_.speed));
+        auto now = Clock::now();
+        if (due - now > kSpinWindow) {
+          std::this_thread::sleep_until(due - kSpinWindow / 2);
+        }
+        while ((now = Clock::now()) < due) {
+        }
+        const auto late = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - due)
+                .count());
+        maxLate = std::max(maxLate, late);
+      }
+      Emit(v);
+      ++n;
+      bytes += v.bytes.size();
+      if (BRANCH_UNLIKELY((n & (kServiceEvery - 1)) == 0)) {
+        for (auto &s : sinks_) {
+          s->Service();
+        }
+        stats_.messages.store(n, std::memory_order_relaxed);
+      }
+    }
+    for (auto &s : sinks_) {
+      s->Service();
+    }
+    stats_.messages.store(n, std::memory_order_relaxed);
+    stats_.bytes.store(bytes, std::memory_order_relaxed);
+    stats_.max_late_ns.store(maxLate, std::memory_order_relaxed);
+    stats_.elapsed_ns.store(
+        static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                                 t0)
+                .count()),
+        std::memory_order_relaxed);
+    done_.store(true, std::memory_order_release);
+  }
+
+  // The fan-out of StreamMerger::Emit. Binary records are rendered back to
+  // NDJSON only when a payload consumer is attached.
+  void Emit(const capture::RecordView &v) {
+    if (handler_) {
+      handler_(v);
+    }
+    if (analytics_) {
+      if (auto bt = v.Decode()) {
+        analytics_->Apply(*bt);
+      }
+    }
+    auto *hub = hub_.load(std::memory_order_acquire);
+    if (sinks_.empty() && hub == nullptr) {
+      return;
+    }
+    std::string_view payload = v.bytes;
+    std::uint32_t src = 0;
+    std::int64_t recvNs = 0;
+    if (v.binary) {
+      const codec::QuoteRecord &q = *v.Quote();
+      payload = {json_, codec::FormatBookTickerJson(q, v.symbol, json_)};
+      src = q.src;
+      recvNs = q.recv_ns;
+    }
+    for (auto &s : sinks_) {
+      s->Push(v.u, src, recvNs, payload);
+    }
+    if (hub != nullptr) {
+      hub->Publish(v.u, src, recvNs, payload.data(), payload.size());
+    }
+  }
+
+  void StopSinks() {
+    for (auto &s : sinks_) {
+      s->Stop();
+    }
+  }
+
+  const capture::CaptureReader &reader_;
+  ReplayConfig cfg_;
+  Handler handler_;
+  std::vector<std::unique_ptr<sink::SinkWorker>> sinks_;
+  std::shared_ptr<analytics::MarketAnalytics> analytics_;
+  std::mutex hub_mu_;
+  std::shared_ptr<merge::ConsumerHub> hub_owner_;
+  std::atomic<merge::ConsumerHub *> hub_{nullptr};
+  std::jthread worker_;
+  std::atomic<bool> stop_{false};
+  std::atomic<bool> done_{false};
+  Stats stats_;
+  char json_[codec::kMaxJsonLen];
+};
+
+} // namespace replay
@@ -1,12 +1,17 @@
 #pragma once
 
+#include "capture/wire_capture.hpp"
 #include "core/isession.hpp"
 #include "core/message.hpp"
 #include "logging/latency_event.hpp"
+#include "logging/latency_histogram.hpp"
 #include "net/backoff.hpp"
+#include "net/warm_start.hpp"
 #include "net/ws_ops.hpp"
+#include "sessions/on_message.hpp"
 #include "util/branch.hpp"
 #include "util/latency.hpp"
+#include "util/startup_timeline.hpp"
 #include <boost/asio.hpp>
 #include <boost/asio/spawn.hpp>
 #include <boost/asio/ssl.hpp>
@@ -14,6 +19,7 @@
 #include <boost/beast/ssl.hpp>
 #include <boost/beast/websocket.hpp>
 #include <boost/beast/websocket/ssl.hpp>
+#include <chrono>
 #include <iostream>
 #include <openssl/err.h>
 #include <string>
@@ -30,7 +36,7 @@ using tcp = net::ip::tcp;
 //   thread (reactor thread), i.e., no dedicated OS thread per session.
 // - All socket operations are non-blocking and cooperatively yield via `yield`.
 // - One session produces into its SPSC queue; the StreamMerger consumes on its
-//   own thread.
+//   own thread. It is also the single writer of its LatencyHistogram.
 // - Error handling on hot paths uses std::expected (C++23) instead of
 // exceptions
 class AsyncSession : public ISession {
@@ -38,10 +44,15 @@ public:
   AsyncSession(int index, net::io_context &ioc, ssl::context &ssl_ctx,
                std::string host, std::string port, std::string target,
                std::shared_ptr<RawOrderQueue> queue,
-               std::shared_ptr<logging::LatencyQueue> latency_queue)
+               std::shared_ptr<logging::LatencyHistogram> latency,
+               std::shared_ptr<logging::LatencyQueue> latency_queue,
+               std::shared_ptr<capture::WireTap> wire = nullptr,
+               std::shared_ptr<warm::ConnectCache> warm = nullptr)
       : index_(index), ioc_(ioc), ssl_ctx_(ssl_ctx), host_(std::move(host)),
         port_(std::move(port)), target_(std::move(target)),
-        ring_(std::move(queue)), latency_queue_(std::move(latency_queue)) {}
+        ring_(std::move(queue)), latency_(std::move(latency)),
+        latency_queue_(std::move(latency_queue)), wire_(std::move(wire)),
+        warm_(std::move(warm)) {}
 
   void Start() override {
     net::spawn(ioc_, [this](net::yield_context yield) { this->Run(yield); });
@@ -56,6 +67,9 @@ private:
         continue;
       }
       backoff.Reset();
+      if (!ring_->Ready() && !WaitReady(yield)) {
+        return;
+      }
       beast::error_code ec = ReadLoop(yield, ws);
       std::cerr << "[async_session " << index_
                 << "] reconnecting after error: " << ec.message() << "\n";
@@ -65,24 +79,43 @@ private:
 
   // FastConnectSequence: minimal-latency connection setup sequence
   // Resolve → TCP connect → SNI → TCP_NODELAY → TLS handshake → Configure WS →
-  // WS handshake
+  // WS handshake. With a warm cache the resolve is skipped while cached
+  // addresses connect, and the TLS handshake offers the stored ticket.
   bool
   FastConnectSequence(net::yield_context yield,
                       websocket::stream<beast::ssl_stream<tcp::socket>> &ws,
                       retry::Backoff &backoff) {
-    tcp::resolver resolver(ioc_);
-    // Resolve
-    auto resultsExp = wsops::AsyncResolve(resolver, host_, port_, yield);
-    if (!resultsExp) {
-      OnError("resolve", resultsExp.error(), yield, backoff);
-      return false;
+    const auto t0 = std::chrono::steady_clock::now();
+    // TCP connect to the cached addresses, if any
+    bool cachedDns = false;
+    if (warm_) {
+      const auto cached = warm_->Endpoints();
+      cachedDns = !cached.empty() &&
+                  wsops::AsyncConnect(beast::get_lowest_layer(ws), cached,
+                                      yield)
+                      .has_value();
+      if (!cached.empty() && !cachedDns) {
+        warm_->ForgetEndpoints();
+      }
     }
-    // TCP connect
-    auto st_connect =
-        wsops::AsyncConnect(beast::get_lowest_layer(ws), *resultsExp, yield);
-    if (BRANCH_UNLIKELY(!st_connect)) {
-      OnError("connect", st_connect.error(), yield, backoff);
-      return false;
+    if (!cachedDns) {
+      tcp::resolver resolver(ioc_);
+      // Resolve
+      auto resultsExp = wsops::AsyncResolve(resolver, host_, port_, yield);
+      if (!resultsExp) {
+        OnError("resolve", resultsExp.error(), yield, backoff);
+        return false;
+      }
+      if (warm_) {
+        warm_->StoreEndpoints(*resultsExp);
+      }
+      // TCP connect
+      auto st_connect =
+          wsops::AsyncConnect(beast::get_lowest_layer(ws), *resultsExp, yield);
+      if (BRANCH_UNLIKELY(!st_connect)) {
+        OnError("connect", st_connect.error(), yield, backoff);
+        return false;
+      }
     }
     // SNI
     if (auto st = wsops::SetSni(ws.next_layer(), host_); BRANCH_UNLIKELY(!st)) {
@@ -93,7 +126,10 @@ private:
     // TCP_NODELAY
     wsops::SetTcpNoDelay(beast::get_lowest_layer(ws));
 
-    // TLS handshake
+    // TLS handshake (resumed when the server accepts the cached ticket)
+    if (warm_) {
+      warm_->Apply(ws.next_layer().native_handle());
+    }
     auto st_tls = wsops::AsyncTlsHandshake(ws.next_layer(), yield);
     if (BRANCH_UNLIKELY(!st_tls)) {
       OnError("handshake", st_tls.error(), yield, backoff);
@@ -102,13 +138,26 @@ private:
 
     // Configure WS: disable permessage-deflate, set UA decorator
     wsops::ConfigureWebSocket(ws, std::string("webhook-parsing/async/0.1"));
+    // A message must fit one slab slot
+    ws.read_message_max(ring_->MaxMessage());
     // WS handshake
     auto st_ws = wsops::AsyncWsHandshake(ws, host_, target_, yield);
     if (BRANCH_UNLIKELY(!st_ws)) {
       OnError("ws handshake", st_ws.error(), yield, backoff);
       return false;
     }
-
+    if (warm_) {
+      std::cerr << "[async_session " << index_ << "] connected in "
+                << std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - t0)
+                       .count()
+                << " ms (dns=" << (cachedDns ? "cached" : "resolved") << " tls="
+                << (SSL_session_reused(ws.next_layer().native_handle())
+                        ? "resumed"
+                        : "full")
+                << ")\n";
+    }
+    StartupTimeline::Mark("conn " + std::to_string(index_) + " connected");
     return true;
   }
 
@@ -129,22 +178,68 @@ private:
            websocket::stream<beast::ssl_stream<tcp::socket>> &ws) {
     beast::error_code ec;
     for (;;) {
-      RawOrderUpdate slot;
-      (void)ring_->acquire(slot);
-      slot.clear();
-      std::size_t nread = ws.async_read(slot, yield[ec]);
+      // The slot stays with the session until a message is published in it,
+      // so a failed read does not lose it from the pool
+      if (!pooled_) {
+        pooled_ = ring_->acquire(slot_);
+        if (BRANCH_UNLIKELY(!pooled_)) {
+          if (ring_->Overflow() == QueueOverflow::block) {
+            pooled_ = WaitForSlot(yield);
+          }
+          if (!pooled_) {
+            // Every slot is in flight: keep the connection drained through
+            // the spare slot; Overflowed() applies the policy after the read
+            slot_ = ring_->Spare();
+          }
+        }
+      }
+      RawOrderUpdate &slot = slot_;
+      slot.buf.clear();
+      std::size_t nread = ws.async_read(slot.buf, yield[ec]);
       if (BRANCH_UNLIKELY(ec)) {
         break;
       }
-      const auto now_ms = lat::EpochMillisUtc();
-      const auto event_ms = lat::ExtractEventTimestampMs(std::string_view{
-          static_cast<const char *>(slot.data().data()), nread});
-      latency_queue_->push({now_ms, event_ms});
-      (void)ring_->publish(std::move(slot));
+      OnMessage(*ring_, slot, nread, pooled_, *latency_,
+                latency_queue_.get(), wire_.get());
     }
     return ec;
   }
 
+  // QueueOverflow::block: polls for a free slot on a short timer, so the
+  // other sessions on the reactor keep running meanwhile. False if the wait
+  // was cancelled.
+  bool WaitForSlot(net::yield_context yield) {
+    const auto t0 = std::chrono::steady_clock::now();
+    net::steady_timer timer(ioc_);
+    beast::error_code ec;
+    bool ok = true;
+    while (!ring_->acquire(slot_)) {
+      timer.expires_after(kSlotPoll);
+      timer.async_wait(yield[ec]);
+      if (ec) {
+        ok = false;
+        break;
+      }
+    }
+    ring_->AddBlocked(std::chrono::steady_clock::now() - t0);
+    return ok;
+  }
+
+  // Startup: the queue's slots are still being prefaulted on a helper
+  // thread (connects run meanwhile); false if the wait was cancelled
+  bool WaitReady(net::yield_context yield) {
+    net::steady_timer timer(ioc_);
+    beast::error_code ec;
+    while (!ring_->Ready()) {
+      timer.expires_after(kSlotPoll);
+      timer.async_wait(yield[ec]);
+      if (ec) {
+        return false;
+      }
+    }
+    return true;
+  }
+
   void OnError(const char *stage, const beast::error_code &ec,
                net::yield_context yield, retry::Backoff &backoff) {
     std::cerr << "[async_session " << index_ << "] " << stage
@@ -152,6 +247,8 @@ private:
     retry::WaitAsync(ioc_, yield, backoff.Next());
   }
 
+  static constexpr std::chrono::microseconds kSlotPoll{50};
+
   int index_;
   net::io_context &ioc_;
   ssl::context &ssl_ctx_;
@@ -159,5 +256,14 @@ private:
   std::string port_;
   std::string target_;
   std::shared_ptr<RawOrderQueue> ring_;
+  // Slot being read into; pooled_ = taken from ring_ (not the spare)
+  RawOrderUpdate slot_;
+  bool pooled_ = false;
+  std::shared_ptr<logging::LatencyHistogram> latency_;
+  // Per-message latency lines for the logger (nullptr = --no-latency-log)
   std::shared_ptr<logging::LatencyQueue> latency_queue_;
+  // Optional raw capture of every message read (nullptr = off)
+  std::shared_ptr<capture::WireTap> wire_;
+  // Optional addresses/TLS ticket of earlier runs (nullptr = cold connects)
+  std::shared_ptr<warm::ConnectCache> warm_;
 };
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "capture/wire_capture.hpp"
+#include "core/message.hpp"
+#include "logging/latency_event.hpp"
+#include "logging/latency_histogram.hpp"
+#include "util/branch.hpp"
+#include "util/latency.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+// OnMessage — the per-message body shared by SyncSession, AsyncSession and
+// bench/alloc_bench: stamps the `len` bytes just read into `slot`, records
+// the latency, queues it for the logger, copies the frame to the wire tap and
+// hands the slot to the ring (or to Overflowed() when it is the spare slot).
+// Threading model:
+// - Called by the single producer of `ring`, which also owns `hist`, `queue`
+//   and `wire`; never allocates. `queue` and `wire` may be null
+inline void OnMessage(RawOrderQueue &ring, RawOrderUpdate &slot,
+                      std::size_t len, bool &pooled,
+                      logging::LatencyHistogram &hist,
+                      logging::LatencyQueue *queue, capture::WireTap *wire) {
+  slot.recv_ns = lat::EpochNanosUtc();
+  const char *data = static_cast<const char *>(slot.buf.data().data());
+  const std::int64_t event_ms =
+      lat::ExtractEventTimestampMs(std::string_view{data, len});
+  slot.event_ms = event_ms;
+  hist.Record(slot.recv_ns, event_ms);
+  if (queue != nullptr &&
+      BRANCH_UNLIKELY(!queue->push({slot.recv_ns / 1'000'000, event_ms}))) {
+    ring.LatencyDropped();
+  }
+  if (wire != nullptr) {
+    wire->Record(slot.recv_ns, data, len);
+  }
+  if (BRANCH_LIKELY(pooled)) {
+    (void)ring.publish(std::move(slot));
+    pooled = false;
+  } else {
+    ring.Overflowed(slot);
+  }
+}
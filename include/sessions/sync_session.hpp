@@ -1,21 +1,30 @@
 #pragma once
 
+#include "capture/wire_capture.hpp"
 #include "core/isession.hpp"
 #include "core/message.hpp"
 #include "logging/latency_event.hpp"
+#include "logging/latency_histogram.hpp"
 #include "net/backoff.hpp"
+#include "net/warm_start.hpp"
 #include "net/ws_ops.hpp"
+#include "sessions/on_message.hpp"
 #include "util/branch.hpp"
+#include "util/cpu_affinity.hpp"
 #include "util/latency.hpp"
+#include "util/realtime.hpp"
+#include "util/startup_timeline.hpp"
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/ssl.hpp>
 #include <boost/beast/websocket.hpp>
 #include <boost/beast/websocket/ssl.hpp>
+#include <chrono>
 #include <expected>
 #include <iostream>
 #include <openssl/err.h>
+#include <optional>
 #include <string>
 #include <thread>
 
@@ -30,20 +39,40 @@ using tcp = net::ip::tcp;
 // - Each Session owns a dedicated std::jthread and performs blocking I/O
 // - One Session is the single producer of its SPSC queue; StreamMerger consumes
 //   on its dedicated thread
+// - Also the single writer of its connection's LatencyHistogram
 // - Suitable for comparison with async reactor-based implementation
+// - The thread pins itself to the CPU set by SetCpu (runner placement) and,
+//   with --realtime, runs SCHED_FIFO like the reactor it replaces
 // - Error handling on hot paths uses std::expected (C++23) instead of
 //   exceptions
 class SyncSession : public ISession {
 public:
   SyncSession(int index, std::string host, std::string port, std::string target,
               std::shared_ptr<RawOrderQueue> queue,
-              std::shared_ptr<logging::LatencyQueue> latency_queue)
+              std::shared_ptr<logging::LatencyHistogram> latency,
+              std::shared_ptr<logging::LatencyQueue> latency_queue,
+              std::shared_ptr<capture::WireTap> wire = nullptr,
+              std::shared_ptr<warm::ConnectCache> warm = nullptr)
       : index_(index), host_(std::move(host)), port_(std::move(port)),
         target_(std::move(target)), ring_(std::move(queue)),
-        latency_queue_(std::move(latency_queue)) {}
+        latency_(std::move(latency)),
+        latency_queue_(std::move(latency_queue)), wire_(std::move(wire)),
+        warm_(std::move(warm)) {}
+
+  // CPU for the session thread; call before Start (nullopt = unpinned)
+  void SetCpu(std::optional<int> cpu) { cpu_ = cpu; }
 
   void Start() override {
-    jthread_ = std::jthread([this](std::stop_token st) { this->Run(st); });
+    jthread_ = std::jthread([this](std::stop_token st) {
+      const std::string name = "session " + std::to_string(index_);
+#ifdef __linux__
+      if (cpu_.has_value()) {
+        CpuAffinity::PinThisThreadToCpu(name.c_str(), *cpu_);
+      }
+#endif
+      rt::Realtime::EnterThread(name.c_str(), rt::Role::reactor);
+      this->Run(st);
+    });
   }
 
   ~SyncSession() {
@@ -66,6 +95,9 @@ private:
       ssl::context ssl_ctx(ssl::context::tls_client);
       ssl_ctx.set_default_verify_paths();
       ssl_ctx.set_verify_mode(ssl::verify_peer);
+      if (warm_) {
+        warm_->Attach(ssl_ctx);
+      }
 
       websocket::stream<beast::ssl_stream<beast::tcp_stream>> ws(ioc, ssl_ctx);
       if (st.stop_requested()) {
@@ -76,6 +108,9 @@ private:
       }
 
       backoff.Reset();
+      if (!ring_->Ready() && !WaitReady(st)) {
+        break;
+      }
       beast::error_code ec = ReadLoop(st, ws);
       if (ec && ec != beast::error::timeout &&
           ec != net::error::operation_aborted) {
@@ -86,24 +121,43 @@ private:
     }
   }
 
+  // Same sequence as AsyncSession::FastConnectSequence, including the warm
+  // cache shortcuts
   bool FastConnectSequence(
       websocket::stream<beast::ssl_stream<beast::tcp_stream>> &ws,
       retry::Backoff &backoff) {
-    tcp::resolver resolver(ws.get_executor());
-
-    auto st_resolve = wsops::Resolve(resolver, host_, port_);
-    if (BRANCH_UNLIKELY(!st_resolve)) {
-      OnError("resolve", st_resolve.error());
-      retry::WaitSync(backoff.Next());
-      return false;
+    const auto t0 = std::chrono::steady_clock::now();
+    bool cachedDns = false;
+    if (warm_) {
+      const auto cached = warm_->Endpoints();
+      cachedDns =
+          !cached.empty() &&
+          wsops::Connect(beast::get_lowest_layer(ws).socket(), cached)
+              .has_value();
+      if (!cached.empty() && !cachedDns) {
+        warm_->ForgetEndpoints();
+      }
     }
+    if (!cachedDns) {
+      tcp::resolver resolver(ws.get_executor());
 
-    auto st_connect =
-        wsops::Connect(beast::get_lowest_layer(ws).socket(), *st_resolve);
-    if (BRANCH_UNLIKELY(!st_connect)) {
-      OnError("connect", st_connect.error());
-      retry::WaitSync(backoff.Next());
-      return false;
+      auto st_resolve = wsops::Resolve(resolver, host_, port_);
+      if (BRANCH_UNLIKELY(!st_resolve)) {
+        OnError("resolve", st_resolve.error());
+        retry::WaitSync(backoff.Next());
+        return false;
+      }
+      if (warm_) {
+        warm_->StoreEndpoints(*st_resolve);
+      }
+
+      auto st_connect =
+          wsops::Connect(beast::get_lowest_layer(ws).socket(), *st_resolve);
+      if (BRANCH_UNLIKELY(!st_connect)) {
+        OnError("connect", st_connect.error());
+        retry::WaitSync(backoff.Next());
+        return false;
+      }
     }
 
     if (auto st = wsops::SetSni(ws.next_layer(), host_); BRANCH_UNLIKELY(!st)) {
@@ -114,6 +168,9 @@ private:
 
     wsops::SetTcpNoDelay(beast::get_lowest_layer(ws));
 
+    if (warm_) {
+      warm_->Apply(ws.next_layer().native_handle());
+    }
     auto st_tls = wsops::TlsHandshake(ws.next_layer());
     if (BRANCH_UNLIKELY(!st_tls)) {
       OnError("handshake", st_tls.error());
@@ -122,6 +179,8 @@ private:
     }
 
     wsops::ConfigureWebSocket(ws, std::string("webhook-parsing/0.1"));
+    // A message must fit one slab slot
+    ws.read_message_max(ring_->MaxMessage());
 
     auto st_ws = wsops::WsHandshake(ws, host_, target_);
     if (BRANCH_UNLIKELY(!st_ws)) {
@@ -129,7 +188,18 @@ private:
       retry::WaitSync(backoff.Next());
       return false;
     }
-
+    if (warm_) {
+      std::cerr << "[session " << index_ << "] connected in "
+                << std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - t0)
+                       .count()
+                << " ms (dns=" << (cachedDns ? "cached" : "resolved") << " tls="
+                << (SSL_session_reused(ws.next_layer().native_handle())
+                        ? "resumed"
+                        : "full")
+                << ")\n";
+    }
+    StartupTimeline::Mark("conn " + std::to_string(index_) + " connected");
     return true;
   }
 
@@ -140,13 +210,27 @@ private:
       if (st.stop_requested()) {
         return {};
       }
-      RawOrderUpdate slot;
       beast::error_code ec;
       // Короткий дедлайн для регулярной проверки stop_token
       beast::get_lowest_layer(ws).expires_after(std::chrono::milliseconds(200));
-      (void)ring_->acquire(slot);
-      slot.clear();
-      ws.read(slot, ec);
+      // The slot stays with the session until a message is published in it,
+      // so a timeout or a failed read does not lose it from the pool
+      if (!pooled_) {
+        pooled_ = ring_->acquire(slot_);
+        if (BRANCH_UNLIKELY(!pooled_)) {
+          if (ring_->Overflow() == QueueOverflow::block) {
+            pooled_ = WaitForSlot(st);
+          }
+          if (!pooled_) {
+            // Every slot is in flight: read into the spare slot;
+            // Overflowed() applies the policy after the read
+            slot_ = ring_->Spare();
+          }
+        }
+      }
+      RawOrderUpdate &slot = slot_;
+      slot.buf.clear();
+      ws.read(slot.buf, ec);
       if (BRANCH_UNLIKELY(ec)) {
         if (BRANCH_UNLIKELY(ec == beast::error::timeout)) {
           if (st.stop_requested()) {
@@ -156,17 +240,39 @@ private:
         }
         return ec;
       }
-      const auto now_ms = lat::EpochMillisUtc();
-      auto b = slot.data();
-      const char *data = static_cast<const char *>(b.data());
-      std::size_t len = b.size();
-      const std::int64_t event_ms =
-          lat::ExtractEventTimestampMs(std::string_view{data, len});
-      latency_queue_->push({now_ms, event_ms});
-      (void)ring_->publish(std::move(slot));
+      OnMessage(*ring_, slot, slot.buf.size(), pooled_, *latency_,
+                latency_queue_.get(), wire_.get());
     }
   }
 
+  // QueueOverflow::block: waits for a free slot; false if stop was
+  // requested meanwhile
+  bool WaitForSlot(std::stop_token st) {
+    const auto t0 = std::chrono::steady_clock::now();
+    bool ok = true;
+    while (!ring_->acquire(slot_)) {
+      if (st.stop_requested()) {
+        ok = false;
+        break;
+      }
+      std::this_thread::yield();
+    }
+    ring_->AddBlocked(std::chrono::steady_clock::now() - t0);
+    return ok;
+  }
+
+  // Startup: the queue's slots are still being prefaulted on a helper
+  // thread (the connect ran meanwhile); false if stop was requested
+  bool WaitReady(std::stop_token st) {
+    while (!ring_->Ready()) {
+      if (st.stop_requested()) {
+        return false;
+      }
+      std::this_thread::yield();
+    }
+    return true;
+  }
+
   void OnError(const char *stage, const beast::error_code &ec) {
     std::cerr << "[session " << index_ << "] " << stage
               << " error: " << ec.message() << "\n";
@@ -177,6 +283,16 @@ private:
   std::string port_;
   std::string target_;
   std::shared_ptr<RawOrderQueue> ring_;
+  // Slot being read into; pooled_ = taken from ring_ (not the spare)
+  RawOrderUpdate slot_;
+  bool pooled_ = false;
+  std::optional<int> cpu_;
   std::jthread jthread_;
+  std::shared_ptr<logging::LatencyHistogram> latency_;
+  // Per-message latency lines for the logger (nullptr = --no-latency-log)
   std::shared_ptr<logging::LatencyQueue> latency_queue_;
+  // Optional raw capture of every message read (nullptr = off)
+  std::shared_ptr<capture::WireTap> wire_;
+  // Optional addresses/TLS ticket of earlier runs (nullptr = cold connects)
+  std::shared_ptr<warm::ConnectCache> warm_;
 };
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "capture/capture_format.hpp"
+#include "capture/resume.hpp"
+#include "io/open_writer.hpp"
+#include "io/writer.hpp"
+#include "sink/sink.hpp"
+#include "util/latency.hpp"
+#include <cstddef>
+#include <expected>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace sink {
+
+// BinaryCaptureSink — the merged stream as a capture::FileHeader followed by
+// fixed 72-byte records (see include/capture/capture_format.hpp). Payloads
+// are decoded once here, on the sink thread; records are accumulated in a
+// 1 MiB buffer and written when it fills or the queue runs empty. With a
+// capture::ResumePoint the existing capture is appended to, reusing its
+// header and symbol ids.
+class BinaryCaptureSink : public ISink {
+public:
+  static constexpr std::size_t kBufferBytes = 1 << 20;
+
+  static std::expected<std::unique_ptr<BinaryCaptureSink>, std::error_code>
+  Open(const std::string &path, io::WriterKind kind = io::WriterKind::write,
+       std::optional<compress::Codec> codec = std::nullopt,
+       io::SyncService *sync = nullptr,
+       const capture::ResumePoint *resume = nullptr) {
+    auto w = io::OpenWriter(path, kind, /*append=*/resume != nullptr, codec,
+                            sync);
+    if (!w) {
+      return std::unexpected(w.error());
+    }
+    if (resume == nullptr || resume->bytes == 0) {
+      const capture::FileHeader h = capture::MakeHeader(lat::EpochNanosUtc());
+      (*w)->Write(&h, sizeof(h));
+      (*w)->Flush();
+    }
+    std::unique_ptr<BinaryCaptureSink> s(new BinaryCaptureSink(std::move(*w)));
+    if (resume != nullptr) {
+      for (const auto &d : resume->symbols) {
+        s->encoder_.Preload(d);
+      }
+    }
+    return s;
+  }
+
+  ~BinaryCaptureSink() override { Flush(); }
+
+  const char *Name() const override { return "binary"; }
+
+  void Write(const Message *msgs, std::size_t n) override {
+    for (std::size_t i = 0; i < n; ++i) {
+      if (used_ + capture::RecordEncoder::kMaxBytesPerMessage > buf_.size()) {
+        Flush();
+      }
+      used_ += encoder_.Encode(msgs[i].payload,
+                               static_cast<std::uint8_t>(msgs[i].src),
+                               msgs[i].recv_ns, buf_.data() + used_);
+    }
+  }
+
+  void Flush() override {
+    if (used_ != 0) {
+      writer_->Write(buf_.data(), used_);
+      used_ = 0;
+    }
+    writer_->Flush();
+  }
+
+  std::uint64_t BytesWritten() const override {
+    return writer_->Size() + used_;
+  }
+  std::uint64_t BytesDropped() const override { return writer_->Dropped(); }
+
+  // Messages that were not bookTickers and therefore not captured
+  std::uint64_t Skipped() const { return encoder_.Skipped(); }
+
+private:
+  explicit BinaryCaptureSink(std::unique_ptr<io::IWriter> w)
+      : writer_(std::move(w)), buf_(kBufferBytes) {}
+
+  std::unique_ptr<io::IWriter> writer_;
+  capture::RecordEncoder encoder_;
+  std::vector<std::byte> buf_;
+  std::size_t used_ = 0;
+};
+
+} // namespace sink
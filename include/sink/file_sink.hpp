@@ -0,0 +1,137 @@
+#pragma once
+
+#include "capture/resume.hpp"
+#include "io/open_writer.hpp"
+#include "io/writer.hpp"
+#include "sink/sink.hpp"
+#include <cerrno>
+#include <expected>
+#include <fcntl.h>
+#include <memory>
+#include <optional>
+#include <spawn.h>
+#include <string>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <system_error>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace sink {
+
+// Writes [payload, "\n"] pairs for a batch with as few writev(2) calls as
+// possible (IOV_MAX-safe chunks of 64 messages).
+inline void WriteNdjson(io::IWriter &w, const Message *msgs, std::size_t n) {
+  static const char newline = '\n';
+  struct iovec iov[128];
+  int cnt = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    iov[cnt++] = {(void *)msgs[i].payload.data(), msgs[i].payload.size()};
+    iov[cnt++] = {(void *)&newline, 1};
+    if (cnt == 128) {
+      w.Writev(iov, cnt);
+      cnt = 0;
+    }
+  }
+  if (cnt > 0) {
+    w.Writev(iov, cnt);
+  }
+}
+
+// FileSink — the merged NDJSON stream to a regular file (truncated on open,
+// appended to when resuming) through the selected io::WriterKind
+class FileSink : public ISink {
+public:
+  static std::expected<std::unique_ptr<FileSink>, std::error_code>
+  Open(const std::string &path, io::WriterKind kind = io::WriterKind::write,
+       std::optional<compress::Codec> codec = std::nullopt,
+       io::SyncService *sync = nullptr,
+       const capture::ResumePoint *resume = nullptr) {
+    auto w = io::OpenWriter(path, kind, /*append=*/resume != nullptr, codec,
+                            sync);
+    if (!w) {
+      return std::unexpected(w.error());
+    }
+    return std::unique_ptr<FileSink>(new FileSink(std::move(*w)));
+  }
+
+  const char *Name() const override { return "file"; }
+  void Write(const Message *msgs, std::size_t n) override {
+    WriteNdjson(*writer_, msgs, n);
+  }
+  void Flush() override { writer_->Flush(); }
+  std::uint64_t BytesWritten() const override { return writer_->Size(); }
+  std::uint64_t BytesDropped() const override { return writer_->Dropped(); }
+
+private:
+  explicit FileSink(std::unique_ptr<io::IWriter> w) : writer_(std::move(w)) {}
+
+  std::unique_ptr<io::IWriter> writer_;
+};
+
+// CompressedFileSink — NDJSON piped through an external stream compressor
+// (`zstd`, `gzip`, `lz4`, ... invoked as `<program> -c -q`) whose stdout is
+// the output file. Compression runs in its own process, off every thread of
+// ours; the sink thread only writes into the pipe. main() and the replay
+// tools ignore SIGPIPE, so a dying compressor surfaces as EPIPE on write.
+class CompressedFileSink : public ISink {
+public:
+  static std::expected<std::unique_ptr<CompressedFileSink>, std::error_code>
+  Open(const std::string &path, const std::string &program) {
+    int out =
+        ::open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+    if (out == -1) {
+      return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
+    int pipefd[2];
+    if (::pipe2(pipefd, O_CLOEXEC) != 0) {
+      auto ec = std::error_code(errno, std::generic_category());
+      ::close(out);
+      return std::unexpected(ec);
+    }
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
+    posix_spawn_file_actions_adddup2(&fa, pipefd[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&fa, out, STDOUT_FILENO);
+    std::string prog = program;
+    std::string c = "-c";
+    std::string q = "-q";
+    char *argv[] = {prog.data(), c.data(), q.data(), nullptr};
+    pid_t pid = -1;
+    const int rc =
+        ::posix_spawnp(&pid, prog.c_str(), &fa, nullptr, argv, environ);
+    posix_spawn_file_actions_destroy(&fa);
+    ::close(pipefd[0]);
+    ::close(out);
+    if (rc != 0) {
+      ::close(pipefd[1]);
+      return std::unexpected(std::error_code(rc, std::generic_category()));
+    }
+    return std::unique_ptr<CompressedFileSink>(
+        new CompressedFileSink(pipefd[1], pid));
+  }
+
+  // Closing the pipe lets the compressor finish its frame; then reap it
+  ~CompressedFileSink() override {
+    pipe_.reset();
+    if (pid_ > 0) {
+      int status = 0;
+      (void)::waitpid(pid_, &status, 0);
+    }
+  }
+
+  const char *Name() const override { return "compressed"; }
+  void Write(const Message *msgs, std::size_t n) override {
+    WriteNdjson(*pipe_, msgs, n);
+  }
+
+private:
+  CompressedFileSink(int fd, pid_t pid)
+      : pipe_(std::make_unique<io::FdWriter>(fd)), pid_(pid) {}
+
+  std::unique_ptr<io::FdWriter> pipe_;
+  pid_t pid_ = -1;
+};
+
+} // namespace sink
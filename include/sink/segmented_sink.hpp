@@ -0,0 +1,248 @@
+#pragma once
+
+#include "capture/segment_index.hpp"
+#include "codec/book_ticker.hpp"
+#include "sink/sink.hpp"
+#include "util/branch.hpp"
+#include "util/latency.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+
+namespace sink {
+
+struct SegmentConfig {
+  std::uint64_t max_bytes = 0;       // rotate after this many bytes, 0 = off
+  std::chrono::seconds max_age{0};   // rotate after this long, 0 = off
+  std::uint32_t index_stride = 64u << 10; // bytes between index entries
+  std::uint32_t first_seq = 0; // sequence of the first segment (resume)
+};
+
+// SegmentedSink — rotates a file output into `<stem>.<seq>.<ext>` segments
+// by size and/or age, each with a `<stem>.<seq>.idx` sidecar
+// (capture/segment_index.hpp) mapping u and exchange time to offsets.
+// Threading model:
+// - Sink thread: writes, cuts segments at message boundaries and opens the
+//   next segment (one open(2) per rotation). The current segment is retired
+//   only once its successor is open; when the open fails, writing continues
+//   into the current one and the rotation is retried a second later
+// - Background std::jthread: closes retired segments (final flush,
+//   compression tail, seek table, truncation, index header) so a rotation
+//   never waits for the previous segment to finish
+class SegmentedSink : public ISink {
+public:
+  using OpenFn = std::function<
+      std::expected<std::unique_ptr<ISink>, std::error_code>(
+          const std::string &)>;
+
+  static std::expected<std::unique_ptr<SegmentedSink>, std::error_code>
+  Open(const std::string &path, SegmentConfig cfg, std::uint16_t indexFlags,
+       OpenFn open) {
+    std::unique_ptr<SegmentedSink> s(
+        new SegmentedSink(path, cfg, indexFlags, std::move(open)));
+    auto first = s->OpenSegment();
+    if (!first) {
+      return std::unexpected(first.error());
+    }
+    s->Install(std::move(*first));
+    return s;
+  }
+
+  ~SegmentedSink() override {
+    Retire();
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+  }
+
+  const char *Name() const override { return "segments"; }
+
+  void Write(const Message *msgs, std::size_t n) override {
+    std::size_t i = 0;
+    while (i < n) {
+      if (BRANCH_UNLIKELY(RotateDue())) {
+        Rotate();
+      }
+      if (seg_messages_ == 0 || since_index_ >= cfg_.index_stride) {
+        index_.Add(msgs[i].u, EventMs(msgs[i].payload), cur_->BytesWritten());
+        since_index_ = 0;
+      }
+      // Chunk up to the next index point
+      std::size_t j = i;
+      while (j < n && since_index_ < cfg_.index_stride) {
+        since_index_ += msgs[j].payload.size() + 1;
+        ++j;
+      }
+      cur_->Write(msgs + i, j - i);
+      seg_messages_ += j - i;
+      last_u_ = msgs[j - 1].u;
+      last_ms_ = EventMs(msgs[j - 1].payload);
+      i = j;
+    }
+  }
+
+  void Flush() override {
+    cur_->Flush();
+    index_.Update(last_u_, last_ms_, seg_messages_, cur_->BytesWritten());
+    index_.Flush();
+  }
+
+  std::uint64_t BytesWritten() const override {
+    return done_bytes_ + cur_->BytesWritten();
+  }
+  // Current segment plus the retired ones closed so far
+  std::uint64_t BytesDropped() const override {
+    return done_dropped_.load(std::memory_order_relaxed) +
+           (cur_ ? cur_->BytesDropped() : 0);
+  }
+  std::uint32_t Segments() const { return seq_ - cfg_.first_seq; }
+  // Rotations postponed because the next segment could not be opened
+  std::uint64_t OpenFailures() const { return open_failures_; }
+
+private:
+  struct Segment {
+    std::unique_ptr<ISink> sink;
+    capture::IndexWriter index;
+  };
+  using Retired = Segment;
+  static constexpr std::chrono::seconds kRetryOpen{1};
+
+  SegmentedSink(const std::string &path, SegmentConfig cfg,
+                std::uint16_t indexFlags, OpenFn open)
+      : cfg_(cfg), index_flags_(indexFlags), open_(std::move(open)),
+        seq_(cfg.first_seq) {
+    std::tie(stem_, ext_) = capture::SplitExt(path);
+    closer_ = std::jthread([this] { CloseLoop(); });
+  }
+
+  static std::int64_t EventMs(std::string_view payload) {
+    auto bt = codec::ParseBookTicker(payload);
+    return bt.has_value() ? bt->event_ms : 0;
+  }
+
+  bool RotateDue() const {
+    if (seg_messages_ == 0 ||
+        std::chrono::steady_clock::now() < retry_open_at_) {
+      return false;
+    }
+    if (cfg_.max_bytes != 0 && cur_->BytesWritten() >= cfg_.max_bytes) {
+      return true;
+    }
+    return cfg_.max_age.count() != 0 &&
+           std::chrono::steady_clock::now() - seg_started_ >= cfg_.max_age;
+  }
+
+  // Opens segment seq_ (data file and index) without touching the current
+  std::expected<Segment, std::error_code> OpenSegment() {
+    const std::string data = capture::SegmentPath(stem_, ext_, seq_);
+    const std::string idx = capture::SegmentPath(stem_, ".idx", seq_);
+    auto s = open_(data);
+    if (!s) {
+      return std::unexpected(s.error());
+    }
+    auto ix = capture::IndexWriter::Create(idx, index_flags_,
+                                           cfg_.index_stride,
+                                           lat::EpochNanosUtc());
+    if (!ix) {
+      return std::unexpected(ix.error());
+    }
+    return Segment{std::move(*s), std::move(*ix)};
+  }
+
+  void Install(Segment next) {
+    cur_ = std::move(next.sink);
+    index_ = std::move(next.index);
+    ++seq_;
+    seg_messages_ = 0;
+    since_index_ = 0;
+    seg_started_ = std::chrono::steady_clock::now();
+  }
+
+  // Switches to the next segment; on an open error (EMFILE, ENOSPC, ...)
+  // keeps the current one, so cur_ is never null
+  void Rotate() {
+    auto next = OpenSegment();
+    if (BRANCH_UNLIKELY(!next)) {
+      ++open_failures_;
+      retry_open_at_ = std::chrono::steady_clock::now() + kRetryOpen;
+      std::cerr << "[segments] cannot open segment " << seq_ << ": "
+                << next.error().message() << ", continuing the current one\n";
+      return;
+    }
+    Retire();
+    Install(std::move(*next));
+  }
+
+  // Hands the current segment to the closer thread
+  void Retire() {
+    if (!cur_) {
+      return;
+    }
+    const std::uint64_t bytes = cur_->BytesWritten();
+    done_bytes_ += bytes;
+    index_.Update(last_u_, last_ms_, seg_messages_, bytes);
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      retired_.push_back({std::move(cur_), std::move(index_)});
+    }
+    cv_.notify_one();
+  }
+
+  void CloseLoop() {
+    std::unique_lock<std::mutex> lock(mu_);
+    for (;;) {
+      cv_.wait(lock, [this] { return stop_ || !retired_.empty(); });
+      if (retired_.empty()) {
+        return;
+      }
+      Retired r = std::move(retired_.front());
+      retired_.pop_front();
+      lock.unlock();
+      r.sink->Flush();
+      done_dropped_.fetch_add(r.sink->BytesDropped(),
+                              std::memory_order_relaxed);
+      r.sink.reset();
+      r.index.Close();
+      lock.lock();
+    }
+  }
+
+  SegmentConfig cfg_;
+  std::uint16_t index_flags_;
+  OpenFn open_;
+  std::string stem_;
+  std::string ext_;
+  // Current segment (sink thread)
+  std::unique_ptr<ISink> cur_;
+  capture::IndexWriter index_;
+  std::uint32_t seq_ = 0;
+  std::uint64_t seg_messages_ = 0;
+  std::uint64_t since_index_ = 0;
+  std::uint64_t done_bytes_ = 0;
+  std::uint64_t last_u_ = 0;
+  std::int64_t last_ms_ = 0;
+  std::chrono::steady_clock::time_point seg_started_{};
+  std::chrono::steady_clock::time_point retry_open_at_{};
+  std::uint64_t open_failures_ = 0;
+  // Retired segments awaiting close
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<Retired> retired_;
+  std::atomic<std::uint64_t> done_dropped_{0}; // closer thread
+  bool stop_ = false;
+  std::jthread closer_;
+};
+
+} // namespace sink
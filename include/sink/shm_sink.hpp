@@ -0,0 +1,40 @@
+#pragma once
+
+#include "ipc/shm_ring.hpp"
+#include "sink/sink.hpp"
+#include <expected>
+#include <memory>
+#include <string>
+#include <system_error>
+
+namespace sink {
+
+// ShmSink — republishes into the named shared-memory broadcast ring read by
+// ipc::ShmRingReader (see include/ipc/shm_ring.hpp) from the sink thread.
+class ShmSink : public ISink {
+public:
+  static std::expected<std::unique_ptr<ShmSink>, std::error_code>
+  Open(const std::string &name, ipc::ShmRingConfig cfg = {}) {
+    auto w = ipc::ShmRingWriter::Create(name, cfg);
+    if (!w) {
+      return std::unexpected(w.error());
+    }
+    return std::unique_ptr<ShmSink>(new ShmSink(std::move(*w)));
+  }
+
+  const char *Name() const override { return "shm"; }
+
+  void Write(const Message *msgs, std::size_t n) override {
+    for (std::size_t i = 0; i < n; ++i) {
+      writer_.Publish(msgs[i].u, msgs[i].src, msgs[i].recv_ns,
+                      msgs[i].payload.data(), msgs[i].payload.size());
+    }
+  }
+
+private:
+  explicit ShmSink(ipc::ShmRingWriter w) : writer_(std::move(w)) {}
+
+  ipc::ShmRingWriter writer_;
+};
+
+} // namespace sink
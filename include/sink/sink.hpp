@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+// namespace sink — outputs of the merged stream. StreamMerger copies every
+// emitted message into one queue per sink; each sink runs on its own thread
+// with its own overflow policy, so a slow output never delays a fast one or
+// the merge itself.
+namespace sink {
+
+// One ordered, deduplicated message as seen by a sink. `payload` is only
+// valid for the duration of ISink::Write.
+struct Message {
+  std::uint64_t u;
+  std::uint32_t src;
+  std::int64_t recv_ns;
+  std::string_view payload;
+};
+
+// ISink — minimal output interface. Write() is always called from the sink's
+// worker thread, in stream order, with batches of up to SinkWorker::kBatch.
+class ISink {
+public:
+  virtual ~ISink() = default;
+  virtual const char *Name() const = 0;
+  virtual void Write(const Message *msgs, std::size_t n) = 0;
+  // Called when the queue runs empty and once more at shutdown
+  virtual void Flush() {}
+  // Logical (uncompressed) bytes accepted so far, for sinks backed by a
+  // file; offsets in capture indexes are based on it
+  virtual std::uint64_t BytesWritten() const { return 0; }
+  // Messages accepted by Write() but not delivered (e.g. a socket that was
+  // down); read after the sink thread stopped
+  virtual std::uint64_t Lost() const { return 0; }
+  // Bytes the file writer accepted but lost to an I/O error (disk full,
+  // failed mapping), see io::IWriter::Dropped; read after the sink thread
+  // stopped
+  virtual std::uint64_t BytesDropped() const { return 0; }
+};
+
+// What the producer does when a sink's queue is full:
+// - block: wait for space (lossless; the merger stalls with this sink)
+// - drop_oldest: overwrite the oldest queued message (sink sees a gap)
+// - conflate: keep only the newest pending message per symbol and publish it
+//   once space frees up (latest-value semantics for top-of-book snapshots)
+enum class OverflowPolicy { block, drop_oldest, conflate };
+
+inline std::optional<OverflowPolicy> ParsePolicy(std::string_view s) {
+  if (s == "block") {
+    return OverflowPolicy::block;
+  }
+  if (s == "drop-oldest" || s == "drop_oldest") {
+    return OverflowPolicy::drop_oldest;
+  }
+  if (s == "conflate") {
+    return OverflowPolicy::conflate;
+  }
+  return std::nullopt;
+}
+
+inline const char *PolicyName(OverflowPolicy p) {
+  switch (p) {
+  case OverflowPolicy::block:
+    return "block";
+  case OverflowPolicy::drop_oldest:
+    return "drop-oldest";
+  case OverflowPolicy::conflate:
+    return "conflate";
+  }
+  return "?";
+}
+
+struct SinkConfig {
+  OverflowPolicy policy = OverflowPolicy::block;
+  std::size_t slot_count = 16384; // power of two
+  // Bytes per slot incl. the 32-byte header; larger messages are dropped
+  // and counted (Oversize). The runner sizes it from --max-message.
+  std::size_t slot_size = 512;
+  std::optional<int> pin_cpu; // pin the sink thread when set
+};
+
+// CallbackSink — forwards batches to user code on the sink thread
+class CallbackSink : public ISink {
+public:
+  using Fn = std::function<void(const Message *, std::size_t)>;
+
+  CallbackSink(const char *name, Fn fn) : name_(name), fn_(std::move(fn)) {}
+
+  const char *Name() const override { return name_; }
+  void Write(const Message *msgs, std::size_t n) override { fn_(msgs, n); }
+
+private:
+  const char *name_;
+  Fn fn_;
+};
+
+} // namespace sink
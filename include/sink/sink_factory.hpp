@@ -0,0 +1,144 @@
+#pragma once
+
+#include "sink/binary_sink.hpp"
+#include "sink/file_sink.hpp"
+#include "sink/segmented_sink.hpp"
+#include "sink/shm_sink.hpp"
+#include "sink/sink.hpp"
+#include "sink/socket_sink.hpp"
+#include <expected>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace sink {
+
+// Command-line description of one extra output:
+//   KIND:TARGET[,POLICY]
+//   file:copy.ndjson            plain NDJSON file
+//   bin:capture.bin             binary capture (capture/capture_format.hpp)
+//   gzip:out.ndjson.gz          compressed via `gzip -c -q` (also zstd, lz4)
+//   tcp:HOST:PORT               NDJSON over TCP
+//   shm:NAME                    shared-memory broadcast ring
+// POLICY is block | drop-oldest | conflate (default: block for files,
+// drop-oldest for tcp/shm). `writer` selects the I/O path of file and bin
+// sinks (see io::WriterKind); `compress` adds in-process block compression
+// with seekable frames to them; `segment` rotates them into indexed
+// segments (see SegmentedSink); `resume` continues an earlier run's output
+// (see capture::FindResumePoint) instead of truncating it.
+struct SinkSpec {
+  std::string kind;
+  std::string target;
+  SinkConfig cfg;
+  io::WriterKind writer = io::WriterKind::write;
+  std::optional<compress::Codec> compress;
+  std::optional<SegmentConfig> segment;
+  std::shared_ptr<io::SyncService> sync; // durability of file outputs
+  std::shared_ptr<const capture::ResumePoint> resume; // file/bin only
+};
+
+inline std::optional<SinkSpec> ParseSinkSpec(std::string_view s) {
+  const std::size_t colon = s.find(':');
+  if (colon == std::string_view::npos || colon == 0) {
+    return std::nullopt;
+  }
+  SinkSpec spec;
+  spec.kind = std::string(s.substr(0, colon));
+  std::string_view rest = s.substr(colon + 1);
+  const std::size_t comma = rest.rfind(',');
+  if (comma != std::string_view::npos) {
+    auto p = ParsePolicy(rest.substr(comma + 1));
+    if (!p.has_value()) {
+      return std::nullopt;
+    }
+    spec.cfg.policy = *p;
+    rest = rest.substr(0, comma);
+  } else if (spec.kind == "tcp" || spec.kind == "shm") {
+    spec.cfg.policy = OverflowPolicy::drop_oldest;
+  }
+  if (rest.empty()) {
+    return std::nullopt;
+  }
+  spec.target = std::string(rest);
+  return spec;
+}
+
+inline std::expected<std::unique_ptr<ISink>, std::error_code>
+MakeSink(const SinkSpec &spec);
+
+namespace detail {
+
+// Wraps a file/bin spec into a SegmentedSink that opens each segment with
+// the same spec (minus segmentation)
+inline std::expected<std::unique_ptr<ISink>, std::error_code>
+MakeSegmented(const SinkSpec &spec) {
+  SinkSpec inner = spec;
+  inner.segment.reset();
+  inner.resume.reset(); // segments are never appended to
+  SegmentConfig cfg = *spec.segment;
+  if (spec.resume) {
+    cfg.first_seq = spec.resume->next_segment;
+  }
+  std::uint16_t flags = 0;
+  if (spec.kind == "bin") {
+    flags |= capture::kIndexBinary;
+  }
+  if (spec.compress.has_value()) {
+    flags |= capture::kIndexCompressed;
+  }
+  auto s = SegmentedSink::Open(spec.target, cfg, flags,
+                               [inner](const std::string &path) {
+                                 SinkSpec seg = inner;
+                                 seg.target = path;
+                                 return MakeSink(seg);
+                               });
+  if (!s) {
+    return std::unexpected(s.error());
+  }
+  return std::unique_ptr<ISink>(std::move(*s));
+}
+
+} // namespace detail
+
+inline std::expected<std::unique_ptr<ISink>, std::error_code>
+MakeSink(const SinkSpec &spec) {
+  if (spec.segment.has_value() && (spec.kind == "file" || spec.kind == "bin")) {
+    return detail::MakeSegmented(spec);
+  }
+  auto widen = [](auto r) -> std::expected<std::unique_ptr<ISink>,
+                                           std::error_code> {
+    if (!r) {
+      return std::unexpected(r.error());
+    }
+    return std::unique_ptr<ISink>(std::move(*r));
+  };
+  if (spec.kind == "file") {
+    return widen(FileSink::Open(spec.target, spec.writer, spec.compress,
+                                spec.sync.get(), spec.resume.get()));
+  }
+  if (spec.kind == "bin") {
+    return widen(BinaryCaptureSink::Open(spec.target, spec.writer,
+                                         spec.compress, spec.sync.get(),
+                                         spec.resume.get()));
+  }
+  if (spec.kind == "gzip" || spec.kind == "zstd" || spec.kind == "lz4") {
+    return widen(CompressedFileSink::Open(spec.target, spec.kind));
+  }
+  if (spec.kind == "tcp") {
+    const std::size_t colon = spec.target.rfind(':');
+    if (colon == std::string::npos) {
+      return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+    return widen(SocketSink::Open(spec.target.substr(0, colon),
+                                  spec.target.substr(colon + 1)));
+  }
+  if (spec.kind == "shm") {
+    return widen(ShmSink::Open(
+        spec.target, ipc::ShmRingConfig{.slot_size = spec.cfg.slot_size}));
+  }
+  return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+}
+
+} // namespace sink
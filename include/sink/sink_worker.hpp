@@ -0,0 +1,345 @@
+#pragma once
+
+#include "lockfree/broadcast_ring.hpp"
+#include "sink/sink.hpp"
+#include "util/branch.hpp"
+#include "util/cpu_affinity.hpp"
+#include "util/latency.hpp"
+#include "util/realtime.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sink {
+
+// SinkWorker
+// Threading model:
+// - Producer side (Push/Service) runs on the StreamMerger thread and copies
+//   each message into this sink's own broadcast-ring queue
+// - One std::jthread per sink copies batches out of the queue (validating
+//   every slot stamp) and hands them to ISink::Write
+// - Overflow handling is local to the sink (see OverflowPolicy); only a
+//   `block` sink can ever stall the producer
+class SinkWorker {
+public:
+  static constexpr std::size_t kBatch = 64;
+  static constexpr std::size_t kMaxConflateKeys = 64;
+
+  struct Stats {
+    std::atomic<std::uint64_t> enqueued{0};
+    std::atomic<std::uint64_t> written{0};
+    std::atomic<std::uint64_t> dropped{0};   // overwritten before written
+    std::atomic<std::uint64_t> conflated{0}; // superseded while pending
+    std::atomic<std::uint64_t> blocked_ns{0};
+    std::atomic<std::uint64_t> max_lag{0};      // messages queued, worst seen
+    std::atomic<std::int64_t> max_delay_ns{0};  // receive → written, worst
+    std::atomic<std::int64_t> last_delay_ns{0}; // receive → written, last
+    std::atomic<std::uint64_t> oversize{0}; // too large for a conflate slot
+  };
+
+  // Slot size that holds messages of up to `maxPayload` bytes
+  static constexpr std::size_t SlotSizeFor(std::size_t maxPayload) {
+    return (maxPayload + sizeof(lockfree::BroadcastRing::SlotHeader) + 63) &
+           ~std::size_t{63};
+  }
+
+  SinkWorker(std::unique_ptr<ISink> sink, SinkConfig cfg)
+      : sink_(std::move(sink)), cfg_(cfg),
+        mem_(static_cast<std::byte *>(::operator new(
+            lockfree::BroadcastRing::RegionSize(cfg.slot_count, cfg.slot_size),
+            std::align_val_t{64}))) {
+    const std::size_t bytes =
+        lockfree::BroadcastRing::RegionSize(cfg.slot_count, cfg.slot_size);
+    std::fill(mem_, mem_ + bytes, std::byte{0});
+    lockfree::BroadcastRing::Format(mem_, cfg.slot_count, cfg.slot_size);
+    ring_ = std::make_unique<lockfree::BroadcastRing>(mem_);
+    staging_.resize(kBatch * ring_->MaxPayload());
+    if (cfg_.policy == OverflowPolicy::conflate) {
+      pending_buf_.resize(kMaxConflateKeys * ring_->MaxPayload());
+    }
+  }
+
+  ~SinkWorker() {
+    Stop();
+    ring_.reset();
+    ::operator delete(mem_, std::align_val_t{64});
+  }
+
+  SinkWorker(const SinkWorker &) = delete;
+  SinkWorker &operator=(const SinkWorker &) = delete;
+
+  void Start() {
+    worker_ = std::jthread([this](std::stop_token st) {
+#ifdef __linux__
+      if (cfg_.pin_cpu.has_value()) {
+        CpuAffinity::PinThisThreadToCpu(sink_->Name(), *cfg_.pin_cpu);
+        rt::Realtime::EnterThread(sink_->Name(), rt::Role::sink);
+      }
+#endif
+      Run(st);
+    });
+  }
+
+  // Drains everything already queued, including the conflated messages still
+  // pending, flushes the sink and joins. Called once the producer stopped
+  // (StreamMerger::Join joins its thread first).
+  void Stop() {
+    if (worker_.joinable()) {
+      while (pending_count_ != 0) {
+        PublishPending();
+        if (pending_count_ != 0) {
+          std::this_thread::yield();
+        }
+      }
+      worker_.request_stop();
+      worker_.join();
+    }
+  }
+
+  // Producer API (StreamMerger thread)
+  void Push(std::uint64_t u, std::uint32_t src, std::int64_t recv_ns,
+            std::string_view payload) {
+    if (cfg_.policy == OverflowPolicy::conflate) {
+      PublishPending();
+      if (pending_count_ != 0 || Full()) {
+        Conflate(u, src, recv_ns, payload);
+        return;
+      }
+    } else if (cfg_.policy == OverflowPolicy::block && Full()) {
+      WaitForSpace();
+    }
+    if (BRANCH_LIKELY(
+            ring_->Publish(u, src, recv_ns, payload.data(), payload.size()))) {
+      stats_.enqueued.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // Producer housekeeping when no new messages arrive (publishes pending
+  // conflated messages as soon as the sink frees space)
+  void Service() {
+    if (pending_count_ != 0) {
+      PublishPending();
+    }
+  }
+
+  const char *Name() const { return sink_->Name(); }
+  OverflowPolicy Policy() const { return cfg_.policy; }
+  const Stats &GetStats() const { return stats_; }
+  // Messages larger than a slot, dropped on either publish path
+  std::uint64_t Oversize() const {
+    return ring_->Oversize() +
+           stats_.oversize.load(std::memory_order_relaxed);
+  }
+  std::uint64_t Lost() const { return sink_->Lost(); }
+  std::uint64_t BytesDropped() const { return sink_->BytesDropped(); }
+  std::uint64_t Lag() const {
+    return ring_->Head() - cursor_.load(std::memory_order_acquire);
+  }
+
+private:
+  struct Pending {
+    std::uint64_t u;
+    std::uint32_t src;
+    std::int64_t recv_ns;
+    std::uint32_t len;
+    std::uint8_t key_len;
+    char key[23];
+  };
+
+  bool Full() const {
+    return ring_->Head() - cursor_.load(std::memory_order_acquire) >=
+           ring_->Capacity();
+  }
+
+  void WaitForSpace() {
+    const auto t0 = std::chrono::steady_clock::now();
+    while (Full()) {
+      std::this_thread::yield();
+    }
+    stats_.blocked_ns.fetch_add(
+        static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - t0)
+                .count()),
+        std::memory_order_relaxed);
+  }
+
+  // Conflation key: the bookTicker symbol ("s"), empty if absent
+  static std::string_view KeyOf(std::string_view payload) {
+    const std::size_t pos = payload.find("\"s\":\"");
+    if (pos == std::string_view::npos) {
+      return {};
+    }
+    const std::size_t b = pos + 5;
+    const std::size_t e = payload.find('"', b);
+    if (e == std::string_view::npos) {
+      return {};
+    }
+    return payload.substr(b, std::min<std::size_t>(e - b, 23));
+  }
+
+  void Conflate(std::uint64_t u, std::uint32_t src, std::int64_t recv_ns,
+                std::string_view payload) {
+    if (BRANCH_UNLIKELY(payload.size() > ring_->MaxPayload())) {
+      stats_.oversize.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    const std::string_view key = KeyOf(payload);
+    std::size_t idx = kMaxConflateKeys;
+    for (std::size_t i = 0; i < pending_count_; ++i) {
+      if (std::string_view{pending_[i].key, pending_[i].key_len} == key) {
+        idx = i;
+        stats_.conflated.fetch_add(1, std::memory_order_relaxed);
+        break;
+      }
+    }
+    if (idx == kMaxConflateKeys) {
+      if (pending_count_ == kMaxConflateKeys) {
+        // Table full: evict the oldest pending key
+        idx = OldestPending();
+        stats_.dropped.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        idx = pending_count_++;
+      }
+    }
+    Pending &p = pending_[idx];
+    p.u = u;
+    p.src = src;
+    p.recv_ns = recv_ns;
+    p.len = static_cast<std::uint32_t>(payload.size());
+    p.key_len = static_cast<std::uint8_t>(key.size());
+    std::memcpy(p.key, key.data(), key.size());
+    std::memcpy(PendingPayload(idx), payload.data(), payload.size());
+  }
+
+  // Publishes pending messages oldest-first while the queue has room
+  void PublishPending() {
+    while (pending_count_ != 0 && !Full()) {
+      const std::size_t i = OldestPending();
+      const Pending &p = pending_[i];
+      ring_->Publish(p.u, p.src, p.recv_ns, PendingPayload(i), p.len);
+      stats_.enqueued.fetch_add(1, std::memory_order_relaxed);
+      const std::size_t last = --pending_count_;
+      if (i != last) {
+        pending_[i] = pending_[last];
+        std::memcpy(PendingPayload(i), PendingPayload(last),
+                    pending_[last].len);
+      }
+    }
+  }
+
+  std::size_t OldestPending() const {
+    std::size_t best = 0;
+    for (std::size_t i = 1; i < pending_count_; ++i) {
+      if (pending_[i].u < pending_[best].u) {
+        best = i;
+      }
+    }
+    return best;
+  }
+
+  std::byte *PendingPayload(std::size_t i) {
+    return pending_buf_.data() + i * ring_->MaxPayload();
+  }
+
+  void Run(std::stop_token st) {
+    bool flushed = true;
+    for (;;) {
+      const std::size_t n = CopyBatch();
+      if (n != 0) {
+        sink_->Write(msgs_.data(), n);
+        stats_.written.fetch_add(n, std::memory_order_relaxed);
+        const std::int64_t delay =
+            lat::EpochNanosUtc() - msgs_[n - 1].recv_ns;
+        stats_.last_delay_ns.store(delay, std::memory_order_relaxed);
+        if (delay > stats_.max_delay_ns.load(std::memory_order_relaxed)) {
+          stats_.max_delay_ns.store(delay, std::memory_order_relaxed);
+        }
+        flushed = false;
+        continue;
+      }
+      if (!flushed) {
+        sink_->Flush();
+        flushed = true;
+      }
+      if (st.stop_requested() && ring_->Head() == cursor_local_) {
+        break;
+      }
+      std::this_thread::yield();
+    }
+    sink_->Flush();
+  }
+
+  // Copies up to kBatch messages into staging_, validating slot stamps so a
+  // message overwritten mid-copy (drop_oldest) is counted, never written.
+  std::size_t CopyBatch() {
+    const std::uint64_t head = ring_->Head();
+    const std::uint64_t cap = ring_->Capacity();
+    std::uint64_t cur = cursor_local_;
+    if (head - cur > stats_.max_lag.load(std::memory_order_relaxed)) {
+      stats_.max_lag.store(head - cur, std::memory_order_relaxed);
+    }
+    std::size_t k = 0;
+    while (k < kBatch && cur < head) {
+      if (BRANCH_UNLIKELY(head - cur > cap)) {
+        stats_.dropped.fetch_add(head - cap - cur, std::memory_order_relaxed);
+        cur = head - cap;
+      }
+      const std::byte *slot = std::as_const(*ring_).SlotAt(cur);
+      const auto *sh =
+          reinterpret_cast<const lockfree::BroadcastRing::SlotHeader *>(slot);
+      const std::uint64_t st1 = sh->stamp.load(std::memory_order_acquire);
+      if (BRANCH_UNLIKELY(st1 != cur + 1)) {
+        stats_.dropped.fetch_add(1, std::memory_order_relaxed);
+        ++cur;
+        continue;
+      }
+      const std::uint32_t len = sh->len;
+      char *dst = reinterpret_cast<char *>(staging_.data() +
+                                           k * ring_->MaxPayload());
+      Message m{sh->u, sh->src, sh->recv_ns, {}};
+      std::memcpy(dst, slot + sizeof(lockfree::BroadcastRing::SlotHeader),
+                  std::min<std::size_t>(len, ring_->MaxPayload()));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (BRANCH_UNLIKELY(sh->stamp.load(std::memory_order_relaxed) != st1)) {
+        stats_.dropped.fetch_add(1, std::memory_order_relaxed);
+        ++cur;
+        continue;
+      }
+      m.payload = std::string_view{dst, len};
+      msgs_[k++] = m;
+      ++cur;
+    }
+    cursor_local_ = cur;
+    cursor_.store(cur, std::memory_order_release);
+    return k;
+  }
+
+  std::unique_ptr<ISink> sink_;
+  SinkConfig cfg_;
+  std::byte *mem_;
+  std::unique_ptr<lockfree::BroadcastRing> ring_;
+  // Consumer cursor: published for the producer (block policy, lag)
+  alignas(64) std::atomic<std::uint64_t> cursor_{0};
+  alignas(64) std::uint64_t cursor_local_ = 0;
+  std::vector<std::byte> staging_;
+  std::array<Message, kBatch> msgs_{};
+  // Producer-side conflation table (conflate policy only)
+  std::array<Pending, kMaxConflateKeys> pending_{};
+  std::size_t pending_count_ = 0;
+  std::vector<std::byte> pending_buf_;
+  Stats stats_;
+  std::jthread worker_;
+};
+
+} // namespace sink
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "sink/sink.hpp"
+#include <cerrno>
+#include <chrono>
+#include <expected>
+#include <memory>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace sink {
+
+// SocketSink — NDJSON over a TCP connection (e.g. a downstream collector).
+// Blocking sendmsg(2) on the sink thread with MSG_NOSIGNAL; on error the
+// connection is dropped and re-established at most once per second. The
+// messages of the failed send and those written while disconnected are
+// counted in Lost().
+class SocketSink : public ISink {
+public:
+  static std::expected<std::unique_ptr<SocketSink>, std::error_code>
+  Open(const std::string &host, const std::string &port) {
+    std::unique_ptr<SocketSink> s(new SocketSink(host, port));
+    if (auto st = s->Connect(); !st) {
+      return std::unexpected(st.error());
+    }
+    return s;
+  }
+
+  ~SocketSink() override { Close(); }
+
+  const char *Name() const override { return "socket"; }
+
+  void Write(const Message *msgs, std::size_t n) override {
+    if (fd_ == -1 && !Reconnect()) {
+      lost_ += n;
+      return;
+    }
+    static const char newline = '\n';
+    struct iovec iov[128];
+    std::size_t i = 0;
+    while (i < n) {
+      const std::size_t first = i;
+      int cnt = 0;
+      for (; i < n && cnt < 128; ++i) {
+        iov[cnt++] = {(void *)msgs[i].payload.data(), msgs[i].payload.size()};
+        iov[cnt++] = {(void *)&newline, 1};
+      }
+      if (!SendAll(iov, cnt)) {
+        // Part of this chunk may have gone out; count it all as lost
+        lost_ += n - first;
+        Close();
+        return;
+      }
+    }
+  }
+
+  std::uint64_t Lost() const override { return lost_; }
+
+private:
+  SocketSink(std::string host, std::string port)
+      : host_(std::move(host)), port_(std::move(port)) {}
+
+  std::expected<void, std::error_code> Connect() {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *res = nullptr;
+    const int rc = ::getaddrinfo(host_.c_str(), port_.c_str(), &hints, &res);
+    if (rc != 0) {
+      return std::unexpected(
+          std::make_error_code(std::errc::host_unreachable));
+    }
+    std::error_code ec = std::make_error_code(std::errc::connection_refused);
+    for (addrinfo *ai = res; ai != nullptr; ai = ai->ai_next) {
+      int fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC,
+                        ai->ai_protocol);
+      if (fd == -1) {
+        continue;
+      }
+      if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+        int one = 1;
+        (void)::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        fd_ = fd;
+        break;
+      }
+      ec = std::error_code(errno, std::generic_category());
+      ::close(fd);
+    }
+    ::freeaddrinfo(res);
+    if (fd_ == -1) {
+      return std::unexpected(ec);
+    }
+    return {};
+  }
+
+  bool Reconnect() {
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_attempt_ < std::chrono::seconds(1)) {
+      return false;
+    }
+    last_attempt_ = now;
+    return Connect().has_value();
+  }
+
+  bool SendAll(struct iovec *iov, int cnt) {
+    while (cnt > 0) {
+      msghdr mh{};
+      mh.msg_iov = iov;
+      mh.msg_iovlen = static_cast<std::size_t>(cnt);
+      ssize_t n = ::sendmsg(fd_, &mh, MSG_NOSIGNAL);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      while (n > 0 && cnt > 0) {
+        if (static_cast<std::size_t>(n) >= iov[0].iov_len) {
+          n -= static_cast<ssize_t>(iov[0].iov_len);
+          ++iov;
+          --cnt;
+        } else {
+          iov[0].iov_base = static_cast<char *>(iov[0].iov_base) + n;
+          iov[0].iov_len -= static_cast<std::size_t>(n);
+          n = 0;
+        }
+      }
+    }
+    return true;
+  }
+
+  void Close() {
+    if (fd_ != -1) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+
+  std::string host_;
+  std::string port_;
+  int fd_ = -1;
+  std::uint64_t lost_ = 0;
+  std::chrono::steady_clock::time_point last_attempt_{};
+};
+
+} // namespace sink
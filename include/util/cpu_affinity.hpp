@@ -20,9 +20,10 @@
 // CpuAffinity — tiny Linux helper to pin long‑running threads to specific
 // // CPUs and to auto‑pick a least‑busy allowed CPU. Used to stabilize latency
 // by reducing context switches (e.g., Reactor, StreamMerger, FileLogger).
-// API: PinThisThreadToCpu(...), PickLeastBusyAllowedCpuExcluding(...),
-// PickAndPin(...), ResetUsed(). Thread‑safe; honors sched_getaffinity; no‑ops
-// on non‑Linux.
+// API: PinThisThreadToCpu(...), BindThisThreadToCpu(...),
+// PickLeastBusyAllowedCpuExcluding(...), PickAndPin(...), Reserve(...),
+// ResetUsed(). Least‑busy picks share one /proc/stat sample per process.
+// Thread‑safe; honors sched_getaffinity; no‑ops on non‑Linux.
 class CpuAffinity {
 public:
   static bool PinThisThreadToCpu(int cpu) {
@@ -52,48 +53,44 @@ public:
 #endif
   }
 
+  // Pins without a log line (short-lived startup helpers)
+  static bool BindThisThreadToCpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+  }
+
+  // Takes the process-wide utilisation sample now (the runner starts it on a
+  // helper thread so that it overlaps the rest of the startup)
+  static void Sample() { (void)Utilisation(); }
+
   // Picks the least busy allowed CPU excluding those in 'exclude', returns
-  // nullopt on failure.
+  // nullopt on failure. Uses the process-wide sample.
   static std::optional<int>
-  PickLeastBusyAllowedCpuExcluding(const std::vector<int> &exclude,
-                                   unsigned sleep_ms = 200) {
+  PickLeastBusyAllowedCpuExcluding(const std::vector<int> &exclude) {
 #ifdef __linux__
     cpu_set_t mask;
     if (sched_getaffinity(0, sizeof(mask), &mask) != 0) {
       return std::nullopt;
     }
-    std::vector<CpuSample> a, b;
-    if (!readProcStat(a)) {
-      return std::nullopt;
-    }
-    std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
-    if (!readProcStat(b)) {
-      return std::nullopt;
-    }
-    const size_t n = std::min(a.size(), b.size());
+    const std::vector<double> &util = Utilisation();
     int best = -1;
     double bestUtil = 1e9;
-    for (size_t i = 0; i < n; ++i) {
+    for (size_t i = 0; i < util.size(); ++i) {
       if (!CPU_ISSET((int)i, &mask)) {
         continue;
       }
       if (std::find(exclude.begin(), exclude.end(), (int)i) != exclude.end()) {
         continue;
       }
-      unsigned long long totalA = a[i].user + a[i].nice + a[i].sys + a[i].idle +
-                                  a[i].iowait + a[i].irq + a[i].softirq +
-                                  a[i].steal;
-      unsigned long long totalB = b[i].user + b[i].nice + b[i].sys + b[i].idle +
-                                  b[i].iowait + b[i].irq + b[i].softirq +
-                                  b[i].steal;
-      unsigned long long totalDelta =
-          (totalB > totalA) ? (totalB - totalA) : 1ULL;
-      unsigned long long idleA = a[i].idle + a[i].iowait;
-      unsigned long long idleB = b[i].idle + b[i].iowait;
-      unsigned long long idleDelta = (idleB > idleA) ? (idleB - idleA) : 0ULL;
-      double util = 1.0 - (double)idleDelta / (double)totalDelta;
-      if (util < bestUtil) {
-        bestUtil = util;
+      if (util[i] < bestUtil) {
+        bestUtil = util[i];
         best = (int)i;
       }
     }
@@ -103,19 +100,20 @@ public:
     return std::nullopt;
 #else
     (void)exclude;
-    (void)sleep_ms;
     return std::nullopt;
 #endif
   }
 
   // Pick least busy CPU not yet used; if none, fallback to round-robin among
-  // used; then pin current thread.
+  // used; then pin current thread. Threads pinning at the same time share
+  // one sample instead of taking turns.
   static std::optional<int> PickAndPin(const char *who = nullptr) {
 #ifdef __linux__
+    Sample(); // outside m_: the first caller measures, the others wait
     int chosen = -1;
     {
       std::lock_guard<std::mutex> lock(m_);
-      auto opt = PickLeastBusyAllowedCpuExcluding(used_, 150);
+      auto opt = PickLeastBusyAllowedCpuExcluding(used_);
       if (opt.has_value()) {
         chosen = *opt;
         used_.push_back(chosen);
@@ -134,6 +132,14 @@ public:
 #endif
   }
 
+  // Keeps PickAndPin off CPUs that were placed up front (util/placement.hpp)
+  static void Reserve(int cpu) {
+    std::lock_guard<std::mutex> lock(m_);
+    if (std::find(used_.begin(), used_.end(), cpu) == used_.end()) {
+      used_.push_back(cpu);
+    }
+  }
+
   static void ResetUsed() {
     std::lock_guard<std::mutex> lock(m_);
     used_.clear();
@@ -141,6 +147,43 @@ public:
   }
 
 private:
+  static constexpr unsigned kSampleMs = 150;
+
+  // Busy fraction per CPU over kSampleMs of /proc/stat, measured once per
+  // process; empty when /proc/stat is unreadable
+  static const std::vector<double> &Utilisation() {
+    std::call_once(sample_once_, [] {
+#ifdef __linux__
+      std::vector<CpuSample> a, b;
+      if (!readProcStat(a)) {
+        return;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(kSampleMs));
+      if (!readProcStat(b)) {
+        return;
+      }
+      const size_t n = std::min(a.size(), b.size());
+      util_.resize(n);
+      for (size_t i = 0; i < n; ++i) {
+        unsigned long long totalA = a[i].user + a[i].nice + a[i].sys +
+                                    a[i].idle + a[i].iowait + a[i].irq +
+                                    a[i].softirq + a[i].steal;
+        unsigned long long totalB = b[i].user + b[i].nice + b[i].sys +
+                                    b[i].idle + b[i].iowait + b[i].irq +
+                                    b[i].softirq + b[i].steal;
+        unsigned long long totalDelta =
+            (totalB > totalA) ? (totalB - totalA) : 1ULL;
+        unsigned long long idleA = a[i].idle + a[i].iowait;
+        unsigned long long idleB = b[i].idle + b[i].iowait;
+        unsigned long long idleDelta =
+            (idleB > idleA) ? (idleB - idleA) : 0ULL;
+        util_[i] = 1.0 - (double)idleDelta / (double)totalDelta;
+      }
+#endif
+    });
+    return util_;
+  }
+
 #ifdef __linux__
   struct CpuSample {
     unsigned long long user{}, nice{}, sys{}, idle{}, iowait{}, irq{},
@@ -198,4 +241,6 @@ private:
   inline static std::mutex m_;
   inline static std::vector<int> used_;
   inline static size_t rr_idx_ = 0;
+  inline static std::once_flag sample_once_;
+  inline static std::vector<double> util_;
 };
@@ -0,0 +1,325 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+// namespace topo — CPU and NIC topology as sysfs/procfs describe it, read
+// once at startup for placement decisions (util/placement.hpp):
+// - per CPU: physical core (package + core_id), SMT siblings, L3 domain
+//   (first CPU of the cache's shared_cpu_list) and NUMA node
+// - per NIC: the CPUs its receive interrupts are routed to and the node the
+//   device hangs off
+// Only CPUs in this process' affinity mask are listed. Missing files leave
+// fields at -1; off Linux everything is empty.
+namespace topo {
+
+struct Cpu {
+  int id = -1;
+  int package = -1;
+  int core = -1; // core_id, unique only within a package
+  int l3 = -1;   // lowest CPU sharing the last-level cache
+  int node = -1;
+  std::vector<int> siblings; // SMT threads of the same core, incl. this one
+};
+
+// "0-2,5" → {0, 1, 2, 5}
+inline std::vector<int> ParseCpuList(const std::string &text) {
+  std::vector<int> cpus;
+  std::stringstream ss(text);
+  std::string part;
+  while (std::getline(ss, part, ',')) {
+    int a = 0;
+    int b = 0;
+    const int n = std::sscanf(part.c_str(), "%d-%d", &a, &b);
+    if (n == 1) {
+      cpus.push_back(a);
+    } else if (n == 2) {
+      for (int c = a; c <= b; ++c) {
+        cpus.push_back(c);
+      }
+    }
+  }
+  return cpus;
+}
+
+// {0, 1, 2, 5} → "0-2,5"
+inline std::string FormatCpuList(std::vector<int> cpus) {
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  std::string out;
+  for (std::size_t i = 0; i < cpus.size();) {
+    std::size_t j = i;
+    while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+      ++j;
+    }
+    out += (out.empty() ? "" : ",") + std::to_string(cpus[i]);
+    if (j != i) {
+      out += "-" + std::to_string(cpus[j]);
+    }
+    i = j + 1;
+  }
+  return out;
+}
+
+inline std::string ReadLine(const std::string &path) {
+  std::ifstream in(path);
+  std::string s;
+  std::getline(in, s);
+  while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) {
+    s.pop_back();
+  }
+  return s;
+}
+
+inline int ReadInt(const std::string &path, int fallback = -1) {
+  const std::string s = ReadLine(path);
+  return s.empty() ? fallback : std::atoi(s.c_str());
+}
+
+// Topology
+// Threading model:
+// - Plain value, built by Read() on the main thread before any pipeline
+//   thread starts; read-only afterwards
+class Topology {
+public:
+  static Topology Read() {
+    Topology t;
+#ifdef __linux__
+    cpu_set_t mask;
+    if (sched_getaffinity(0, sizeof(mask), &mask) != 0) {
+      return t;
+    }
+    const std::string sys = "/sys/devices/system/cpu/";
+    std::vector<int> online = ParseCpuList(ReadLine(sys + "online"));
+    if (online.empty()) {
+      for (int c = 0; c < CPU_SETSIZE; ++c) {
+        if (CPU_ISSET(c, &mask)) {
+          online.push_back(c);
+        }
+      }
+    }
+    std::map<int, int> nodeOf;
+    for (const int n : ParseCpuList(ReadLine("/sys/devices/system/node/online"))) {
+      const std::string list = ReadLine("/sys/devices/system/node/node" +
+                                        std::to_string(n) + "/cpulist");
+      for (const int c : ParseCpuList(list)) {
+        nodeOf[c] = n;
+      }
+    }
+    for (const int c : online) {
+      if (c < 0 || c >= CPU_SETSIZE || !CPU_ISSET(c, &mask)) {
+        continue;
+      }
+      const std::string dir = sys + "cpu" + std::to_string(c) + "/";
+      Cpu cpu;
+      cpu.id = c;
+      cpu.package = ReadInt(dir + "topology/physical_package_id", 0);
+      cpu.core = ReadInt(dir + "topology/core_id", c);
+      cpu.siblings = ParseCpuList(ReadLine(dir + "topology/thread_siblings_list"));
+      if (cpu.siblings.empty()) {
+        cpu.siblings = {c};
+      }
+      cpu.l3 = LastLevelCache(dir, c);
+      const auto n = nodeOf.find(c);
+      cpu.node = n == nodeOf.end() ? 0 : n->second;
+      t.cpus_.push_back(std::move(cpu));
+    }
+#endif
+    return t;
+  }
+
+  const std::vector<Cpu> &Cpus() const { return cpus_; }
+  bool Empty() const { return cpus_.empty(); }
+
+  // nullptr when `id` is not an allowed CPU
+  const Cpu *Find(int id) const {
+    const auto it = std::find_if(cpus_.begin(), cpus_.end(),
+                                 [id](const Cpu &c) { return c.id == id; });
+    return it == cpus_.end() ? nullptr : &*it;
+  }
+
+  // Same physical core (SMT siblings, or the same CPU)
+  bool SameCore(int a, int b) const {
+    const Cpu *ca = Find(a);
+    const Cpu *cb = Find(b);
+    return ca != nullptr && cb != nullptr && ca->package == cb->package &&
+           ca->core == cb->core;
+  }
+
+  // "4 cpus, 4 cores, 1 l3, 1 node"
+  std::string Summary() const {
+    std::vector<std::pair<int, int>> cores;
+    std::vector<int> l3s;
+    std::vector<int> nodes;
+    for (const Cpu &c : cpus_) {
+      cores.emplace_back(c.package, c.core);
+      l3s.push_back(c.l3);
+      nodes.push_back(c.node);
+    }
+    const auto distinct = [](auto v) {
+      std::sort(v.begin(), v.end());
+      return std::unique(v.begin(), v.end()) - v.begin();
+    };
+    std::ostringstream out;
+    out << cpus_.size() << " cpus, " << distinct(cores) << " cores, "
+        << distinct(l3s) << " l3, " << distinct(nodes) << " node"
+        << (distinct(nodes) == 1 ? "" : "s");
+    return out.str();
+  }
+
+private:
+  // The highest cache level listed for the CPU, identified by the lowest
+  // CPU sharing it; the package when no cache information is exposed
+  static int LastLevelCache(const std::string &dir, int self) {
+    int bestLevel = -1;
+    int id = -1;
+    for (int i = 0; i < 8; ++i) {
+      const std::string idx = dir + "cache/index" + std::to_string(i) + "/";
+      const int level = ReadInt(idx + "level");
+      if (level < 0) {
+        break;
+      }
+      const std::vector<int> shared =
+          ParseCpuList(ReadLine(idx + "shared_cpu_list"));
+      if (level > bestLevel && !shared.empty()) {
+        bestLevel = level;
+        id = *std::min_element(shared.begin(), shared.end());
+      }
+    }
+    if (id < 0) {
+      const std::vector<int> pkg =
+          ParseCpuList(ReadLine(dir + "topology/package_cpus_list"));
+      id = pkg.empty() ? self : *std::min_element(pkg.begin(), pkg.end());
+    }
+    return id;
+  }
+
+  std::vector<Cpu> cpus_;
+};
+
+// Where a network interface delivers its receive interrupts
+struct NicIrqs {
+  std::string iface;
+  std::vector<int> irqs;
+  std::vector<int> cpus; // effective affinity of those IRQs
+  int node = -1;         // NUMA node of the device, -1 = unknown
+};
+
+// Interface of the IPv4 default route, empty when there is none
+inline std::string DefaultRouteInterface() {
+  std::ifstream in("/proc/net/route");
+  std::string line;
+  std::getline(in, line); // header
+  while (std::getline(in, line)) {
+    std::istringstream ls(line);
+    std::string iface;
+    std::string dest;
+    if (ls >> iface >> dest && dest == "00000000") {
+      return iface;
+    }
+  }
+  return {};
+}
+
+// IRQs of `iface` (its PCI function's MSI vectors, or /proc/interrupts
+// entries naming the interface), narrowed to receive queues when their
+// names tell (rx, TxRx, input, comp), and the CPUs those are routed to
+inline NicIrqs ReadNicIrqs(std::string iface) {
+  NicIrqs r;
+#ifdef __linux__
+  if (iface.empty()) {
+    iface = DefaultRouteInterface();
+  }
+  r.iface = iface;
+  if (iface.empty()) {
+    return r;
+  }
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  const fs::path dev =
+      fs::canonical("/sys/class/net/" + iface + "/device", ec);
+  std::vector<int> irqs;
+  std::string devName;
+  if (!ec) {
+    devName = dev.filename().string();
+    // virtio and similar put the net device under the PCI function
+    for (const fs::path &d : {dev, dev.parent_path()}) {
+      for (const auto &e : fs::directory_iterator(d / "msi_irqs", ec)) {
+        irqs.push_back(std::atoi(e.path().filename().c_str()));
+      }
+      if (!irqs.empty()) {
+        break;
+      }
+    }
+    for (const fs::path &d : {dev, dev.parent_path()}) {
+      if (const int n = ReadInt((d / "numa_node").string()); n >= 0) {
+        r.node = n;
+        break;
+      }
+    }
+  }
+  // Names from /proc/interrupts: keep the device's receive vectors
+  std::vector<int> named;
+  std::vector<int> rx;
+  std::ifstream in("/proc/interrupts");
+  std::string line;
+  while (std::getline(in, line)) {
+    const std::size_t colon = line.find(':');
+    if (colon == std::string::npos) {
+      continue;
+    }
+    const std::size_t digit = line.find_first_not_of(' ');
+    if (digit >= colon ||
+        !std::isdigit(static_cast<unsigned char>(line[digit]))) {
+      continue; // NMI, LOC, ...
+    }
+    const int irq = std::atoi(line.c_str() + digit);
+    std::string name = line.substr(line.find_last_of(" \t") + 1);
+    const bool mine =
+        name.find(iface) != std::string::npos ||
+        (!devName.empty() && name.rfind(devName + "-", 0) == 0) ||
+        std::find(irqs.begin(), irqs.end(), irq) != irqs.end();
+    if (!mine) {
+      continue;
+    }
+    named.push_back(irq);
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char ch) { return std::tolower(ch); });
+    if (name.find("rx") != std::string::npos ||
+        name.find("input") != std::string::npos ||
+        name.find("comp") != std::string::npos) {
+      rx.push_back(irq);
+    }
+  }
+  r.irqs = !rx.empty() ? rx : !named.empty() ? named : irqs;
+  for (const int irq : r.irqs) {
+    const std::string base = "/proc/irq/" + std::to_string(irq) + "/";
+    std::string list = ReadLine(base + "effective_affinity_list");
+    if (list.empty()) {
+      list = ReadLine(base + "smp_affinity_list");
+    }
+    for (const int c : ParseCpuList(list)) {
+      r.cpus.push_back(c);
+    }
+  }
+  std::sort(r.cpus.begin(), r.cpus.end());
+  r.cpus.erase(std::unique(r.cpus.begin(), r.cpus.end()), r.cpus.end());
+#else
+  r.iface = std::move(iface);
+#endif
+  return r;
+}
+
+} // namespace topo
@@ -17,6 +17,13 @@ inline std::int64_t EpochMillisUtc() {
       .count();
 }
 
+inline std::int64_t EpochNanosUtc() {
+  using clock = std::chrono::system_clock;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             clock::now().time_since_epoch())
+      .count();
+}
+
 inline std::int64_t ExtractEventTimestampMs(std::string_view sv) {
   std::size_t pos = sv.find("\"E\":");
   if (BRANCH_UNLIKELY(pos == std::string_view::npos)) {
@@ -0,0 +1,336 @@
+#pragma once
+
+#include "util/cpu_topology.hpp"
+#include <algorithm>
+#include <charconv>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+// namespace placement — decides, once at startup, which CPU each pipeline
+// thread is pinned to, from the topology rather than from a busy-ness sample:
+// - the I/O threads (the reactor, or every sync session) go on the L3
+//   domain that receives the NIC's RX interrupts, but on a different core
+//   than the interrupt CPUs themselves
+// - the threads they hand messages to (merger, logger) go on the same L3, so
+//   every SPSC hand-off stays in the shared cache
+// - every thread gets its own physical core; SMT siblings of an occupied
+//   core are used only when the home node runs out of cores (before going
+//   to another socket), sharing a CPU only after that
+// - `--placement ROLE=CPU,...` pins roles explicitly; the rest are placed
+//   around them
+// Roles: reactor, merger, logger, session0..sessionN-1.
+namespace placement {
+
+struct Config {
+  bool enabled = true;           // false = CpuAffinity::PickAndPin per thread
+  std::string nic;               // empty = interface of the default route
+  std::map<std::string, int> pinned; // role → CPU
+};
+
+// "auto", "off" or "reactor=2,merger=4,session0=6"; nullopt when malformed
+inline std::optional<Config> ParseConfig(std::string_view s) {
+  Config cfg;
+  if (s == "auto") {
+    return cfg;
+  }
+  if (s == "off") {
+    cfg.enabled = false;
+    return cfg;
+  }
+  std::stringstream ss{std::string(s)};
+  std::string part;
+  while (std::getline(ss, part, ',')) {
+    const std::size_t eq = part.find('=');
+    if (eq == 0 || eq == std::string::npos || eq + 1 == part.size()) {
+      return std::nullopt;
+    }
+    const std::string role = part.substr(0, eq);
+    const std::string_view cpu = std::string_view{part}.substr(eq + 1);
+    int cpuId = 0;
+    const auto [end, ec] =
+        std::from_chars(cpu.data(), cpu.data() + cpu.size(), cpuId);
+    if (ec != std::errc{} || end != cpu.data() + cpu.size() || cpuId < 0) {
+      return std::nullopt;
+    }
+    const bool known = role == "reactor" || role == "merger" ||
+                       role == "logger" ||
+                       (role.rfind("session", 0) == 0 && role.size() > 7 &&
+                        role.find_first_not_of("0123456789", 7) ==
+                            std::string::npos);
+    if (!known) {
+      return std::nullopt;
+    }
+    cfg.pinned[role] = cpuId;
+  }
+  return cfg;
+}
+
+struct Slot {
+  std::string role;
+  int cpu = -1;
+  std::string why; // how the CPU was chosen
+};
+
+struct Plan {
+  std::vector<Slot> slots;
+  std::vector<std::string> notes; // topology and anchor, one line each
+
+  // CPU planned for `role`; nullopt = not planned (pick at thread start)
+  std::optional<int> Cpu(std::string_view role) const {
+    for (const Slot &s : slots) {
+      if (s.role == role) {
+        return s.cpu;
+      }
+    }
+    return std::nullopt;
+  }
+};
+
+// Planner
+// Threading model:
+// - Runs on the main thread before any pipeline thread starts; the Plan it
+//   returns is read-only afterwards
+class Planner {
+public:
+  Planner(const topo::Topology &topo, const topo::NicIrqs &nic)
+      : topo_(topo), nic_(nic) {}
+
+  // `producers` feed `consumers` over SPSC queues (reactor or sessions →
+  // merger, logger), both in order of importance
+  Plan Place(const Config &cfg, const std::vector<std::string> &producers,
+             const std::vector<std::string> &consumers) {
+    Plan plan;
+    if (topo_.Empty()) {
+      return plan;
+    }
+    plan.notes.push_back("topology " + topo_.Summary());
+    for (const int c : nic_.cpus) {
+      if (topo_.Find(c) != nullptr) {
+        irqCpus_.push_back(c);
+      }
+    }
+    if (!nic_.iface.empty()) {
+      plan.notes.push_back(
+          "nic " + nic_.iface + " rx irqs on cpus " +
+          (nic_.cpus.empty() ? std::string("unknown")
+                             : topo::FormatCpuList(nic_.cpus)) +
+          (nic_.node >= 0 ? " node " + std::to_string(nic_.node) : ""));
+    }
+    // Explicit roles first; they are not moved
+    for (const auto &[role, cpu] : cfg.pinned) {
+      const auto inRun = [&](const std::vector<std::string> &roles) {
+        return std::find(roles.begin(), roles.end(), role) != roles.end();
+      };
+      if (!inRun(producers) && !inRun(consumers)) {
+        plan.notes.push_back(role + " does not run in this mode, ignoring "
+                                    "its cpu");
+        continue;
+      }
+      if (topo_.Find(cpu) == nullptr) {
+        plan.notes.push_back("cpu " + std::to_string(cpu) + " for " + role +
+                             " is not available to this process, placing "
+                             "it automatically");
+        continue;
+      }
+      Take(plan, role, cpu, "explicit");
+    }
+    home_ = HomeL3(cfg, producers);
+    plan.notes.push_back("home l3 " + std::to_string(home_) + " (cpus " +
+                         topo::FormatCpuList(CpusOfL3(home_)) + ")");
+    // The first consumer (the merger) takes every producer's hand-off, so it
+    // is placed right after the first producer, before the others can fill
+    // the home L3
+    for (std::size_t i = 0; i < producers.size(); ++i) {
+      Assign(plan, producers[i], true);
+      if (i == 0 && !consumers.empty()) {
+        Assign(plan, consumers[0], true);
+      }
+    }
+    // The other consumers (the logger) are off the message path: a free
+    // core on another node beats an SMT sibling of a hand-off thread
+    for (std::size_t i = producers.empty() ? 0 : 1; i < consumers.size();
+         ++i) {
+      Assign(plan, consumers[i], i == 0);
+    }
+    return plan;
+  }
+
+private:
+  // The L3 the hand-off pairs share: that of an explicitly pinned producer,
+  // else that of the RX interrupts, else the node of the NIC, else the L3
+  // with the most cores
+  int HomeL3(const Config &cfg,
+             const std::vector<std::string> &producers) const {
+    for (const std::string &role : producers) {
+      if (const auto it = cfg.pinned.find(role); it != cfg.pinned.end()) {
+        if (const topo::Cpu *c = topo_.Find(it->second)) {
+          return c->l3;
+        }
+      }
+    }
+    if (!irqCpus_.empty()) {
+      return topo_.Find(irqCpus_.front())->l3;
+    }
+    std::map<int, int> cores; // l3 → free physical cores
+    for (const topo::Cpu &c : topo_.Cpus()) {
+      if ((nic_.node < 0 || c.node == nic_.node) &&
+          c.siblings.front() == c.id) {
+        ++cores[c.l3];
+      }
+    }
+    if (cores.empty()) {
+      return topo_.Cpus().front().l3;
+    }
+    return std::max_element(cores.begin(), cores.end(),
+                            [](const auto &a, const auto &b) {
+                              return a.second < b.second;
+                            })
+        ->first;
+  }
+
+  std::vector<int> CpusOfL3(int l3) const {
+    std::vector<int> r;
+    for (const topo::Cpu &c : topo_.Cpus()) {
+      if (c.l3 == l3) {
+        r.push_back(c.id);
+      }
+    }
+    return r;
+  }
+
+  bool CoreBusy(const topo::Cpu &c) const {
+    return std::any_of(used_.begin(), used_.end(),
+                       [&](int u) { return topo_.SameCore(u, c.id); });
+  }
+
+  bool IrqCore(const topo::Cpu &c) const {
+    return std::any_of(irqCpus_.begin(), irqCpus_.end(),
+                       [&](int i) { return topo_.SameCore(i, c.id); });
+  }
+
+  // Best remaining CPU for `role`, most preferred first:
+  // 1. free core on the home L3, not serving RX interrupts
+  // 2. free core on the home L3
+  // 3. free core on another L3 of the home node
+  // 4. free SMT sibling of an occupied core on the home L3 (a sibling costs
+  //    less than a hand-off across sockets); on-path roles only
+  // 5. free core on another node, then any free SMT sibling
+  // 6. the least shared CPU, home L3 first
+  void Assign(Plan &plan, const std::string &role, bool onPath) {
+    if (plan.Cpu(role).has_value()) {
+      return;
+    }
+    const topo::Cpu *home = nullptr;
+    for (const topo::Cpu &c : topo_.Cpus()) {
+      if (c.l3 == home_) {
+        home = &c;
+        break;
+      }
+    }
+    const int homeNode = home != nullptr ? home->node : -1;
+    struct Tier {
+      const char *why;
+      bool (*match)(const Planner &, const topo::Cpu &, int);
+    };
+    static constexpr Tier kTiers[] = {
+        {"home l3",
+         [](const Planner &p, const topo::Cpu &c, int) {
+           return c.l3 == p.home_ && !p.CoreBusy(c) && !p.IrqCore(c);
+         }},
+        {"home l3, shares a core with rx irqs",
+         [](const Planner &p, const topo::Cpu &c, int) {
+           return c.l3 == p.home_ && !p.CoreBusy(c);
+         }},
+        {"home node, other l3",
+         [](const Planner &p, const topo::Cpu &c, int node) {
+           return c.node == node && !p.CoreBusy(c);
+         }},
+        {"smt sibling of a busy core, home l3",
+         [](const Planner &p, const topo::Cpu &c, int) {
+           return c.l3 == p.home_ && !p.Used(c.id);
+         }},
+        {"other node",
+         [](const Planner &p, const topo::Cpu &c, int) {
+           return !p.CoreBusy(c);
+         }},
+        {"smt sibling of a busy core",
+         [](const Planner &p, const topo::Cpu &c, int) {
+           return !p.Used(c.id);
+         }},
+    };
+    for (const Tier &t : kTiers) {
+      if (!onPath && &t == &kTiers[3]) {
+        continue;
+      }
+      for (const topo::Cpu &c : topo_.Cpus()) {
+        if (t.match(*this, c, homeNode)) {
+          Take(plan, role, c.id, t.why);
+          return;
+        }
+      }
+    }
+    // Out of CPUs: share the least loaded one, home L3 first
+    int best = -1;
+    std::size_t bestLoad = 0;
+    for (const bool homeOnly : {true, false}) {
+      for (const topo::Cpu &c : topo_.Cpus()) {
+        if (homeOnly && c.l3 != home_) {
+          continue;
+        }
+        const auto load = static_cast<std::size_t>(
+            std::count(used_.begin(), used_.end(), c.id));
+        if (best < 0 || load < bestLoad) {
+          best = c.id;
+          bestLoad = load;
+        }
+      }
+      if (best >= 0) {
+        break;
+      }
+    }
+    std::string with;
+    for (const Slot &s : plan.slots) {
+      if (s.cpu == best) {
+        with += (with.empty() ? "" : "+") + s.role;
+      }
+    }
+    Take(plan, role, best, "shares the cpu with " + with);
+  }
+
+  bool Used(int cpu) const {
+    return std::find(used_.begin(), used_.end(), cpu) != used_.end();
+  }
+
+  void Take(Plan &plan, const std::string &role, int cpu, std::string why) {
+    used_.push_back(cpu);
+    const topo::Cpu *c = topo_.Find(cpu);
+    std::ostringstream out;
+    out << why << "; core " << c->package << "/" << c->core << " l3 " << c->l3
+        << " node " << c->node;
+    plan.slots.push_back({role, cpu, out.str()});
+  }
+
+  const topo::Topology &topo_;
+  const topo::NicIrqs &nic_;
+  std::vector<int> irqCpus_; // RX interrupt CPUs this process may use
+  std::vector<int> used_;    // one entry per placed role
+  int home_ = -1;
+};
+
+// Reads the topology and the NIC interrupts and places the roles
+inline Plan Place(const Config &cfg, const std::vector<std::string> &producers,
+                  const std::vector<std::string> &consumers) {
+  if (!cfg.enabled) {
+    return {};
+  }
+  const topo::Topology topology = topo::Topology::Read();
+  const topo::NicIrqs nic = topo::ReadNicIrqs(cfg.nic);
+  return Planner(topology, nic).Place(cfg, producers, consumers);
+}
+
+} // namespace placement
@@ -0,0 +1,330 @@
+#pragma once
+
+#include "util/cpu_topology.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+// namespace rt — optional real-time mode for the pinned pipeline threads.
+// Pinning keeps a thread on one core but it still competes under CFS and can
+// fault in pages at runtime; both show up in the far tail (p99.9+). With
+// --realtime:
+// - the process locks its memory (mlockall current + future), so every later
+//   mapping — message slabs, sink rings, thread stacks — is resident at
+//   creation and never faults on the message path
+// - the reactor (or each sync session), merger, logger and pinned sink
+//   worker threads switch to SCHED_FIFO right after pinning and prefault the
+//   top of their stacks
+// - the kernel setup the mode depends on (isolcpus, nohz_full, rcu_nocbs,
+//   RT throttling, rlimits, cpufreq governor) is checked and every missing
+//   piece is reported; nothing is changed system-wide
+// No-ops off Linux.
+namespace rt {
+
+struct Config {
+  bool enabled = false;
+  int priority = 50; // reactor; merger runs one below, logger and sinks at 1
+  bool lock_memory = true;
+  std::size_t stack_prefault = 256u << 10; // bytes touched per thread
+};
+
+enum class Role { reactor, merger, logger, sink };
+
+// Realtime
+// Threading model:
+// - Configure(), PlanCpu() and LockMemory() run on the main thread before
+//   any pipeline thread starts; EnterThread() is called by each pinned thread
+//   on itself and serialises on a mutex (it runs once per thread, at startup)
+class Realtime {
+public:
+  static void Configure(const Config &cfg) {
+    std::lock_guard<std::mutex> lock(m_);
+    cfg_ = cfg;
+  }
+
+  // Records the placement plan: `role` ("merger", "session0", ...) will be
+  // pinned to `cpu`
+  static void PlanCpu(int cpu, std::string role) {
+    std::lock_guard<std::mutex> lock(m_);
+    planned_.emplace_back(cpu, std::move(role));
+  }
+
+  static bool Enabled() {
+    std::lock_guard<std::mutex> lock(m_);
+    return cfg_.enabled;
+  }
+
+  // mlockall(MCL_CURRENT | MCL_FUTURE); false (with the reason printed) when
+  // RLIMIT_MEMLOCK or the missing capability refuses it
+  static bool LockMemory() {
+#ifdef __linux__
+    if (::mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      std::cerr << "[realtime] mlockall failed: " << std::strerror(errno)
+                << " (raise RLIMIT_MEMLOCK or grant CAP_IPC_LOCK)\n";
+      return false;
+    }
+    std::cout << "[realtime] memory locked (current and future mappings)\n";
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  // Called by a pipeline thread after it pinned itself: prefaults its stack
+  // and switches it to SCHED_FIFO. A second FIFO thread on the same CPU is
+  // refused and stays SCHED_OTHER. A spinning role (merger, logger, sink
+  // worker) never gets FIFO on a CPU it shares with any other pipeline
+  // thread, planned or already running: it would never yield the CPU to them.
+  static void EnterThread(const char *who, Role role) {
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock(m_);
+    if (!cfg_.enabled) {
+      return;
+    }
+    PrefaultStack(cfg_.stack_prefault);
+    const int cpu = PinnedCpu();
+    std::ostringstream out;
+    out << "[realtime] " << who << ": cpu=" << (cpu < 0 ? std::string("any")
+                                                        : std::to_string(cpu));
+    const auto holder =
+        std::find_if(fifo_.begin(), fifo_.end(),
+                     [cpu](const auto &e) { return cpu >= 0 && e.cpu == cpu; });
+    const std::string sharing = cpu >= 0 && Spins(role)
+                                    ? SharersOf(cpu, RoleName(role))
+                                    : std::string();
+    if (cpu >= 0) {
+      entered_.emplace_back(cpu, who);
+    }
+    if (cpu < 0) {
+      out << " not pinned to one CPU, staying SCHED_OTHER";
+    } else if (holder != fifo_.end() && holder->spins) {
+      // Arrived after a spinning FIFO thread outside the plan: demote that
+      // one instead of starving this one
+      sched_param sp{};
+      (void)pthread_setschedparam(holder->thread, SCHED_OTHER, &sp);
+      out << " shares the CPU with spinning " << holder->who
+          << ", which is moved back to SCHED_OTHER; staying SCHED_OTHER";
+      fifo_.erase(holder);
+    } else if (!sharing.empty()) {
+      out << " spins on a CPU shared with" << sharing
+          << ", staying SCHED_OTHER (FIFO would starve them)";
+    } else if (holder != fifo_.end()) {
+      out << " shares the CPU with " << holder->who
+          << ", staying SCHED_OTHER";
+    } else {
+      sched_param sp{};
+      sp.sched_priority = PriorityOf(role);
+      const int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+      if (rc == 0) {
+        fifo_.push_back({cpu, who, pthread_self(), Spins(role)});
+        out << " SCHED_FIFO prio=" << sp.sched_priority;
+      } else {
+        out << " SCHED_FIFO failed: " << std::strerror(rc)
+            << " (needs CAP_SYS_NICE or RLIMIT_RTPRIO)";
+      }
+    }
+    out << " stack=" << (cfg_.stack_prefault >> 10) << "K";
+    if (cpu >= 0) {
+      std::string missing;
+      if (!Contains(ReadCpuList("/sys/devices/system/cpu/isolated"), cpu)) {
+        missing += " not-isolated";
+      }
+      if (!Contains(ReadCpuList("/sys/devices/system/cpu/nohz_full"), cpu)) {
+        missing += " not-nohz_full";
+      }
+      const std::string gov = ReadLine("/sys/devices/system/cpu/cpu" +
+                                       std::to_string(cpu) +
+                                       "/cpufreq/scaling_governor");
+      if (!gov.empty() && gov != "performance") {
+        missing += " governor=" + gov;
+      }
+      if (!missing.empty()) {
+        out << " (cpu" << missing << ")";
+      }
+    }
+    std::cout << out.str() << "\n";
+#else
+    (void)who;
+    (void)role;
+#endif
+  }
+
+  // Kernel and process settings the mode relies on; one line per finding,
+  // "ok ..." or "missing ..."
+  static std::vector<std::string> CheckSystem() {
+    std::vector<std::string> r;
+#ifdef __linux__
+    const std::string isolated = ReadLine("/sys/devices/system/cpu/isolated");
+    r.push_back(isolated.empty()
+                    ? "missing isolcpus: pinned threads share their CPUs "
+                      "with every other task (boot with isolcpus=LIST)"
+                    : "ok isolcpus=" + isolated);
+    const std::string nohz = ReadLine("/sys/devices/system/cpu/nohz_full");
+    r.push_back(nohz.empty() || nohz == "(null)"
+                    ? "missing nohz_full: the scheduler tick still interrupts "
+                      "busy pipeline CPUs (boot with nohz_full=LIST)"
+                    : "ok nohz_full=" + nohz);
+    const std::string cmdline = ReadLine("/proc/cmdline");
+    r.push_back(cmdline.find("rcu_nocbs") == std::string::npos
+                    ? "missing rcu_nocbs: RCU callbacks run on the pipeline "
+                      "CPUs (boot with rcu_nocbs=LIST)"
+                    : "ok rcu_nocbs");
+    const std::string rtRuntime =
+        ReadLine("/proc/sys/kernel/sched_rt_runtime_us");
+    if (rtRuntime == "-1") {
+      r.push_back("ok sched_rt_runtime_us=-1 (no RT throttling; a spinning "
+                  "FIFO thread owns its CPU)");
+    } else if (!rtRuntime.empty()) {
+      r.push_back("missing sched_rt_runtime_us=-1: FIFO threads are "
+                  "throttled after " +
+                  rtRuntime + " us of every sched_rt_period_us");
+    }
+    rlimit rl{};
+    if (::geteuid() != 0 && ::getrlimit(RLIMIT_RTPRIO, &rl) == 0 &&
+        rl.rlim_cur == 0) {
+      r.push_back("missing RLIMIT_RTPRIO: SCHED_FIFO will be refused "
+                  "(ulimit -r or CAP_SYS_NICE)");
+    }
+    if (::geteuid() != 0 && ::getrlimit(RLIMIT_MEMLOCK, &rl) == 0 &&
+        rl.rlim_cur != RLIM_INFINITY) {
+      r.push_back("missing RLIMIT_MEMLOCK=unlimited: mlockall may fail or "
+                  "cap locked memory at " +
+                  std::to_string(rl.rlim_cur >> 10) + " KiB");
+    }
+#endif
+    return r;
+  }
+
+private:
+  // The merger, the logger and the sink workers yield-spin when idle: under
+  // SCHED_FIFO, SCHED_OTHER threads on their CPU would never run
+  static bool Spins(Role role) { return role != Role::reactor; }
+
+  // Name of `role` in the placement plan
+  static const char *RoleName(Role role) {
+    switch (role) {
+    case Role::reactor:
+      return "reactor";
+    case Role::merger:
+      return "merger";
+    case Role::logger:
+      return "logger";
+    case Role::sink:
+      return "sink";
+    }
+    return "";
+  }
+
+  // " a b": the other roles the plan puts on `cpu` or, without a plan for
+  // it, the pipeline threads already running there
+  static std::string SharersOf(int cpu, const std::string &self) {
+    std::string r;
+    for (const auto &[c, name] : planned_) {
+      if (c == cpu && name != self) {
+        r += " " + name;
+      }
+    }
+    if (!r.empty()) {
+      return r;
+    }
+    for (const auto &[c, name] : entered_) {
+      if (c == cpu) {
+        r += " " + name;
+      }
+    }
+    return r;
+  }
+
+  static int PriorityOf(Role role) {
+    switch (role) {
+    case Role::reactor:
+      return cfg_.priority;
+    case Role::merger:
+      return std::max(1, cfg_.priority - 1);
+    case Role::logger:
+    case Role::sink:
+      return 1;
+    }
+    return 1;
+  }
+
+#ifdef __linux__
+  // The single CPU the calling thread may run on, -1 when it may run on more
+  static int PinnedCpu() {
+    cpu_set_t set;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) != 0 ||
+        CPU_COUNT(&set) != 1) {
+      return -1;
+    }
+    for (int c = 0; c < CPU_SETSIZE; ++c) {
+      if (CPU_ISSET(c, &set)) {
+        return c;
+      }
+    }
+    return -1;
+  }
+
+  // Touches `bytes` below the current frame, one write per page
+  [[gnu::noinline]] static void PrefaultStack(std::size_t bytes) {
+    const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    auto *p = static_cast<volatile char *>(__builtin_alloca(bytes));
+    for (std::size_t off = 0; off < bytes; off += page) {
+      p[off] = 0;
+    }
+  }
+#endif
+
+  static std::string ReadLine(const std::string &path) {
+    std::ifstream in(path);
+    std::string s;
+    std::getline(in, s);
+    while (!s.empty() && (s.back() == '\n' || s.back() == ' ')) {
+      s.pop_back();
+    }
+    return s;
+  }
+
+  static std::vector<int> ReadCpuList(const std::string &path) {
+    return topo::ParseCpuList(ReadLine(path));
+  }
+
+  static bool Contains(const std::vector<int> &v, int x) {
+    return std::find(v.begin(), v.end(), x) != v.end();
+  }
+
+  inline static std::mutex m_;
+  inline static Config cfg_;
+  // Placement plan: CPU and role of every pinned pipeline thread
+  inline static std::vector<std::pair<int, std::string>> planned_;
+  // Pipeline threads that already entered, with their CPU
+  inline static std::vector<std::pair<int, std::string>> entered_;
+#ifdef __linux__
+  struct FifoThread {
+    int cpu;
+    std::string who;
+    pthread_t thread;
+    bool spins;
+  };
+  // CPUs already running a FIFO pipeline thread
+  inline static std::vector<FifoThread> fifo_;
+#endif
+};
+
+} // namespace rt
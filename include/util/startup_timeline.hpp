@@ -0,0 +1,73 @@
+#pragma once
+
+#include "util/latency.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// StartupTimeline — wall-clock marks from process start until every
+// connection delivered its first message: placement, queue mapping, the
+// sessions' connects, background prefaults, merger start. Marks use the same
+// epoch clock as RawOrderUpdate::recv_ns, so first-message times taken on
+// the message path drop straight in.
+// Threading model:
+// - Mark() may be called from any thread; it takes a mutex and allocates,
+//   so it is for startup and reconnects only, never the message path
+// - Finish() is called by the runner once the startup is over; marks after
+//   it (reconnects) are ignored
+class StartupTimeline {
+public:
+  // Origin of the timeline (first call wins); main() calls it first thing
+  static void Begin() {
+    std::lock_guard<std::mutex> lock(m_);
+    if (origin_ == 0) {
+      origin_ = lat::EpochNanosUtc();
+    }
+  }
+
+  static void Mark(std::string what) {
+    MarkAt(lat::EpochNanosUtc(), std::move(what));
+  }
+
+  // A mark taken earlier on another clock reading (epoch ns)
+  static void MarkAt(std::int64_t epoch_ns, std::string what) {
+    std::lock_guard<std::mutex> lock(m_);
+    if (finished_) {
+      return;
+    }
+    if (origin_ == 0) {
+      origin_ = epoch_ns;
+    }
+    marks_.emplace_back(epoch_ns, std::move(what));
+  }
+
+  // Stops recording; returns "+   12.345 ms  what" lines in time order
+  static std::vector<std::string> Finish() {
+    std::lock_guard<std::mutex> lock(m_);
+    finished_ = true;
+    std::vector<std::pair<std::int64_t, std::string>> sorted =
+        std::move(marks_);
+    std::stable_sort(
+        sorted.begin(), sorted.end(),
+        [](const auto &a, const auto &b) { return a.first < b.first; });
+    std::vector<std::string> out;
+    out.reserve(sorted.size());
+    for (const auto &[ns, what] : sorted) {
+      char at[32];
+      std::snprintf(at, sizeof(at), "+%9.3f ms  ",
+                    static_cast<double>(ns - origin_) / 1e6);
+      out.push_back(at + what);
+    }
+    return out;
+  }
+
+private:
+  inline static std::mutex m_;
+  inline static std::int64_t origin_ = 0;
+  inline static bool finished_ = false;
+  inline static std::vector<std::pair<std::int64_t, std::string>> marks_;
+};
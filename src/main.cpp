@@ -1,5 +1,6 @@
 #include "core/runner.hpp"
 #include "net/url.hpp"
+#include <csignal>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -13,9 +14,52 @@ struct Options {
   int num_connections = 2;
   std::string out_file = "stream.ndjson";
   std::string mode = "async";
-  int seconds = 0; // 0 = run indefinitely
+  std::string format = "ndjson"; // ndjson | binary
+  std::string writer = "write";  // write|mmap|uring|stream|direct
+  std::string compress;          // zstd | lz4, empty = none
+  std::uint64_t segment_bytes = 0; // 0 = no size-based rotation
+  int segment_seconds = 0;         // 0 = no time-based rotation
+  int seconds = 0; // 0 = run until SIGINT/SIGTERM
+  bool analytics = false;
+  std::string shm_name;
+  std::vector<std::string> sinks;   // KIND:TARGET[,POLICY], repeatable
+  std::string mcast;                // GROUP:PORT, empty = disabled
+  std::string mcast_if = "127.0.0.1";
+  std::string wire_dir;             // raw per-connection capture, empty = off
+  std::string durability;           // none | periodic[:MS] | group[:MS[,B]]
+  bool resume = false;              // warm restart of the outputs
+  std::string state_dir = "state";  // addresses and TLS tickets (--resume)
+  std::uint64_t max_message = 2048; // bytes per message slot
+  bool hugepages = false;           // message slots on hugepages
+  int numa_node = -1;               // bind message slots, -1 = first touch
+  std::string queue_overflow = "drop-newest"; // drop-newest|drop-oldest|block
+  bool realtime = false;            // SCHED_FIFO + mlockall + prefault
+  int rt_priority = 50;             // reactor FIFO priority (--realtime)
+  std::string placement = "auto";   // auto | off | ROLE=CPU[,ROLE=CPU...]
+  std::string nic;                  // RX interface, empty = default route
+  bool latency_log = true;          // per-message latencies/*.lat lines
+  int latency_report = 10;          // seconds between percentile reports
+  std::string metrics;              // NDJSON report file, empty = none
 };
 
+// "512M", "2G", "65536" → bytes
+static std::uint64_t ParseSize(const std::string &s) {
+  std::uint64_t v = std::strtoull(s.c_str(), nullptr, 10);
+  switch (s.empty() ? '\0' : s.back()) {
+  case 'K':
+  case 'k':
+    return v << 10;
+  case 'M':
+  case 'm':
+    return v << 20;
+  case 'G':
+  case 'g':
+    return v << 30;
+  default:
+    return v;
+  }
+}
+
 static Options ParseArgs(int argc, char **argv) {
   Options opt;
   for (int i = 1; i < argc; ++i) {
@@ -28,13 +72,67 @@ static Options ParseArgs(int argc, char **argv) {
       opt.out_file = argv[++i];
     else if ((a == "-m" || a == "--mode") && i + 1 < argc)
       opt.mode = argv[++i];
+    else if ((a == "-f" || a == "--format") && i + 1 < argc)
+      opt.format = argv[++i];
+    else if (a == "--writer" && i + 1 < argc)
+      opt.writer = argv[++i];
+    else if (a == "--compress" && i + 1 < argc)
+      opt.compress = argv[++i];
+    else if (a == "--segment-bytes" && i + 1 < argc)
+      opt.segment_bytes = ParseSize(argv[++i]);
+    else if (a == "--segment-seconds" && i + 1 < argc)
+      opt.segment_seconds = std::max(0, std::atoi(argv[++i]));
     else if ((a == "-t" || a == "--seconds") && i + 1 < argc)
       opt.seconds = std::max(0, std::atoi(argv[++i]));
+    else if (a == "--analytics")
+      opt.analytics = true;
+    else if (a == "--shm" && i + 1 < argc)
+      opt.shm_name = argv[++i];
+    else if (a == "--sink" && i + 1 < argc)
+      opt.sinks.emplace_back(argv[++i]);
+    else if (a == "--mcast" && i + 1 < argc)
+      opt.mcast = argv[++i];
+    else if (a == "--mcast-if" && i + 1 < argc)
+      opt.mcast_if = argv[++i];
+    else if (a == "--wire-capture" && i + 1 < argc)
+      opt.wire_dir = argv[++i];
+    else if (a == "--durability" && i + 1 < argc)
+      opt.durability = argv[++i];
+    else if (a == "--resume")
+      opt.resume = true;
+    else if (a == "--state-dir" && i + 1 < argc)
+      opt.state_dir = argv[++i];
+    else if (a == "--max-message" && i + 1 < argc)
+      opt.max_message = ParseSize(argv[++i]);
+    else if (a == "--hugepages")
+      opt.hugepages = true;
+    else if (a == "--numa-node" && i + 1 < argc)
+      opt.numa_node = std::atoi(argv[++i]);
+    else if (a == "--queue-overflow" && i + 1 < argc)
+      opt.queue_overflow = argv[++i];
+    else if (a == "--realtime")
+      opt.realtime = true;
+    else if (a == "--rt-priority" && i + 1 < argc)
+      opt.rt_priority = std::atoi(argv[++i]);
+    else if (a == "--placement" && i + 1 < argc)
+      opt.placement = argv[++i];
+    else if (a == "--nic" && i + 1 < argc)
+      opt.nic = argv[++i];
+    else if (a == "--no-latency-log")
+      opt.latency_log = false;
+    else if (a == "--latency-report" && i + 1 < argc)
+      opt.latency_report = std::atoi(argv[++i]);
+    else if (a == "--metrics" && i + 1 < argc)
+      opt.metrics = argv[++i];
   }
   return opt;
 }
 
 int main(int argc, char **argv) {
+  StartupTimeline::Begin();
+  // A dead compressor (gzip:/zstd:/lz4: sinks) or peer must surface as
+  // EPIPE on write, not kill the process
+  std::signal(SIGPIPE, SIG_IGN);
   auto opt = ParseArgs(argc, argv);
   auto url = URL::ParseWssUrl(opt.url);
   if (!url) {
@@ -47,12 +145,132 @@ int main(int argc, char **argv) {
             << " with N=" << opt.num_connections << ", output='" << opt.out_file
             << "'\n";
 
+  std::optional<mcast::Endpoint> multicast;
+  if (!opt.mcast.empty()) {
+    multicast = mcast::ParseEndpoint(opt.mcast, opt.mcast_if);
+    if (!multicast) {
+      std::cerr << "Invalid --mcast (expected GROUP:PORT, PORT 1..65534): "
+                << opt.mcast << "\n";
+      return 1;
+    }
+  }
+
+  if (opt.format != "ndjson" && opt.format != "binary") {
+    std::cerr << "Invalid --format (expected ndjson|binary): " << opt.format
+              << "\n";
+    return 1;
+  }
+
+  auto writer = io::ParseWriterKind(opt.writer);
+  if (!writer) {
+    std::cerr << "Invalid --writer (expected "
+                 "write|mmap|uring|stream|direct): "
+              << opt.writer << "\n";
+    return 1;
+  }
+
+  std::optional<compress::Codec> codec;
+  if (!opt.compress.empty()) {
+    codec = compress::ParseCodec(opt.compress);
+    if (!codec) {
+      std::cerr << "Invalid --compress (expected zstd|lz4): " << opt.compress
+                << "\n";
+      return 1;
+    }
+  }
+
+  std::optional<sink::SegmentConfig> segment;
+  if (opt.segment_bytes != 0 || opt.segment_seconds != 0) {
+    segment = sink::SegmentConfig{
+        .max_bytes = opt.segment_bytes,
+        .max_age = std::chrono::seconds(opt.segment_seconds)};
+  }
+
+  std::optional<io::DurabilityConfig> durability;
+  if (!opt.durability.empty()) {
+    durability = io::ParseDurability(opt.durability);
+    if (!durability) {
+      std::cerr << "Invalid --durability (expected none|periodic[:MS]|"
+                   "group[:MS[,BYTES]]): "
+                << opt.durability << "\n";
+      return 1;
+    }
+  }
+
+  if (opt.max_message == 0 || opt.max_message > (64u << 20)) {
+    std::cerr << "Invalid --max-message (expected 1..64M): "
+              << opt.max_message << "\n";
+    return 1;
+  }
+
+  auto overflow = ParseQueueOverflow(opt.queue_overflow);
+  if (!overflow) {
+    std::cerr << "Invalid --queue-overflow (expected "
+                 "drop-newest|drop-oldest|block): "
+              << opt.queue_overflow << "\n";
+    return 1;
+  }
+
+  if (opt.rt_priority < 1 || opt.rt_priority > 99) {
+    std::cerr << "Invalid --rt-priority (expected 1..99): " << opt.rt_priority
+              << "\n";
+    return 1;
+  }
+
+  auto placement = placement::ParseConfig(opt.placement);
+  if (!placement) {
+    std::cerr << "Invalid --placement (expected auto|off|ROLE=CPU[,...] with "
+                 "ROLE reactor|merger|logger|sessionN): "
+              << opt.placement << "\n";
+    return 1;
+  }
+  placement->nic = opt.nic;
+
+  if (opt.latency_report < 0) {
+    std::cerr << "Invalid --latency-report (expected SECONDS >= 0): "
+              << opt.latency_report << "\n";
+    return 1;
+  }
+
+  std::vector<sink::SinkSpec> sinks;
+  for (const auto &s : opt.sinks) {
+    auto spec = sink::ParseSinkSpec(s);
+    if (!spec) {
+      std::cerr << "Invalid --sink (expected KIND:TARGET[,POLICY]): " << s
+                << "\n";
+      return 1;
+    }
+    sinks.push_back(std::move(*spec));
+  }
+
   RunOptions ro{.host = url->host,
                 .port = url->port,
                 .target = url->target,
                 .numConnections = opt.num_connections,
                 .outFile = opt.out_file,
-                .seconds = opt.seconds};
+                .binaryOut = opt.format == "binary",
+                .writer = *writer,
+                .compress = codec,
+                .segment = segment,
+                .seconds = opt.seconds,
+                .analytics = opt.analytics,
+                .shmName = opt.shm_name,
+                .sinks = std::move(sinks),
+                .multicast = multicast,
+                .wireCapture = opt.wire_dir,
+                .durability = durability,
+                .resume = opt.resume,
+                .stateDir = opt.state_dir,
+                .slab = {.slot_bytes = opt.max_message,
+                         .hugepages = opt.hugepages,
+                         .numa_node = opt.numa_node},
+                .queueOverflow = *overflow,
+                .realtime = {.enabled = opt.realtime,
+                             .priority = opt.rt_priority},
+                .placement = std::move(*placement),
+                .latencyLog = opt.latency_log,
+                .latencyReportSeconds = opt.latency_report,
+                .metricsPath = opt.metrics};
   if (opt.mode == "async") {
     return Run(ro, RunMode::async);
   } else {
@@ -0,0 +1,62 @@
+// capture_columns — columnar export for vectorised analysis (NumPy/pandas).
+//   capture_columns -o DIR CAPTURE                 one capture (NDJSON or
+//                                                  binary, plain/compressed)
+//   capture_columns -o DIR --latency FILE.lat...   latency series
+// Options: -j THREADS (default: every CPU).
+// DIR receives one .npy per column (see include/capture/columnar_export.hpp):
+//   cols = {p.name[:-4]: np.load(p, mmap_mode='r') for p in Path(DIR).glob('*.npy')}
+#include "capture/columnar_export.hpp"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+  std::string dir;
+  bool latency = false;
+  unsigned threads = 0;
+  std::vector<std::filesystem::path> inputs;
+  for (int i = 1; i < argc; ++i) {
+    const std::string a = argv[i];
+    if (a == "-o" && i + 1 < argc) {
+      dir = argv[++i];
+    } else if (a == "-j" && i + 1 < argc) {
+      threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+    } else if (a == "--latency") {
+      latency = true;
+    } else {
+      inputs.emplace_back(a);
+    }
+  }
+  if (dir.empty() || inputs.empty() || (!latency && inputs.size() != 1)) {
+    std::cerr << "usage: capture_columns -o DIR [-j N] CAPTURE\n"
+                 "       capture_columns -o DIR [-j N] --latency FILE...\n";
+    return 1;
+  }
+  const auto t0 = std::chrono::steady_clock::now();
+  std::expected<std::size_t, std::error_code> rows;
+  if (latency) {
+    std::sort(inputs.begin(), inputs.end());
+    rows = capture::ExportLatencyColumns(inputs, dir, threads);
+  } else {
+    auto r = capture::CaptureReader::Open(inputs[0].string(), threads);
+    if (!r) {
+      std::cerr << "[capture_columns] " << inputs[0].string() << ": "
+                << r.error().message() << "\n";
+      return 1;
+    }
+    r->BuildIndex(threads);
+    rows = capture::ExportCaptureColumns(*r, dir, threads);
+  }
+  if (!rows) {
+    std::cerr << "[capture_columns] " << dir << ": " << rows.error().message()
+              << "\n";
+    return 1;
+  }
+  std::cerr << "[capture_columns] " << *rows << " rows -> " << dir << " in "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now() - t0)
+                   .count()
+            << " ms\n";
+  return 0;
+}
@@ -0,0 +1,200 @@
+// capture_convert — converts between the NDJSON stream and the binary capture
+// format (include/capture/capture_format.hpp). The direction is taken from
+// the input: a file starting with the capture magic becomes NDJSON, anything
+// else is read as NDJSON and becomes a binary capture. "-" is stdin/stdout.
+//
+// NDJSON → binary keeps u, s, b, B, a, A, T, E exactly (decimal precision is
+// recorded per record); receive time and source are unknown and stored as 0.
+// binary → NDJSON renders Binance's bookTicker key order, so converting a
+// merged stream there and back yields the original bytes.
+#include "capture/capture_format.hpp"
+#include "io/file_writer.hpp"
+#include "util/latency.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kChunk = 1 << 20;
+
+std::size_t ReadSome(int fd, std::byte *buf, std::size_t len) {
+  for (;;) {
+    ssize_t n = ::read(fd, buf, len);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    return n < 0 ? 0 : static_cast<std::size_t>(n);
+  }
+}
+
+// Output staging: appends and writes in kChunk pieces
+struct Out {
+  int fd;
+  std::vector<std::byte> buf = std::vector<std::byte>(kChunk);
+  std::size_t used = 0;
+
+  std::byte *Reserve(std::size_t n) {
+    if (used + n > buf.size()) {
+      Drain();
+    }
+    return buf.data() + used;
+  }
+  void Commit(std::size_t n) { used += n; }
+  void Drain() {
+    io::WriteAll(fd, reinterpret_cast<const char *>(buf.data()), used);
+    used = 0;
+  }
+};
+
+// `pending` already holds the first bytes of the input (the sniffed prefix)
+int BinaryToNdjson(int in, Out &out, std::vector<std::byte> &pending,
+                   std::size_t have) {
+  capture::FileHeader h;
+  while (have < sizeof(h)) {
+    const std::size_t n = ReadSome(in, pending.data() + have, kChunk - have);
+    if (n == 0) {
+      std::cerr << "[capture_convert] truncated header\n";
+      return 1;
+    }
+    have += n;
+  }
+  std::memcpy(&h, pending.data(), sizeof(h));
+  if (auto st = capture::ValidateHeader(h); !st) {
+    std::cerr << "[capture_convert] bad header: " << st.error().message()
+              << " (version " << h.version << ")\n";
+    return 1;
+  }
+  std::memmove(pending.data(), pending.data() + sizeof(h), have - sizeof(h));
+  have -= sizeof(h);
+  capture::RecordDecoder dec;
+  std::uint64_t quotes = 0;
+  for (;;) {
+    const std::size_t whole = have / capture::kRecordSize;
+    quotes += dec.Decode(
+        pending.data(), whole,
+        [&out](const codec::QuoteRecord &r, std::string_view symbol) {
+          char *p = reinterpret_cast<char *>(out.Reserve(codec::kMaxJsonLen));
+          std::size_t n = codec::FormatBookTickerJson(r, symbol, p);
+          p[n++] = '\n';
+          out.Commit(n);
+        });
+    const std::size_t used = whole * capture::kRecordSize;
+    std::memmove(pending.data(), pending.data() + used, have - used);
+    have -= used;
+    const std::size_t n = ReadSome(in, pending.data() + have, kChunk - have);
+    if (n == 0) {
+      break;
+    }
+    have += n;
+  }
+  out.Drain();
+  std::cerr << "[capture_convert] binary -> ndjson: " << quotes << " quotes";
+  if (have != 0) {
+    std::cerr << ", " << have << " trailing bytes ignored";
+  }
+  std::cerr << "\n";
+  return 0;
+}
+
+int NdjsonToBinary(int in, Out &out, std::vector<std::byte> &pending,
+                   std::size_t have) {
+  const capture::FileHeader h = capture::MakeHeader(lat::EpochNanosUtc());
+  std::memcpy(out.Reserve(sizeof(h)), &h, sizeof(h));
+  out.Commit(sizeof(h));
+  capture::RecordEncoder enc;
+  std::uint64_t lines = 0;
+  auto encodeLine = [&](std::string_view line) {
+    if (line.empty()) {
+      return;
+    }
+    ++lines;
+    std::byte *p = out.Reserve(capture::RecordEncoder::kMaxBytesPerMessage);
+    out.Commit(enc.Encode(line, 0, 0, p));
+  };
+  for (;;) {
+    const char *base = reinterpret_cast<const char *>(pending.data());
+    std::size_t start = 0;
+    for (;;) {
+      const void *nl = std::memchr(base + start, '\n', have - start);
+      if (nl == nullptr) {
+        break;
+      }
+      const std::size_t end = static_cast<const char *>(nl) - base;
+      encodeLine(std::string_view{base + start, end - start});
+      start = end + 1;
+    }
+    std::memmove(pending.data(), pending.data() + start, have - start);
+    have -= start;
+    if (have == kChunk) {
+      std::cerr << "[capture_convert] line longer than " << kChunk
+                << " bytes\n";
+      return 1;
+    }
+    const std::size_t n = ReadSome(in, pending.data() + have, kChunk - have);
+    if (n == 0) {
+      encodeLine(std::string_view{
+          reinterpret_cast<const char *>(pending.data()), have});
+      break;
+    }
+    have += n;
+  }
+  out.Drain();
+  std::cerr << "[capture_convert] ndjson -> binary: " << lines << " lines, "
+            << enc.Skipped() << " skipped (not bookTicker)\n";
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    std::cerr << "usage: capture_convert IN OUT   (IN/OUT may be -)\n";
+    return 1;
+  }
+  const std::string inPath = argv[1];
+  const std::string outPath = argv[2];
+  int in = inPath == "-" ? STDIN_FILENO
+                         : ::open(inPath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (in == -1) {
+    std::cerr << "[capture_convert] open " << inPath << ": "
+              << std::strerror(errno) << "\n";
+    return 1;
+  }
+  int outFd = outPath == "-"
+                  ? STDOUT_FILENO
+                  : ::open(outPath.c_str(),
+                           O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+  if (outFd == -1) {
+    std::cerr << "[capture_convert] open " << outPath << ": "
+              << std::strerror(errno) << "\n";
+    return 1;
+  }
+  (void)::posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+  std::vector<std::byte> pending(kChunk);
+  std::size_t have = 0;
+  while (have < sizeof(capture::kMagic)) {
+    const std::size_t n = ReadSome(in, pending.data() + have, kChunk - have);
+    if (n == 0) {
+      break;
+    }
+    have += n;
+  }
+  Out out{outFd};
+  const int rc = capture::HasMagic(pending.data(), have)
+                     ? BinaryToNdjson(in, out, pending, have)
+                     : NdjsonToBinary(in, out, pending, have);
+  if (outFd != STDOUT_FILENO) {
+    ::close(outFd);
+  }
+  if (in != STDIN_FILENO) {
+    ::close(in);
+  }
+  return rc;
+}
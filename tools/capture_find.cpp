@@ -0,0 +1,185 @@
+// capture_find — locates an update id or an exchange time in a segmented
+// capture (`-o STEM.ext --segment-bytes/--segment-seconds`) using only the
+// sidecar .idx files: one binary search over segments, one within the
+// segment's index, then a short forward scan of at most one index stride.
+//   capture_find STEM --u U [--print N]
+//   capture_find STEM --time 2025-09-05T23:27:00[.123] [--print N]   (UTC)
+//   capture_find STEM --ms EPOCH_MS [--print N]
+//   capture_find STEM --list
+// --print N prints N NDJSON lines starting at the match (NDJSON segments,
+// plain or compressed).
+#include "capture/segment_index.hpp"
+#include "codec/book_ticker.hpp"
+#include "compress/seekable_reader.hpp"
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::optional<std::int64_t> ParseUtcMs(const std::string &s) {
+  std::tm tm{};
+  int ms = 0;
+  const char *rest = ::strptime(s.c_str(), "%Y-%m-%dT%H:%M:%S", &tm);
+  if (rest == nullptr) {
+    return std::nullopt;
+  }
+  if (*rest == '.') {
+    int digits = 0;
+    for (++rest; *rest >= '0' && *rest <= '9' && digits < 3; ++rest, ++digits) {
+      ms = ms * 10 + (*rest - '0');
+    }
+    for (; digits < 3; ++digits) {
+      ms *= 10;
+    }
+  }
+  return static_cast<std::int64_t>(::timegm(&tm)) * 1000 + ms;
+}
+
+// Reads the segment's logical bytes from `offset` on, up to `max` bytes
+std::string ReadFrom(const capture::SegmentIndex &seg, std::uint64_t offset,
+                     std::size_t max) {
+  std::string out;
+  if (seg.header.flags & capture::kIndexCompressed) {
+    auto r = compress::SeekableReader::Open(seg.data_path);
+    if (!r) {
+      return out;
+    }
+    std::vector<char> frame;
+    for (std::size_t i = r->FrameAt(offset);
+         i < r->Frames().size() && out.size() < max; ++i) {
+      if (!r->ReadFrame(i, frame)) {
+        break;
+      }
+      const auto &f = r->Frames()[i];
+      const std::size_t b =
+          offset > f.raw_offset ? static_cast<std::size_t>(offset - f.raw_offset)
+                                : 0;
+      out.append(frame.data() + b, frame.size() - b);
+    }
+  } else {
+    std::ifstream in(seg.data_path, std::ios::binary);
+    in.seekg(static_cast<std::streamoff>(offset));
+    out.resize(max);
+    in.read(out.data(), static_cast<std::streamsize>(max));
+    out.resize(static_cast<std::size_t>(in.gcount()));
+  }
+  return out;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "usage: capture_find STEM (--u U | --time ISO | --ms MS | "
+                 "--list) [--print N]\n";
+    return 1;
+  }
+  const std::string stem = argv[1];
+  std::optional<std::uint64_t> u;
+  std::optional<std::int64_t> ms;
+  bool list = false;
+  int print = 0;
+  for (int i = 2; i < argc; ++i) {
+    const std::string a = argv[i];
+    if (a == "--u" && i + 1 < argc) {
+      u = std::stoull(argv[++i]);
+    } else if (a == "--ms" && i + 1 < argc) {
+      ms = std::stoll(argv[++i]);
+    } else if (a == "--time" && i + 1 < argc) {
+      ms = ParseUtcMs(argv[++i]);
+      if (!ms) {
+        std::cerr << "[capture_find] bad time: " << argv[i] << "\n";
+        return 1;
+      }
+    } else if (a == "--list") {
+      list = true;
+    } else if (a == "--print" && i + 1 < argc) {
+      print = std::atoi(argv[++i]);
+    }
+  }
+  const auto segs = capture::LoadSegments(stem);
+  if (segs.empty()) {
+    std::cerr << "[capture_find] no segment indexes for " << stem << "\n";
+    return 1;
+  }
+  if (list) {
+    for (const auto &s : segs) {
+      std::printf("%s u=[%llu,%llu] E=[%lld,%lld] messages=%llu bytes=%llu "
+                  "entries=%zu%s\n",
+                  s.data_path.c_str(),
+                  static_cast<unsigned long long>(s.header.first_u),
+                  static_cast<unsigned long long>(s.header.last_u),
+                  static_cast<long long>(s.header.first_ms),
+                  static_cast<long long>(s.header.last_ms),
+                  static_cast<unsigned long long>(s.header.messages),
+                  static_cast<unsigned long long>(s.header.bytes),
+                  s.entries.size(),
+                  (s.header.flags & capture::kIndexClosed) ? "" : " (open)");
+    }
+    return 0;
+  }
+  if (!u && !ms) {
+    std::cerr << "[capture_find] need --u, --time or --ms\n";
+    return 1;
+  }
+  // Last segment starting at or before the target
+  std::size_t k = 0;
+  {
+    std::size_t lo = 0;
+    std::size_t hi = segs.size();
+    while (lo < hi) {
+      const std::size_t mid = (lo + hi) / 2;
+      const bool before = u ? segs[mid].header.first_u <= *u
+                            : segs[mid].header.first_ms < *ms;
+      if (before) {
+        k = mid;
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+  }
+  const auto &seg = segs[k];
+  if (seg.entries.empty()) {
+    std::cerr << "[capture_find] segment " << seg.index_path
+              << " has no entries\n";
+    return 1;
+  }
+  const std::size_t e = u ? seg.FindU(*u) : seg.FindTime(*ms);
+  const capture::IndexEntry &entry = seg.entries[e];
+  std::printf("%s offset=%llu u=%llu E=%lld\n", seg.data_path.c_str(),
+              static_cast<unsigned long long>(entry.offset),
+              static_cast<unsigned long long>(entry.u),
+              static_cast<long long>(entry.event_ms));
+  if (print <= 0 || (seg.header.flags & capture::kIndexBinary)) {
+    return 0;
+  }
+  // Scan forward from the entry to the first matching line
+  const std::string text =
+      ReadFrom(seg, entry.offset, 2 * seg.header.stride + 4096u * print);
+  std::size_t pos = 0;
+  int printed = 0;
+  while (pos < text.size() && printed < print) {
+    std::size_t nl = text.find('\n', pos);
+    if (nl == std::string::npos) {
+      nl = text.size();
+    }
+    const std::string_view line(text.data() + pos, nl - pos);
+    pos = nl + 1;
+    if (printed == 0) {
+      auto bt = codec::ParseBookTicker(line);
+      if (bt && ((u && bt->u < *u) || (ms && bt->event_ms < *ms))) {
+        continue;
+      }
+    }
+    std::fwrite(line.data(), 1, line.size(), stdout);
+    std::fputc('\n', stdout);
+    ++printed;
+  }
+  return 0;
+}
@@ -0,0 +1,118 @@
+// capture_stats — loads a whole capture with capture::CaptureReader and
+// prints its shape: record count, u and event-time ranges, ordering
+// violations and per-symbol counts, plus how long each phase took.
+//   capture_stats FILE [-j THREADS]
+// FILE is NDJSON or a binary capture, plain or written with --compress.
+// Every record is fully decoded (on all cores) to validate the file.
+#include "capture/capture_reader.hpp"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+double MsSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - t0)
+      .count();
+}
+
+struct WorkerStats {
+  std::uint64_t bad = 0;
+  std::uint64_t regressions = 0; // u not above the previous record's
+  std::uint64_t prev_u = 0;
+  std::map<std::string, std::uint64_t, std::less<>> symbols;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::cerr << "usage: capture_stats FILE [-j THREADS]\n";
+    return 1;
+  }
+  unsigned threads = 0;
+  for (int i = 2; i + 1 < argc; ++i) {
+    if (std::string(argv[i]) == "-j") {
+      threads = static_cast<unsigned>(std::max(1, std::atoi(argv[i + 1])));
+    }
+  }
+  threads = capture::CaptureReader::Workers(threads);
+  auto t0 = std::chrono::steady_clock::now();
+  auto r = capture::CaptureReader::Open(argv[1], threads);
+  if (!r) {
+    std::cerr << "[capture_stats] " << argv[1] << ": " << r.error().message()
+              << "\n";
+    return 1;
+  }
+  const double openMs = MsSince(t0);
+  t0 = std::chrono::steady_clock::now();
+  r->BuildIndex(threads);
+  const double indexMs = MsSince(t0);
+
+  t0 = std::chrono::steady_clock::now();
+  std::vector<WorkerStats> ws(threads);
+  r->ParallelForEach(threads, [&](unsigned w, const capture::RecordView &v) {
+    WorkerStats &s = ws[w];
+    auto bt = v.Decode();
+    if (!bt) {
+      ++s.bad;
+      return;
+    }
+    if (v.u <= s.prev_u) {
+      ++s.regressions;
+    }
+    s.prev_u = v.u;
+    auto it = s.symbols.find(bt->symbol);
+    if (it == s.symbols.end()) {
+      s.symbols.emplace(std::string(bt->symbol), 1);
+    } else {
+      ++it->second;
+    }
+  });
+  const double parseMs = MsSince(t0);
+
+  WorkerStats total;
+  for (unsigned w = 0; w < threads; ++w) {
+    total.bad += ws[w].bad;
+    total.regressions += ws[w].regressions;
+    for (const auto &[sym, n] : ws[w].symbols) {
+      total.symbols[sym] += n;
+    }
+  }
+  // Ordering across worker boundaries
+  const auto &idx = r->Index();
+  for (unsigned w = 1; w < threads; ++w) {
+    const std::size_t at = idx.size() * w / threads;
+    if (at > 0 && at < idx.size() && idx[at].u <= idx[at - 1].u) {
+      ++total.regressions;
+    }
+  }
+
+  const double mb = static_cast<double>(r->Data().size()) / (1 << 20);
+  std::printf("format=%s%s bytes=%zu records=%zu skipped=%llu bad=%llu "
+              "threads=%u\n",
+              r->Format() == capture::CaptureFormat::binary ? "binary"
+                                                            : "ndjson",
+              r->Compressed() ? "+compressed" : "", r->Data().size(),
+              r->Size(), static_cast<unsigned long long>(r->Skipped()),
+              static_cast<unsigned long long>(total.bad), threads);
+  if (!idx.empty()) {
+    std::printf("u=[%llu,%llu] E=[%lld,%lld] u_regressions=%llu\n",
+                static_cast<unsigned long long>(idx.front().u),
+                static_cast<unsigned long long>(idx.back().u),
+                static_cast<long long>(idx.front().event_ms),
+                static_cast<long long>(idx.back().event_ms),
+                static_cast<unsigned long long>(total.regressions));
+  }
+  for (const auto &[sym, n] : total.symbols) {
+    std::printf("  %s %llu\n", sym.c_str(), static_cast<unsigned long long>(n));
+  }
+  std::printf("open_ms=%.1f index_ms=%.1f (%.0f MB/s) decode_ms=%.1f\n",
+              openMs, indexMs, indexMs > 0 ? mb / (indexMs / 1000) : 0.0,
+              parseMs);
+  return 0;
+}
@@ -0,0 +1,53 @@
+// shm_tail — minimal out-of-process reader of the merged stream published by
+// `webhook_parsing --shm NAME`. Attaches (retrying until the writer appears),
+// prints each payload as an NDJSON line and reports overruns on exit.
+#include "ipc/shm_ring.hpp"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+
+static std::atomic<bool> g_stop{false};
+
+static void OnSignal(int) { g_stop.store(true); }
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::cerr << "usage: shm_tail NAME [-q]\n";
+    return 1;
+  }
+  const std::string name = argv[1];
+  const bool quiet = argc > 2 && std::string(argv[2]) == "-q";
+  std::signal(SIGINT, OnSignal);
+  std::signal(SIGTERM, OnSignal);
+
+  auto reader = ipc::ShmRingReader::Attach(name);
+  while (!reader && !g_stop.load()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    reader = ipc::ShmRingReader::Attach(name);
+  }
+  if (!reader) {
+    std::cerr << "[shm_tail] attach '" << name
+              << "' failed: " << reader.error().message() << "\n";
+    return 1;
+  }
+  while (!g_stop.load()) {
+    const std::size_t n =
+        reader->Poll([quiet](const lockfree::BroadcastMessage &m) {
+          if (!quiet) {
+            std::fwrite(m.payload.data(), 1, m.payload.size(), stdout);
+            std::fputc('\n', stdout);
+          }
+        });
+    if (n == 0) {
+      std::this_thread::yield();
+    }
+  }
+  const auto &st = reader->Stats();
+  std::cerr << "[shm_tail] delivered=" << st.delivered << " lost=" << st.lost
+            << " torn=" << st.torn << "\n";
+  return 0;
+}
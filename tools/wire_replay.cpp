@@ -0,0 +1,210 @@
+// wire_replay — feeds raw wire captures (--wire-capture) back through a
+// StreamMerger offline, one producer queue per recorded connection, so the
+// merged output of an incident can be reproduced and inspected.
+//   wire_replay FILE... [--speed X] [--sink KIND:TARGET[,POLICY]]... [--dump]
+// Messages are fed in the order they were received across all files (the
+// steady-clock stamps share one host clock). --speed 1 (default) keeps the
+// original inter-arrival gaps, which is what the merger's hold-back window
+// reacts to; 10 is ten times faster, 0 as fast as possible. --dump prints
+// one line per message instead: conn, seq, recv_ns, gap since the previous
+// message on any connection (us), bytes and the payload.
+#include "capture/wire_capture.hpp"
+#include "merge/stream_merger.hpp"
+#include "sink/sink_factory.hpp"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Cursor {
+  capture::WireFile file;
+  std::size_t offset = capture::WireFile::Begin();
+  capture::WireRecord rec{};
+  bool live = false;
+  std::uint64_t records = 0;
+  std::uint64_t gaps = 0; // messages missing from the recording (seq jumps)
+  std::uint64_t next_seq = 0;
+
+  void Advance() { live = file.Next(offset, rec); }
+
+  // Longest recorded message (sizes the replay's message slots)
+  std::size_t MaxLen() const {
+    std::size_t off = capture::WireFile::Begin();
+    capture::WireRecord r;
+    std::size_t n = 0;
+    while (file.Next(off, r)) {
+      n = std::max<std::size_t>(n, r.h.len);
+    }
+    return n;
+  }
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::signal(SIGPIPE, SIG_IGN); // compressed and tcp sinks see EPIPE
+  double speed = 1.0;
+  bool dump = false;
+  std::vector<std::string> paths;
+  std::vector<sink::SinkSpec> specs;
+  for (int i = 1; i < argc; ++i) {
+    const std::string a = argv[i];
+    if (a == "--speed" && i + 1 < argc) {
+      speed = std::max(0.0, std::atof(argv[++i]));
+    } else if (a == "--dump") {
+      dump = true;
+    } else if (a == "--sink" && i + 1 < argc) {
+      auto spec = sink::ParseSinkSpec(argv[++i]);
+      if (!spec) {
+        std::cerr << "[wire_replay] invalid --sink: " << argv[i] << "\n";
+        return 1;
+      }
+      specs.push_back(std::move(*spec));
+    } else {
+      paths.push_back(a);
+    }
+  }
+  if (paths.empty()) {
+    std::cerr << "usage: wire_replay FILE... [--speed X] [--sink SPEC]... "
+                 "[--dump]\n";
+    return 1;
+  }
+
+  std::vector<Cursor> cur;
+  cur.reserve(paths.size());
+  for (const auto &p : paths) {
+    auto f = capture::WireFile::Open(p);
+    if (!f) {
+      std::cerr << "[wire_replay] " << p << ": " << f.error().message() << "\n";
+      return 1;
+    }
+    cur.push_back(Cursor{.file = std::move(*f)});
+    cur.back().Advance();
+  }
+  // Earliest pending message across all connections, or -1 when done
+  auto nextSrc = [&cur]() -> int {
+    int best = -1;
+    for (std::size_t i = 0; i < cur.size(); ++i) {
+      if (cur[i].live && (best < 0 || cur[i].rec.h.mono_ns <
+                                          cur[best].rec.h.mono_ns)) {
+        best = static_cast<int>(i);
+      }
+    }
+    return best;
+  };
+  auto account = [](Cursor &c) {
+    if (c.rec.h.seq > c.next_seq) {
+      c.gaps += c.rec.h.seq - c.next_seq;
+    }
+    c.next_seq = c.rec.h.seq + 1;
+    ++c.records;
+  };
+
+  if (dump) {
+    std::int64_t prevMono = 0;
+    for (int s; (s = nextSrc()) >= 0;) {
+      Cursor &c = cur[static_cast<std::size_t>(s)];
+      const capture::WireRecordHeader &h = c.rec.h;
+      account(c);
+      std::printf("%u\t%llu\t%lld\t%.1f\t%u\t%.*s\n", h.conn,
+                  static_cast<unsigned long long>(h.seq),
+                  static_cast<long long>(h.recv_ns),
+                  prevMono == 0 ? 0.0 : (h.mono_ns - prevMono) / 1e3, h.len,
+                  static_cast<int>(c.rec.payload.size()), c.rec.payload.data());
+      prevMono = h.mono_ns;
+      c.Advance();
+    }
+    return 0;
+  }
+
+  std::vector<std::shared_ptr<RawOrderQueue>> queues;
+  // Slots sized for the largest recorded message of any connection
+  mem::SlabConfig slab;
+  for (const auto &c : cur) {
+    slab.slot_bytes = std::max(slab.slot_bytes, c.MaxLen());
+  }
+  for (std::size_t i = 0; i < cur.size(); ++i) {
+    auto q = RawOrderQueue::Create(slab);
+    if (!q) {
+      std::cerr << "[wire_replay] queue: " << q.error().message() << "\n";
+      return 1;
+    }
+    queues.push_back(std::move(*q));
+  }
+  StreamMerger merger{queues};
+  for (auto &spec : specs) {
+    spec.cfg.slot_size =
+        std::max(spec.cfg.slot_size,
+                 sink::SinkWorker::SlotSizeFor(slab.slot_bytes));
+    auto s = sink::MakeSink(spec);
+    if (!s) {
+      std::cerr << "[wire_replay] sink " << spec.kind << ":" << spec.target
+                << " error: " << s.error().message() << "\n";
+      return 1;
+    }
+    merger.AddSink(std::move(*s), spec.cfg);
+  }
+  merger.Start();
+
+  using Clock = std::chrono::steady_clock;
+  const auto t0 = Clock::now();
+  std::int64_t mono0 = 0;
+  std::uint64_t fed = 0;
+  for (int s; (s = nextSrc()) >= 0;) {
+    Cursor &c = cur[static_cast<std::size_t>(s)];
+    const capture::WireRecordHeader &h = c.rec.h;
+    account(c);
+    if (speed > 0.0) {
+      if (fed == 0) {
+        mono0 = h.mono_ns;
+      }
+      const auto due = t0 + std::chrono::nanoseconds(static_cast<std::int64_t>(
+                                static_cast<double>(h.mono_ns - mono0) / speed));
+      if (due - Clock::now() > std::chrono::microseconds(200)) {
+        std::this_thread::sleep_until(due - std::chrono::microseconds(100));
+      }
+      while (Clock::now() < due) {
+      }
+    }
+    // Same slot handling as the sessions, except that running out of slots
+    // is waited out instead of losing the message
+    RawOrderQueue &q = *queues[static_cast<std::size_t>(s)];
+    RawOrderUpdate slot;
+    while (!q.acquire(slot)) {
+      std::this_thread::yield();
+    }
+    slot.buf.clear();
+    auto mb = slot.buf.prepare(c.rec.payload.size());
+    std::memcpy(mb.data(), c.rec.payload.data(), c.rec.payload.size());
+    slot.buf.commit(c.rec.payload.size());
+    slot.recv_ns = h.recv_ns;
+    (void)q.publish(std::move(slot));
+    ++fed;
+    c.Advance();
+  }
+  merger.Join();
+  const double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0)
+                        .count();
+
+  for (std::size_t i = 0; i < cur.size(); ++i) {
+    std::printf("[wire %s] conn=%u records=%llu missing=%llu\n",
+                paths[i].c_str(), cur[i].file.Header().conn,
+                static_cast<unsigned long long>(cur[i].records),
+                static_cast<unsigned long long>(cur[i].gaps));
+  }
+  for (const auto &w : merger.Sinks()) {
+    std::printf("[sink %s] written=%llu dropped=%llu\n", w->Name(),
+                static_cast<unsigned long long>(w->GetStats().written.load()),
+                static_cast<unsigned long long>(w->GetStats().dropped.load()));
+  }
+  std::printf("fed=%llu elapsed_ms=%.1f\n", static_cast<unsigned long long>(fed),
+              ms);
+  return 0;
+}